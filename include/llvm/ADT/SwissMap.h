@@ -0,0 +1,700 @@
+//===- llvm/ADT/SwissMap.h - Group probed hash table ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the SwissMap class, an open addressing hash table with the
+// interface of DenseMap.
+//
+// Next to its array of buckets, a SwissMap keeps one control byte per bucket,
+// which says whether the bucket is empty, erased, or full, and in the last
+// case holds seven bits of the hash of its key. A lookup loads the control
+// bytes of a whole group of buckets at once, 16 with SSE2 and 8 otherwise,
+// and only compares the keys of the buckets whose hash bits match, so probing
+// rarely touches a bucket it doesn't need. Groups are probed quadratically.
+//
+// Unlike DenseMap, SwissMap needs no empty or tombstone key, so every value
+// of KeyT may be stored, and only getHashValue and isEqual of KeyInfoT are
+// used. Iterators and pointers to buckets are invalidated by insertion, like
+// those of DenseMap.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_SWISSMAP_H
+#define LLVM_ADT_SWISSMAP_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/EpochTracker.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/type_traits.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LLVM_SWISSMAP_USE_SSE2 1
+#else
+#define LLVM_SWISSMAP_USE_SSE2 0
+#endif
+
+namespace llvm {
+
+namespace detail {
+
+/// Control byte values. Full buckets have the top bit clear.
+enum : int8_t { SwissEmpty = -128, SwissDeleted = -2 };
+
+/// The buckets of a group that matched a query, one bit or one byte each.
+template <typename T, unsigned Shift> class SwissBitMask {
+  T Mask;
+
+public:
+  explicit SwissBitMask(T Mask) : Mask(Mask) {}
+
+  explicit operator bool() const { return Mask != 0; }
+
+  /// Index in the group of the first matching bucket.
+  unsigned lowest() const {
+    return countTrailingZeros(Mask, ZB_Undefined) >> Shift;
+  }
+
+  /// Forget the first matching bucket.
+  void clearLowest() { Mask &= Mask - 1; }
+};
+
+#if LLVM_SWISSMAP_USE_SSE2
+
+/// The control bytes of 16 buckets, compared with SSE2.
+class SwissGroup {
+  __m128i Ctrl;
+
+public:
+  static const unsigned Width = 16;
+  using BitMask = SwissBitMask<uint32_t, 0>;
+
+  explicit SwissGroup(const int8_t *Pos)
+      : Ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Pos))) {}
+
+  BitMask match(int8_t Hash) const {
+    return BitMask(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(Hash), Ctrl))));
+  }
+
+  BitMask matchEmpty() const { return match(SwissEmpty); }
+
+  BitMask matchEmptyOrDeleted() const {
+    return BitMask(static_cast<uint32_t>(_mm_movemask_epi8(Ctrl)));
+  }
+};
+
+#else
+
+/// The control bytes of 8 buckets, compared a word at a time.
+class SwissGroup {
+  static const uint64_t Lsbs = 0x0101010101010101ULL;
+  static const uint64_t Msbs = 0x8080808080808080ULL;
+  uint64_t Ctrl;
+
+public:
+  static const unsigned Width = 8;
+  using BitMask = SwissBitMask<uint64_t, 3>;
+
+  explicit SwissGroup(const int8_t *Pos)
+      : Ctrl(support::endian::read64le(Pos)) {}
+
+  /// This may report a full bucket after a matching one as matching too,
+  /// which costs a key comparison but nothing else.
+  BitMask match(int8_t Hash) const {
+    uint64_t X = Ctrl ^ (Lsbs * static_cast<uint8_t>(Hash));
+    return BitMask((X - Lsbs) & ~X & Msbs);
+  }
+
+  /// The empty byte is the only one with bit 7 set and bit 1 clear.
+  BitMask matchEmpty() const { return BitMask(Ctrl & (~Ctrl << 6) & Msbs); }
+
+  BitMask matchEmptyOrDeleted() const { return BitMask(Ctrl & Msbs); }
+};
+
+#endif
+
+} // end namespace detail
+
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename BucketT,
+          bool IsConst = false>
+class SwissMapIterator;
+
+template <typename KeyT, typename ValueT,
+          typename KeyInfoT = DenseMapInfo<KeyT>,
+          typename BucketT = detail::DenseMapPair<KeyT, ValueT>>
+class SwissMap : public DebugEpochBase {
+  template <typename T>
+  using const_arg_type_t = typename const_pointer_or_const_ref<T>::type;
+
+  using Group = detail::SwissGroup;
+
+  int8_t *Ctrl = nullptr;
+  BucketT *Buckets = nullptr;
+  unsigned NumEntries = 0;
+  unsigned NumBuckets = 0;
+  /// How many more entries can go into empty buckets before a rehash.
+  unsigned GrowthLeft = 0;
+
+public:
+  using size_type = unsigned;
+  using key_type = KeyT;
+  using mapped_type = ValueT;
+  using value_type = BucketT;
+
+  using iterator = SwissMapIterator<KeyT, ValueT, KeyInfoT, BucketT>;
+  using const_iterator =
+      SwissMapIterator<KeyT, ValueT, KeyInfoT, BucketT, true>;
+
+  /// Create a SwissMap that can hold \p InitialReserve entries without
+  /// growing.
+  explicit SwissMap(unsigned InitialReserve = 0) { reserve(InitialReserve); }
+
+  SwissMap(const SwissMap &Other) : DebugEpochBase() { copyFrom(Other); }
+
+  SwissMap(SwissMap &&Other) : DebugEpochBase() { swap(Other); }
+
+  template <typename InputIt> SwissMap(const InputIt &I, const InputIt &E) {
+    reserve(std::distance(I, E));
+    insert(I, E);
+  }
+
+  SwissMap(std::initializer_list<std::pair<KeyT, ValueT>> Vals) {
+    reserve(Vals.size());
+    insert(Vals.begin(), Vals.end());
+  }
+
+  ~SwissMap() {
+    destroyAll();
+    operator delete(Ctrl);
+  }
+
+  SwissMap &operator=(const SwissMap &Other) {
+    if (&Other != this) {
+      destroyAll();
+      operator delete(Ctrl);
+      copyFrom(Other);
+    }
+    return *this;
+  }
+
+  SwissMap &operator=(SwissMap &&Other) {
+    destroyAll();
+    operator delete(Ctrl);
+    Ctrl = nullptr;
+    Buckets = nullptr;
+    NumEntries = NumBuckets = GrowthLeft = 0;
+    swap(Other);
+    return *this;
+  }
+
+  void swap(SwissMap &RHS) {
+    incrementEpoch();
+    RHS.incrementEpoch();
+    std::swap(Ctrl, RHS.Ctrl);
+    std::swap(Buckets, RHS.Buckets);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(NumBuckets, RHS.NumBuckets);
+    std::swap(GrowthLeft, RHS.GrowthLeft);
+  }
+
+  iterator begin() {
+    if (empty())
+      return end();
+    return iterator(Ctrl, Buckets, Buckets + NumBuckets, *this);
+  }
+  iterator end() {
+    return iterator(Ctrl + NumBuckets, Buckets + NumBuckets,
+                    Buckets + NumBuckets, *this, true);
+  }
+  const_iterator begin() const {
+    if (empty())
+      return end();
+    return const_iterator(Ctrl, Buckets, Buckets + NumBuckets, *this);
+  }
+  const_iterator end() const {
+    return const_iterator(Ctrl + NumBuckets, Buckets + NumBuckets,
+                          Buckets + NumBuckets, *this, true);
+  }
+
+  LLVM_NODISCARD bool empty() const { return NumEntries == 0; }
+  unsigned size() const { return NumEntries; }
+
+  /// Grow the map so that it can contain at least \p NumEntries items before
+  /// resizing again.
+  void reserve(size_type NumEntries) {
+    incrementEpoch();
+    unsigned Needed = getMinBucketsForEntries(NumEntries);
+    if (Needed > NumBuckets)
+      rehash(Needed);
+  }
+
+  void clear() {
+    incrementEpoch();
+    if (NumEntries == 0 && GrowthLeft == getMaxEntries(NumBuckets))
+      return;
+
+    // If the capacity of the array is huge, and the # elements used is small,
+    // shrink the array.
+    if (NumEntries * 4 < NumBuckets && NumBuckets > 64) {
+      shrink_and_clear();
+      return;
+    }
+
+    destroyAll();
+    std::memset(Ctrl, detail::SwissEmpty, NumBuckets);
+    NumEntries = 0;
+    GrowthLeft = getMaxEntries(NumBuckets);
+  }
+
+  void shrink_and_clear() {
+    unsigned OldNumEntries = NumEntries;
+    destroyAll();
+    operator delete(Ctrl);
+    Ctrl = nullptr;
+    Buckets = nullptr;
+    NumEntries = NumBuckets = GrowthLeft = 0;
+    reserve(OldNumEntries);
+  }
+
+  /// Return 1 if the specified key is in the map, 0 otherwise.
+  size_type count(const_arg_type_t<KeyT> Val) const {
+    return lookupBucketFor(Val) ? 1 : 0;
+  }
+
+  iterator find(const_arg_type_t<KeyT> Val) { return find_as(Val); }
+  const_iterator find(const_arg_type_t<KeyT> Val) const {
+    return find_as(Val);
+  }
+
+  /// Alternate version of find() which allows a different, and possibly less
+  /// expensive, key type. The KeyInfoT is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key type
+  /// used.
+  template <class LookupKeyT> iterator find_as(const LookupKeyT &Val) {
+    if (BucketT *TheBucket = lookupBucketFor(Val))
+      return makeIterator(TheBucket);
+    return end();
+  }
+  template <class LookupKeyT>
+  const_iterator find_as(const LookupKeyT &Val) const {
+    if (const BucketT *TheBucket = lookupBucketFor(Val))
+      return makeConstIterator(TheBucket);
+    return end();
+  }
+
+  /// Return the entry for the specified key, or a default constructed value
+  /// if no such entry exists.
+  ValueT lookup(const_arg_type_t<KeyT> Val) const {
+    if (const BucketT *TheBucket = lookupBucketFor(Val))
+      return TheBucket->getSecond();
+    return ValueT();
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    return try_emplace(KV.first, KV.second);
+  }
+  std::pair<iterator, bool> insert(std::pair<KeyT, ValueT> &&KV) {
+    return try_emplace(std::move(KV.first), std::move(KV.second));
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // The value is constructed in-place if the key is not in the map, otherwise
+  // it is not moved.
+  template <typename... Ts>
+  std::pair<iterator, bool> try_emplace(KeyT &&Key, Ts &&... Args) {
+    std::pair<BucketT *, bool> Slot = findOrPrepareInsert(Key);
+    if (Slot.second)
+      constructBucket(Slot.first, std::move(Key), std::forward<Ts>(Args)...);
+    return std::make_pair(makeIterator(Slot.first), Slot.second);
+  }
+  template <typename... Ts>
+  std::pair<iterator, bool> try_emplace(const KeyT &Key, Ts &&... Args) {
+    std::pair<BucketT *, bool> Slot = findOrPrepareInsert(Key);
+    if (Slot.second)
+      constructBucket(Slot.first, Key, std::forward<Ts>(Args)...);
+    return std::make_pair(makeIterator(Slot.first), Slot.second);
+  }
+
+  /// Alternate version of insert() which allows a different, and possibly
+  /// less expensive, key type.
+  template <typename LookupKeyT>
+  std::pair<iterator, bool> insert_as(std::pair<KeyT, ValueT> &&KV,
+                                      const LookupKeyT &Val) {
+    std::pair<BucketT *, bool> Slot = findOrPrepareInsert(Val);
+    if (Slot.second)
+      constructBucket(Slot.first, std::move(KV.first), std::move(KV.second));
+    return std::make_pair(makeIterator(Slot.first), Slot.second);
+  }
+
+  /// insert - Range insertion of pairs.
+  template <typename InputIt> void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  bool erase(const KeyT &Val) {
+    BucketT *TheBucket = lookupBucketFor(Val);
+    if (!TheBucket)
+      return false; // not in map.
+    eraseBucket(TheBucket);
+    return true;
+  }
+  void erase(iterator I) { eraseBucket(&*I); }
+
+  value_type &FindAndConstruct(const KeyT &Key) {
+    return *try_emplace(Key).first;
+  }
+  value_type &FindAndConstruct(KeyT &&Key) {
+    return *try_emplace(std::move(Key)).first;
+  }
+
+  ValueT &operator[](const KeyT &Key) { return FindAndConstruct(Key).second; }
+  ValueT &operator[](KeyT &&Key) {
+    return FindAndConstruct(std::move(Key)).second;
+  }
+
+  /// Return true if the specified pointer points somewhere into the map's
+  /// array of buckets (i.e. either to a key or value in the map).
+  bool isPointerIntoBucketsArray(const void *Ptr) const {
+    return Ptr >= Buckets && Ptr < Buckets + NumBuckets;
+  }
+
+  /// Return an opaque pointer into the buckets array. In conjunction with the
+  /// previous method, this can be used to determine whether an insertion
+  /// caused the map to reallocate.
+  const void *getPointerIntoBucketsArray() const { return Buckets; }
+
+  /// Return the approximate size (in bytes) of the actual map.
+  size_t getMemorySize() const { return getAllocationSize(NumBuckets); }
+
+private:
+  iterator makeIterator(BucketT *B) {
+    return iterator(Ctrl + (B - Buckets), B, Buckets + NumBuckets, *this,
+                    true);
+  }
+  const_iterator makeConstIterator(const BucketT *B) const {
+    return const_iterator(Ctrl + (B - Buckets), B, Buckets + NumBuckets,
+                          *this, true);
+  }
+
+  /// The most entries a table of \p Buckets buckets holds, 7/8 of them.
+  static unsigned getMaxEntries(unsigned Buckets) {
+    return Buckets - Buckets / 8;
+  }
+
+  static unsigned getMinBucketsForEntries(unsigned Entries) {
+    if (Entries == 0)
+      return 0;
+    unsigned Buckets = Group::Width;
+    while (getMaxEntries(Buckets) < Entries)
+      Buckets *= 2;
+    return Buckets;
+  }
+
+  static size_t getBucketsOffset(unsigned Buckets) {
+    return alignTo(Buckets, alignof(BucketT));
+  }
+
+  static size_t getAllocationSize(unsigned Buckets) {
+    return Buckets ? getBucketsOffset(Buckets) + sizeof(BucketT) * Buckets : 0;
+  }
+
+  /// Spread the bits of the hash of \p Val: the top seven go into the control
+  /// byte, the rest pick the first group to probe.
+  template <typename LookupKeyT>
+  static uint64_t getHash(const LookupKeyT &Val) {
+    return static_cast<uint64_t>(KeyInfoT::getHashValue(Val)) *
+           0x9E3779B97F4A7C15ULL;
+  }
+  static int8_t getControlByte(uint64_t Hash) {
+    return static_cast<int8_t>(Hash >> 57);
+  }
+  static size_t getFirstGroup(uint64_t Hash) { return Hash >> 25; }
+
+  template <typename LookupKeyT>
+  BucketT *lookupBucketFor(const LookupKeyT &Val) const {
+    if (NumBuckets == 0)
+      return nullptr;
+    return lookupBucketFor(Val, getHash(Val));
+  }
+
+  template <typename LookupKeyT>
+  BucketT *lookupBucketFor(const LookupKeyT &Val, uint64_t Hash) const {
+    int8_t H2 = getControlByte(Hash);
+    size_t GroupMask = NumBuckets / Group::Width - 1;
+    size_t GroupIdx = getFirstGroup(Hash) & GroupMask;
+    for (size_t Probe = 1;; ++Probe) {
+      size_t Base = GroupIdx * Group::Width;
+      Group G(Ctrl + Base);
+      for (auto Match = G.match(H2); Match; Match.clearLowest()) {
+        BucketT *B = Buckets + Base + Match.lowest();
+        if (LLVM_LIKELY(KeyInfoT::isEqual(Val, B->getFirst())))
+          return B;
+      }
+      if (G.matchEmpty())
+        return nullptr;
+      GroupIdx = (GroupIdx + Probe) & GroupMask;
+    }
+  }
+
+  /// Return the first empty or erased bucket in the probe sequence of a key
+  /// with hash \p Hash.
+  size_t findFreeBucket(uint64_t Hash) const {
+    size_t GroupMask = NumBuckets / Group::Width - 1;
+    size_t GroupIdx = getFirstGroup(Hash) & GroupMask;
+    for (size_t Probe = 1;; ++Probe) {
+      size_t Base = GroupIdx * Group::Width;
+      if (auto Free = Group(Ctrl + Base).matchEmptyOrDeleted())
+        return Base + Free.lowest();
+      GroupIdx = (GroupIdx + Probe) & GroupMask;
+    }
+  }
+
+  /// Return the bucket of \p Val and false if it is in the map. Otherwise
+  /// claim a bucket for it, growing the map if needed, and return that bucket,
+  /// still to be constructed, and true.
+  template <typename LookupKeyT>
+  std::pair<BucketT *, bool> findOrPrepareInsert(const LookupKeyT &Val) {
+    incrementEpoch();
+    uint64_t Hash = getHash(Val);
+    size_t Idx = 0;
+    if (NumBuckets) {
+      if (BucketT *TheBucket = lookupBucketFor(Val, Hash))
+        return std::make_pair(TheBucket, false);
+      Idx = findFreeBucket(Hash);
+    }
+
+    if (NumBuckets == 0 ||
+        (GrowthLeft == 0 && Ctrl[Idx] == detail::SwissEmpty)) {
+      // Rehash at the same size if most of the unusable buckets are erased
+      // ones, otherwise double the table.
+      unsigned NewNumBuckets = Group::Width;
+      if (NumBuckets)
+        NewNumBuckets = NumEntries * 2 < getMaxEntries(NumBuckets)
+                            ? NumBuckets
+                            : NumBuckets * 2;
+      rehash(NewNumBuckets);
+      Idx = findFreeBucket(Hash);
+    }
+
+    if (Ctrl[Idx] == detail::SwissEmpty)
+      --GrowthLeft;
+    Ctrl[Idx] = getControlByte(Hash);
+    ++NumEntries;
+    return std::make_pair(Buckets + Idx, true);
+  }
+
+  template <typename KeyArg, typename... ValueArgs>
+  static void constructBucket(BucketT *B, KeyArg &&Key,
+                              ValueArgs &&... Values) {
+    ::new (&B->getFirst()) KeyT(std::forward<KeyArg>(Key));
+    ::new (&B->getSecond()) ValueT(std::forward<ValueArgs>(Values)...);
+  }
+
+  static void destroyBucket(BucketT *B) {
+    B->getSecond().~ValueT();
+    B->getFirst().~KeyT();
+  }
+
+  // Like DenseMap, erasing does not bump the epoch: the table is not moved,
+  // so iterators to the other entries stay valid.
+  void eraseBucket(BucketT *B) {
+    destroyBucket(B);
+    size_t Idx = B - Buckets;
+    // A probe only gets past this group if it has no empty bucket, so if it
+    // has one the bucket can simply become empty again.
+    if (Group(Ctrl + (Idx & ~size_t(Group::Width - 1))).matchEmpty()) {
+      Ctrl[Idx] = detail::SwissEmpty;
+      ++GrowthLeft;
+    } else {
+      Ctrl[Idx] = detail::SwissDeleted;
+    }
+    --NumEntries;
+  }
+
+  void destroyAll() {
+    if (isPodLike<KeyT>::value && isPodLike<ValueT>::value)
+      return;
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (Ctrl[I] >= 0)
+        destroyBucket(Buckets + I);
+  }
+
+  /// Allocate a table of \p Num buckets, all of them empty.
+  void allocateBuckets(unsigned Num) {
+    NumBuckets = Num;
+    GrowthLeft = getMaxEntries(Num);
+    if (Num == 0) {
+      Ctrl = nullptr;
+      Buckets = nullptr;
+      return;
+    }
+    Ctrl = static_cast<int8_t *>(operator new(getAllocationSize(Num)));
+    Buckets = reinterpret_cast<BucketT *>(Ctrl + getBucketsOffset(Num));
+    std::memset(Ctrl, detail::SwissEmpty, Num);
+  }
+
+  /// Move every entry into a new table of \p NewNumBuckets buckets, which
+  /// drops the erased buckets.
+  void rehash(unsigned NewNumBuckets) {
+    assert(isPowerOf2_32(NewNumBuckets) && NewNumBuckets >= Group::Width &&
+           getMaxEntries(NewNumBuckets) >= NumEntries && "Bad table size!");
+    int8_t *OldCtrl = Ctrl;
+    BucketT *OldBuckets = Buckets;
+    unsigned OldNumBuckets = NumBuckets;
+
+    allocateBuckets(NewNumBuckets);
+    for (unsigned I = 0; I != OldNumBuckets; ++I) {
+      if (OldCtrl[I] < 0)
+        continue;
+      BucketT *Old = OldBuckets + I;
+      uint64_t Hash = getHash(Old->getFirst());
+      size_t Idx = findFreeBucket(Hash);
+      Ctrl[Idx] = getControlByte(Hash);
+      constructBucket(Buckets + Idx, std::move(Old->getFirst()),
+                      std::move(Old->getSecond()));
+      destroyBucket(Old);
+    }
+    GrowthLeft -= NumEntries;
+
+    operator delete(OldCtrl);
+  }
+
+  /// Make this map, which owns no table, a copy of \p Other, bucket for
+  /// bucket.
+  void copyFrom(const SwissMap &Other) {
+    allocateBuckets(Other.NumBuckets);
+    NumEntries = Other.NumEntries;
+    GrowthLeft = Other.GrowthLeft;
+    if (NumBuckets == 0)
+      return;
+    std::memcpy(Ctrl, Other.Ctrl, NumBuckets);
+    if (isPodLike<KeyT>::value && isPodLike<ValueT>::value) {
+      std::memcpy(reinterpret_cast<void *>(Buckets), Other.Buckets,
+                  NumBuckets * sizeof(BucketT));
+      return;
+    }
+    for (unsigned I = 0; I != NumBuckets; ++I)
+      if (Ctrl[I] >= 0)
+        constructBucket(Buckets + I, Other.Buckets[I].getFirst(),
+                        Other.Buckets[I].getSecond());
+  }
+};
+
+template <typename KeyT, typename ValueT, typename KeyInfoT, typename BucketT,
+          bool IsConst>
+class SwissMapIterator : DebugEpochBase::HandleBase {
+  friend class SwissMapIterator<KeyT, ValueT, KeyInfoT, BucketT, true>;
+  friend class SwissMapIterator<KeyT, ValueT, KeyInfoT, BucketT, false>;
+
+  using ConstIterator = SwissMapIterator<KeyT, ValueT, KeyInfoT, BucketT, true>;
+
+public:
+  using difference_type = ptrdiff_t;
+  using value_type =
+      typename std::conditional<IsConst, const BucketT, BucketT>::type;
+  using pointer = value_type *;
+  using reference = value_type &;
+  using iterator_category = std::forward_iterator_tag;
+
+private:
+  const int8_t *Ctrl = nullptr;
+  pointer Ptr = nullptr;
+  pointer End = nullptr;
+
+public:
+  SwissMapIterator() = default;
+
+  SwissMapIterator(const int8_t *C, pointer Pos, pointer E,
+                   const DebugEpochBase &Epoch, bool NoAdvance = false)
+      : DebugEpochBase::HandleBase(&Epoch), Ctrl(C), Ptr(Pos), End(E) {
+    assert(isHandleInSync() && "invalid construction!");
+    if (!NoAdvance)
+      AdvancePastEmptyBuckets();
+  }
+
+  // Converting ctor from non-const iterators to const iterators. SFINAE'd out
+  // for const iterator destinations so it doesn't end up as a user defined copy
+  // constructor.
+  template <bool IsConstSrc,
+            typename = typename std::enable_if<!IsConstSrc && IsConst>::type>
+  SwissMapIterator(
+      const SwissMapIterator<KeyT, ValueT, KeyInfoT, BucketT, IsConstSrc> &I)
+      : DebugEpochBase::HandleBase(I), Ctrl(I.Ctrl), Ptr(I.Ptr), End(I.End) {}
+
+  reference operator*() const {
+    assert(isHandleInSync() && "invalid iterator access!");
+    return *Ptr;
+  }
+  pointer operator->() const {
+    assert(isHandleInSync() && "invalid iterator access!");
+    return Ptr;
+  }
+
+  bool operator==(const ConstIterator &RHS) const {
+    assert((!Ptr || isHandleInSync()) && "handle not in sync!");
+    assert((!RHS.Ptr || RHS.isHandleInSync()) && "handle not in sync!");
+    assert(getEpochAddress() == RHS.getEpochAddress() &&
+           "comparing incomparable iterators!");
+    return Ptr == RHS.Ptr;
+  }
+  bool operator!=(const ConstIterator &RHS) const {
+    return !(*this == RHS);
+  }
+
+  SwissMapIterator &operator++() { // Preincrement
+    assert(isHandleInSync() && "invalid iterator access!");
+    ++Ctrl;
+    ++Ptr;
+    AdvancePastEmptyBuckets();
+    return *this;
+  }
+  SwissMapIterator operator++(int) { // Postincrement
+    assert(isHandleInSync() && "invalid iterator access!");
+    SwissMapIterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+private:
+  void AdvancePastEmptyBuckets() {
+    assert(Ptr <= End);
+    while (Ptr != End && *Ctrl < 0) {
+      ++Ctrl;
+      ++Ptr;
+    }
+  }
+};
+
+template <typename KeyT, typename ValueT, typename KeyInfoT>
+static inline size_t
+capacity_in_bytes(const SwissMap<KeyT, ValueT, KeyInfoT> &X) {
+  return X.getMemorySize();
+}
+
+} // end namespace llvm
+
+#endif // LLVM_ADT_SWISSMAP_H
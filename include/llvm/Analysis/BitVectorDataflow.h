@@ -0,0 +1,112 @@
+//===- BitVectorDataflow.h - Generic bit-vector dataflow solver -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a generic solver for classic gen/kill dataflow problems
+// whose lattice is a dense bit vector, such as reaching definitions,
+// liveness or definite initialization.
+//
+// A client describes its problem by subclassing BitVectorDataflowProblem. The
+// solver computes the local gen and kill sets of every block once and then
+// iterates a worklist in reverse post-order (post-order for backward
+// problems) until a fixed point is reached for the function being solved.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_BITVECTORDATAFLOW_H
+#define LLVM_ANALYSIS_BITVECTORDATAFLOW_H
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include <vector>
+
+namespace llvm {
+
+class BasicBlock;
+class Function;
+
+/// BitVectorDataflowProblem - This class is implemented by a dataflow client
+/// to describe the direction, meet operator and local effect of each block.
+///
+/// For a forward problem the solver computes, for every block,
+///   In  = meet of Out over all predecessors (or the boundary value if the
+///         block has no predecessors)
+///   Out = Gen | (In & ~Kill)
+/// Backward problems are solved the same way with the roles of predecessors
+/// and successors, and of In and Out, exchanged.
+class BitVectorDataflowProblem {
+public:
+  enum class Direction { Forward, Backward };
+  enum class Meet { Union, Intersection };
+
+private:
+  Direction Dir;
+  Meet MeetOp;
+
+public:
+  BitVectorDataflowProblem(Direction Dir, Meet MeetOp)
+      : Dir(Dir), MeetOp(MeetOp) {}
+
+  virtual ~BitVectorDataflowProblem();
+
+  Direction getDirection() const { return Dir; }
+  Meet getMeet() const { return MeetOp; }
+
+  /// getNumBits - Return the number of facts tracked by the lattice.
+  virtual unsigned getNumBits() const = 0;
+
+  /// computeLocalSets - Fill in the facts generated and killed by \p BB. Both
+  /// vectors are sized to getNumBits() and cleared on entry.
+  virtual void computeLocalSets(const BasicBlock &BB, BitVector &Gen,
+                                BitVector &Kill) = 0;
+
+  /// initializeBoundary - Fill in the value flowing into blocks without
+  /// incoming edges: the entry block for forward problems and the exiting
+  /// blocks for backward problems. The vector is cleared on entry, so the
+  /// default boundary is the empty set.
+  virtual void initializeBoundary(BitVector &Boundary) {}
+};
+
+/// BitVectorDataflow - Solve a BitVectorDataflowProblem over one function and
+/// hold the resulting In and Out sets of each block.
+///
+/// Every block of the function is solved, including blocks that are not
+/// reachable from the entry block; those are visited after all reachable
+/// blocks.
+class BitVectorDataflow {
+  struct BlockState {
+    BitVector In, Out, Gen, Kill;
+  };
+
+  /// Position of each block in the visit order.
+  DenseMap<const BasicBlock *, unsigned> BlockNumbers;
+  std::vector<const BasicBlock *> Order;
+  std::vector<BlockState> States;
+  unsigned NumBlockVisits = 0;
+
+public:
+  /// solve - Compute the fixed point of \p P over \p F, replacing any
+  /// previous result.
+  void solve(const Function &F, BitVectorDataflowProblem &P);
+
+  /// getIn - Return the facts that hold on entry to \p BB.
+  const BitVector &getIn(const BasicBlock *BB) const;
+
+  /// getOut - Return the facts that hold on exit from \p BB.
+  const BitVector &getOut(const BasicBlock *BB) const;
+
+  /// getNumBlockVisits - Return how many times the transfer function of a
+  /// block was evaluated by the last call to solve().
+  unsigned getNumBlockVisits() const { return NumBlockVisits; }
+
+  void clear();
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ANALYSIS_BITVECTORDATAFLOW_H
@@ -0,0 +1,144 @@
+//===- BlockReachability.h - Precomputed CFG reachability -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the BlockReachability analysis, which precomputes the
+// transitive closure of a function's CFG so that "is block B reachable from
+// block A" can be answered in constant time.
+//
+// The closure is built once per function by condensing the CFG into its
+// strongly connected components (using an iterative Tarjan walk, so deep CFGs
+// cannot overflow the stack) and propagating one bit vector per component in
+// reverse topological order. Building it costs O(E * S / W) time and
+// O(S * S / W) bits of storage, where S is the number of components and W the
+// machine word size.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_BLOCKREACHABILITY_H
+#define LLVM_ANALYSIS_BLOCKREACHABILITY_H
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Pass.h"
+#include <vector>
+
+namespace llvm {
+
+class BasicBlock;
+class Function;
+class raw_ostream;
+
+/// \brief Constant-time reachability queries between the basic blocks of a
+/// single function.
+///
+/// Every block of the function is indexed, including blocks that are not
+/// reachable from the entry block. A block is always considered reachable from
+/// itself.
+class BlockReachability {
+  /// The function this index was computed for.
+  const Function *Fn = nullptr;
+
+  /// The strongly connected component each block belongs to. Components are
+  /// numbered in the order Tarjan's algorithm completes them, so every
+  /// component reachable from component N has a number not greater than N.
+  DenseMap<const BasicBlock *, unsigned> SCCNumbers;
+
+  /// For each component, the set of components reachable from it (including
+  /// itself).
+  std::vector<BitVector> Reachable;
+
+  /// Whether each component contains a cycle, i.e. has more than one block or
+  /// a block that branches to itself.
+  BitVector Cyclic;
+
+public:
+  BlockReachability() = default;
+  explicit BlockReachability(const Function &F) { recalculate(F); }
+
+  /// \brief Recompute the reachability index for \p F.
+  void recalculate(const Function &F);
+
+  /// \brief Return true if \p To can be reached from \p From by following zero
+  /// or more CFG edges.
+  ///
+  /// Both blocks must belong to the function this index was computed for.
+  bool isReachable(const BasicBlock *From, const BasicBlock *To) const;
+
+  /// \brief Return true if \p BB lies on a CFG cycle.
+  bool isInCycle(const BasicBlock *BB) const;
+
+  /// \brief Return the number of strongly connected components in the CFG.
+  unsigned getNumSCCs() const { return Reachable.size(); }
+
+  /// \brief Return the strongly connected component \p BB belongs to.
+  unsigned getSCCNumber(const BasicBlock *BB) const;
+
+  void releaseMemory();
+
+  void print(raw_ostream &OS) const;
+
+  /// Handle invalidation explicitly.
+  bool invalidate(Function &F, const PreservedAnalyses &PA,
+                  FunctionAnalysisManager::Invalidator &);
+};
+
+/// \brief Analysis pass which computes a \c BlockReachability index.
+class BlockReachabilityAnalysis
+    : public AnalysisInfoMixin<BlockReachabilityAnalysis> {
+  friend AnalysisInfoMixin<BlockReachabilityAnalysis>;
+
+  static AnalysisKey Key;
+
+public:
+  /// \brief Provide the result type for this analysis pass.
+  using Result = BlockReachability;
+
+  /// \brief Run the analysis pass over a function and produce its
+  ///        reachability index.
+  BlockReachability run(Function &F, FunctionAnalysisManager &);
+};
+
+/// \brief Printer pass for the \c BlockReachability index.
+class BlockReachabilityPrinterPass
+    : public PassInfoMixin<BlockReachabilityPrinterPass> {
+  raw_ostream &OS;
+
+public:
+  explicit BlockReachabilityPrinterPass(raw_ostream &OS);
+
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+/// \brief Legacy analysis pass which computes a \c BlockReachability index.
+class BlockReachabilityWrapperPass : public FunctionPass {
+  BlockReachability BR;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+
+  BlockReachabilityWrapperPass();
+
+  BlockReachability &getReachability() { return BR; }
+  const BlockReachability &getReachability() const { return BR; }
+
+  bool runOnFunction(Function &F) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  void releaseMemory() override { BR.releaseMemory(); }
+
+  void print(raw_ostream &OS, const Module * = nullptr) const override;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ANALYSIS_BLOCKREACHABILITY_H
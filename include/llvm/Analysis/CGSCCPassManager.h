@@ -98,6 +98,7 @@
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/InstructionArena.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/ValueHandle.h"
 #include "llvm/Support/Debug.h"
@@ -600,7 +601,11 @@ public:
       if (CG.lookupSCC(*N) != CurrentC)
         continue;
 
-      PreservedAnalyses PassPA = Pass.run(N->getFunction(), FAM);
+      PreservedAnalyses PassPA;
+      {
+        InstructionArenaScope Arena(N->getFunction());
+        PassPA = Pass.run(N->getFunction(), FAM);
+      }
 
       // We know that the function pass couldn't have invalidated any other
       // function's analyses (that's the contract of a function pass), so
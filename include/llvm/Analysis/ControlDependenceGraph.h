@@ -0,0 +1,137 @@
+//===- ControlDependenceGraph.h - Control dependence analysis ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ControlDependenceGraph analysis, which records for
+// every basic block the branches that decide whether it executes.
+//
+// Block B is control dependent on block A if and only if A is in the
+// post-dominance frontier of B. The frontiers are computed edge by edge from
+// the post-dominator tree: for every CFG edge A -> S, every block on the
+// post-dominator tree path from S up to (but excluding) the immediate
+// post-dominator of A is control dependent on A. This costs time proportional
+// to the number of CFG edges plus the size of the resulting graph.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_CONTROLDEPENDENCEGRAPH_H
+#define LLVM_ANALYSIS_CONTROLDEPENDENCEGRAPH_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Pass.h"
+
+namespace llvm {
+
+class BasicBlock;
+class Function;
+class PostDominatorTree;
+class raw_ostream;
+
+/// \brief The control dependence relation between the basic blocks of a
+/// single function.
+class ControlDependenceGraph {
+public:
+  using BlockListT = SmallVector<BasicBlock *, 2>;
+
+private:
+  /// The function this graph was computed for.
+  const Function *Fn = nullptr;
+
+  /// For each block, the blocks whose terminators it is control dependent on.
+  DenseMap<const BasicBlock *, BlockListT> Controllers;
+
+  /// For each block, the blocks that are control dependent on its terminator.
+  DenseMap<const BasicBlock *, BlockListT> Dependents;
+
+public:
+  ControlDependenceGraph() = default;
+  ControlDependenceGraph(const Function &F, const PostDominatorTree &PDT) {
+    recalculate(F, PDT);
+  }
+
+  /// \brief Recompute the control dependences of \p F from its post-dominator
+  /// tree \p PDT.
+  void recalculate(const Function &F, const PostDominatorTree &PDT);
+
+  /// \brief Return the blocks \p BB is control dependent on, in function
+  /// order.
+  ArrayRef<BasicBlock *> getControllingBlocks(const BasicBlock *BB) const;
+
+  /// \brief Return the blocks that are control dependent on \p BB, in function
+  /// order.
+  ArrayRef<BasicBlock *> getDependentBlocks(const BasicBlock *BB) const;
+
+  /// \brief Return true if \p BB is control dependent on \p Controller.
+  bool isControlDependent(const BasicBlock *BB,
+                          const BasicBlock *Controller) const;
+
+  void releaseMemory();
+
+  void print(raw_ostream &OS) const;
+
+  /// Handle invalidation explicitly.
+  bool invalidate(Function &F, const PreservedAnalyses &PA,
+                  FunctionAnalysisManager::Invalidator &);
+};
+
+/// \brief Analysis pass which computes a \c ControlDependenceGraph.
+class ControlDependenceAnalysis
+    : public AnalysisInfoMixin<ControlDependenceAnalysis> {
+  friend AnalysisInfoMixin<ControlDependenceAnalysis>;
+
+  static AnalysisKey Key;
+
+public:
+  /// \brief Provide the result type for this analysis pass.
+  using Result = ControlDependenceGraph;
+
+  /// \brief Run the analysis pass over a function and produce its control
+  ///        dependence graph.
+  ControlDependenceGraph run(Function &F, FunctionAnalysisManager &AM);
+};
+
+/// \brief Printer pass for the \c ControlDependenceGraph.
+class ControlDependencePrinterPass
+    : public PassInfoMixin<ControlDependencePrinterPass> {
+  raw_ostream &OS;
+
+public:
+  explicit ControlDependencePrinterPass(raw_ostream &OS);
+
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+/// \brief Legacy analysis pass which computes a \c ControlDependenceGraph.
+class ControlDependenceWrapperPass : public FunctionPass {
+  ControlDependenceGraph CDG;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+
+  ControlDependenceWrapperPass();
+
+  ControlDependenceGraph &getControlDependenceGraph() { return CDG; }
+  const ControlDependenceGraph &getControlDependenceGraph() const {
+    return CDG;
+  }
+
+  bool runOnFunction(Function &F) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+  void releaseMemory() override { CDG.releaseMemory(); }
+
+  void print(raw_ostream &OS, const Module * = nullptr) const override;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ANALYSIS_CONTROLDEPENDENCEGRAPH_H
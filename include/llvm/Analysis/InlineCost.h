@@ -19,6 +19,7 @@
 #include "llvm/Analysis/OptimizationDiagnosticInfo.h"
 #include <cassert>
 #include <climits>
+#include <memory>
 
 namespace llvm {
 class AssumptionCacheTracker;
@@ -26,6 +27,7 @@ class BlockFrequencyInfo;
 class CallSite;
 class DataLayout;
 class Function;
+class InlineCostCacheImpl;
 class ProfileSummaryInfo;
 class TargetTransformInfo;
 
@@ -154,6 +156,38 @@ struct InlineParams {
   Optional<int> ColdCallSiteThreshold;
 };
 
+/// \brief A cache of what the inline cost analysis learned from walking the
+/// body of each callee.
+///
+/// The walk over the callee body is the expensive part of computing an inline
+/// cost, and it depends on the call site only through what the arguments of
+/// the callee are bound to. Its result is kept for each callee and each way of
+/// binding the arguments the callee uses, and reused for every call site that
+/// binds them the same way. Call sites passing a constant to an argument that
+/// is used are not cached, as the constant is folded through the body.
+///
+/// A cache must only be used with one set of \c InlineParams, and whoever
+/// holds it must \c invalidate every function whose body they change. Deleted
+/// functions drop out of the cache by themselves.
+class InlineCostCache {
+  std::unique_ptr<InlineCostCacheImpl> Impl;
+
+public:
+  InlineCostCache();
+  InlineCostCache(InlineCostCache &&Arg);
+  InlineCostCache &operator=(InlineCostCache &&RHS);
+  ~InlineCostCache();
+
+  /// Forget what was learned about the body of \p F.
+  void invalidate(const Function &F);
+
+  /// Forget everything.
+  void clear();
+
+  /// The cached walks, which only the inline cost analysis looks into.
+  InlineCostCacheImpl &getImpl() { return *Impl; }
+};
+
 /// Generate the parameters to tune the inline cost analysis based only on the
 /// commandline options.
 InlineParams getInlineParams();
@@ -185,12 +219,14 @@ int getCallsiteCost(CallSite CS, const DataLayout &DL);
 /// sufficiently low to warrant inlining.
 ///
 /// Also note that calling this function *dynamically* computes the cost of
-/// inlining the callsite. It is an expensive, heavyweight call.
+/// inlining the callsite. It is an expensive, heavyweight call, unless \p Cache
+/// already knows the callee.
 InlineCost getInlineCost(
     CallSite CS, const InlineParams &Params, TargetTransformInfo &CalleeTTI,
     std::function<AssumptionCache &(Function &)> &GetAssumptionCache,
     Optional<function_ref<BlockFrequencyInfo &(Function &)>> GetBFI,
-    ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE = nullptr);
+    ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE = nullptr,
+    InlineCostCache *Cache = nullptr);
 
 /// \brief Get an InlineCost with the callee explicitly specified.
 /// This allows you to calculate the cost of inlining a function via a
@@ -202,7 +238,8 @@ getInlineCost(CallSite CS, Function *Callee, const InlineParams &Params,
               TargetTransformInfo &CalleeTTI,
               std::function<AssumptionCache &(Function &)> &GetAssumptionCache,
               Optional<function_ref<BlockFrequencyInfo &(Function &)>> GetBFI,
-              ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE);
+              ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE,
+              InlineCostCache *Cache = nullptr);
 
 /// \brief Minimal filter to detect invalid constructs for inlining.
 bool isInlineViable(Function &Callee);
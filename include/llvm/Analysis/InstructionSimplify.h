@@ -42,6 +42,7 @@ class AssumptionCache;
 class DominatorTree;
 class Instruction;
 class ImmutableCallSite;
+class KnownBitsCache;
 class DataLayout;
 class FastMathFlags;
 struct LoopStandardAnalysisResults;
@@ -57,6 +58,9 @@ struct SimplifyQuery {
   const DominatorTree *DT = nullptr;
   AssumptionCache *AC = nullptr;
   const Instruction *CxtI = nullptr;
+  /// Memo for the known bits queries made while simplifying. See
+  /// KnownBitsCache for when a client may keep one across changes to the IR.
+  KnownBitsCache *KBCache = nullptr;
 
   SimplifyQuery(const DataLayout &DL, const Instruction *CXTI = nullptr)
       : DL(DL), CxtI(CXTI) {}
@@ -64,8 +68,9 @@ struct SimplifyQuery {
   SimplifyQuery(const DataLayout &DL, const TargetLibraryInfo *TLI,
                 const DominatorTree *DT = nullptr,
                 AssumptionCache *AC = nullptr,
-                const Instruction *CXTI = nullptr)
-      : DL(DL), TLI(TLI), DT(DT), AC(AC), CxtI(CXTI) {}
+                const Instruction *CXTI = nullptr,
+                KnownBitsCache *KBCache = nullptr)
+      : DL(DL), TLI(TLI), DT(DT), AC(AC), CxtI(CXTI), KBCache(KBCache) {}
   SimplifyQuery getWithInstruction(Instruction *I) const {
     SimplifyQuery Copy(*this);
     Copy.CxtI = I;
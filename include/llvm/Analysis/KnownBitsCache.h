@@ -0,0 +1,107 @@
+//===- llvm/Analysis/KnownBitsCache.h - Memoize known bits ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines KnownBitsCache, which lets the clients of ValueTracking
+// memoize the results of computeKnownBits and ComputeNumSignBits.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_KNOWNBITSCACHE_H
+#define LLVM_ANALYSIS_KNOWNBITSCACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/KnownBits.h"
+#include <utility>
+
+namespace llvm {
+
+class Instruction;
+class Value;
+
+/// \brief A cache of the known bits and sign bits of the values of a function.
+///
+/// computeKnownBits and ComputeNumSignBits recurse through the operands of a
+/// value up to a fixed depth and keep nothing, so an expression DAG is walked
+/// once for every path through it, and again for every query that reaches it.
+/// Passing a cache to them records the answer for each value, context
+/// instruction and depth they visit, and answers later queries for the same
+/// triple from the cache. The answers are the same as without the cache.
+///
+/// A cache belongs to one function and must always be used with the same
+/// DataLayout, AssumptionCache and DominatorTree. Deleting an instruction or
+/// argument the cache has seen clears the cache through a value handle.
+/// Replacing all uses of a value needs nothing: the replacement refines the
+/// value, so what was known stays true. Any other change to an instruction,
+/// such as to one of its operands or flags, may invalidate what is known about
+/// it and its users, and the client must clear() the cache when it makes one.
+class KnownBitsCache {
+  class DeletionCallbackVH final : public CallbackVH {
+    KnownBitsCache *Cache;
+    void deleted() override;
+
+  public:
+    using DMI = DenseMapInfo<Value *>;
+
+    DeletionCallbackVH(Value *V, KnownBitsCache *Cache = nullptr)
+        : CallbackVH(V), Cache(Cache) {}
+  };
+
+  friend DeletionCallbackVH;
+
+  using KeyT = std::pair<std::pair<const Value *, const Instruction *>,
+                         unsigned>;
+
+  DenseMap<KeyT, KnownBits> KnownBitsMap;
+  DenseMap<KeyT, unsigned> NumSignBitsMap;
+
+  /// The values that appear in the keys of the maps.
+  DenseSet<DeletionCallbackVH, DeletionCallbackVH::DMI> Watched;
+
+  void watch(const Value *V);
+
+  static KeyT getKey(const Value *V, const Instruction *CxtI, unsigned Depth) {
+    return std::make_pair(std::make_pair(V, CxtI), Depth);
+  }
+
+public:
+  KnownBitsCache() = default;
+  KnownBitsCache(const KnownBitsCache &) = delete;
+  KnownBitsCache &operator=(const KnownBitsCache &) = delete;
+
+  /// Return the known bits recorded for \p V at \p CxtI and \p Depth, or null
+  /// if there are none. The pointer is invalidated by the next insertion.
+  const KnownBits *lookupKnownBits(const Value *V, const Instruction *CxtI,
+                                   unsigned Depth) const {
+    auto I = KnownBitsMap.find(getKey(V, CxtI, Depth));
+    return I == KnownBitsMap.end() ? nullptr : &I->second;
+  }
+
+  /// Return the number of sign bits recorded for \p V at \p CxtI and \p Depth,
+  /// or zero if there is none.
+  unsigned lookupNumSignBits(const Value *V, const Instruction *CxtI,
+                             unsigned Depth) const {
+    return NumSignBitsMap.lookup(getKey(V, CxtI, Depth));
+  }
+
+  void insertKnownBits(const Value *V, const Instruction *CxtI, unsigned Depth,
+                       const KnownBits &Known);
+  void insertNumSignBits(const Value *V, const Instruction *CxtI,
+                         unsigned Depth, unsigned NumSignBits);
+
+  /// Forget everything, as needed after changing an instruction in place.
+  void clear();
+
+  bool empty() const { return KnownBitsMap.empty() && NumSignBitsMap.empty(); }
+};
+
+} // end namespace llvm
+
+#endif
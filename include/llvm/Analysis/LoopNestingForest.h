@@ -0,0 +1,203 @@
+//===- LoopNestingForest.h - Cycle nesting forest of a CFG ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the LoopNestingForest analysis, which finds every cycle of
+// a function's CFG, reducible or not, together with the blocks each cycle can
+// be entered through.
+//
+// LoopInfo only recognizes natural loops, whose header dominates the whole
+// loop, so cycles that can be entered in more than one place (as produced by
+// computed gotos or interpreter dispatch code) are missing from it. The forest
+// is built with Havlak's algorithm ("Nesting of Reducible and Irreducible
+// Loops", TOPLAS 1997): one depth-first walk and a union-find pass, in almost
+// linear time in the size of the CFG. Each cycle is headed by its block that
+// comes first in depth-first preorder; a reducible cycle is exactly the natural
+// loop of that header.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_LOOPNESTINGFOREST_H
+#define LLVM_ANALYSIS_LOOPNESTINGFOREST_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Pass.h"
+#include <memory>
+#include <vector>
+
+namespace llvm {
+
+class BasicBlock;
+class Function;
+class raw_ostream;
+
+/// \brief A cycle of the CFG and the cycles nested in it.
+class NestedCycle {
+  friend class LoopNestingForest;
+
+  BasicBlock *Header;
+  NestedCycle *Parent;
+  unsigned Depth;
+  bool Irreducible = false;
+  SmallVector<NestedCycle *, 4> SubCycles;
+  /// Every block of the cycle, including the blocks of nested cycles, in
+  /// depth-first preorder. The header comes first.
+  std::vector<BasicBlock *> Blocks;
+  /// The blocks of the cycle that have a predecessor outside of it, in
+  /// function order. The entry block of the function counts as entered from
+  /// outside.
+  SmallVector<BasicBlock *, 2> Entries;
+
+  NestedCycle(BasicBlock *Header, NestedCycle *Parent)
+      : Header(Header), Parent(Parent), Depth(Parent ? Parent->Depth + 1 : 1) {}
+
+public:
+  /// \brief Return the block of the cycle that comes first in depth-first
+  /// preorder. For a reducible cycle it dominates all the others.
+  BasicBlock *getHeader() const { return Header; }
+
+  /// \brief Return the innermost cycle containing this one, or null.
+  NestedCycle *getParent() const { return Parent; }
+
+  /// \brief Return the nesting depth; outermost cycles have depth 1.
+  unsigned getDepth() const { return Depth; }
+
+  /// \brief Return true if the cycle can be entered through a block other
+  /// than its header, i.e. it is not a natural loop.
+  bool isIrreducible() const { return Irreducible; }
+
+  /// \brief Return true if the cycle has more than one entry block.
+  bool isMultiEntry() const { return Entries.size() > 1; }
+
+  ArrayRef<NestedCycle *> getSubCycles() const { return SubCycles; }
+  ArrayRef<BasicBlock *> getBlocks() const { return Blocks; }
+  ArrayRef<BasicBlock *> getEntries() const { return Entries; }
+
+  /// \brief Return true if \p C is this cycle or is nested in it.
+  bool contains(const NestedCycle *C) const {
+    while (C && C->Depth > Depth)
+      C = C->Parent;
+    return C == this;
+  }
+
+  void print(raw_ostream &OS) const;
+};
+
+/// \brief The nesting forest of all the cycles of a single function.
+///
+/// Blocks that are not reachable from the entry block belong to no cycle.
+class LoopNestingForest {
+  /// Every cycle, outer cycles before the cycles nested in them.
+  std::vector<std::unique_ptr<NestedCycle>> Cycles;
+
+  /// The outermost cycles, in depth-first preorder of their headers.
+  std::vector<NestedCycle *> TopLevelCycles;
+
+  /// The innermost cycle of every block that is part of a cycle.
+  DenseMap<const BasicBlock *, NestedCycle *> BlockMap;
+
+public:
+  LoopNestingForest() = default;
+  explicit LoopNestingForest(const Function &F) { recalculate(F); }
+
+  /// \brief Recompute the forest for \p F.
+  void recalculate(const Function &F);
+
+  /// \brief Return the innermost cycle containing \p BB, or null.
+  NestedCycle *getCycleFor(const BasicBlock *BB) const {
+    return BlockMap.lookup(BB);
+  }
+
+  /// \brief Return the nesting depth of \p BB, zero if it is in no cycle.
+  unsigned getCycleDepth(const BasicBlock *BB) const {
+    NestedCycle *C = getCycleFor(BB);
+    return C ? C->getDepth() : 0;
+  }
+
+  ArrayRef<NestedCycle *> getTopLevelCycles() const { return TopLevelCycles; }
+
+  /// \brief Return the number of cycles at every depth.
+  unsigned getNumCycles() const { return Cycles.size(); }
+
+  /// \brief Return the number of cycles that are not natural loops.
+  unsigned getNumIrreducibleCycles() const;
+
+  /// \brief Return the number of cycles with more than one entry block.
+  unsigned getNumMultiEntryCycles() const;
+
+  /// \brief Visit every cycle, outer cycles before the cycles nested in them.
+  template <typename CallbackT> void forEachCycle(CallbackT Callback) const {
+    for (const std::unique_ptr<NestedCycle> &C : Cycles)
+      Callback(*C);
+  }
+
+  void releaseMemory();
+
+  void print(raw_ostream &OS) const;
+
+  /// Handle invalidation explicitly.
+  bool invalidate(Function &F, const PreservedAnalyses &PA,
+                  FunctionAnalysisManager::Invalidator &);
+};
+
+/// \brief Analysis pass which computes a \c LoopNestingForest.
+class LoopNestingForestAnalysis
+    : public AnalysisInfoMixin<LoopNestingForestAnalysis> {
+  friend AnalysisInfoMixin<LoopNestingForestAnalysis>;
+
+  static AnalysisKey Key;
+
+public:
+  /// \brief Provide the result type for this analysis pass.
+  using Result = LoopNestingForest;
+
+  /// \brief Run the analysis pass over a function and produce its loop
+  ///        nesting forest.
+  LoopNestingForest run(Function &F, FunctionAnalysisManager &);
+};
+
+/// \brief Printer pass for the \c LoopNestingForest.
+class LoopNestingForestPrinterPass
+    : public PassInfoMixin<LoopNestingForestPrinterPass> {
+  raw_ostream &OS;
+
+public:
+  explicit LoopNestingForestPrinterPass(raw_ostream &OS);
+
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+/// \brief Legacy analysis pass which computes a \c LoopNestingForest.
+class LoopNestingForestWrapperPass : public FunctionPass {
+  LoopNestingForest LNF;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+
+  LoopNestingForestWrapperPass();
+
+  LoopNestingForest &getLoopNestingForest() { return LNF; }
+  const LoopNestingForest &getLoopNestingForest() const { return LNF; }
+
+  bool runOnFunction(Function &F) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  void releaseMemory() override { LNF.releaseMemory(); }
+
+  void print(raw_ostream &OS, const Module * = nullptr) const override;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ANALYSIS_LOOPNESTINGFOREST_H
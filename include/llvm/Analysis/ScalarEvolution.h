@@ -727,6 +727,11 @@ private:
     /// subexpression.
     bool hasOperand(const SCEV *S, ScalarEvolution *SE) const;
 
+    /// Append the computed exact and maximum counts to \p Exprs, leaving out
+    /// the SCEVCouldNotCompute ones.
+    void getExpressions(SmallVectorImpl<const SCEV *> &Exprs,
+                        ScalarEvolution *SE) const;
+
     /// Invalidate this result and free associated memory.
     void clear();
   };
@@ -742,6 +747,18 @@ private:
   // Cache the calculated exit limits for the loops.
   DenseMap<ExitLimitQuery, ExitLimit> ExitLimits;
 
+  /// The loops whose cached backedge-taken count refers to an expression. The
+  /// integer part is true for PredicatedBackedgeTakenCounts. Forgetting an
+  /// expression only has to look at these loops instead of at every count.
+  /// The sets are not pruned when a count is dropped, so an entry may be
+  /// stale and the count must be checked again before it is erased.
+  DenseMap<const SCEV *, SmallPtrSet<PointerIntPair<const Loop *, 1, bool>, 4>>
+      BECountUsers;
+
+  /// The queries whose cached exit limit refers to an expression. Like
+  /// BECountUsers, the entries may be stale.
+  DenseMap<const SCEV *, SmallSetVector<ExitLimitQuery, 2>> ExitLimitUsers;
+
   /// This map contains entries for all of the PHI instructions that we
   /// attempt to compute constant evolutions for.  This allows us to avoid
   /// potentially expensive recomputation of these properties.  An instruction
@@ -880,6 +897,15 @@ private:
   /// with the purpose of returning complete information.
   const BackedgeTakenInfo &getPredicatedBackedgeTakenInfo(const Loop *L);
 
+  /// Record in BECountUsers that the backedge-taken count \p BTI of \p L
+  /// refers to each of its subexpressions.
+  void addBECountUsers(const Loop *L, bool Predicated,
+                       const BackedgeTakenInfo &BTI);
+
+  /// Record in ExitLimitUsers that the exit limit \p EL computed for \p Query
+  /// refers to each of its subexpressions.
+  void addExitLimitUsers(const ExitLimitQuery &Query, const ExitLimit &EL);
+
   /// Compute the number of times the specified loop will iterate.
   /// If AllowPredicates is set, we will create new SCEV predicates as
   /// necessary in order to return an exact answer.
@@ -0,0 +1,160 @@
+//===- SourceLineIndex.h - Source line table of a module --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the SourceLineIndex analysis, a line table of a module
+// built once from the debug locations of its instructions.
+//
+// Consecutive instructions of a block that come from the same source line are
+// folded into one range, so the table is usually much smaller than the module.
+// The ranges are kept in module order, which makes the ranges of a function
+// contiguous, and are also sorted by file and line, so the instructions of a
+// source line can be found by binary search instead of walking the module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_SOURCELINEINDEX_H
+#define LLVM_ANALYSIS_SOURCELINEINDEX_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Pass.h"
+#include <vector>
+
+namespace llvm {
+
+class Function;
+class Instruction;
+class Module;
+class raw_ostream;
+
+/// \brief Maps source lines to the instructions generated for them, and back.
+class SourceLineIndex {
+public:
+  /// \brief A run of consecutive instructions of one block that all come from
+  /// the same line of the same file.
+  struct LineRange {
+    unsigned File;
+    unsigned Line;
+    unsigned NumInstructions;
+    const Instruction *First;
+
+    /// \brief Return the last instruction of the range.
+    const Instruction *getLast() const;
+  };
+
+private:
+  /// File names, indexed by the File of a LineRange.
+  std::vector<StringRef> Files;
+  StringMap<unsigned> FileNumbers;
+
+  /// All ranges in module order.
+  std::vector<LineRange> Ranges;
+
+  /// The ranges of every function with debug locations, as [begin, end)
+  /// indices into Ranges.
+  DenseMap<const Function *, std::pair<unsigned, unsigned>> FunctionRanges;
+
+  /// Ranges sorted by file and line, then module order.
+  std::vector<const LineRange *> ByLine;
+
+public:
+  SourceLineIndex() = default;
+  explicit SourceLineIndex(const Module &M) { recalculate(M); }
+
+  SourceLineIndex(SourceLineIndex &&) = default;
+  SourceLineIndex &operator=(SourceLineIndex &&) = default;
+
+  /// \brief Rebuild the index for \p M.
+  void recalculate(const Module &M);
+
+  /// \brief Return the name of every file that has a line in the index.
+  ArrayRef<StringRef> getFiles() const { return Files; }
+
+  /// \brief Return the number of \p File, or -1 if it has no line.
+  int getFileNumber(StringRef File) const;
+
+  /// \brief Return all ranges, in module order.
+  ArrayRef<LineRange> ranges() const { return Ranges; }
+
+  /// \brief Return the ranges of \p F, in the order of its instructions.
+  ArrayRef<LineRange> ranges(const Function &F) const;
+
+  /// \brief Return the ranges of lines [\p BeginLine, \p EndLine) of \p File,
+  /// sorted by line.
+  ArrayRef<const LineRange *> lookup(StringRef File, unsigned BeginLine,
+                                     unsigned EndLine) const;
+
+  /// \brief Return the ranges of \p Line of \p File.
+  ArrayRef<const LineRange *> lookup(StringRef File, unsigned Line) const {
+    return lookup(File, Line, Line + 1);
+  }
+
+  /// \brief Return the source line of \p I, or 0 if it has no debug location.
+  static unsigned getLine(const Instruction &I);
+
+  void releaseMemory();
+
+  void print(raw_ostream &OS) const;
+};
+
+/// \brief Analysis pass which computes a \c SourceLineIndex.
+class SourceLineIndexAnalysis
+    : public AnalysisInfoMixin<SourceLineIndexAnalysis> {
+  friend AnalysisInfoMixin<SourceLineIndexAnalysis>;
+
+  static AnalysisKey Key;
+
+public:
+  /// \brief Provide the result type for this analysis pass.
+  using Result = SourceLineIndex;
+
+  /// \brief Run the analysis pass over a module and produce its line table.
+  SourceLineIndex run(Module &M, ModuleAnalysisManager &);
+};
+
+/// \brief Printer pass for the \c SourceLineIndex.
+class SourceLineIndexPrinterPass
+    : public PassInfoMixin<SourceLineIndexPrinterPass> {
+  raw_ostream &OS;
+
+public:
+  explicit SourceLineIndexPrinterPass(raw_ostream &OS);
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+};
+
+/// \brief Legacy analysis pass which computes a \c SourceLineIndex.
+class SourceLineIndexWrapperPass : public ModulePass {
+  SourceLineIndex Index;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+
+  SourceLineIndexWrapperPass();
+
+  SourceLineIndex &getSourceLineIndex() { return Index; }
+  const SourceLineIndex &getSourceLineIndex() const { return Index; }
+
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  void releaseMemory() override { Index.releaseMemory(); }
+
+  void print(raw_ostream &OS, const Module * = nullptr) const override;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_ANALYSIS_SOURCELINEINDEX_H
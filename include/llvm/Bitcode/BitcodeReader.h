@@ -180,6 +180,11 @@ namespace llvm {
   getModuleSummaryIndexForFile(StringRef Path,
                                bool IgnoreEmptyThinLTOIndexFile = false);
 
+  /// Set how many threads decode function blocks ahead of the reader when a
+  /// whole module is materialized, as -bitcode-reader-threads does. With zero
+  /// or one, the reader decodes every block itself.
+  void setBitcodeReaderThreads(unsigned Threads);
+
   /// isBitcodeWrapper - Return true if the given bytes are the magic bytes
   /// for an LLVM IR bitcode wrapper.
   ///
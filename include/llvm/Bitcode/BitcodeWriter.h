@@ -145,6 +145,11 @@ namespace llvm {
   void WriteIndexToFile(const ModuleSummaryIndex &Index, raw_ostream &Out,
                         const std::map<std::string, GVSummaryMapTy>
                             *ModuleToSummariesForIndex = nullptr);
+
+  /// Set how many threads encode the function blocks of a module, as
+  /// -bitcode-writer-threads does. With zero or one, the writer encodes every
+  /// block itself. The output is the same either way.
+  void setBitcodeWriterThreads(unsigned Threads);
 } // End llvm namespace
 
 #endif
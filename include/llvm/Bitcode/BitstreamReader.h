@@ -18,6 +18,7 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Bitcode/BitCodes.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
@@ -304,6 +305,46 @@ struct BitstreamEntry {
   }
 };
 
+/// The entries and decoded records of one block and the blocks nested in it,
+/// read ahead of time by BitstreamCursor::recordBlock. A cursor replaying a
+/// recording hands out the same entries and records it would have read from
+/// the stream, so the decoding work can be done on another thread.
+class BitstreamRecording {
+  friend class BitstreamCursor;
+
+  struct Entry {
+    BitstreamEntry Kind;
+
+    /// The record code, or the size in words of a block.
+    unsigned Code;
+
+    /// The operands of a record are Ops[FirstOp, FirstOp + NumOps).
+    unsigned NumOps;
+    size_t FirstOp;
+
+    /// For a block, the index of the entry after its end.
+    size_t SkipTo;
+
+    /// The blob of a record, with a null data pointer if it has none.
+    StringRef Blob;
+  };
+
+  std::vector<Entry> Entries;
+  std::vector<uint64_t> Ops;
+
+  /// The bit number right after the recorded block.
+  uint64_t EndBitNo = 0;
+
+public:
+  bool empty() const { return Entries.empty(); }
+
+  void clear() {
+    Entries.clear();
+    Ops.clear();
+    EndBitNo = 0;
+  }
+};
+
 /// This represents a position within a bitcode file, implemented on top of a
 /// SimpleBitstreamCursor.
 ///
@@ -329,6 +370,12 @@ class BitstreamCursor : SimpleBitstreamCursor {
 
   BitstreamBlockInfo *BlockInfo = nullptr;
 
+  /// The recording being replayed, if any, the index of its next entry, and
+  /// the number of its blocks that have been entered and not left.
+  const BitstreamRecording *Replay = nullptr;
+  size_t ReplayPos = 0;
+  unsigned ReplayDepth = 0;
+
 public:
   static const size_t MaxChunkSize = sizeof(word_t) * 8;
 
@@ -368,6 +415,9 @@ public:
 
   /// Advance the current bitstream, returning the next entry in the stream.
   BitstreamEntry advance(unsigned Flags = 0) {
+    if (LLVM_UNLIKELY(Replay))
+      return advanceReplay(Flags);
+
     while (true) {
       if (AtEndOfStream())
         return BitstreamEntry::getError();
@@ -425,6 +475,11 @@ public:
   /// Having read the ENTER_SUBBLOCK abbrevid and a BlockID, skip over the body
   /// of this block. If the block record is malformed, return true.
   bool SkipBlock() {
+    if (LLVM_UNLIKELY(Replay)) {
+      skipReplayBlock();
+      return false;
+    }
+
     // Read and ignore the codelen value.  Since we are skipping this block, we
     // don't care what code widths are used inside of it.
     ReadVBR(bitc::CodeLenWidth);
@@ -446,6 +501,11 @@ public:
   bool EnterSubBlock(unsigned BlockID, unsigned *NumWordsP = nullptr);
 
   bool ReadBlockEnd() {
+    if (LLVM_UNLIKELY(Replay)) {
+      popReplayBlock();
+      return false;
+    }
+
     if (BlockScope.empty()) return true;
 
     // Block tail:
@@ -464,6 +524,66 @@ private:
     BlockScope.pop_back();
   }
 
+  //===--------------------------------------------------------------------===//
+  // Recording and Replaying
+  //===--------------------------------------------------------------------===//
+
+public:
+  /// Having read the ENTER_SUBBLOCK abbrevid and the BlockID of a block, read
+  /// the block and every block nested in it into \p Recording, and leave the
+  /// cursor after the block. Return true if the block is malformed or holds a
+  /// block info block, which a recording cannot represent; the position of
+  /// the cursor is then unspecified.
+  bool recordBlock(unsigned BlockID, BitstreamRecording &Recording);
+
+  /// Replay \p Recording, which recordBlock made from the block whose
+  /// ENTER_SUBBLOCK abbrevid and BlockID were just read. Until the end of the
+  /// recorded block is read, advance, EnterSubBlock, SkipBlock, ReadBlockEnd,
+  /// readRecord and skipRecord return what they would have returned for the
+  /// block, without touching the stream. The bit position is already the one
+  /// after the block meanwhile. The recording must outlive the replay.
+  void replay(const BitstreamRecording &Recording) {
+    assert(!Recording.empty() && "Replaying an empty recording");
+    Replay = &Recording;
+    ReplayPos = 1;
+    ReplayDepth = 0;
+    JumpToBit(Recording.EndBitNo);
+  }
+
+  /// Return true if the cursor is replaying a recording.
+  bool isReplaying() const { return Replay != nullptr; }
+
+  /// Stop replaying, leaving the cursor after the recorded block.
+  void stopReplaying() { Replay = nullptr; }
+
+private:
+  const BitstreamRecording::Entry &getReplayEntry() const {
+    return Replay->Entries[ReplayPos - 1];
+  }
+
+  BitstreamEntry advanceReplay(unsigned Flags) {
+    assert(!(Flags & AF_DontAutoprocessAbbrevs) &&
+           "A recording holds no abbrevs");
+    BitstreamEntry Entry = Replay->Entries[ReplayPos++].Kind;
+    if (Entry.Kind == BitstreamEntry::EndBlock &&
+        !(Flags & AF_DontPopBlockAtEnd))
+      popReplayBlock();
+    return Entry;
+  }
+
+  void skipReplayBlock() {
+    assert(getReplayEntry().Kind.Kind == BitstreamEntry::SubBlock &&
+           "Not at the start of a block");
+    ReplayPos = getReplayEntry().SkipTo;
+    if (!ReplayDepth)
+      Replay = nullptr;
+  }
+
+  void popReplayBlock() {
+    if (!--ReplayDepth)
+      Replay = nullptr;
+  }
+
   //===--------------------------------------------------------------------===//
   // Record Processing
   //===--------------------------------------------------------------------===//
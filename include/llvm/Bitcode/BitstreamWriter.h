@@ -197,14 +197,28 @@ public:
     return nullptr;
   }
 
-  void EnterSubblock(unsigned BlockID, unsigned CodeLen) {
-    // Block header:
-    //    [ENTER_SUBBLOCK, blockid, newcodelen, <align4bytes>, blocklen]
+private:
+  void EmitSubblockHeader(unsigned BlockID, unsigned CodeLen) {
     EmitCode(bitc::ENTER_SUBBLOCK);
     EmitVBR(BlockID, bitc::BlockIDWidth);
     EmitVBR(CodeLen, bitc::CodeLenWidth);
     FlushToWord();
+  }
 
+public:
+  void EnterSubblock(unsigned BlockID, unsigned CodeLen) {
+    // Block header:
+    //    [ENTER_SUBBLOCK, blockid, newcodelen, <align4bytes>, blocklen]
+    EmitSubblockHeader(BlockID, CodeLen);
+    EnterSubblockBody(BlockID, CodeLen);
+  }
+
+  /// EnterSubblockBody - Enter a block without emitting the part of its header
+  /// in front of the block length, which is word aligned.  This allows a block
+  /// to be written to a separate stream, starting at a word boundary, and
+  /// spliced into the stream it belongs to with EmitSubblockBody once
+  /// ExitBlock has finished it.
+  void EnterSubblockBody(unsigned BlockID, unsigned CodeLen) {
     size_t BlockSizeWordIndex = GetWordIndex();
     unsigned OldCodeSize = CurCodeSize;
 
@@ -248,6 +262,18 @@ public:
     BlockScope.pop_back();
   }
 
+  /// EmitSubblockBody - Emit a block whose body, from the block length to the
+  /// end of the block, was written with EnterSubblockBody and ExitBlock.  The
+  /// result is the same as writing the block here with EnterSubblock, as long
+  /// as the body was written with the same blockinfo abbrevs as this stream
+  /// has, see CopyBlockInfo.
+  void EmitSubblockBody(unsigned BlockID, unsigned CodeLen,
+                        ArrayRef<char> Body) {
+    assert(Body.size() % 4 == 0 && "Block body is not word aligned");
+    EmitSubblockHeader(BlockID, CodeLen);
+    Out.append(Body.begin(), Body.end());
+  }
+
   //===--------------------------------------------------------------------===//
   // Record Emission
   //===--------------------------------------------------------------------===//
@@ -507,6 +533,12 @@ public:
     BlockInfoCurBID = ~0U;
     BlockInfoRecords.clear();
   }
+  /// CopyBlockInfo - Make the abbrevs that the BLOCKINFO_BLOCK of \p Other
+  /// defined available to the blocks of this stream, without emitting them.
+  void CopyBlockInfo(const BitstreamWriter &Other) {
+    BlockInfoRecords = Other.BlockInfoRecords;
+  }
+
 private:
   /// SwitchToBlockID - If we aren't already talking about the specified block
   /// ID, emit a BLOCKINFO_CODE_SETBID record.
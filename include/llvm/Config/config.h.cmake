@@ -140,6 +140,9 @@
 /* Define to 1 if you have the <malloc/malloc.h> header file. */
 #cmakedefine HAVE_MALLOC_MALLOC_H ${HAVE_MALLOC_MALLOC_H}
 
+/* Define to 1 if you have the `malloc_usable_size' function. */
+#cmakedefine HAVE_MALLOC_USABLE_SIZE ${HAVE_MALLOC_USABLE_SIZE}
+
 /* Define to 1 if you have the `malloc_zone_statistics' function. */
 #cmakedefine HAVE_MALLOC_ZONE_STATISTICS ${HAVE_MALLOC_ZONE_STATISTICS}
 
@@ -47,6 +47,7 @@ namespace llvm {
 class AssemblyAnnotationWriter;
 class Constant;
 class DISubprogram;
+class InstructionArena;
 class LLVMContext;
 class Module;
 template <typename T> class Optional;
@@ -73,6 +74,7 @@ private:
   std::unique_ptr<ValueSymbolTable>
       SymTab;                             ///< Symbol table of args/instructions
   AttributeList AttributeSets;            ///< Parameter attributes
+  InstructionArena *Arena = nullptr;      ///< Memory of new instructions
 
   /*
    * Value::SubclassData
@@ -574,6 +576,10 @@ public:
     return SymTab.get();
   }
 
+  /// getInstructionArena() - Return the arena the instructions created while
+  /// passes run on this function are allocated from, creating it if needed.
+  InstructionArena *getInstructionArena();
+
   //===--------------------------------------------------------------------===//
   // BasicBlock iterator forwarding functions
   //
@@ -54,6 +54,12 @@ class Instruction : public User,
 protected:
   ~Instruction(); // Use deleteValue() to delete a generic Instruction.
 
+  /// Allocate an instruction like the User overloads do, but from the current
+  /// InstructionArena of this thread if there is one.
+  void *operator new(size_t Size);
+  void *operator new(size_t Size, unsigned Us);
+  void *operator new(size_t Size, unsigned Us, unsigned DescBytes);
+
 public:
   Instruction(const Instruction &) = delete;
   Instruction &operator=(const Instruction &) = delete;
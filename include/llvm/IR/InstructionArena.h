@@ -0,0 +1,112 @@
+//===- llvm/IR/InstructionArena.h - Instruction memory ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares InstructionArena, a slab allocator for the instructions
+// of one function and their operands, and InstructionArenaScope, which makes
+// the arena of a function the one new instructions are allocated from.
+//
+// Arenas are enabled with -instruction-arenas. The pass managers open a scope
+// for every function they run function passes on, so the instructions that
+// the passes create, and the operand lists they grow, are carved out of slabs
+// owned by the function instead of taking a trip through malloc each. Freed
+// blocks are kept on per-size free lists and reused by later allocations of
+// the same size, and the slabs are released all at once when the function and
+// every instruction allocated from its arena are gone.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_INSTRUCTIONARENA_H
+#define LLVM_IR_INSTRUCTIONARENA_H
+
+#include "llvm/Support/Allocator.h"
+#include <atomic>
+#include <cstddef>
+
+namespace llvm {
+
+class Function;
+
+/// \brief The memory of the instructions of one function.
+///
+/// Only the thread running passes on the function allocates from its arena,
+/// and only that thread puts freed blocks back on the free lists. Blocks freed
+/// by any other thread, for example because an instruction was moved into
+/// another function, are simply dropped until the whole arena is released.
+class InstructionArena {
+  /// Blocks are handed out in multiples of this many bytes.
+  static const size_t Granule = 16;
+
+  /// Blocks of this many granules or more come from the heap.
+  static const unsigned NumSizeClasses = 64;
+
+  /// Every block starts with a header recording where it came from.
+  struct alignas(Granule) BlockHeader {
+    InstructionArena *Arena; ///< Null for heap blocks.
+    size_t SizeClass;
+  };
+
+  struct FreeBlock {
+    FreeBlock *Next;
+  };
+
+  BumpPtrAllocator Slabs;
+  FreeBlock *FreeLists[NumSizeClasses] = {};
+
+  /// The number of blocks allocated from the slabs and not freed yet, plus
+  /// one while the function exists.
+  std::atomic<size_t> RefCount;
+
+  InstructionArena() : RefCount(1) {}
+
+  void release();
+
+public:
+  InstructionArena(const InstructionArena &) = delete;
+  InstructionArena &operator=(const InstructionArena &) = delete;
+
+  /// \brief Create the arena of a function. The function calls \c destroy
+  /// when it is deleted.
+  static InstructionArena *create() { return new InstructionArena(); }
+  void destroy() { release(); }
+
+  /// \brief Allocate \p Size bytes from \p Arena, or from the heap if it is
+  /// null, with a header in front so that \c deallocate knows where they
+  /// came from.
+  static void *allocate(InstructionArena *Arena, size_t Size);
+
+  /// \brief Free a block returned by \c allocate.
+  static void deallocate(void *Ptr);
+
+  /// \brief Return the arena of the function the pass managers are running
+  /// passes on in this thread, or null if there is none or arenas are
+  /// disabled.
+  static InstructionArena *getCurrent();
+
+  /// \brief Return true if arenas are enabled, by -instruction-arenas or
+  /// \c setEnabled.
+  static bool isEnabled();
+  static void setEnabled(bool Enabled);
+};
+
+/// \brief Makes the arena of a function the current one of this thread for
+/// the lifetime of the scope. Does nothing if arenas are disabled.
+class InstructionArenaScope {
+  InstructionArena *Saved;
+  bool Active;
+
+public:
+  explicit InstructionArenaScope(Function &F);
+  InstructionArenaScope(const InstructionArenaScope &) = delete;
+  InstructionArenaScope &operator=(const InstructionArenaScope &) = delete;
+  ~InstructionArenaScope();
+};
+
+} // end namespace llvm
+
+#endif // LLVM_IR_INSTRUCTIONARENA_H
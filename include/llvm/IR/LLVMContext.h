@@ -164,6 +164,23 @@ public:
   void enableDebugTypeODRUniquing();
   void disableDebugTypeODRUniquing();
 
+  /// Whether constants, types, metadata strings and uniqued metadata nodes
+  /// may be created from several threads at once.  Off by default.
+  ///
+  /// In concurrent mode the uniquing tables of the context are guarded by
+  /// locks, and the tables of integer and floating point constants are split
+  /// into independently locked shards, so that threads running function
+  /// passes on different functions of a module can create them without
+  /// serializing on one lock.  Uniqued objects keep their identity: every
+  /// thread gets the same pointer for the same constant, type or node.
+  ///
+  /// Only the uniquing tables are guarded.  Use lists, value handles, value
+  /// names and metadata attachments of shared values are not, so threads must
+  /// still not modify IR that another thread can see.  The mode must not be
+  /// changed while other threads use the context.
+  bool hasConcurrentUniquing() const;
+  void setConcurrentUniquing(bool Concurrent);
+
   using InlineAsmDiagHandlerTy = void (*)(const SMDiagnostic&, void *Context,
                                           unsigned LocCookie);
 
@@ -99,7 +99,8 @@ private:
 DEFINE_STDCXX_CONVERSION_FUNCTIONS(legacy::PassManagerBase, LLVMPassManagerRef)
 
 /// If -time-passes has been specified, report the timings immediately and then
-/// reset the timers to zero.
+/// reset the timers to zero. The -track-pass-memory report is printed and
+/// reset along with them.
 void reportAndResetTimings();
 } // End llvm namespace
 
@@ -39,18 +39,24 @@
 #define LLVM_IR_PASSMANAGER_H
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/InstructionArena.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManagerInternal.h"
+#include "llvm/IR/PassMemoryInfo.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/TypeName.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <functional>
 #include <iterator>
 #include <list>
 #include <memory>
@@ -453,7 +459,11 @@ public:
         dbgs() << "Running pass: " << Passes[Idx]->name() << " on "
                << IR.getName() << "\n";
 
-      PreservedAnalyses PassPA = Passes[Idx]->run(IR, AM, ExtraArgs...);
+      PreservedAnalyses PassPA = PreservedAnalyses::none();
+      {
+        AllocationRegion PassMemory(getPassMemoryRecord(Passes[Idx]->name()));
+        PassPA = Passes[Idx]->run(IR, AM, ExtraArgs...);
+      }
 
       // Update the analysis manager as each pass runs and potentially
       // invalidates analyses.
@@ -861,7 +871,10 @@ private:
         dbgs() << "Running analysis: " << P.name() << " on " << IR.getName()
                << "\n";
       AnalysisResultListT &ResultList = AnalysisResultLists[&IR];
-      ResultList.emplace_back(ID, P.run(IR, *this, ExtraArgs...));
+      {
+        AllocationRegion PassMemory(getPassMemoryRecord(P.name()));
+        ResultList.emplace_back(ID, P.run(IR, *this, ExtraArgs...));
+      }
 
       // P.run may have inserted elements into AnalysisResults and invalidated
       // RI.
@@ -1157,6 +1170,15 @@ extern template class OuterAnalysisManagerProxy<ModuleAnalysisManager,
 using ModuleAnalysisManagerFunctionProxy =
     OuterAnalysisManagerProxy<ModuleAnalysisManager, Function>;
 
+namespace detail {
+
+/// \brief Run \p Body on \p NumThreads threads, one of them the calling
+/// thread, and return once every thread is done. Without thread support the
+/// body runs once on the calling thread.
+void runOnThreads(unsigned NumThreads, function_ref<void()> Body);
+
+} // end namespace detail
+
 /// \brief Trivial adaptor that maps from a module to its functions.
 ///
 /// Designed to allow composition of a FunctionPass(Manager) and
@@ -1180,24 +1202,62 @@ using ModuleAnalysisManagerFunctionProxy =
 /// Note that although function passes can access module analyses, module
 /// analyses are not invalidated while the function passes are running, so they
 /// may be stale.  Function analyses will not be stale.
+///
+/// The adaptor can optionally run the function pass over several functions at
+/// once. Passes and analysis managers are not thread safe, so every thread
+/// gets its own copy of the pass and its own function analysis manager from a
+/// setup callback; the module analysis manager is only read. The shared
+/// function analysis manager is updated in module order once all threads are
+/// done, so the outcome does not depend on the scheduling. The LLVMContext is
+/// put in concurrent uniquing mode while the threads run, so they can look up
+/// constants, types and metadata, and watch shared values with value handles.
+/// What each function writes to dbgs() is buffered and printed in module
+/// order once all threads are done. The use lists of constants and globals
+/// are still read without a lock, so this mode is only correct for analysis
+/// pipelines, which neither create constants or globals nor add or remove
+/// uses of them.
 template <typename FunctionPassT>
 class ModuleToFunctionPassAdaptor
     : public PassInfoMixin<ModuleToFunctionPassAdaptor<FunctionPassT>> {
 public:
+  /// \brief Callback building the state of one thread of the parallel mode.
+  ///
+  /// It must create a copy of the pass and a function analysis manager with
+  /// every analysis the pass needs registered, including a proxy to the given
+  /// module analysis manager, and call the given function with them. They are
+  /// destroyed when it returns.
+  using ThreadSetupT = std::function<void(
+      ModuleAnalysisManager &,
+      function_ref<void(FunctionPassT &, FunctionAnalysisManager &)>)>;
+
   explicit ModuleToFunctionPassAdaptor(FunctionPassT Pass)
       : Pass(std::move(Pass)) {}
 
+  /// \brief Create an adaptor that runs the pass on \p NumThreads functions
+  /// at once, with the per-thread state built by \p ThreadSetup.
+  ModuleToFunctionPassAdaptor(FunctionPassT Pass, unsigned NumThreads,
+                              ThreadSetupT ThreadSetup)
+      : Pass(std::move(Pass)), NumThreads(NumThreads),
+        ThreadSetup(std::move(ThreadSetup)) {}
+
   /// \brief Runs the function pass across every function in the module.
   PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM) {
     FunctionAnalysisManager &FAM =
         AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
 
+    if (NumThreads > 1 && ThreadSetup)
+      return runInParallel(M, AM, FAM);
+
     PreservedAnalyses PA = PreservedAnalyses::all();
     for (Function &F : M) {
       if (F.isDeclaration())
         continue;
 
-      PreservedAnalyses PassPA = Pass.run(F, FAM);
+      PreservedAnalyses PassPA;
+      {
+        InstructionArenaScope Arena(F);
+        PassPA = Pass.run(F, FAM);
+      }
 
       // We know that the function pass couldn't have invalidated any other
       // function's analyses (that's the contract of a function pass), so
@@ -1220,7 +1280,64 @@ public:
   }
 
 private:
+  PreservedAnalyses runInParallel(Module &M, ModuleAnalysisManager &AM,
+                                  FunctionAnalysisManager &FAM) {
+    std::vector<Function *> Functions;
+    for (Function &F : M)
+      if (!F.isDeclaration())
+        Functions.push_back(&F);
+
+    // Every thread takes the next function in module order until none is
+    // left, and only writes the slot of that function.
+    std::vector<PreservedAnalyses> Results(Functions.size());
+    std::vector<std::string> Outputs(Functions.size());
+    std::atomic<size_t> Next(0);
+    LLVMContext &Ctx = M.getContext();
+    bool WasConcurrent = Ctx.hasConcurrentUniquing();
+    Ctx.setConcurrentUniquing(true);
+    detail::runOnThreads(
+        std::min<size_t>(NumThreads, Functions.size()), [&] {
+          std::string Output;
+          raw_string_ostream OS(Output);
+          DebugStreamRedirect Redirect(OS);
+          ThreadSetup(AM, [&](FunctionPassT &ThreadPass,
+                              FunctionAnalysisManager &ThreadFAM) {
+            for (size_t I = Next++; I < Functions.size(); I = Next++) {
+              {
+                InstructionArenaScope Arena(*Functions[I]);
+                Results[I] = ThreadPass.run(*Functions[I], ThreadFAM);
+                // No other thread will see this function, and the results of
+                // the shared manager are updated below.
+                ThreadFAM.clear(*Functions[I]);
+              }
+              OS.flush();
+              Outputs[I].swap(Output);
+            }
+          });
+        });
+    Ctx.setConcurrentUniquing(WasConcurrent);
+
+    for (const std::string &Out : Outputs)
+      dbgs() << Out;
+
+    // A pass manager invalidates the analyses of the manager it ran with and
+    // then reports every function analysis as preserved, so the results of
+    // the shared manager can only be kept if nothing at all was invalidated.
+    PreservedAnalyses PA = PreservedAnalyses::all();
+    for (size_t I = 0, E = Functions.size(); I != E; ++I) {
+      if (!Results[I].areAllPreserved())
+        FAM.clear(*Functions[I]);
+      PA.intersect(std::move(Results[I]));
+    }
+
+    PA.preserveSet<AllAnalysesOn<Function>>();
+    PA.preserve<FunctionAnalysisManagerModuleProxy>();
+    return PA;
+  }
+
   FunctionPassT Pass;
+  unsigned NumThreads = 1;
+  ThreadSetupT ThreadSetup;
 };
 
 /// \brief A function to deduce a function pass type and wrap it in the
@@ -0,0 +1,39 @@
+//===- PassMemoryInfo.h - Heap allocations of each pass ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the interface the pass managers use to attribute heap
+// allocations to passes when -track-pass-memory is enabled. Each pass run is
+// wrapped in an AllocationRegion for the record returned here, and the records
+// are printed as a table next to the -time-passes report.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_PASSMEMORYINFO_H
+#define LLVM_IR_PASSMEMORYINFO_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/AllocationTracker.h"
+
+namespace llvm {
+
+class Pass;
+
+/// If -track-pass-memory is enabled, return the record the heap activity of
+/// the specified legacy pass is added to.
+AllocationCounts *getPassMemoryRecord(Pass *P);
+
+/// If -track-pass-memory is enabled, return the record the heap activity of
+/// the new pass manager pass or analysis called \p PassName is added to.
+/// Returns null for pass managers, adaptors and analysis manager proxies,
+/// which only run other passes.
+AllocationCounts *getPassMemoryRecord(StringRef PassName);
+
+} // end namespace llvm
+
+#endif // LLVM_IR_PASSMEMORYINFO_H
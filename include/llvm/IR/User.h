@@ -35,6 +35,7 @@ namespace llvm {
 
 template <typename T> class ArrayRef;
 template <typename T> class MutableArrayRef;
+class InstructionArena;
 
 /// \brief Compile-time customization of User operands.
 ///
@@ -47,7 +48,9 @@ class User : public Value {
   friend struct HungoffOperandTraits;
 
   LLVM_ATTRIBUTE_ALWAYS_INLINE inline static void *
-  allocateFixedOperandUser(size_t, unsigned, unsigned);
+  allocateFixedOperandUser(size_t, unsigned, unsigned, InstructionArena *);
+  LLVM_ATTRIBUTE_ALWAYS_INLINE inline static void *
+  allocateHungOffOperandUser(size_t, InstructionArena *);
 
 protected:
   /// Allocate a User with an operand pointer co-allocated.
@@ -71,6 +74,13 @@ protected:
   /// This is used for subclasses which have a fixed number of operands.
   void *operator new(size_t Size, unsigned Us, unsigned DescBytes);
 
+  /// Allocate a User like the operator new overloads above, but from \p
+  /// Arena.  Its hung off uses, if any, are allocated from the current
+  /// instruction arena of the thread that allocates them.
+  static void *allocateInArena(InstructionArena *Arena, size_t Size);
+  static void *allocateInArena(InstructionArena *Arena, size_t Size,
+                               unsigned Us, unsigned DescBytes = 0);
+
   User(Type *ty, unsigned vty, Use *, unsigned NumOps)
       : Value(ty, vty) {
     assert(NumOps < (1u << NumUserOperandsBits) && "Too many operands");
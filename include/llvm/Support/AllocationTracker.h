@@ -0,0 +1,93 @@
+//===- llvm/Support/AllocationTracker.h - Heap allocation counts -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares an interface for attributing heap allocations to regions
+// of code, such as the passes run by the pass managers.
+//
+// When configured with LLVM_ENABLE_ALLOCATION_HOOK, LLVM replaces the global
+// operator new and operator delete with versions that forward to malloc and
+// free, and that report every block to this interface while tracking is
+// enabled. Each thread keeps its own counts, so the hook is a single flag test
+// when tracking is disabled and a handful of thread-local additions when it
+// is enabled. Memory that is obtained from malloc directly, for example by
+// SmallVector or BumpPtrAllocator, is not seen by the hook. Without the hook,
+// isAvailable() returns false and the regions count nothing.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_ALLOCATIONTRACKER_H
+#define LLVM_SUPPORT_ALLOCATIONTRACKER_H
+
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+
+/// \brief The heap activity of a region of code.
+struct AllocationCounts {
+  uint64_t Allocations = 0; ///< Number of blocks allocated.
+  uint64_t Bytes = 0;       ///< Bytes allocated, including malloc's slop.
+  uint64_t PeakBytes = 0;   ///< Most bytes live above the level on entry.
+
+  /// The part of Allocations and Bytes from runs that were not nested in
+  /// another region, so that these can be summed over regions.
+  uint64_t OutermostAllocations = 0;
+  uint64_t OutermostBytes = 0;
+
+  /// Merge the counts of another run of the same region.
+  AllocationCounts &operator+=(const AllocationCounts &RHS) {
+    Allocations += RHS.Allocations;
+    Bytes += RHS.Bytes;
+    OutermostAllocations += RHS.OutermostAllocations;
+    OutermostBytes += RHS.OutermostBytes;
+    if (RHS.PeakBytes > PeakBytes)
+      PeakBytes = RHS.PeakBytes;
+    return *this;
+  }
+};
+
+namespace AllocationTracker {
+
+/// \brief Turn the reporting of allocations by the operator new hook on or
+/// off for all threads.
+void setEnabled(bool Enabled);
+bool isEnabled();
+
+/// \brief Return true if the operator new hook of LLVM is the one the program
+/// uses, and the size of freed blocks is known on this host.
+bool isAvailable();
+
+/// \brief Called by the operator new and operator delete hook for every block.
+/// They return right away unless tracking is enabled.
+void noteAllocation(void *Ptr);
+void noteDeallocation(void *Ptr);
+
+} // end namespace AllocationTracker
+
+/// \brief Adds the heap activity of this thread over the lifetime of the
+/// region to an AllocationCounts record. Regions may be nested, in which case
+/// the activity of the inner region is included in the outer one as well.
+/// Records may be shared by regions running on different threads.
+class AllocationRegion {
+  AllocationCounts *Counts;
+  uint64_t StartAllocations, StartBytes;
+  int64_t StartLive, SavedPeak;
+  bool Outermost;
+
+  AllocationRegion(const AllocationRegion &) = delete;
+  AllocationRegion &operator=(const AllocationRegion &) = delete;
+
+public:
+  /// Does nothing if \p Counts is null.
+  explicit AllocationRegion(AllocationCounts *Counts);
+  ~AllocationRegion();
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_ALLOCATIONTRACKER_H
@@ -108,6 +108,20 @@ extern bool EnableDebugBuffering;
 /// like: dbgs() << "foo" << "bar";
 raw_ostream &dbgs();
 
+/// DebugStreamRedirect - While alive, dbgs() returns \p OS on the calling
+/// thread, so that the output of code running on several threads at once can
+/// be kept apart.  Streams obtained from dbgs() earlier are not affected.
+class DebugStreamRedirect {
+  raw_ostream *Saved;
+
+  DebugStreamRedirect(const DebugStreamRedirect &) = delete;
+  DebugStreamRedirect &operator=(const DebugStreamRedirect &) = delete;
+
+public:
+  explicit DebugStreamRedirect(raw_ostream &OS);
+  ~DebugStreamRedirect();
+};
+
 // DEBUG macro - This macro should be used by passes to emit debug information.
 // In the '-debug' option is specified on the commandline, and if this is a
 // debug build, then the code specified as the option to the macro will be
@@ -70,15 +70,25 @@ public:
     std::unique_lock<std::mutex> lock(Mutex);
     Cond.wait(lock, [&] { return Count == 0; });
   }
+
+  bool isDone() const {
+    std::unique_lock<std::mutex> lock(Mutex);
+    return Count == 0;
+  }
 };
 
 class TaskGroup {
   Latch L;
 
 public:
+  ~TaskGroup() { sync(); }
+
   void spawn(std::function<void()> f);
 
-  void sync() const { L.sync(); }
+  /// \brief Wait for every task spawned in the group, including the tasks
+  /// they spawned. On a thread of the pool this runs other tasks while it
+  /// waits, so tasks can spawn and sync groups of their own.
+  void sync() const;
 };
 
 #if defined(_MSC_VER)
@@ -64,6 +64,30 @@ public:
                            std::chrono::nanoseconds &user_time,
                            std::chrono::nanoseconds &sys_time);
 
+  /// Counts of hardware events, see GetPerfCounts.
+  struct PerfCounts {
+    uint64_t Cycles = 0;
+    uint64_t Instructions = 0;
+    uint64_t CacheMisses = 0;
+    uint64_t BranchMisses = 0;
+    /// Nanoseconds the counters were enabled, and actually counting.
+    uint64_t TimeEnabled = 0;
+    uint64_t TimeRunning = 0;
+  };
+
+  /// This static function will set \p Counts to the number of CPU cycles,
+  /// instructions, cache misses and branch misses counted in user mode for the
+  /// calling thread so far.  The counters are set up the first time a thread
+  /// asks for them.  If the operating system or the hardware does not provide
+  /// them, or access to them is not permitted, false is returned and \p Counts
+  /// is left alone.
+  ///
+  /// The counts are raw.  If the counters had to share the hardware with other
+  /// events, they ran for less time than they were enabled, and the difference
+  /// of two readings should be scaled up by the ratio of the differences of
+  /// TimeEnabled and TimeRunning.
+  static bool GetPerfCounts(PerfCounts &Counts);
+
   /// This function makes the necessary calls to the operating system to
   /// prevent core files or any other kind of large memory dumps that can
   /// occur when a program fails.
@@ -28,8 +28,25 @@ class TimeRecord {
   double UserTime;       ///< User time elapsed.
   double SystemTime;     ///< System time elapsed.
   ssize_t MemUsed;       ///< Memory allocated (in bytes).
+  uint64_t Cycles;       ///< CPU cycles, if hardware counters are tracked.
+  uint64_t Instructions; ///< Instructions executed.
+  uint64_t CacheMisses;  ///< Cache misses.
+  uint64_t BranchMisses; ///< Mispredicted branches.
+  uint64_t PerfTimeEnabled; ///< Nanoseconds the counters were enabled.
+  uint64_t PerfTimeRunning; ///< Nanoseconds the counters were counting.
+
+  /// The counts are kept raw, so that subtracting two readings cannot wrap
+  /// around, and only scaled up for multiplexing when they are read.
+  uint64_t scaleCount(uint64_t Count) const {
+    if (PerfTimeRunning == PerfTimeEnabled || !PerfTimeRunning)
+      return Count;
+    return uint64_t(double(Count) * PerfTimeEnabled / PerfTimeRunning);
+  }
 public:
-  TimeRecord() : WallTime(0), UserTime(0), SystemTime(0), MemUsed(0) {}
+  TimeRecord()
+      : WallTime(0), UserTime(0), SystemTime(0), MemUsed(0), Cycles(0),
+        Instructions(0), CacheMisses(0), BranchMisses(0), PerfTimeEnabled(0),
+        PerfTimeRunning(0) {}
 
   /// Get the current time and memory usage.  If Start is true we get the memory
   /// usage before the time, otherwise we get time before memory usage.  This
@@ -42,6 +59,10 @@ public:
   double getSystemTime() const { return SystemTime; }
   double getWallTime() const { return WallTime; }
   ssize_t getMemUsed() const { return MemUsed; }
+  uint64_t getCycles() const { return scaleCount(Cycles); }
+  uint64_t getInstructions() const { return scaleCount(Instructions); }
+  uint64_t getCacheMisses() const { return scaleCount(CacheMisses); }
+  uint64_t getBranchMisses() const { return scaleCount(BranchMisses); }
 
   bool operator<(const TimeRecord &T) const {
     // Sort by Wall Time elapsed, as it is the only thing really accurate
@@ -53,12 +74,24 @@ public:
     UserTime   += RHS.UserTime;
     SystemTime += RHS.SystemTime;
     MemUsed    += RHS.MemUsed;
+    Cycles       += RHS.Cycles;
+    Instructions += RHS.Instructions;
+    CacheMisses  += RHS.CacheMisses;
+    BranchMisses += RHS.BranchMisses;
+    PerfTimeEnabled += RHS.PerfTimeEnabled;
+    PerfTimeRunning += RHS.PerfTimeRunning;
   }
   void operator-=(const TimeRecord &RHS) {
     WallTime   -= RHS.WallTime;
     UserTime   -= RHS.UserTime;
     SystemTime -= RHS.SystemTime;
     MemUsed    -= RHS.MemUsed;
+    Cycles       -= RHS.Cycles;
+    Instructions -= RHS.Instructions;
+    CacheMisses  -= RHS.CacheMisses;
+    BranchMisses -= RHS.BranchMisses;
+    PerfTimeEnabled -= RHS.PerfTimeEnabled;
+    PerfTimeRunning -= RHS.PerfTimeRunning;
   }
 
   /// Print the current time record to \p OS, with a breakdown showing
@@ -223,6 +256,8 @@ private:
   void PrintQueuedTimers(raw_ostream &OS);
   void printJSONValue(raw_ostream &OS, const PrintRecord &R,
                       const char *suffix, double Value);
+  void printJSONValue(raw_ostream &OS, const PrintRecord &R,
+                      const char *suffix, uint64_t Value);
   const char *printJSONValues(raw_ostream &OS, const char *delim);
 };
 
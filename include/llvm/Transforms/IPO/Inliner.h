@@ -75,6 +75,11 @@ protected:
   AssumptionCacheTracker *ACT;
   ProfileSummaryInfo *PSI;
   ImportedFunctionsInliningStatistics ImportedFunctionsStats;
+
+  /// What the inline cost analysis learned about the bodies of callees, kept
+  /// up to date as the inliner changes them. Subclasses that compute the cost
+  /// with \c llvm::getInlineCost should pass it along.
+  InlineCostCache CostCache;
 };
 
 /// The inliner pass for the new pass manager.
@@ -101,6 +106,9 @@ public:
 
 private:
   InlineParams Params;
+
+  /// What the inline cost analysis learned about the bodies of callees.
+  InlineCostCache CostCache;
 };
 
 } // End llvm namespace
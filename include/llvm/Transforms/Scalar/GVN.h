@@ -24,9 +24,13 @@
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
+#include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/MemorySSAUpdater.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/PassManager.h"
+#include <memory>
 
 namespace llvm {
 class OptimizationRemarkEmitter;
@@ -59,6 +63,7 @@ public:
   DominatorTree &getDominatorTree() const { return *DT; }
   AliasAnalysis *getAliasAnalysis() const { return VN.getAliasAnalysis(); }
   MemoryDependenceResults &getMemDep() const { return *MD; }
+  MemorySSA *getMemorySSA() const { return MSSA.get(); }
 
   struct Expression;
 
@@ -85,6 +90,7 @@ public:
 
     AliasAnalysis *AA;
     MemoryDependenceResults *MD;
+    MemorySSA *MSSA;
     DominatorTree *DT;
 
     uint32_t nextValueNumber;
@@ -119,6 +125,7 @@ public:
     void setAliasAnalysis(AliasAnalysis *A) { AA = A; }
     AliasAnalysis *getAliasAnalysis() const { return AA; }
     void setMemDep(MemoryDependenceResults *M) { MD = M; }
+    void setMemorySSA(MemorySSA *M) { MSSA = M; }
     void setDomTree(DominatorTree *D) { DT = D; }
     uint32_t getNextUnusedValueNumber() { return nextValueNumber; }
     void verifyRemoved(const Value *) const;
@@ -135,6 +142,16 @@ private:
   SetVector<BasicBlock *> DeadBlocks;
   OptimizationRemarkEmitter *ORE;
 
+  /// In the MemorySSA mode, loads get their dependencies from a MemorySSA that
+  /// GVN builds and keeps up to date itself instead of from memdep.
+  std::unique_ptr<MemorySSA> MSSA;
+  std::unique_ptr<MemorySSAUpdater> MSSAU;
+
+  /// The clobbering accesses found by the walks that start from the incoming
+  /// accesses of a MemoryPhi, which GVN repeats on every iteration.
+  DenseMap<std::pair<MemoryAccess *, MemoryLocation>, MemoryAccess *>
+      ClobberCache;
+
   ValueTable VN;
 
   /// A mapping from value numbers to lists of Value*'s that
@@ -163,8 +180,8 @@ private:
 
   bool runImpl(Function &F, AssumptionCache &RunAC, DominatorTree &RunDT,
                const TargetLibraryInfo &RunTLI, AAResults &RunAA,
-               MemoryDependenceResults *RunMD, LoopInfo *LI,
-               OptimizationRemarkEmitter *ORE);
+               MemoryDependenceResults *RunMD, bool UseMemorySSA,
+               LoopInfo *LI, OptimizationRemarkEmitter *ORE);
 
   /// Push a new Value to the LeaderTable onto the list for its value number.
   void addToLeaderTable(uint32_t N, Value *V, const BasicBlock *BB) {
@@ -232,6 +249,24 @@ private:
   bool PerformLoadPRE(LoadInst *LI, AvailValInBlkVect &ValuesPerBlock,
                       UnavailBlkVect &UnavailableBlocks);
 
+  // Helper functions of the MemorySSA mode of redundant load elimination
+  MemoryAccess *getClobberingAccess(MemoryAccess *Start,
+                                    const MemoryLocation &Loc);
+  /// Translate the clobbering access of \p Loc, read by \p LI, at the end of
+  /// \p BB (or at \p LI itself if \p BB is null) into the dependency memdep
+  /// would have found there.  A MemoryPhi becomes a non-local dependency.
+  MemDepResult getMemorySSADependency(LoadInst *LI, MemoryAccess *Clobber,
+                                      const MemoryLocation &Loc,
+                                      const BasicBlock *BB);
+  LoadInst *findDominatingLoad(LoadInst *LI, Value *Address,
+                               MemoryAccess *Clobber, const BasicBlock *BB);
+  /// Gather the dependencies of \p LI in the predecessors of \p Phi, and of
+  /// the MemoryPhis above it that the paths to them run into.  Returns false
+  /// if the address of the load can't be followed through the MemoryPhis.
+  bool getNonLocalMemorySSADependencies(LoadInst *LI, MemoryPhi *Phi,
+                                        LoadDepVect &Deps);
+  void removeFromMemorySSA(Instruction *I);
+
   // Other helper routines
   bool processInstruction(Instruction *I);
   bool processBlock(BasicBlock *BB);
@@ -0,0 +1,54 @@
+//===- Hello.h - Hello analysis report pass ---------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides the new pass manager interface of the hello pass, which
+// prints loop, reachability, control dependence and uninitialized-use reports
+// for a module and then propagates constants through allocas.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_HELLO_H
+#define LLVM_TRANSFORMS_UTILS_HELLO_H
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+/// The hello pass.
+///
+/// The per-function reports only read the IR, so in parallel mode they are
+/// computed on a thread pool, each function into its own output buffers, and
+/// then printed in module order. The output is identical to the serial mode.
+///
+/// With -hello-report-file, nothing is printed to errs(); a YAML summary of the
+/// module, plus the sections chosen with -hello-report-sections, is written to
+/// the file instead.
+///
+/// With -hello-cache-dir, the per-function results are cached on disk under a
+/// hash of the function's IR, so only functions that changed are analyzed
+/// again.
+class HelloPass : public PassInfoMixin<HelloPass> {
+  bool Parallel;
+  unsigned NumThreads;
+
+public:
+  /// Configure the pass from the -hello-parallel and -hello-threads options.
+  HelloPass();
+
+  /// \p NumThreads of zero uses one thread per hardware thread.
+  explicit HelloPass(bool Parallel, unsigned NumThreads = 0)
+      : Parallel(Parallel), NumThreads(NumThreads) {}
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_TRANSFORMS_UTILS_HELLO_H
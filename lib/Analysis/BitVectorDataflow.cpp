@@ -0,0 +1,140 @@
+//===- BitVectorDataflow.cpp - Generic bit-vector dataflow solver ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the BitVectorDataflow solver.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/BitVectorDataflow.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Function.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "bitvector-dataflow"
+
+BitVectorDataflowProblem::~BitVectorDataflowProblem() = default;
+
+void BitVectorDataflow::clear() {
+  BlockNumbers.clear();
+  Order.clear();
+  States.clear();
+  NumBlockVisits = 0;
+}
+
+const BitVector &BitVectorDataflow::getIn(const BasicBlock *BB) const {
+  auto I = BlockNumbers.find(BB);
+  assert(I != BlockNumbers.end() && "Block is not part of the solved function");
+  return States[I->second].In;
+}
+
+const BitVector &BitVectorDataflow::getOut(const BasicBlock *BB) const {
+  auto I = BlockNumbers.find(BB);
+  assert(I != BlockNumbers.end() && "Block is not part of the solved function");
+  return States[I->second].Out;
+}
+
+void BitVectorDataflow::solve(const Function &F, BitVectorDataflowProblem &P) {
+  clear();
+  if (F.isDeclaration())
+    return;
+
+  bool Forward =
+      P.getDirection() == BitVectorDataflowProblem::Direction::Forward;
+  bool Intersect = P.getMeet() == BitVectorDataflowProblem::Meet::Intersection;
+  unsigned NumBits = P.getNumBits();
+
+  // Reverse post-order visits every block after its forward predecessors
+  // (back edges aside); post-order does the same for backward problems.
+  // Blocks the traversal cannot reach are appended in function order.
+  Order.reserve(F.size());
+  ReversePostOrderTraversal<const Function *> RPOT(&F);
+  for (const BasicBlock *BB : RPOT) {
+    BlockNumbers[BB] = Order.size();
+    Order.push_back(BB);
+  }
+  for (const BasicBlock &BB : F)
+    if (BlockNumbers.insert(std::make_pair(&BB, Order.size())).second)
+      Order.push_back(&BB);
+  if (!Forward) {
+    std::reverse(Order.begin(), Order.end());
+    for (unsigned I = 0, E = Order.size(); I != E; ++I)
+      BlockNumbers[Order[I]] = I;
+  }
+
+  // Start every block at the top of the lattice so that the first visit of a
+  // block only sees meaningful values from the blocks solved before it.
+  States.resize(Order.size());
+  for (unsigned I = 0, E = Order.size(); I != E; ++I) {
+    BlockState &S = States[I];
+    S.Gen.resize(NumBits);
+    S.Kill.resize(NumBits);
+    P.computeLocalSets(*Order[I], S.Gen, S.Kill);
+    S.In.resize(NumBits, Intersect);
+    S.Out.resize(NumBits, Intersect);
+  }
+
+  BitVector Boundary(NumBits);
+  P.initializeBoundary(Boundary);
+
+  // Pending holds the visit-order positions of blocks whose inputs changed.
+  // Each sweep handles them in increasing order, so blocks that become
+  // pending further along the order are still handled in the same sweep.
+  BitVector Pending(Order.size(), true);
+  BitVector Result(NumBits);
+  while (Pending.any()) {
+    for (int Idx = Pending.find_first(); Idx != -1;
+         Idx = Pending.find_next(Idx)) {
+      Pending.reset(Idx);
+      ++NumBlockVisits;
+      const BasicBlock *BB = Order[Idx];
+      BlockState &S = States[Idx];
+      BitVector &Input = Forward ? S.In : S.Out;
+      BitVector &Output = Forward ? S.Out : S.In;
+
+      bool HasUpstream = false;
+      auto MeetWith = [&](const BasicBlock *Other) {
+        const BlockState &OS = States[BlockNumbers.lookup(Other)];
+        const BitVector &V = Forward ? OS.Out : OS.In;
+        if (!HasUpstream)
+          Input = V;
+        else if (Intersect)
+          Input &= V;
+        else
+          Input |= V;
+        HasUpstream = true;
+      };
+      if (Forward)
+        for (const BasicBlock *Pred : predecessors(BB))
+          MeetWith(Pred);
+      else
+        for (const BasicBlock *Succ : successors(BB))
+          MeetWith(Succ);
+      if (!HasUpstream)
+        Input = Boundary;
+
+      Result = Input;
+      Result.reset(S.Kill);
+      Result |= S.Gen;
+      if (Result == Output)
+        continue;
+      Output = Result;
+
+      if (Forward)
+        for (const BasicBlock *Succ : successors(BB))
+          Pending.set(BlockNumbers.lookup(Succ));
+      else
+        for (const BasicBlock *Pred : predecessors(BB))
+          Pending.set(BlockNumbers.lookup(Pred));
+    }
+  }
+}
@@ -0,0 +1,229 @@
+//===- BlockReachability.cpp - Precomputed CFG reachability ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the BlockReachability analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/BlockReachability.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <utility>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "block-reachability"
+
+//===----------------------------------------------------------------------===//
+//  BlockReachability Implementation
+//===----------------------------------------------------------------------===//
+
+void BlockReachability::recalculate(const Function &F) {
+  releaseMemory();
+  Fn = &F;
+
+  // Number the blocks densely. SCCNumbers temporarily maps each block to its
+  // position in the function and is rewritten to hold component numbers once
+  // the components are known.
+  std::vector<const BasicBlock *> Blocks;
+  Blocks.reserve(F.size());
+  for (const BasicBlock &BB : F) {
+    SCCNumbers[&BB] = Blocks.size();
+    Blocks.push_back(&BB);
+  }
+  unsigned NumBlocks = Blocks.size();
+
+  // Iterative Tarjan walk. Every block is used as a root so that blocks which
+  // are unreachable from the entry block are indexed too. A visited block
+  // that has not been assigned a component yet is on the SCC stack.
+  const unsigned NoSCC = ~0U;
+  std::vector<unsigned> DFSNum(NumBlocks, 0), LowLink(NumBlocks, 0);
+  std::vector<unsigned> SCCOf(NumBlocks, NoSCC);
+  SmallVector<unsigned, 32> SCCStack;
+  SmallVector<std::pair<unsigned, succ_const_iterator>, 32> VisitStack;
+  // Component members, grouped by component; component N owns the entries
+  // [MemberBegin[N], MemberBegin[N + 1]).
+  std::vector<unsigned> Members, MemberBegin;
+  Members.reserve(NumBlocks);
+  unsigned NextDFSNum = 1;
+
+  auto Visit = [&](unsigned Idx) {
+    DFSNum[Idx] = LowLink[Idx] = NextDFSNum++;
+    SCCStack.push_back(Idx);
+    VisitStack.push_back(std::make_pair(Idx, succ_begin(Blocks[Idx])));
+  };
+
+  for (unsigned Root = 0; Root != NumBlocks; ++Root) {
+    if (DFSNum[Root])
+      continue;
+    Visit(Root);
+    while (!VisitStack.empty()) {
+      unsigned Idx = VisitStack.back().first;
+      succ_const_iterator &Next = VisitStack.back().second;
+      if (Next != succ_end(Blocks[Idx])) {
+        unsigned Succ = SCCNumbers.lookup(*Next++);
+        if (!DFSNum[Succ])
+          Visit(Succ);
+        else if (SCCOf[Succ] == NoSCC)
+          LowLink[Idx] = std::min(LowLink[Idx], DFSNum[Succ]);
+        continue;
+      }
+
+      VisitStack.pop_back();
+      if (!VisitStack.empty()) {
+        unsigned Parent = VisitStack.back().first;
+        LowLink[Parent] = std::min(LowLink[Parent], LowLink[Idx]);
+      }
+      if (LowLink[Idx] != DFSNum[Idx])
+        continue;
+
+      // Idx is the root of a component; everything above it on the SCC stack
+      // belongs to the same component.
+      unsigned SCC = MemberBegin.size();
+      MemberBegin.push_back(Members.size());
+      unsigned Member;
+      do {
+        Member = SCCStack.pop_back_val();
+        SCCOf[Member] = SCC;
+        Members.push_back(Member);
+      } while (Member != Idx);
+    }
+  }
+  MemberBegin.push_back(Members.size());
+
+  // Tarjan completes a component only after every component reachable from
+  // it, so the closure can be built in component order. Component N can only
+  // reach components numbered N or lower, which bounds each vector's size.
+  unsigned NumSCCs = MemberBegin.size() - 1;
+  Reachable.resize(NumSCCs);
+  Cyclic.resize(NumSCCs);
+  for (unsigned SCC = 0; SCC != NumSCCs; ++SCC) {
+    BitVector &Reach = Reachable[SCC];
+    Reach.resize(SCC + 1);
+    Reach.set(SCC);
+    if (MemberBegin[SCC + 1] - MemberBegin[SCC] > 1)
+      Cyclic.set(SCC);
+    for (unsigned I = MemberBegin[SCC], E = MemberBegin[SCC + 1]; I != E; ++I)
+      for (const BasicBlock *Succ : successors(Blocks[Members[I]])) {
+        unsigned SuccSCC = SCCOf[SCCNumbers.lookup(Succ)];
+        if (SuccSCC == SCC)
+          Cyclic.set(SCC);
+        else if (!Reach.test(SuccSCC))
+          Reach |= Reachable[SuccSCC];
+      }
+  }
+
+  for (unsigned Idx = 0; Idx != NumBlocks; ++Idx)
+    SCCNumbers[Blocks[Idx]] = SCCOf[Idx];
+}
+
+unsigned BlockReachability::getSCCNumber(const BasicBlock *BB) const {
+  auto I = SCCNumbers.find(BB);
+  assert(I != SCCNumbers.end() && "Block is not part of the analyzed function");
+  return I->second;
+}
+
+bool BlockReachability::isReachable(const BasicBlock *From,
+                                    const BasicBlock *To) const {
+  if (From == To)
+    return true;
+  unsigned FromSCC = getSCCNumber(From);
+  unsigned ToSCC = getSCCNumber(To);
+  if (ToSCC > FromSCC)
+    return false;
+  return Reachable[FromSCC].test(ToSCC);
+}
+
+bool BlockReachability::isInCycle(const BasicBlock *BB) const {
+  return Cyclic.test(getSCCNumber(BB));
+}
+
+void BlockReachability::releaseMemory() {
+  Fn = nullptr;
+  SCCNumbers.clear();
+  Reachable.clear();
+  Cyclic.clear();
+}
+
+void BlockReachability::print(raw_ostream &OS) const {
+  if (!Fn)
+    return;
+  for (const BasicBlock &From : *Fn) {
+    OS << "  ";
+    From.printAsOperand(OS, false);
+    OS << " (scc " << getSCCNumber(&From);
+    if (isInCycle(&From))
+      OS << ", cyclic";
+    OS << ") reaches:";
+    for (const BasicBlock &To : *Fn)
+      if (isReachable(&From, &To)) {
+        OS << ' ';
+        To.printAsOperand(OS, false);
+      }
+    OS << '\n';
+  }
+}
+
+bool BlockReachability::invalidate(Function &F, const PreservedAnalyses &PA,
+                                   FunctionAnalysisManager::Invalidator &) {
+  // Check whether the analysis, all analyses on functions, or the function's
+  // CFG have been preserved.
+  auto PAC = PA.getChecker<BlockReachabilityAnalysis>();
+  return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Function>>() ||
+           PAC.preservedSet<CFGAnalyses>());
+}
+
+//===----------------------------------------------------------------------===//
+//  BlockReachabilityAnalysis and BlockReachabilityPrinterPass Implementation
+//===----------------------------------------------------------------------===//
+
+AnalysisKey BlockReachabilityAnalysis::Key;
+
+BlockReachability BlockReachabilityAnalysis::run(Function &F,
+                                                 FunctionAnalysisManager &) {
+  return BlockReachability(F);
+}
+
+BlockReachabilityPrinterPass::BlockReachabilityPrinterPass(raw_ostream &OS)
+    : OS(OS) {}
+
+PreservedAnalyses
+BlockReachabilityPrinterPass::run(Function &F, FunctionAnalysisManager &AM) {
+  OS << "BlockReachability for function: " << F.getName() << "\n";
+  AM.getResult<BlockReachabilityAnalysis>(F).print(OS);
+
+  return PreservedAnalyses::all();
+}
+
+//===----------------------------------------------------------------------===//
+//  BlockReachabilityWrapperPass Implementation
+//===----------------------------------------------------------------------===//
+
+char BlockReachabilityWrapperPass::ID = 0;
+
+INITIALIZE_PASS(BlockReachabilityWrapperPass, "block-reachability",
+                "Block Reachability Index Construction", true, true)
+
+BlockReachabilityWrapperPass::BlockReachabilityWrapperPass()
+    : FunctionPass(ID) {
+  initializeBlockReachabilityWrapperPassPass(*PassRegistry::getPassRegistry());
+}
+
+bool BlockReachabilityWrapperPass::runOnFunction(Function &F) {
+  BR.recalculate(F);
+  return false;
+}
+
+void BlockReachabilityWrapperPass::print(raw_ostream &OS,
+                                         const Module *) const {
+  BR.print(OS);
+}
@@ -67,7 +67,11 @@ PassManager<LazyCallGraph::SCC, CGSCCAnalysisManager, LazyCallGraph &,
     if (DebugLogging)
       dbgs() << "Running pass: " << Pass->name() << " on " << *C << "\n";
 
-    PreservedAnalyses PassPA = Pass->run(*C, AM, G, UR);
+    PreservedAnalyses PassPA = PreservedAnalyses::none();
+    {
+      AllocationRegion PassMemory(getPassMemoryRecord(Pass->name()));
+      PassPA = Pass->run(*C, AM, G, UR);
+    }
 
     // Update the SCC if necessary.
     C = UR.UpdatedC ? UR.UpdatedC : C;
@@ -27,6 +27,7 @@
 #include "llvm/IR/LegacyPassManagers.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/OptBisect.h"
+#include "llvm/IR/PassMemoryInfo.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
@@ -130,6 +131,7 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
 
     {
       TimeRegion PassTimer(getPassTimer(CGSP));
+      AllocationRegion PassMemory(getPassMemoryRecord(CGSP));
       Changed = CGSP->runOnSCC(CurSCC);
     }
     
@@ -153,6 +155,7 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
       dumpPassInfo(P, EXECUTION_MSG, ON_FUNCTION_MSG, F->getName());
       {
         TimeRegion PassTimer(getPassTimer(FPP));
+        AllocationRegion PassMemory(getPassMemoryRecord(FPP));
         Changed |= FPP->runOnFunction(*F);
       }
       F->getContext().yield();
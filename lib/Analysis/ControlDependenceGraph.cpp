@@ -0,0 +1,176 @@
+//===- ControlDependenceGraph.cpp - Control dependence analysis -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ControlDependenceGraph analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/ControlDependenceGraph.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "control-dependence"
+
+//===----------------------------------------------------------------------===//
+//  ControlDependenceGraph Implementation
+//===----------------------------------------------------------------------===//
+
+void ControlDependenceGraph::recalculate(const Function &F,
+                                         const PostDominatorTree &PDT) {
+  releaseMemory();
+  Fn = &F;
+
+  for (const BasicBlock &Controller : F) {
+    BasicBlock *A = const_cast<BasicBlock *>(&Controller);
+    const DomTreeNode *ANode = PDT.getNode(A);
+    if (!ANode)
+      continue;
+    const DomTreeNode *Stop = ANode->getIDom();
+    for (BasicBlock *Succ : successors(A)) {
+      for (const DomTreeNode *Runner = PDT.getNode(Succ);
+           Runner && Runner != Stop; Runner = Runner->getIDom()) {
+        // The virtual root of the post-dominator tree has no block.
+        BasicBlock *B = Runner->getBlock();
+        if (!B)
+          break;
+        // If another successor of A already reached B, the rest of the path
+        // up to Stop has been recorded as well.
+        BlockListT &Ctrls = Controllers[B];
+        if (!Ctrls.empty() && Ctrls.back() == A)
+          break;
+        Ctrls.push_back(A);
+      }
+    }
+  }
+
+  // Controllers were discovered in function order; inverting the relation in
+  // function order keeps the dependent lists sorted the same way.
+  for (const BasicBlock &BB : F) {
+    auto I = Controllers.find(&BB);
+    if (I == Controllers.end())
+      continue;
+    for (BasicBlock *A : I->second)
+      Dependents[A].push_back(const_cast<BasicBlock *>(&BB));
+  }
+}
+
+ArrayRef<BasicBlock *>
+ControlDependenceGraph::getControllingBlocks(const BasicBlock *BB) const {
+  auto I = Controllers.find(BB);
+  if (I == Controllers.end())
+    return None;
+  return I->second;
+}
+
+ArrayRef<BasicBlock *>
+ControlDependenceGraph::getDependentBlocks(const BasicBlock *BB) const {
+  auto I = Dependents.find(BB);
+  if (I == Dependents.end())
+    return None;
+  return I->second;
+}
+
+bool ControlDependenceGraph::isControlDependent(
+    const BasicBlock *BB, const BasicBlock *Controller) const {
+  return is_contained(getControllingBlocks(BB), Controller);
+}
+
+void ControlDependenceGraph::releaseMemory() {
+  Fn = nullptr;
+  Controllers.clear();
+  Dependents.clear();
+}
+
+void ControlDependenceGraph::print(raw_ostream &OS) const {
+  if (!Fn)
+    return;
+  for (const BasicBlock &BB : *Fn) {
+    ArrayRef<BasicBlock *> Ctrls = getControllingBlocks(&BB);
+    if (Ctrls.empty())
+      continue;
+    OS << "  ";
+    BB.printAsOperand(OS, false);
+    OS << " is control dependent on:";
+    for (const BasicBlock *A : Ctrls) {
+      OS << ' ';
+      A->printAsOperand(OS, false);
+    }
+    OS << '\n';
+  }
+}
+
+bool ControlDependenceGraph::invalidate(
+    Function &F, const PreservedAnalyses &PA,
+    FunctionAnalysisManager::Invalidator &) {
+  // Check whether the analysis, all analyses on functions, or the function's
+  // CFG have been preserved.
+  auto PAC = PA.getChecker<ControlDependenceAnalysis>();
+  return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Function>>() ||
+           PAC.preservedSet<CFGAnalyses>());
+}
+
+//===----------------------------------------------------------------------===//
+//  ControlDependenceAnalysis and ControlDependencePrinterPass Implementation
+//===----------------------------------------------------------------------===//
+
+AnalysisKey ControlDependenceAnalysis::Key;
+
+ControlDependenceGraph
+ControlDependenceAnalysis::run(Function &F, FunctionAnalysisManager &AM) {
+  return ControlDependenceGraph(F, AM.getResult<PostDominatorTreeAnalysis>(F));
+}
+
+ControlDependencePrinterPass::ControlDependencePrinterPass(raw_ostream &OS)
+    : OS(OS) {}
+
+PreservedAnalyses
+ControlDependencePrinterPass::run(Function &F, FunctionAnalysisManager &AM) {
+  OS << "ControlDependenceGraph for function: " << F.getName() << "\n";
+  AM.getResult<ControlDependenceAnalysis>(F).print(OS);
+
+  return PreservedAnalyses::all();
+}
+
+//===----------------------------------------------------------------------===//
+//  ControlDependenceWrapperPass Implementation
+//===----------------------------------------------------------------------===//
+
+char ControlDependenceWrapperPass::ID = 0;
+
+INITIALIZE_PASS_BEGIN(ControlDependenceWrapperPass, "control-dependence",
+                      "Control Dependence Graph Construction", true, true)
+INITIALIZE_PASS_DEPENDENCY(PostDominatorTreeWrapperPass)
+INITIALIZE_PASS_END(ControlDependenceWrapperPass, "control-dependence",
+                    "Control Dependence Graph Construction", true, true)
+
+ControlDependenceWrapperPass::ControlDependenceWrapperPass()
+    : FunctionPass(ID) {
+  initializeControlDependenceWrapperPassPass(*PassRegistry::getPassRegistry());
+}
+
+bool ControlDependenceWrapperPass::runOnFunction(Function &F) {
+  CDG.recalculate(
+      F, getAnalysis<PostDominatorTreeWrapperPass>().getPostDomTree());
+  return false;
+}
+
+void ControlDependenceWrapperPass::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+  AU.addRequired<PostDominatorTreeWrapperPass>();
+}
+
+void ControlDependenceWrapperPass::print(raw_ostream &OS,
+                                         const Module *) const {
+  CDG.print(OS);
+}
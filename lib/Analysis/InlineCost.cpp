@@ -32,6 +32,7 @@
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/IR/ValueMap.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -40,6 +41,8 @@ using namespace llvm;
 #define DEBUG_TYPE "inline-cost"
 
 STATISTIC(NumCallsAnalyzed, "Number of call sites analyzed");
+STATISTIC(NumCallsFromCache,
+          "Number of call sites analyzed from a cached walk of the callee");
 
 static cl::opt<int> InlineThreshold(
     "inline-threshold", cl::Hidden, cl::init(225), cl::ZeroOrMore,
@@ -87,6 +90,106 @@ static cl::opt<bool> ComputeFullInlineCost(
     cl::desc("Compute the full inline cost of a call site even when the cost "
              "exceeds the threshold."));
 
+namespace llvm {
+
+/// The walks over callee bodies remembered by an \c InlineCostCache.
+class InlineCostCacheImpl {
+public:
+  /// How a call site binds one argument of the callee, as far as the walk over
+  /// the callee body can tell.
+  struct ArgBinding {
+    enum BindingKind : uint8_t {
+      /// Nothing is known about the argument, or the body doesn't use it.
+      Unknown,
+      /// A pointer at a constant offset from a base in the caller.
+      Pointer,
+      /// A pointer at a constant offset from an alloca in the caller.
+      AllocaPointer
+    };
+    BindingKind Kind = Unknown;
+    /// Whether the call site says the pointer is non-null.
+    bool NonNull = false;
+    /// The number of the first argument whose pointer has the same base.
+    unsigned BaseArg = 0;
+    /// The offset of the pointer from its base.
+    APInt Offset;
+
+    bool operator==(const ArgBinding &RHS) const {
+      return Kind == RHS.Kind && NonNull == RHS.NonNull &&
+             BaseArg == RHS.BaseArg && Offset == RHS.Offset;
+    }
+  };
+
+  /// What a walk over the callee body found. The cost leaves out everything
+  /// that depends on the call site rather than on the body.
+  struct CalleeSummary {
+    bool Viable;
+    bool SingleBB;
+    bool IsRecursiveCall;
+    bool ExposesReturnsTwice;
+    bool HasDynamicAlloca;
+    bool ContainsNoDuplicateCall;
+    bool HasIndirectBr;
+    bool HasFrameEscape;
+    int Cost;
+    uint64_t AllocatedSize;
+    unsigned NumInstructions, NumVectorInstructions;
+    unsigned NumConstantPtrCmps, NumConstantPtrDiffs;
+    unsigned NumInstructionsSimplified;
+    unsigned SROACostSavings, SROACostSavingsLost;
+  };
+
+  const CalleeSummary *lookup(const Function &F,
+                              ArrayRef<ArgBinding> Bindings) const {
+    auto I = Summaries.find(&F);
+    if (I == Summaries.end())
+      return nullptr;
+    for (const Entry &E : I->second)
+      if (makeArrayRef(E.Bindings) == Bindings)
+        return &E.Summary;
+    return nullptr;
+  }
+
+  void insert(const Function &F, ArrayRef<ArgBinding> Bindings,
+              const CalleeSummary &Summary) {
+    // A callee that is called with this many different bindings will likely
+    // see yet more of them, so stop spending memory on it.
+    auto &Entries = Summaries[&F];
+    if (Entries.size() < MaxBindingsPerCallee)
+      Entries.push_back(Entry{{Bindings.begin(), Bindings.end()}, Summary});
+  }
+
+  void invalidate(const Function &F) { Summaries.erase(&F); }
+  void clear() { Summaries.clear(); }
+
+private:
+  static const unsigned MaxBindingsPerCallee = 8;
+
+  struct Entry {
+    SmallVector<ArgBinding, 4> Bindings;
+    CalleeSummary Summary;
+  };
+
+  /// A function that takes over the uses of another has a body of its own, so
+  /// the entries stay with the function they were made for.
+  struct SummaryMapConfig : ValueMapConfig<const Function *> {
+    enum { FollowRAUW = false };
+  };
+  ValueMap<const Function *, SmallVector<Entry, 2>, SummaryMapConfig>
+      Summaries;
+};
+
+} // end namespace llvm
+
+InlineCostCache::InlineCostCache() : Impl(new InlineCostCacheImpl()) {}
+InlineCostCache::InlineCostCache(InlineCostCache &&Arg) = default;
+InlineCostCache &InlineCostCache::operator=(InlineCostCache &&RHS) = default;
+InlineCostCache::~InlineCostCache() = default;
+
+void InlineCostCache::invalidate(const Function &F) { Impl->invalidate(F); }
+
+void InlineCostCache::clear() { Impl->clear(); }
+
 namespace {
 
 class CallAnalyzer : public InstVisitor<CallAnalyzer, bool> {
@@ -122,6 +225,12 @@ class CallAnalyzer : public InstVisitor<CallAnalyzer, bool> {
   /// Tunable parameters that control the analysis.
   const InlineParams &Params;
 
+  /// Where walks over the callee body are remembered, if anywhere.
+  InlineCostCacheImpl *Cache;
+
+  /// Whether to keep walking the callee once the cost exceeds the threshold.
+  bool ComputeFullCost;
+
   int Threshold;
   int Cost;
 
@@ -140,6 +249,7 @@ class CallAnalyzer : public InstVisitor<CallAnalyzer, bool> {
   int VectorBonus, TenPercentVectorBonus;
   // Bonus to be applied when the callee has only one reachable basic block.
   int SingleBBBonus;
+  bool SingleBB;
 
   /// While we walk the potentially-inlined instructions, we build up and
   /// maintain a mapping of simplified values specific to this callsite. The
@@ -206,6 +316,18 @@ class CallAnalyzer : public InstVisitor<CallAnalyzer, bool> {
 
   // Custom analysis routines.
   bool analyzeBlock(BasicBlock *BB, SmallPtrSetImpl<const Value *> &EphValues);
+  bool analyzeCallee();
+  bool
+  getArgBindings(SmallVectorImpl<InlineCostCacheImpl::ArgBinding> &Bindings);
+  bool
+  analyzeCalleeWithCache(ArrayRef<InlineCostCacheImpl::ArgBinding> Bindings);
+
+  bool hasUninlinablePattern() const {
+    return IsRecursiveCall || ExposesReturnsTwice || HasDynamicAlloca ||
+           HasIndirectBr || HasFrameEscape;
+  }
+  void emitUninlinablePatternRemark();
+  void emitRecursiveCallerRemark();
 
   // Disable several entry points to the visitor so we don't accidentally use
   // them by declaring but not defining them here.
@@ -252,16 +374,19 @@ public:
                std::function<AssumptionCache &(Function &)> &GetAssumptionCache,
                Optional<function_ref<BlockFrequencyInfo &(Function &)>> &GetBFI,
                ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE,
-               Function &Callee, CallSite CSArg, const InlineParams &Params)
+               Function &Callee, CallSite CSArg, const InlineParams &Params,
+               InlineCostCacheImpl *Cache = nullptr)
       : TTI(TTI), GetAssumptionCache(GetAssumptionCache), GetBFI(GetBFI),
         PSI(PSI), F(Callee), DL(F.getParent()->getDataLayout()), ORE(ORE),
-        CandidateCS(CSArg), Params(Params), Threshold(Params.DefaultThreshold),
-        Cost(0), IsCallerRecursive(false), IsRecursiveCall(false),
-        ExposesReturnsTwice(false), HasDynamicAlloca(false),
-        ContainsNoDuplicateCall(false), HasReturn(false), HasIndirectBr(false),
-        HasFrameEscape(false), AllocatedSize(0), NumInstructions(0),
-        NumVectorInstructions(0), VectorBonus(0), SingleBBBonus(0),
-        NumConstantArgs(0), NumConstantOffsetPtrArgs(0), NumAllocaArgs(0),
+        CandidateCS(CSArg), Params(Params), Cache(Cache),
+        ComputeFullCost(ComputeFullInlineCost),
+        Threshold(Params.DefaultThreshold), Cost(0), IsCallerRecursive(false),
+        IsRecursiveCall(false), ExposesReturnsTwice(false),
+        HasDynamicAlloca(false), ContainsNoDuplicateCall(false),
+        HasReturn(false), HasIndirectBr(false), HasFrameEscape(false),
+        AllocatedSize(0), NumInstructions(0), NumVectorInstructions(0),
+        VectorBonus(0), SingleBBBonus(0), SingleBB(true), NumConstantArgs(0),
+        NumConstantOffsetPtrArgs(0), NumAllocaArgs(0),
         NumConstantPtrCmps(0), NumConstantPtrDiffs(0),
         NumInstructionsSimplified(0), SROACostSavings(0),
         SROACostSavingsLost(0) {}
@@ -1206,7 +1331,7 @@ bool CallAnalyzer::visitSwitchInst(SwitchInst &SI) {
       std::min((int64_t)CostUpperBound,
                (int64_t)SI.getNumCases() * InlineConstants::InstrCost + Cost);
 
-  if (CostLowerBound > Threshold && !ComputeFullInlineCost) {
+  if (CostLowerBound > Threshold && !ComputeFullCost) {
     Cost = CostLowerBound;
     return false;
   }
@@ -1355,15 +1480,9 @@ bool CallAnalyzer::analyzeBlock(BasicBlock *BB,
     else
       Cost += InlineConstants::InstrCost;
 
-    using namespace ore;
     // If the visit this instruction detected an uninlinable pattern, abort.
-    if (IsRecursiveCall || ExposesReturnsTwice || HasDynamicAlloca ||
-        HasIndirectBr || HasFrameEscape) {
-      if (ORE)
-        ORE->emit(OptimizationRemarkMissed(DEBUG_TYPE, "NeverInline",
-                                           CandidateCS.getInstruction())
-                  << NV("Callee", &F)
-                  << " has uninlinable pattern and cost is not fully computed");
+    if (hasUninlinablePattern()) {
+      emitUninlinablePatternRemark();
       return false;
     }
 
@@ -1372,25 +1491,38 @@ bool CallAnalyzer::analyzeBlock(BasicBlock *BB,
     // the caller stack usage dramatically.
     if (IsCallerRecursive &&
         AllocatedSize > InlineConstants::TotalAllocaSizeRecursiveCaller) {
-      if (ORE)
-        ORE->emit(
-            OptimizationRemarkMissed(DEBUG_TYPE, "NeverInline",
-                                     CandidateCS.getInstruction())
-            << NV("Callee", &F)
-            << " is recursive and allocates too much stack space. Cost is "
-               "not fully computed");
+      emitRecursiveCallerRemark();
       return false;
     }
 
     // Check if we've past the maximum possible threshold so we don't spin in
     // huge basic blocks that will never inline.
-    if (Cost >= Threshold && !ComputeFullInlineCost)
+    if (Cost >= Threshold && !ComputeFullCost)
       return false;
   }
 
   return true;
 }
 
+void CallAnalyzer::emitUninlinablePatternRemark() {
+  using namespace ore;
+  if (ORE)
+    ORE->emit(OptimizationRemarkMissed(DEBUG_TYPE, "NeverInline",
+                                       CandidateCS.getInstruction())
+              << NV("Callee", &F)
+              << " has uninlinable pattern and cost is not fully computed");
+}
+
+void CallAnalyzer::emitRecursiveCallerRemark() {
+  using namespace ore;
+  if (ORE)
+    ORE->emit(OptimizationRemarkMissed(DEBUG_TYPE, "NeverInline",
+                                       CandidateCS.getInstruction())
+              << NV("Callee", &F)
+              << " is recursive and allocates too much stack space. Cost is "
+                 "not fully computed");
+}
+
 /// \brief Compute the base pointer and cumulative constant offsets for V.
 ///
 /// This strips all constant offsets off of V, leaving it the base pointer, and
@@ -1429,6 +1561,209 @@ ConstantInt *CallAnalyzer::stripAndComputeInBoundsConstantOffsets(Value *&V) {
   return cast<ConstantInt>(ConstantInt::get(IntPtrTy, Offset));
 }
 
+/// \brief Walk the blocks of the callee that are live at this call site.
+///
+/// Returns false if inlining is no longer viable, and true if it remains
+/// viable.
+bool CallAnalyzer::analyzeCallee() {
+  // FIXME: If a caller has multiple calls to a callee, we end up recomputing
+  // the ephemeral values multiple times (and they're completely determined by
+  // the callee, so this is purely duplicate work).
+  SmallPtrSet<const Value *, 32> EphValues;
+  CodeMetrics::collectEphemeralValues(&F, &GetAssumptionCache(F), EphValues);
+
+  // The worklist of live basic blocks in the callee *after* inlining. We avoid
+  // adding basic blocks of the callee which can be proven to be dead for this
+  // particular call site in order to get more accurate cost estimates. This
+  // requires a somewhat heavyweight iteration pattern: we need to walk the
+  // basic blocks in a breadth-first order as we insert live successors. To
+  // accomplish this, prioritizing for small iterations because we exit after
+  // crossing our threshold, we use a small-size optimized SetVector.
+  typedef SetVector<BasicBlock *, SmallVector<BasicBlock *, 16>,
+                    SmallPtrSet<BasicBlock *, 16>>
+      BBSetVector;
+  BBSetVector BBWorklist;
+  BBWorklist.insert(&F.getEntryBlock());
+  // Note that we *must not* cache the size, this loop grows the worklist.
+  for (unsigned Idx = 0; Idx != BBWorklist.size(); ++Idx) {
+    // Bail out the moment we cross the threshold. This means we'll under-count
+    // the cost, but only when undercounting doesn't matter.
+    if (Cost >= Threshold && !ComputeFullCost)
+      break;
+
+    BasicBlock *BB = BBWorklist[Idx];
+    if (BB->empty())
+      continue;
+
+    // Disallow inlining a blockaddress. A blockaddress only has defined
+    // behavior for an indirect branch in the same function, and we do not
+    // currently support inlining indirect branches. But, the inliner may not
+    // see an indirect branch that ends up being dead code at a particular call
+    // site. If the blockaddress escapes the function, e.g., via a global
+    // variable, inlining may lead to an invalid cross-function reference.
+    if (BB->hasAddressTaken())
+      return false;
+
+    // Analyze the cost of this block. If we blow through the threshold, this
+    // returns false, and we can bail on out.
+    if (!analyzeBlock(BB, EphValues))
+      return false;
+
+    TerminatorInst *TI = BB->getTerminator();
+
+    // Add in the live successors by first checking whether we have terminator
+    // that may be simplified based on the values simplified by this call.
+    if (BranchInst *BI = dyn_cast<BranchInst>(TI)) {
+      if (BI->isConditional()) {
+        Value *Cond = BI->getCondition();
+        if (ConstantInt *SimpleCond =
+                dyn_cast_or_null<ConstantInt>(SimplifiedValues.lookup(Cond))) {
+          BBWorklist.insert(BI->getSuccessor(SimpleCond->isZero() ? 1 : 0));
+          continue;
+        }
+      }
+    } else if (SwitchInst *SI = dyn_cast<SwitchInst>(TI)) {
+      Value *Cond = SI->getCondition();
+      if (ConstantInt *SimpleCond =
+              dyn_cast_or_null<ConstantInt>(SimplifiedValues.lookup(Cond))) {
+        BBWorklist.insert(SI->findCaseValue(SimpleCond)->getCaseSuccessor());
+        continue;
+      }
+    }
+
+    // If we're unable to select a particular successor, just count all of
+    // them.
+    for (unsigned TIdx = 0, TSize = TI->getNumSuccessors(); TIdx != TSize;
+         ++TIdx)
+      BBWorklist.insert(TI->getSuccessor(TIdx));
+
+    // If we had any successors at this point, than post-inlining is likely to
+    // have them as well. Note that we assume any basic blocks which existed
+    // due to branches or switches which folded above will also fold after
+    // inlining.
+    if (SingleBB && TI->getNumSuccessors() > 1) {
+      // Take off the bonus we applied to the threshold.
+      Threshold -= SingleBBBonus;
+      SingleBB = false;
+    }
+  }
+
+  return true;
+}
+
+/// \brief Describe how the call site binds each argument of the callee, from
+/// what the analysis has recorded about the arguments.
+///
+/// Returns false if the call site passes a constant to an argument the callee
+/// uses, as the walk over the callee body folds those.
+bool CallAnalyzer::getArgBindings(
+    SmallVectorImpl<InlineCostCacheImpl::ArgBinding> &Bindings) {
+  typedef InlineCostCacheImpl::ArgBinding ArgBinding;
+  SmallVector<Value *, 4> Bases;
+  for (Argument &A : F.args()) {
+    Bindings.emplace_back();
+    ArgBinding &B = Bindings.back();
+    Value *Base = nullptr;
+    if (!A.use_empty()) {
+      if (SimplifiedValues.count(&A))
+        return false;
+      auto I = ConstantOffsetPtrs.find(&A);
+      if (I != ConstantOffsetPtrs.end()) {
+        Base = I->second.first;
+        B.Kind = SROAArgValues.count(&A) ? ArgBinding::AllocaPointer
+                                         : ArgBinding::Pointer;
+        B.NonNull = paramHasAttr(&A, Attribute::NonNull);
+        B.BaseArg = find(Bases, Base) - Bases.begin();
+        B.Offset = I->second.second;
+      }
+    }
+    Bases.push_back(Base);
+  }
+  return true;
+}
+
+/// \brief Account for the callee body with what a walk over it found for call
+/// sites binding the arguments as in \p Bindings, walking it first if there
+/// has been no such call site yet.
+bool CallAnalyzer::analyzeCalleeWithCache(
+    ArrayRef<InlineCostCacheImpl::ArgBinding> Bindings) {
+  InlineCostCacheImpl::CalleeSummary S;
+  if (const auto *Cached = Cache->lookup(F, Bindings)) {
+    ++NumCallsFromCache;
+    S = *Cached;
+  } else {
+    // Walk the whole body and leave out what is particular to this call site:
+    // the cost so far, the threshold, the caller and the remarks.
+    int CallSiteCost = Cost, CallSiteThreshold = Threshold;
+    bool CallSiteFullCost = ComputeFullCost;
+    bool CallerRecursive = IsCallerRecursive;
+    OptimizationRemarkEmitter *CallSiteORE = ORE;
+    Cost = 0;
+    ComputeFullCost = true;
+    IsCallerRecursive = false;
+    ORE = nullptr;
+
+    S.Viable = analyzeCallee();
+    S.SingleBB = SingleBB;
+    S.IsRecursiveCall = IsRecursiveCall;
+    S.ExposesReturnsTwice = ExposesReturnsTwice;
+    S.HasDynamicAlloca = HasDynamicAlloca;
+    S.ContainsNoDuplicateCall = ContainsNoDuplicateCall;
+    S.HasIndirectBr = HasIndirectBr;
+    S.HasFrameEscape = HasFrameEscape;
+    S.Cost = Cost;
+    S.AllocatedSize = AllocatedSize;
+    S.NumInstructions = NumInstructions;
+    S.NumVectorInstructions = NumVectorInstructions;
+    S.NumConstantPtrCmps = NumConstantPtrCmps;
+    S.NumConstantPtrDiffs = NumConstantPtrDiffs;
+    S.NumInstructionsSimplified = NumInstructionsSimplified;
+    S.SROACostSavings = SROACostSavings;
+    S.SROACostSavingsLost = SROACostSavingsLost;
+    Cache->insert(F, Bindings, S);
+
+    Cost = CallSiteCost;
+    Threshold = CallSiteThreshold;
+    SingleBB = true;
+    ComputeFullCost = CallSiteFullCost;
+    IsCallerRecursive = CallerRecursive;
+    ORE = CallSiteORE;
+  }
+
+  int CostUpperBound = INT_MAX - InlineConstants::InstrCost - 1;
+  Cost = std::min((int64_t)CostUpperBound, (int64_t)Cost + S.Cost);
+  IsRecursiveCall = S.IsRecursiveCall;
+  ExposesReturnsTwice = S.ExposesReturnsTwice;
+  HasDynamicAlloca = S.HasDynamicAlloca;
+  ContainsNoDuplicateCall = S.ContainsNoDuplicateCall;
+  HasIndirectBr = S.HasIndirectBr;
+  HasFrameEscape = S.HasFrameEscape;
+  AllocatedSize = S.AllocatedSize;
+  NumInstructions = S.NumInstructions;
+  NumVectorInstructions = S.NumVectorInstructions;
+  NumConstantPtrCmps = S.NumConstantPtrCmps;
+  NumConstantPtrDiffs = S.NumConstantPtrDiffs;
+  NumInstructionsSimplified = S.NumInstructionsSimplified;
+  SROACostSavings = S.SROACostSavings;
+  SROACostSavingsLost = S.SROACostSavingsLost;
+  if (!S.SingleBB) {
+    Threshold -= SingleBBBonus;
+    SingleBB = false;
+  }
+
+  if (!S.Viable) {
+    if (hasUninlinablePattern())
+      emitUninlinablePatternRemark();
+    return false;
+  }
+  if (IsCallerRecursive &&
+      AllocatedSize > InlineConstants::TotalAllocaSizeRecursiveCaller) {
+    emitRecursiveCallerRemark();
+    return false;
+  }
+  return true;
+}
+
 /// \brief Analyze a call site for potential inlining.
 ///
 /// Returns true if inlining this call is viable, and false if it is not
@@ -1470,7 +1805,7 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
     Cost += InlineConstants::ColdccPenalty;
 
   // Check if we're done. This can happen due to bonuses and penalties.
-  if (Cost >= Threshold && !ComputeFullInlineCost)
+  if (Cost >= Threshold && !ComputeFullCost)
     return false;
 
   if (F.empty())
@@ -1513,88 +1848,14 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
   NumConstantOffsetPtrArgs = ConstantOffsetPtrs.size();
   NumAllocaArgs = SROAArgValues.size();
 
-  // FIXME: If a caller has multiple calls to a callee, we end up recomputing
-  // the ephemeral values multiple times (and they're completely determined by
-  // the callee, so this is purely duplicate work).
-  SmallPtrSet<const Value *, 32> EphValues;
-  CodeMetrics::collectEphemeralValues(&F, &GetAssumptionCache(F), EphValues);
-
-  // The worklist of live basic blocks in the callee *after* inlining. We avoid
-  // adding basic blocks of the callee which can be proven to be dead for this
-  // particular call site in order to get more accurate cost estimates. This
-  // requires a somewhat heavyweight iteration pattern: we need to walk the
-  // basic blocks in a breadth-first order as we insert live successors. To
-  // accomplish this, prioritizing for small iterations because we exit after
-  // crossing our threshold, we use a small-size optimized SetVector.
-  typedef SetVector<BasicBlock *, SmallVector<BasicBlock *, 16>,
-                    SmallPtrSet<BasicBlock *, 16>>
-      BBSetVector;
-  BBSetVector BBWorklist;
-  BBWorklist.insert(&F.getEntryBlock());
-  bool SingleBB = true;
-  // Note that we *must not* cache the size, this loop grows the worklist.
-  for (unsigned Idx = 0; Idx != BBWorklist.size(); ++Idx) {
-    // Bail out the moment we cross the threshold. This means we'll under-count
-    // the cost, but only when undercounting doesn't matter.
-    if (Cost >= Threshold && !ComputeFullInlineCost)
-      break;
-
-    BasicBlock *BB = BBWorklist[Idx];
-    if (BB->empty())
-      continue;
-
-    // Disallow inlining a blockaddress. A blockaddress only has defined
-    // behavior for an indirect branch in the same function, and we do not
-    // currently support inlining indirect branches. But, the inliner may not
-    // see an indirect branch that ends up being dead code at a particular call
-    // site. If the blockaddress escapes the function, e.g., via a global
-    // variable, inlining may lead to an invalid cross-function reference.
-    if (BB->hasAddressTaken())
-      return false;
-
-    // Analyze the cost of this block. If we blow through the threshold, this
-    // returns false, and we can bail on out.
-    if (!analyzeBlock(BB, EphValues))
-      return false;
-
-    TerminatorInst *TI = BB->getTerminator();
-
-    // Add in the live successors by first checking whether we have terminator
-    // that may be simplified based on the values simplified by this call.
-    if (BranchInst *BI = dyn_cast<BranchInst>(TI)) {
-      if (BI->isConditional()) {
-        Value *Cond = BI->getCondition();
-        if (ConstantInt *SimpleCond =
-                dyn_cast_or_null<ConstantInt>(SimplifiedValues.lookup(Cond))) {
-          BBWorklist.insert(BI->getSuccessor(SimpleCond->isZero() ? 1 : 0));
-          continue;
-        }
-      }
-    } else if (SwitchInst *SI = dyn_cast<SwitchInst>(TI)) {
-      Value *Cond = SI->getCondition();
-      if (ConstantInt *SimpleCond =
-              dyn_cast_or_null<ConstantInt>(SimplifiedValues.lookup(Cond))) {
-        BBWorklist.insert(SI->findCaseValue(SimpleCond)->getCaseSuccessor());
-        continue;
-      }
-    }
-
-    // If we're unable to select a particular successor, just count all of
-    // them.
-    for (unsigned TIdx = 0, TSize = TI->getNumSuccessors(); TIdx != TSize;
-         ++TIdx)
-      BBWorklist.insert(TI->getSuccessor(TIdx));
-
-    // If we had any successors at this point, than post-inlining is likely to
-    // have them as well. Note that we assume any basic blocks which existed
-    // due to branches or switches which folded above will also fold after
-    // inlining.
-    if (SingleBB && TI->getNumSuccessors() > 1) {
-      // Take off the bonus we applied to the threshold.
-      Threshold -= SingleBBBonus;
-      SingleBB = false;
-    }
-  }
+  // Walk the callee body, unless an earlier call site that binds the
+  // arguments the same way has walked it already.
+  SmallVector<InlineCostCacheImpl::ArgBinding, 4> Bindings;
+  bool Viable = Cache && getArgBindings(Bindings)
+                    ? analyzeCalleeWithCache(Bindings)
+                    : analyzeCallee();
+  if (!Viable)
+    return false;
 
   bool OnlyOneCallAndLocalLinkage =
       F.hasLocalLinkage() && F.hasOneUse() && &F == CS.getCalledFunction();
@@ -1680,9 +1941,10 @@ InlineCost llvm::getInlineCost(
     CallSite CS, const InlineParams &Params, TargetTransformInfo &CalleeTTI,
     std::function<AssumptionCache &(Function &)> &GetAssumptionCache,
     Optional<function_ref<BlockFrequencyInfo &(Function &)>> GetBFI,
-    ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE) {
+    ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE,
+    InlineCostCache *Cache) {
   return getInlineCost(CS, CS.getCalledFunction(), Params, CalleeTTI,
-                       GetAssumptionCache, GetBFI, PSI, ORE);
+                       GetAssumptionCache, GetBFI, PSI, ORE, Cache);
 }
 
 InlineCost llvm::getInlineCost(
@@ -1690,7 +1952,8 @@ InlineCost llvm::getInlineCost(
     TargetTransformInfo &CalleeTTI,
     std::function<AssumptionCache &(Function &)> &GetAssumptionCache,
     Optional<function_ref<BlockFrequencyInfo &(Function &)>> GetBFI,
-    ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE) {
+    ProfileSummaryInfo *PSI, OptimizationRemarkEmitter *ORE,
+    InlineCostCache *Cache) {
 
   // Cannot inline indirect calls.
   if (!Callee)
@@ -1729,7 +1992,7 @@ InlineCost llvm::getInlineCost(
                      << "... (caller:" << Caller->getName() << ")\n");
 
   CallAnalyzer CA(CalleeTTI, GetAssumptionCache, GetBFI, PSI, ORE, *Callee, CS,
-                  Params);
+                  Params, Cache ? &Cache->getImpl() : nullptr);
   bool ShouldInline = CA.analyzeCall(CS);
 
   DEBUG(CA.dump());
@@ -0,0 +1,53 @@
+//===- KnownBitsCache.cpp - Memoize known bits ----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements KnownBitsCache.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/KnownBitsCache.h"
+#include "llvm/IR/Instruction.h"
+
+using namespace llvm;
+
+void KnownBitsCache::DeletionCallbackVH::deleted() {
+  // The cache doesn't know which of its entries depend on the value, and a new
+  // value may reuse its address, so drop all of them.
+  Cache->clear();
+  // 'this' now dangles!
+}
+
+void KnownBitsCache::watch(const Value *V) {
+  // Look the value up before making a handle for it, as creating a handle is
+  // the expensive part.
+  if (!V || Watched.find_as(V) != Watched.end())
+    return;
+  Watched.insert(DeletionCallbackVH(const_cast<Value *>(V), this));
+}
+
+void KnownBitsCache::insertKnownBits(const Value *V, const Instruction *CxtI,
+                                     unsigned Depth, const KnownBits &Known) {
+  watch(V);
+  watch(CxtI);
+  KnownBitsMap[getKey(V, CxtI, Depth)] = Known;
+}
+
+void KnownBitsCache::insertNumSignBits(const Value *V,
+                                       const Instruction *CxtI, unsigned Depth,
+                                       unsigned NumSignBits) {
+  watch(V);
+  watch(CxtI);
+  NumSignBitsMap[getKey(V, CxtI, Depth)] = NumSignBits;
+}
+
+void KnownBitsCache::clear() {
+  KnownBitsMap.clear();
+  NumSignBitsMap.clear();
+  Watched.clear();
+}
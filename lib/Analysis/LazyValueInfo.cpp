@@ -14,7 +14,9 @@
 
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/InstructionSimplify.h"
@@ -32,6 +34,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/PatternMatch.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/raw_ostream.h"
@@ -42,10 +45,17 @@ using namespace PatternMatch;
 
 #define DEBUG_TYPE "lazy-value-info"
 
+STATISTIC(NumBlocksEvicted, "Number of blocks evicted from the cache");
+
 // This is the number of worklist items we will process to try to discover an
 // answer for a given value.
 static const unsigned MaxProcessedPerValue = 500;
 
+static cl::opt<unsigned> MaxCacheEntries(
+    "lvi-max-cache-entries", cl::Hidden, cl::init(1000000),
+    cl::desc("Maximum number of block values kept in the LazyValueInfo cache "
+             "(0 = unlimited)"));
+
 char LazyValueInfoWrapperPass::ID = 0;
 INITIALIZE_PASS_BEGIN(LazyValueInfoWrapperPass, "lazy-value-info",
                 "Lazy Value Information Analysis", false, true)
@@ -355,12 +365,9 @@ namespace {
   /// A callback value handle updates the cache when values are erased.
   class LazyValueInfoCache;
   struct LVIValueHandle final : public CallbackVH {
-    // Needs to access getValPtr(), which is protected.
-    friend struct DenseMapInfo<LVIValueHandle>;
-
     LazyValueInfoCache *Parent;
 
-    LVIValueHandle(Value *V, LazyValueInfoCache *P)
+    LVIValueHandle(Value *V, LazyValueInfoCache *P = nullptr)
       : CallbackVH(V), Parent(P) { }
 
     void deleted() override;
@@ -370,94 +377,204 @@ namespace {
   };
 } // end anonymous namespace
 
+namespace {
+  /// A lattice value as the cache stores it, in a single pointer for the
+  /// common states. Undefined is a null constant, and a constant or
+  /// not-constant is the constant itself. An integer range of one element, or
+  /// of all but one element, is stored as the ConstantInt of that element,
+  /// which is how LVILatticeVal builds those ranges from ConstantInts in the
+  /// first place. Only other ranges are allocated out of line. Over-defined
+  /// values aren't stored as lattice values at all.
+  class CompactLatticeVal {
+    enum KindTy { ConstantKind, NotConstantKind, RangeKind };
+
+    PointerIntPair<void *, 2, KindTy> Val;
+
+    void reset() {
+      if (Val.getInt() == RangeKind)
+        delete static_cast<ConstantRange *>(Val.getPointer());
+      Val.setPointerAndInt(nullptr, ConstantKind);
+    }
+
+  public:
+    CompactLatticeVal() : Val(nullptr, ConstantKind) {}
+
+    CompactLatticeVal(const LVILatticeVal &LV, LLVMContext &Ctx)
+        : Val(nullptr, ConstantKind) {
+      assert(!LV.isOverdefined() && "Over-defined values have no entry!");
+      if (LV.isConstant())
+        Val.setPointerAndInt(LV.getConstant(), ConstantKind);
+      else if (LV.isNotConstant())
+        Val.setPointerAndInt(LV.getNotConstant(), NotConstantKind);
+      else if (LV.isConstantRange()) {
+        const ConstantRange &CR = LV.getConstantRange();
+        if (const APInt *C = CR.getSingleElement())
+          Val.setPointerAndInt(ConstantInt::get(Ctx, *C), ConstantKind);
+        else if (const APInt *C = CR.getSingleMissingElement())
+          Val.setPointerAndInt(ConstantInt::get(Ctx, *C), NotConstantKind);
+        else
+          Val.setPointerAndInt(new ConstantRange(CR), RangeKind);
+      }
+    }
+
+    CompactLatticeVal(CompactLatticeVal &&Other) : Val(Other.Val) {
+      Other.Val.setPointerAndInt(nullptr, ConstantKind);
+    }
+
+    CompactLatticeVal &operator=(CompactLatticeVal &&Other) {
+      if (this != &Other) {
+        reset();
+        Val = Other.Val;
+        Other.Val.setPointerAndInt(nullptr, ConstantKind);
+      }
+      return *this;
+    }
+
+    CompactLatticeVal(const CompactLatticeVal &) = delete;
+    CompactLatticeVal &operator=(const CompactLatticeVal &) = delete;
+
+    ~CompactLatticeVal() { reset(); }
+
+    LVILatticeVal get() const {
+      switch (Val.getInt()) {
+      case ConstantKind:
+        if (!Val.getPointer())
+          return LVILatticeVal();
+        return LVILatticeVal::get(static_cast<Constant *>(Val.getPointer()));
+      case NotConstantKind:
+        return LVILatticeVal::getNot(static_cast<Constant *>(Val.getPointer()));
+      case RangeKind:
+        return LVILatticeVal::getRange(
+            *static_cast<ConstantRange *>(Val.getPointer()));
+      }
+      llvm_unreachable("Unknown lattice value kind!");
+    }
+  };
+} // end anonymous namespace
+
 namespace {
   /// This is the cache kept by LazyValueInfo which
   /// maintains information about queries across the clients' queries.
+  ///
+  /// The cache holds at most MaxCacheEntries values, counted per block, at
+  /// the start of a query. Blocks over the budget are evicted whole with the
+  /// clock algorithm: each block has a referenced bit that lookups set, and
+  /// the clock hand clears the bits of the blocks it passes and evicts the
+  /// first block it finds cleared. Evicted values are simply recomputed when
+  /// they are queried again.
   class LazyValueInfoCache {
-    /// This is all of the cached block information for exactly one Value*.
-    /// The entries are sorted by the BasicBlock* of the
-    /// entries, allowing us to do a lookup with a binary search.
-    /// Over-defined lattice values are recorded in OverDefinedCache to reduce
+    /// This is all of the cached information for exactly one block.
+    /// Over-defined lattice values are recorded in OverDefined to reduce
     /// memory overhead.
-    struct ValueCacheEntryTy {
-      ValueCacheEntryTy(Value *V, LazyValueInfoCache *P) : Handle(V, P) {}
-      LVIValueHandle Handle;
-      SmallDenseMap<PoisoningVH<BasicBlock>, LVILatticeVal, 4> BlockVals;
+    struct BlockCacheEntry {
+      BlockCacheEntry(BasicBlock *BB, unsigned ClockIndex)
+          : BB(BB), ClockIndex(ClockIndex) {}
+
+      BasicBlock *BB;
+      /// The position of the entry in Clock.
+      unsigned ClockIndex;
+      /// Set when the entry is used, and cleared when the clock hand passes.
+      mutable bool Referenced = true;
+
+      SmallPtrSet<Value *, 4> OverDefined;
+      SmallDenseMap<Value *, CompactLatticeVal, 4> LatticeElements;
+
+      unsigned size() const {
+        return OverDefined.size() + LatticeElements.size();
+      }
     };
 
-    /// This tracks, on a per-block basis, the set of values that are
-    /// over-defined at the end of that block.
-    typedef DenseMap<PoisoningVH<BasicBlock>, SmallPtrSet<Value *, 4>>
-        OverDefinedCacheTy;
-    /// Keep track of all blocks that we have ever seen, so we
-    /// don't spend time removing unused blocks from our caches.
-    DenseSet<PoisoningVH<BasicBlock> > SeenBlocks;
+    DenseMap<PoisoningVH<BasicBlock>, std::unique_ptr<BlockCacheEntry>>
+        BlockCache;
 
-    /// This is all of the cached information for all values,
-    /// mapped from Value* to key information.
-    DenseMap<Value *, std::unique_ptr<ValueCacheEntryTy>> ValueCache;
-    OverDefinedCacheTy OverDefinedCache;
+    /// Handles for the values that have been cached, to erase them from the
+    /// cache when they are deleted.
+    DenseSet<LVIValueHandle, DenseMapInfo<Value *>> ValueHandles;
 
+    /// The entries of BlockCache in the order the clock hand visits them.
+    std::vector<BlockCacheEntry *> Clock;
+    unsigned ClockHand = 0;
+
+    /// The number of values cached over all the blocks.
+    unsigned NumEntries = 0;
+
+    const BlockCacheEntry *getBlockEntry(BasicBlock *BB) const {
+      auto I = BlockCache.find(BB);
+      if (I == BlockCache.end())
+        return nullptr;
+      I->second->Referenced = true;
+      return I->second.get();
+    }
+
+    BlockCacheEntry &getOrCreateBlockEntry(BasicBlock *BB) {
+      auto &Entry = BlockCache[BB];
+      if (!Entry) {
+        Entry = make_unique<BlockCacheEntry>(BB, Clock.size());
+        Clock.push_back(Entry.get());
+      }
+      Entry->Referenced = true;
+      return *Entry;
+    }
+
+    void removeBlockEntry(BasicBlock *BB);
 
   public:
     void insertResult(Value *Val, BasicBlock *BB, const LVILatticeVal &Result) {
-      SeenBlocks.insert(BB);
+      BlockCacheEntry &Entry = getOrCreateBlockEntry(BB);
+      if (ValueHandles.find_as(Val) == ValueHandles.end())
+        ValueHandles.insert(LVIValueHandle(Val, this));
 
-      // Insert over-defined values into their own cache to reduce memory
+      // Insert over-defined values into their own set to reduce memory
       // overhead.
-      if (Result.isOverdefined())
-        OverDefinedCache[BB].insert(Val);
-      else {
-        auto It = ValueCache.find_as(Val);
-        if (It == ValueCache.end()) {
-          ValueCache[Val] = make_unique<ValueCacheEntryTy>(Val, this);
-          It = ValueCache.find_as(Val);
-          assert(It != ValueCache.end() && "Val was just added to the map!");
-        }
-        It->second->BlockVals[BB] = Result;
+      if (Result.isOverdefined()) {
+        if (Entry.OverDefined.insert(Val).second)
+          ++NumEntries;
+      } else {
+        auto Inserted = Entry.LatticeElements.try_emplace(Val);
+        if (Inserted.second)
+          ++NumEntries;
+        Inserted.first->second = CompactLatticeVal(Result, Val->getContext());
       }
     }
 
     bool isOverdefined(Value *V, BasicBlock *BB) const {
-      auto ODI = OverDefinedCache.find(BB);
-
-      if (ODI == OverDefinedCache.end())
-        return false;
-
-      return ODI->second.count(V);
+      const BlockCacheEntry *Entry = getBlockEntry(BB);
+      return Entry && Entry->OverDefined.count(V);
     }
 
     bool hasCachedValueInfo(Value *V, BasicBlock *BB) const {
-      if (isOverdefined(V, BB))
-        return true;
-
-      auto I = ValueCache.find_as(V);
-      if (I == ValueCache.end())
-        return false;
-
-      return I->second->BlockVals.count(BB);
+      const BlockCacheEntry *Entry = getBlockEntry(BB);
+      return Entry && (Entry->OverDefined.count(V) ||
+                       Entry->LatticeElements.count(V));
     }
 
     LVILatticeVal getCachedValueInfo(Value *V, BasicBlock *BB) const {
-      if (isOverdefined(V, BB))
+      const BlockCacheEntry *Entry = getBlockEntry(BB);
+      if (!Entry)
+        return LVILatticeVal();
+      if (Entry->OverDefined.count(V))
         return LVILatticeVal::getOverdefined();
 
-      auto I = ValueCache.find_as(V);
-      if (I == ValueCache.end())
-        return LVILatticeVal();
-      auto BBI = I->second->BlockVals.find(BB);
-      if (BBI == I->second->BlockVals.end())
+      auto I = Entry->LatticeElements.find(V);
+      if (I == Entry->LatticeElements.end())
         return LVILatticeVal();
-      return BBI->second;
+      return I->second.get();
     }
 
     /// clear - Empty the cache.
     void clear() {
-      SeenBlocks.clear();
-      ValueCache.clear();
-      OverDefinedCache.clear();
+      BlockCache.clear();
+      ValueHandles.clear();
+      Clock.clear();
+      ClockHand = 0;
+      NumEntries = 0;
     }
 
+    /// Evict blocks until the cache is well within its budget, if it is over
+    /// it. This must not be called while a query is being solved, as the
+    /// solver expects the values it has computed to stay in the cache.
+    void evictOverBudget();
+
     /// Inform the cache that a given value has been deleted.
     void eraseValue(Value *V);
 
@@ -474,18 +591,51 @@ namespace {
   };
 }
 
+void LazyValueInfoCache::removeBlockEntry(BasicBlock *BB) {
+  auto I = BlockCache.find(BB);
+  assert(I != BlockCache.end() && "Block isn't in the cache!");
+  BlockCacheEntry *Entry = I->second.get();
+  NumEntries -= Entry->size();
+
+  // Move the last entry of the clock into the place of this one.
+  Clock[Entry->ClockIndex] = Clock.back();
+  Clock[Entry->ClockIndex]->ClockIndex = Entry->ClockIndex;
+  Clock.pop_back();
+
+  BlockCache.erase(I);
+}
+
+void LazyValueInfoCache::evictOverBudget() {
+  if (!MaxCacheEntries || NumEntries <= MaxCacheEntries)
+    return;
+
+  // Leave some room so that the next queries don't evict again right away.
+  unsigned Target = MaxCacheEntries - MaxCacheEntries / 4;
+  while (NumEntries > Target) {
+    if (ClockHand >= Clock.size())
+      ClockHand = 0;
+    BlockCacheEntry *Entry = Clock[ClockHand];
+    if (Entry->Referenced) {
+      Entry->Referenced = false;
+      ++ClockHand;
+      continue;
+    }
+    // The last entry takes its place, so the hand stays where it is.
+    ++NumBlocksEvicted;
+    removeBlockEntry(Entry->BB);
+  }
+}
+
 void LazyValueInfoCache::eraseValue(Value *V) {
-  for (auto I = OverDefinedCache.begin(), E = OverDefinedCache.end(); I != E;) {
-    // Copy and increment the iterator immediately so we can erase behind
-    // ourselves.
-    auto Iter = I++;
-    SmallPtrSetImpl<Value *> &ValueSet = Iter->second;
-    ValueSet.erase(V);
-    if (ValueSet.empty())
-      OverDefinedCache.erase(Iter);
+  for (auto &I : BlockCache) {
+    BlockCacheEntry &Entry = *I.second;
+    NumEntries -= Entry.OverDefined.erase(V);
+    NumEntries -= Entry.LatticeElements.erase(V);
   }
 
-  ValueCache.erase(V);
+  auto HandleIt = ValueHandles.find_as(V);
+  if (HandleIt != ValueHandles.end())
+    ValueHandles.erase(HandleIt);
 }
 
 void LVIValueHandle::deleted() {
@@ -496,17 +646,9 @@ void LVIValueHandle::deleted() {
 
 void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
   // Shortcut if we have never seen this block.
-  DenseSet<PoisoningVH<BasicBlock> >::iterator I = SeenBlocks.find(BB);
-  if (I == SeenBlocks.end())
+  if (BlockCache.find(BB) == BlockCache.end())
     return;
-  SeenBlocks.erase(I);
-
-  auto ODI = OverDefinedCache.find(BB);
-  if (ODI != OverDefinedCache.end())
-    OverDefinedCache.erase(ODI);
-
-  for (auto &I : ValueCache)
-    I.second->BlockVals.erase(BB);
+  removeBlockEntry(BB);
 }
 
 void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
@@ -524,10 +666,11 @@ void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
   std::vector<BasicBlock*> worklist;
   worklist.push_back(OldSucc);
 
-  auto I = OverDefinedCache.find(OldSucc);
-  if (I == OverDefinedCache.end())
+  auto I = BlockCache.find(OldSucc);
+  if (I == BlockCache.end() || I->second->OverDefined.empty())
     return; // Nothing to process here.
-  SmallVector<Value *, 4> ValsToClear(I->second.begin(), I->second.end());
+  SmallVector<Value *, 4> ValsToClear(I->second->OverDefined.begin(),
+                                      I->second->OverDefined.end());
 
   // Use a worklist to perform a depth-first search of OldSucc's successors.
   // NOTE: We do not need a visited list since any blocks we have already
@@ -541,10 +684,10 @@ void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
     if (ToUpdate == NewSucc) continue;
 
     // If a value was marked overdefined in OldSucc, and is here too...
-    auto OI = OverDefinedCache.find(ToUpdate);
-    if (OI == OverDefinedCache.end())
+    auto OI = BlockCache.find(ToUpdate);
+    if (OI == BlockCache.end())
       continue;
-    SmallPtrSetImpl<Value *> &ValueSet = OI->second;
+    SmallPtrSetImpl<Value *> &ValueSet = OI->second->OverDefined;
 
     bool changed = false;
     for (Value *V : ValsToClear) {
@@ -554,11 +697,10 @@ void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
       // If we removed anything, then we potentially need to update
       // blocks successors too.
       changed = true;
+      --NumEntries;
 
-      if (ValueSet.empty()) {
-        OverDefinedCache.erase(OI);
+      if (ValueSet.empty())
         break;
-      }
     }
 
     if (!changed) continue;
@@ -783,8 +925,8 @@ bool LazyValueInfoImpl::solveBlockValue(Value *Val, BasicBlock *BB) {
                  << "' val=" << TheCache.getCachedValueInfo(Val, BB) << '\n');
 
     // Since we're reusing a cached value, we don't need to update the
-    // OverDefinedCache. The cache will have been properly updated whenever the
-    // cached value was inserted.
+    // over-defined sets. The cache will have been properly updated whenever
+    // the cached value was inserted.
     return true;
   }
 
@@ -1590,6 +1732,7 @@ LVILatticeVal LazyValueInfoImpl::getValueInBlock(Value *V, BasicBlock *BB,
         << BB->getName() << "'\n");
 
   assert(BlockValueStack.empty() && BlockValueSet.empty());
+  TheCache.evictOverBudget();
   if (!hasBlockValue(V, BB)) {
     pushBlockValue(std::make_pair(BB, V));
     solve();
@@ -1623,6 +1766,7 @@ getValueOnEdge(Value *V, BasicBlock *FromBB, BasicBlock *ToBB,
   DEBUG(dbgs() << "LVI Getting edge value " << *V << " from '"
         << FromBB->getName() << "' to '" << ToBB->getName() << "'\n");
 
+  TheCache.evictOverBudget();
   LVILatticeVal Result;
   if (!getEdgeValue(V, FromBB, ToBB, Result, CxtI)) {
     solve();
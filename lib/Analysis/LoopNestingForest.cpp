@@ -0,0 +1,291 @@
+//===- LoopNestingForest.cpp - Cycles of reducible and irreducible CFGs ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the LoopNestingForest analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/LoopNestingForest.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/raw_ostream.h"
+#include <utility>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "loop-nesting-forest"
+
+//===----------------------------------------------------------------------===//
+//  NestedCycle Implementation
+//===----------------------------------------------------------------------===//
+
+void NestedCycle::print(raw_ostream &OS) const {
+  OS << "Cycle at depth " << Depth;
+  if (Irreducible)
+    OS << " (irreducible)";
+  OS << " containing: ";
+  for (unsigned I = 0, E = Blocks.size(); I != E; ++I) {
+    if (I)
+      OS << ",";
+    Blocks[I]->printAsOperand(OS, false);
+    if (Blocks[I] == Header)
+      OS << "<header>";
+    if (is_contained(Entries, Blocks[I]))
+      OS << "<entry>";
+  }
+}
+
+//===----------------------------------------------------------------------===//
+//  LoopNestingForest Implementation
+//===----------------------------------------------------------------------===//
+
+void LoopNestingForest::recalculate(const Function &F) {
+  releaseMemory();
+  if (F.empty())
+    return;
+
+  // Number the blocks reachable from the entry in depth-first preorder with
+  // an iterative walk, so deep CFGs cannot overflow the stack. Last[N] is the
+  // highest number in the depth-first subtree of block N, so N is an ancestor
+  // of M exactly when N <= M <= Last[N].
+  std::vector<const BasicBlock *> Nodes;
+  std::vector<unsigned> Last;
+  DenseMap<const BasicBlock *, unsigned> Number;
+  SmallVector<std::pair<unsigned, succ_const_iterator>, 32> VisitStack;
+
+  auto Visit = [&](const BasicBlock *BB) {
+    Number[BB] = Nodes.size();
+    VisitStack.push_back(std::make_pair(Nodes.size(), succ_begin(BB)));
+    Nodes.push_back(BB);
+    Last.push_back(0);
+  };
+
+  Visit(&F.getEntryBlock());
+  while (!VisitStack.empty()) {
+    unsigned Idx = VisitStack.back().first;
+    succ_const_iterator &Next = VisitStack.back().second;
+    if (Next != succ_end(Nodes[Idx])) {
+      const BasicBlock *Succ = *Next++;
+      if (!Number.count(Succ))
+        Visit(Succ);
+      continue;
+    }
+    VisitStack.pop_back();
+    Last[Idx] = Nodes.size() - 1;
+  }
+  unsigned NumNodes = Nodes.size();
+
+  auto IsAncestor = [&](unsigned N, unsigned M) {
+    return N <= M && M <= Last[N];
+  };
+
+  // Split the predecessors of every block into back edge sources, which are
+  // depth-first descendants of the block, and all the others.
+  std::vector<SmallVector<unsigned, 4>> BackPreds(NumNodes);
+  std::vector<SmallVector<unsigned, 4>> NonBackPreds(NumNodes);
+  BitVector SelfLoop(NumNodes);
+  for (unsigned W = 0; W != NumNodes; ++W)
+    for (const BasicBlock *Pred : predecessors(Nodes[W])) {
+      auto It = Number.find(Pred);
+      if (It == Number.end())
+        continue;
+      unsigned V = It->second;
+      if (V == W)
+        SelfLoop.set(W);
+      else if (IsAncestor(W, V))
+        BackPreds[W].push_back(V);
+      else
+        NonBackPreds[W].push_back(V);
+    }
+
+  // Havlak's algorithm: visit the blocks in reverse preorder, so inner cycles
+  // are found first and collapsed into their headers with a union-find. The
+  // body of the cycle headed by W is everything that reaches a back edge
+  // source of W without leaving the depth-first subtree of W. A path that
+  // enters the body from outside that subtree makes the cycle irreducible,
+  // and the edge is handed to W so enclosing cycles still see it.
+  const unsigned NoHeader = ~0U;
+  std::vector<unsigned> HeaderOf(NumNodes, NoHeader);
+  std::vector<unsigned> Representative(NumNodes);
+  std::vector<unsigned> Mark(NumNodes, NoHeader);
+  for (unsigned N = 0; N != NumNodes; ++N)
+    Representative[N] = N;
+  auto Find = [&](unsigned N) {
+    while (Representative[N] != N) {
+      Representative[N] = Representative[Representative[N]];
+      N = Representative[N];
+    }
+    return N;
+  };
+
+  BitVector IsHeader(NumNodes), IsIrreducible(NumNodes);
+  SmallVector<unsigned, 32> Body;
+  for (unsigned W = NumNodes; W-- != 0;) {
+    Body.clear();
+    for (unsigned V : BackPreds[W]) {
+      unsigned X = Find(V);
+      if (X != W && Mark[X] != W) {
+        Mark[X] = W;
+        Body.push_back(X);
+      }
+    }
+    if (Body.empty() && !SelfLoop.test(W))
+      continue;
+
+    for (unsigned I = 0; I != Body.size(); ++I)
+      for (unsigned Y : NonBackPreds[Body[I]]) {
+        unsigned Z = Find(Y);
+        if (!IsAncestor(W, Z)) {
+          IsIrreducible.set(W);
+          NonBackPreds[W].push_back(Z);
+        } else if (Z != W && Mark[Z] != W) {
+          Mark[Z] = W;
+          Body.push_back(Z);
+        }
+      }
+
+    IsHeader.set(W);
+    for (unsigned X : Body) {
+      HeaderOf[X] = W;
+      Representative[X] = W;
+    }
+  }
+
+  // Materialize the cycles. Every header has a lower preorder number than the
+  // blocks of its cycle, including nested headers, so walking in preorder
+  // creates each cycle before the cycles nested in it and adds its header to
+  // it first.
+  std::vector<NestedCycle *> CycleOf(NumNodes, nullptr);
+  for (unsigned N = 0; N != NumNodes; ++N) {
+    BasicBlock *BB = const_cast<BasicBlock *>(Nodes[N]);
+    NestedCycle *Innermost =
+        HeaderOf[N] == NoHeader ? nullptr : CycleOf[HeaderOf[N]];
+    if (IsHeader.test(N)) {
+      Cycles.emplace_back(new NestedCycle(BB, Innermost));
+      NestedCycle *C = Cycles.back().get();
+      C->Irreducible = IsIrreducible.test(N);
+      if (Innermost)
+        Innermost->SubCycles.push_back(C);
+      else
+        TopLevelCycles.push_back(C);
+      CycleOf[N] = Innermost = C;
+    }
+    if (!Innermost)
+      continue;
+    BlockMap[BB] = Innermost;
+    for (NestedCycle *C = Innermost; C; C = C->Parent)
+      C->Blocks.push_back(BB);
+  }
+
+  // A block is an entry of every cycle that contains it but not one of its
+  // predecessors. Predecessors that are unreachable from the entry block
+  // never transfer control and are ignored.
+  const BasicBlock *EntryBB = &F.getEntryBlock();
+  for (const BasicBlock &BB : F) {
+    NestedCycle *Innermost = getCycleFor(&BB);
+    if (!Innermost)
+      continue;
+    BasicBlock *Entry = const_cast<BasicBlock *>(&BB);
+    auto AddEntry = [&](const NestedCycle *PredCycle) {
+      for (NestedCycle *C = Innermost; C && !C->contains(PredCycle);
+           C = C->Parent)
+        if (C->Entries.empty() || C->Entries.back() != Entry)
+          C->Entries.push_back(Entry);
+    };
+    if (&BB == EntryBB)
+      AddEntry(nullptr);
+    for (const BasicBlock *Pred : predecessors(&BB))
+      if (Number.count(Pred))
+        AddEntry(getCycleFor(Pred));
+  }
+}
+
+unsigned LoopNestingForest::getNumIrreducibleCycles() const {
+  unsigned NumIrreducible = 0;
+  for (const std::unique_ptr<NestedCycle> &C : Cycles)
+    NumIrreducible += C->isIrreducible();
+  return NumIrreducible;
+}
+
+unsigned LoopNestingForest::getNumMultiEntryCycles() const {
+  unsigned NumMultiEntry = 0;
+  for (const std::unique_ptr<NestedCycle> &C : Cycles)
+    NumMultiEntry += C->isMultiEntry();
+  return NumMultiEntry;
+}
+
+void LoopNestingForest::releaseMemory() {
+  Cycles.clear();
+  TopLevelCycles.clear();
+  BlockMap.clear();
+}
+
+void LoopNestingForest::print(raw_ostream &OS) const {
+  forEachCycle([&](const NestedCycle &C) {
+    OS.indent(C.getDepth() * 2);
+    C.print(OS);
+    OS << "\n";
+  });
+}
+
+bool LoopNestingForest::invalidate(Function &F, const PreservedAnalyses &PA,
+                                   FunctionAnalysisManager::Invalidator &) {
+  // Check whether the analysis, all analyses on functions, or the function's
+  // CFG have been preserved.
+  auto PAC = PA.getChecker<LoopNestingForestAnalysis>();
+  return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Function>>() ||
+           PAC.preservedSet<CFGAnalyses>());
+}
+
+//===----------------------------------------------------------------------===//
+//  LoopNestingForestAnalysis and LoopNestingForestPrinterPass Implementation
+//===----------------------------------------------------------------------===//
+
+AnalysisKey LoopNestingForestAnalysis::Key;
+
+LoopNestingForest LoopNestingForestAnalysis::run(Function &F,
+                                                 FunctionAnalysisManager &) {
+  return LoopNestingForest(F);
+}
+
+LoopNestingForestPrinterPass::LoopNestingForestPrinterPass(raw_ostream &OS)
+    : OS(OS) {}
+
+PreservedAnalyses
+LoopNestingForestPrinterPass::run(Function &F, FunctionAnalysisManager &AM) {
+  OS << "LoopNestingForest for function: " << F.getName() << "\n";
+  AM.getResult<LoopNestingForestAnalysis>(F).print(OS);
+
+  return PreservedAnalyses::all();
+}
+
+//===----------------------------------------------------------------------===//
+//  LoopNestingForestWrapperPass Implementation
+//===----------------------------------------------------------------------===//
+
+char LoopNestingForestWrapperPass::ID = 0;
+
+INITIALIZE_PASS(LoopNestingForestWrapperPass, "loop-nesting-forest",
+                "Loop Nesting Forest Construction", true, true)
+
+LoopNestingForestWrapperPass::LoopNestingForestWrapperPass()
+    : FunctionPass(ID) {
+  initializeLoopNestingForestWrapperPassPass(*PassRegistry::getPassRegistry());
+}
+
+bool LoopNestingForestWrapperPass::runOnFunction(Function &F) {
+  LNF.recalculate(F);
+  return false;
+}
+
+void LoopNestingForestWrapperPass::print(raw_ostream &OS,
+                                         const Module *) const {
+  LNF.print(OS);
+}
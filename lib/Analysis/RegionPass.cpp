@@ -16,6 +16,7 @@
 #include "llvm/Analysis/RegionPass.h"
 #include "llvm/Analysis/RegionIterator.h"
 #include "llvm/IR/OptBisect.h"
+#include "llvm/IR/PassMemoryInfo.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -95,6 +96,7 @@ bool RGPassManager::runOnFunction(Function &F) {
         PassManagerPrettyStackEntry X(P, *CurrentRegion->getEntry());
 
         TimeRegion PassTimer(getPassTimer(P));
+        AllocationRegion PassMemory(getPassMemoryRecord(P));
         Changed |= P->runOnRegion(CurrentRegion, *this);
       }
 
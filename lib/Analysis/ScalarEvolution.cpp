@@ -6197,7 +6197,10 @@ ScalarEvolution::getPredicatedBackedgeTakenInfo(const Loop *L) {
   BackedgeTakenInfo Result =
       computeBackedgeTakenCount(L, /*AllowPredicates=*/true);
 
-  return PredicatedBackedgeTakenCounts.find(L)->second = std::move(Result);
+  auto &PredBTI = PredicatedBackedgeTakenCounts.find(L)->second =
+      std::move(Result);
+  addBECountUsers(L, /*Predicated=*/true, PredBTI);
+  return PredBTI;
 }
 
 const ScalarEvolution::BackedgeTakenInfo &
@@ -6272,67 +6275,120 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   // recusive call to getBackedgeTakenInfo (on a different
   // loop), which would invalidate the iterator computed
   // earlier.
-  return BackedgeTakenCounts.find(L)->second = std::move(Result);
+  auto &BTI = BackedgeTakenCounts.find(L)->second = std::move(Result);
+  addBECountUsers(L, /*Predicated=*/false, BTI);
+  return BTI;
+}
+
+namespace {
+
+/// Call a function once for every distinct subexpression of an expression,
+/// including the expression itself.
+template <typename FuncT> struct SubexpressionVisitor {
+  FuncT &Func;
+
+  SubexpressionVisitor(FuncT &Func) : Func(Func) {}
+
+  bool follow(const SCEV *S) {
+    Func(S);
+    return true;
+  }
+
+  bool isDone() const { return false; }
+};
+
+template <typename FuncT>
+void visitSubexpressions(const SCEV *S, FuncT Func) {
+  if (isa<SCEVCouldNotCompute>(S))
+    return;
+  SubexpressionVisitor<FuncT> Visitor(Func);
+  visitAll(S, Visitor);
+}
+
+} // end anonymous namespace
+
+void ScalarEvolution::addBECountUsers(const Loop *L, bool Predicated,
+                                      const BackedgeTakenInfo &BTI) {
+  SmallVector<const SCEV *, 4> Exprs;
+  BTI.getExpressions(Exprs, this);
+  PointerIntPair<const Loop *, 1, bool> User(L, Predicated);
+  for (const SCEV *Expr : Exprs)
+    visitSubexpressions(
+        Expr, [&](const SCEV *S) { BECountUsers[S].insert(User); });
+}
+
+void ScalarEvolution::addExitLimitUsers(const ExitLimitQuery &Query,
+                                        const ExitLimit &EL) {
+  auto AddUser = [&](const SCEV *S) { ExitLimitUsers[S].insert(Query); };
+  visitSubexpressions(EL.ExactNotTaken, AddUser);
+  if (EL.MaxNotTaken != EL.ExactNotTaken)
+    visitSubexpressions(EL.MaxNotTaken, AddUser);
 }
 
 void ScalarEvolution::forgetLoop(const Loop *L) {
   // Drop any stored trip count value.
   auto RemoveLoopFromBackedgeMap =
-      [L](DenseMap<const Loop *, BackedgeTakenInfo> &Map) {
-        auto BTCPos = Map.find(L);
+      [](DenseMap<const Loop *, BackedgeTakenInfo> &Map, const Loop *CurrL) {
+        auto BTCPos = Map.find(CurrL);
         if (BTCPos != Map.end()) {
           BTCPos->second.clear();
           Map.erase(BTCPos);
         }
       };
 
-  RemoveLoopFromBackedgeMap(BackedgeTakenCounts);
-  RemoveLoopFromBackedgeMap(PredicatedBackedgeTakenCounts);
+  SmallVector<const Loop *, 16> LoopWorklist(1, L);
+  SmallVector<Instruction *, 32> Worklist;
+  SmallPtrSet<Instruction *, 16> Visited;
+
+  // Forget the loop and all the loops it contains, to avoid dangling entries
+  // in the ValuesAtScopes map. The def-use walks of the loops of the nest
+  // share one visited set: most of what the PHIs of an inner loop reach has
+  // already been dropped from the PHIs of the loops around it.
+  while (!LoopWorklist.empty()) {
+    const Loop *CurrL = LoopWorklist.pop_back_val();
+
+    RemoveLoopFromBackedgeMap(BackedgeTakenCounts, CurrL);
+    RemoveLoopFromBackedgeMap(PredicatedBackedgeTakenCounts, CurrL);
+
+    // Drop information about predicated SCEV rewrites for this loop.
+    for (auto I = PredicatedSCEVRewrites.begin();
+         I != PredicatedSCEVRewrites.end();) {
+      std::pair<const SCEV *, const Loop *> Entry = I->first;
+      if (Entry.second == CurrL)
+        PredicatedSCEVRewrites.erase(I++);
+      else
+        ++I;
+    }
 
-  // Drop information about predicated SCEV rewrites for this loop.
-  for (auto I = PredicatedSCEVRewrites.begin();
-       I != PredicatedSCEVRewrites.end();) {
-    std::pair<const SCEV *, const Loop *> Entry = I->first;
-    if (Entry.second == L)
-      PredicatedSCEVRewrites.erase(I++);
-    else
-      ++I;
-  }
+    // Drop information about expressions based on loop-header PHIs.
+    PushLoopPHIs(CurrL, Worklist);
 
-  // Drop information about expressions based on loop-header PHIs.
-  SmallVector<Instruction *, 16> Worklist;
-  PushLoopPHIs(L, Worklist);
+    while (!Worklist.empty()) {
+      Instruction *I = Worklist.pop_back_val();
+      if (!Visited.insert(I).second)
+        continue;
 
-  SmallPtrSet<Instruction *, 8> Visited;
-  while (!Worklist.empty()) {
-    Instruction *I = Worklist.pop_back_val();
-    if (!Visited.insert(I).second)
-      continue;
+      ValueExprMapType::iterator It =
+        ValueExprMap.find_as(static_cast<Value *>(I));
+      if (It != ValueExprMap.end()) {
+        eraseValueFromMap(It->first);
+        forgetMemoizedResults(It->second);
+        if (PHINode *PN = dyn_cast<PHINode>(I))
+          ConstantEvolutionLoopExitValue.erase(PN);
+      }
 
-    ValueExprMapType::iterator It =
-      ValueExprMap.find_as(static_cast<Value *>(I));
-    if (It != ValueExprMap.end()) {
-      eraseValueFromMap(It->first);
-      forgetMemoizedResults(It->second);
-      if (PHINode *PN = dyn_cast<PHINode>(I))
-        ConstantEvolutionLoopExitValue.erase(PN);
+      PushDefUseChildren(I, Worklist);
     }
 
-    PushDefUseChildren(I, Worklist);
-  }
+    for (auto I = ExitLimits.begin(); I != ExitLimits.end(); ++I) {
+      auto &Query = I->first;
+      if (Query.L == CurrL)
+        ExitLimits.erase(I);
+    }
 
-  for (auto I = ExitLimits.begin(); I != ExitLimits.end(); ++I) {
-    auto &Query = I->first;
-    if (Query.L == L)
-      ExitLimits.erase(I);
+    LoopPropertiesCache.erase(CurrL);
+    LoopWorklist.append(CurrL->begin(), CurrL->end());
   }
-
-  // Forget all contained loops too, to avoid dangling entries in the
-  // ValuesAtScopes map.
-  for (Loop *I : *L)
-    forgetLoop(I);
-
-  LoopPropertiesCache.erase(L);
 }
 
 void ScalarEvolution::forgetValue(Value *V) {
@@ -6443,6 +6499,16 @@ bool ScalarEvolution::BackedgeTakenInfo::hasOperand(const SCEV *S,
   return false;
 }
 
+void ScalarEvolution::BackedgeTakenInfo::getExpressions(
+    SmallVectorImpl<const SCEV *> &Exprs, ScalarEvolution *SE) const {
+  if (getMax() && getMax() != SE->getCouldNotCompute())
+    Exprs.push_back(getMax());
+
+  for (auto &ENT : ExitNotTaken)
+    if (ENT.ExactNotTaken != SE->getCouldNotCompute())
+      Exprs.push_back(ENT.ExactNotTaken);
+}
+
 ScalarEvolution::ExitLimit::ExitLimit(const SCEV *E)
     : ExactNotTaken(E), MaxNotTaken(E) {
   assert((isa<SCEVCouldNotCompute>(MaxNotTaken) ||
@@ -6596,6 +6662,7 @@ ScalarEvolution::computeExitLimit(const Loop *L, BasicBlock *ExitingBlock,
     return MaybeEL->second;
   ExitLimit EL = computeExitLimitImpl(L, ExitingBlock, AllowPredicates);
   ExitLimits.insert({Query, EL});
+  addExitLimitUsers(Query, EL);
   return EL;
 }
 
@@ -10473,6 +10540,8 @@ ScalarEvolution::ScalarEvolution(ScalarEvolution &&Arg)
       PredicatedBackedgeTakenCounts(
           std::move(Arg.PredicatedBackedgeTakenCounts)),
       ExitLimits(std::move(Arg.ExitLimits)),
+      BECountUsers(std::move(Arg.BECountUsers)),
+      ExitLimitUsers(std::move(Arg.ExitLimitUsers)),
       ConstantEvolutionLoopExitValue(
           std::move(Arg.ConstantEvolutionLoopExitValue)),
       ValuesAtScopes(std::move(Arg.ValuesAtScopes)),
@@ -10903,27 +10972,37 @@ ScalarEvolution::forgetMemoizedResults(const SCEV *S, bool EraseExitLimit) {
       ++I;
   }
 
-  auto RemoveSCEVFromBackedgeMap =
-      [S, this](DenseMap<const Loop *, BackedgeTakenInfo> &Map) {
-        for (auto I = Map.begin(), E = Map.end(); I != E;) {
-          BackedgeTakenInfo &BEInfo = I->second;
-          if (BEInfo.hasOperand(S, this)) {
-            BEInfo.clear();
-            Map.erase(I++);
-          } else
-            ++I;
-        }
-      };
-
-  RemoveSCEVFromBackedgeMap(BackedgeTakenCounts);
-  RemoveSCEVFromBackedgeMap(PredicatedBackedgeTakenCounts);
+  // Only the counts recorded as users of S can refer to it. The counts of the
+  // other loops stay cached.
+  auto BECountIt = BECountUsers.find(S);
+  if (BECountIt != BECountUsers.end()) {
+    for (auto User : BECountIt->second) {
+      auto &Map = User.getInt() ? PredicatedBackedgeTakenCounts
+                                : BackedgeTakenCounts;
+      auto BTCPos = Map.find(User.getPointer());
+      // The count may have been dropped and recomputed without S since it was
+      // recorded.
+      if (BTCPos != Map.end() && BTCPos->second.hasOperand(S, this)) {
+        BTCPos->second.clear();
+        Map.erase(BTCPos);
+      }
+    }
+    BECountUsers.erase(BECountIt);
+  }
 
   // TODO: There is a suspicion that we only need to do it when there is a
   // SCEVUnknown somewhere inside S. Need to check this.
-  if (EraseExitLimit)
-    for (auto I = ExitLimits.begin(), E = ExitLimits.end(); I != E; ++I)
-      if (I->second.hasOperand(S))
-        ExitLimits.erase(I);
+  if (EraseExitLimit) {
+    auto ExitLimitIt = ExitLimitUsers.find(S);
+    if (ExitLimitIt != ExitLimitUsers.end()) {
+      for (const ExitLimitQuery &Query : ExitLimitIt->second) {
+        auto EL = ExitLimits.find(Query);
+        if (EL != ExitLimits.end() && EL->second.hasOperand(S))
+          ExitLimits.erase(EL);
+      }
+      ExitLimitUsers.erase(ExitLimitIt);
+    }
+  }
 }
 
 void ScalarEvolution::verify() const {
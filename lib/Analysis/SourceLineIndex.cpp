@@ -0,0 +1,187 @@
+//===- SourceLineIndex.cpp - Source line table of a module ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SourceLineIndex analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/SourceLineIndex.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "source-line-index"
+
+//===----------------------------------------------------------------------===//
+//  SourceLineIndex Implementation
+//===----------------------------------------------------------------------===//
+
+const Instruction *SourceLineIndex::LineRange::getLast() const {
+  const Instruction *I = First;
+  for (unsigned N = 1; N < NumInstructions; ++N)
+    I = I->getNextNode();
+  return I;
+}
+
+void SourceLineIndex::recalculate(const Module &M) {
+  releaseMemory();
+
+  for (const Function &F : M) {
+    unsigned Begin = Ranges.size();
+    for (const BasicBlock &BB : F) {
+      // Ranges never span blocks, so start a new one for the first located
+      // instruction of every block.
+      LineRange *Current = nullptr;
+      for (const Instruction &I : BB) {
+        const DILocation *Loc = I.getDebugLoc();
+        if (!Loc || !Loc->getLine()) {
+          Current = nullptr;
+          continue;
+        }
+        auto Inserted = FileNumbers.insert(
+            std::make_pair(Loc->getFilename(), (unsigned)Files.size()));
+        if (Inserted.second)
+          Files.push_back(Inserted.first->first());
+        unsigned File = Inserted.first->second;
+
+        if (Current && Current->File == File &&
+            Current->Line == Loc->getLine()) {
+          ++Current->NumInstructions;
+          continue;
+        }
+        Ranges.push_back({File, Loc->getLine(), 1, &I});
+        Current = &Ranges.back();
+      }
+    }
+    if (Ranges.size() != Begin)
+      FunctionRanges[&F] = std::make_pair(Begin, (unsigned)Ranges.size());
+  }
+
+  // Ranges does not grow any more, so pointers into it stay valid.
+  ByLine.reserve(Ranges.size());
+  for (const LineRange &R : Ranges)
+    ByLine.push_back(&R);
+  std::stable_sort(ByLine.begin(), ByLine.end(),
+                   [](const LineRange *L, const LineRange *R) {
+                     return std::make_pair(L->File, L->Line) <
+                            std::make_pair(R->File, R->Line);
+                   });
+}
+
+int SourceLineIndex::getFileNumber(StringRef File) const {
+  auto It = FileNumbers.find(File);
+  return It == FileNumbers.end() ? -1 : (int)It->second;
+}
+
+ArrayRef<SourceLineIndex::LineRange>
+SourceLineIndex::ranges(const Function &F) const {
+  auto It = FunctionRanges.find(&F);
+  if (It == FunctionRanges.end())
+    return None;
+  return makeArrayRef(Ranges).slice(It->second.first,
+                                    It->second.second - It->second.first);
+}
+
+ArrayRef<const SourceLineIndex::LineRange *>
+SourceLineIndex::lookup(StringRef File, unsigned BeginLine,
+                        unsigned EndLine) const {
+  int FileNo = getFileNumber(File);
+  if (FileNo < 0 || BeginLine >= EndLine)
+    return None;
+
+  auto Less = [](const LineRange *R, std::pair<unsigned, unsigned> Key) {
+    return std::make_pair(R->File, R->Line) < Key;
+  };
+  auto Begin = std::lower_bound(ByLine.begin(), ByLine.end(),
+                                std::make_pair((unsigned)FileNo, BeginLine),
+                                Less);
+  auto End = std::lower_bound(Begin, ByLine.end(),
+                              std::make_pair((unsigned)FileNo, EndLine), Less);
+  return makeArrayRef(&*Begin, End - Begin);
+}
+
+unsigned SourceLineIndex::getLine(const Instruction &I) {
+  if (const DILocation *Loc = I.getDebugLoc())
+    return Loc->getLine();
+  return 0;
+}
+
+void SourceLineIndex::releaseMemory() {
+  Files.clear();
+  FileNumbers.clear();
+  Ranges.clear();
+  FunctionRanges.clear();
+  ByLine.clear();
+}
+
+void SourceLineIndex::print(raw_ostream &OS) const {
+  const Function *Last = nullptr;
+  for (const LineRange &R : Ranges) {
+    const Function *F = R.First->getFunction();
+    if (F != Last) {
+      OS << "Lines of function: " << F->getName() << "\n";
+      Last = F;
+    }
+    OS << "  " << Files[R.File] << ":" << R.Line << ": " << R.NumInstructions
+       << (R.NumInstructions == 1 ? " instruction" : " instructions")
+       << " in block ";
+    R.First->getParent()->printAsOperand(OS, false);
+    OS << "\n";
+  }
+}
+
+//===----------------------------------------------------------------------===//
+//  SourceLineIndexAnalysis and SourceLineIndexPrinterPass Implementation
+//===----------------------------------------------------------------------===//
+
+AnalysisKey SourceLineIndexAnalysis::Key;
+
+SourceLineIndex SourceLineIndexAnalysis::run(Module &M,
+                                             ModuleAnalysisManager &) {
+  return SourceLineIndex(M);
+}
+
+SourceLineIndexPrinterPass::SourceLineIndexPrinterPass(raw_ostream &OS)
+    : OS(OS) {}
+
+PreservedAnalyses SourceLineIndexPrinterPass::run(Module &M,
+                                                  ModuleAnalysisManager &AM) {
+  OS << "SourceLineIndex for module: " << M.getModuleIdentifier() << "\n";
+  AM.getResult<SourceLineIndexAnalysis>(M).print(OS);
+
+  return PreservedAnalyses::all();
+}
+
+//===----------------------------------------------------------------------===//
+//  SourceLineIndexWrapperPass Implementation
+//===----------------------------------------------------------------------===//
+
+char SourceLineIndexWrapperPass::ID = 0;
+
+INITIALIZE_PASS(SourceLineIndexWrapperPass, "source-line-index",
+                "Source Line Index Construction", true, true)
+
+SourceLineIndexWrapperPass::SourceLineIndexWrapperPass() : ModulePass(ID) {
+  initializeSourceLineIndexWrapperPassPass(*PassRegistry::getPassRegistry());
+}
+
+bool SourceLineIndexWrapperPass::runOnModule(Module &M) {
+  Index.recalculate(M);
+  return false;
+}
+
+void SourceLineIndexWrapperPass::print(raw_ostream &OS, const Module *) const {
+  Index.print(OS);
+}
@@ -17,6 +17,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/InstructionSimplify.h"
+#include "llvm/Analysis/KnownBitsCache.h"
 #include "llvm/Analysis/Loads.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
@@ -82,6 +83,9 @@ struct Query {
   // Unlike the other analyses, this may be a nullptr because not all clients
   // provide it currently.
   OptimizationRemarkEmitter *ORE;
+  // Optional memo of computeKnownBits and ComputeNumSignBits. It is only used
+  // while no assumptions are excluded; see getKnownBitsCache.
+  KnownBitsCache *KBCache;
 
   /// Set of assumptions that should be excluded from further queries.
   /// This is because of the potential for mutual recursion to cause
@@ -95,12 +99,14 @@ struct Query {
   unsigned NumExcluded;
 
   Query(const DataLayout &DL, AssumptionCache *AC, const Instruction *CxtI,
-        const DominatorTree *DT, OptimizationRemarkEmitter *ORE = nullptr)
-      : DL(DL), AC(AC), CxtI(CxtI), DT(DT), ORE(ORE), NumExcluded(0) {}
+        const DominatorTree *DT, OptimizationRemarkEmitter *ORE = nullptr,
+        KnownBitsCache *KBCache = nullptr)
+      : DL(DL), AC(AC), CxtI(CxtI), DT(DT), ORE(ORE), KBCache(KBCache),
+        NumExcluded(0) {}
 
   Query(const Query &Q, const Value *NewExcl)
       : DL(Q.DL), AC(Q.AC), CxtI(Q.CxtI), DT(Q.DT), ORE(Q.ORE),
-        NumExcluded(Q.NumExcluded) {
+        KBCache(Q.KBCache), NumExcluded(Q.NumExcluded) {
     Excluded = Q.Excluded;
     Excluded[NumExcluded++] = NewExcl;
     assert(NumExcluded <= Excluded.size());
@@ -131,6 +137,19 @@ static const Instruction *safeCxtI(const Value *V, const Instruction *CxtI) {
   return nullptr;
 }
 
+/// Return the cache to use for the query about \p V at \p Depth, if any.
+/// Constants are cheap to look at and queries at the maximum depth give up
+/// right away. A query that excludes some assumptions may know less than the
+/// same query without exclusions, so it doesn't use the cache either.
+static KnownBitsCache *getKnownBitsCache(const Value *V, unsigned Depth,
+                                         const Query &Q) {
+  if (!Q.KBCache || Q.NumExcluded || Depth == MaxDepth)
+    return nullptr;
+  if (!isa<Instruction>(V) && !isa<Argument>(V))
+    return nullptr;
+  return Q.KBCache;
+}
+
 static void computeKnownBits(const Value *V, KnownBits &Known,
                              unsigned Depth, const Query &Q);
 
@@ -138,9 +157,10 @@ void llvm::computeKnownBits(const Value *V, KnownBits &Known,
                             const DataLayout &DL, unsigned Depth,
                             AssumptionCache *AC, const Instruction *CxtI,
                             const DominatorTree *DT,
-                            OptimizationRemarkEmitter *ORE) {
+                            OptimizationRemarkEmitter *ORE,
+                            KnownBitsCache *KBCache) {
   ::computeKnownBits(V, Known, Depth,
-                     Query(DL, AC, safeCxtI(V, CxtI), DT, ORE));
+                     Query(DL, AC, safeCxtI(V, CxtI), DT, ORE, KBCache));
 }
 
 static KnownBits computeKnownBits(const Value *V, unsigned Depth,
@@ -150,9 +170,10 @@ KnownBits llvm::computeKnownBits(const Value *V, const DataLayout &DL,
                                  unsigned Depth, AssumptionCache *AC,
                                  const Instruction *CxtI,
                                  const DominatorTree *DT,
-                                 OptimizationRemarkEmitter *ORE) {
-  return ::computeKnownBits(V, Depth,
-                            Query(DL, AC, safeCxtI(V, CxtI), DT, ORE));
+                                 OptimizationRemarkEmitter *ORE,
+                                 KnownBitsCache *KBCache) {
+  return ::computeKnownBits(
+      V, Depth, Query(DL, AC, safeCxtI(V, CxtI), DT, ORE, KBCache));
 }
 
 bool llvm::haveNoCommonBitsSet(const Value *LHS, const Value *RHS,
@@ -191,17 +212,21 @@ bool llvm::isKnownToBeAPowerOfTwo(const Value *V, const DataLayout &DL,
                                   bool OrZero,
                                   unsigned Depth, AssumptionCache *AC,
                                   const Instruction *CxtI,
-                                  const DominatorTree *DT) {
-  return ::isKnownToBeAPowerOfTwo(V, OrZero, Depth,
-                                  Query(DL, AC, safeCxtI(V, CxtI), DT));
+                                  const DominatorTree *DT,
+                                  KnownBitsCache *KBCache) {
+  return ::isKnownToBeAPowerOfTwo(
+      V, OrZero, Depth,
+      Query(DL, AC, safeCxtI(V, CxtI), DT, /*ORE=*/nullptr, KBCache));
 }
 
 static bool isKnownNonZero(const Value *V, unsigned Depth, const Query &Q);
 
 bool llvm::isKnownNonZero(const Value *V, const DataLayout &DL, unsigned Depth,
                           AssumptionCache *AC, const Instruction *CxtI,
-                          const DominatorTree *DT) {
-  return ::isKnownNonZero(V, Depth, Query(DL, AC, safeCxtI(V, CxtI), DT));
+                          const DominatorTree *DT, KnownBitsCache *KBCache) {
+  return ::isKnownNonZero(
+      V, Depth,
+      Query(DL, AC, safeCxtI(V, CxtI), DT, /*ORE=*/nullptr, KBCache));
 }
 
 bool llvm::isKnownNonNegative(const Value *V, const DataLayout &DL,
@@ -248,9 +273,11 @@ static bool MaskedValueIsZero(const Value *V, const APInt &Mask, unsigned Depth,
 bool llvm::MaskedValueIsZero(const Value *V, const APInt &Mask,
                              const DataLayout &DL,
                              unsigned Depth, AssumptionCache *AC,
-                             const Instruction *CxtI, const DominatorTree *DT) {
-  return ::MaskedValueIsZero(V, Mask, Depth,
-                             Query(DL, AC, safeCxtI(V, CxtI), DT));
+                             const Instruction *CxtI, const DominatorTree *DT,
+                             KnownBitsCache *KBCache) {
+  return ::MaskedValueIsZero(
+      V, Mask, Depth,
+      Query(DL, AC, safeCxtI(V, CxtI), DT, /*ORE=*/nullptr, KBCache));
 }
 
 static unsigned ComputeNumSignBits(const Value *V, unsigned Depth,
@@ -259,8 +286,11 @@ static unsigned ComputeNumSignBits(const Value *V, unsigned Depth,
 unsigned llvm::ComputeNumSignBits(const Value *V, const DataLayout &DL,
                                   unsigned Depth, AssumptionCache *AC,
                                   const Instruction *CxtI,
-                                  const DominatorTree *DT) {
-  return ::ComputeNumSignBits(V, Depth, Query(DL, AC, safeCxtI(V, CxtI), DT));
+                                  const DominatorTree *DT,
+                                  KnownBitsCache *KBCache) {
+  return ::ComputeNumSignBits(
+      V, Depth,
+      Query(DL, AC, safeCxtI(V, CxtI), DT, /*ORE=*/nullptr, KBCache));
 }
 
 static void computeKnownBitsAddSub(bool Add, const Value *Op0, const Value *Op1,
@@ -1529,6 +1559,13 @@ void computeKnownBits(const Value *V, KnownBits &Known, unsigned Depth,
   if (Depth == MaxDepth)
     return;
 
+  KnownBitsCache *Cache = getKnownBitsCache(V, Depth, Q);
+  if (Cache)
+    if (const KnownBits *Cached = Cache->lookupKnownBits(V, Q.CxtI, Depth)) {
+      Known = *Cached;
+      return;
+    }
+
   // A weak GlobalAlias is totally unknown. A non-weak GlobalAlias has
   // the bits of its aliasee.
   if (const GlobalAlias *GA = dyn_cast<GlobalAlias>(V)) {
@@ -1554,6 +1591,8 @@ void computeKnownBits(const Value *V, KnownBits &Known, unsigned Depth,
   computeKnownBitsFromAssume(V, Known, Depth, Q);
 
   assert((Known.Zero & Known.One) == 0 && "Bits known to be one AND zero?");
+  if (Cache)
+    Cache->insertKnownBits(V, Q.CxtI, Depth, Known);
 }
 
 /// Return true if the given value is known to have exactly one
@@ -2010,8 +2049,15 @@ static unsigned ComputeNumSignBitsImpl(const Value *V, unsigned Depth,
 
 static unsigned ComputeNumSignBits(const Value *V, unsigned Depth,
                                    const Query &Q) {
+  KnownBitsCache *Cache = getKnownBitsCache(V, Depth, Q);
+  if (Cache)
+    if (unsigned Cached = Cache->lookupNumSignBits(V, Q.CxtI, Depth))
+      return Cached;
+
   unsigned Result = ComputeNumSignBitsImpl(V, Depth, Q);
   assert(Result > 0 && "At least one sign bit needs to be present!");
+  if (Cache)
+    Cache->insertNumSignBits(V, Q.CxtI, Depth, Result);
   return Result;
 }
 
@@ -3516,7 +3562,8 @@ OverflowResult llvm::computeOverflowForUnsignedMul(const Value *LHS,
                                                    const DataLayout &DL,
                                                    AssumptionCache *AC,
                                                    const Instruction *CxtI,
-                                                   const DominatorTree *DT) {
+                                                   const DominatorTree *DT,
+                                                   KnownBitsCache *KBCache) {
   // Multiplying n * m significant bits yields a result of n + m significant
   // bits. If the total number of significant bits does not exceed the
   // result bit width (minus 1), there is no overflow.
@@ -3526,8 +3573,10 @@ OverflowResult llvm::computeOverflowForUnsignedMul(const Value *LHS,
   unsigned BitWidth = LHS->getType()->getScalarSizeInBits();
   KnownBits LHSKnown(BitWidth);
   KnownBits RHSKnown(BitWidth);
-  computeKnownBits(LHS, LHSKnown, DL, /*Depth=*/0, AC, CxtI, DT);
-  computeKnownBits(RHS, RHSKnown, DL, /*Depth=*/0, AC, CxtI, DT);
+  computeKnownBits(LHS, LHSKnown, DL, /*Depth=*/0, AC, CxtI, DT, nullptr,
+                   KBCache);
+  computeKnownBits(RHS, RHSKnown, DL, /*Depth=*/0, AC, CxtI, DT, nullptr,
+                   KBCache);
   // Note that underestimating the number of zero bits gives a more
   // conservative answer.
   unsigned ZeroBits = LHSKnown.countMinLeadingZeros() +
@@ -3563,10 +3612,13 @@ OverflowResult llvm::computeOverflowForUnsignedAdd(const Value *LHS,
                                                    const DataLayout &DL,
                                                    AssumptionCache *AC,
                                                    const Instruction *CxtI,
-                                                   const DominatorTree *DT) {
-  KnownBits LHSKnown = computeKnownBits(LHS, DL, /*Depth=*/0, AC, CxtI, DT);
+                                                   const DominatorTree *DT,
+                                                   KnownBitsCache *KBCache) {
+  KnownBits LHSKnown = computeKnownBits(LHS, DL, /*Depth=*/0, AC, CxtI, DT,
+                                        nullptr, KBCache);
   if (LHSKnown.isNonNegative() || LHSKnown.isNegative()) {
-    KnownBits RHSKnown = computeKnownBits(RHS, DL, /*Depth=*/0, AC, CxtI, DT);
+    KnownBits RHSKnown = computeKnownBits(RHS, DL, /*Depth=*/0, AC, CxtI, DT,
+                                          nullptr, KBCache);
 
     if (LHSKnown.isNegative() && RHSKnown.isNegative()) {
       // The sign bit is set in both cases: this MUST overflow.
@@ -3635,7 +3687,8 @@ static OverflowResult computeOverflowForSignedAdd(const Value *LHS,
                                                   const DataLayout &DL,
                                                   AssumptionCache *AC,
                                                   const Instruction *CxtI,
-                                                  const DominatorTree *DT) {
+                                                  const DominatorTree *DT,
+                                                  KnownBitsCache *KBCache) {
   if (Add && Add->hasNoSignedWrap()) {
     return OverflowResult::NeverOverflows;
   }
@@ -3654,12 +3707,14 @@ static OverflowResult computeOverflowForSignedAdd(const Value *LHS,
   //
   // Since the carry into the most significant position is always equal to
   // the carry out of the addition, there is no signed overflow.
-  if (ComputeNumSignBits(LHS, DL, 0, AC, CxtI, DT) > 1 &&
-      ComputeNumSignBits(RHS, DL, 0, AC, CxtI, DT) > 1)
+  if (ComputeNumSignBits(LHS, DL, 0, AC, CxtI, DT, KBCache) > 1 &&
+      ComputeNumSignBits(RHS, DL, 0, AC, CxtI, DT, KBCache) > 1)
     return OverflowResult::NeverOverflows;
 
-  KnownBits LHSKnown = computeKnownBits(LHS, DL, /*Depth=*/0, AC, CxtI, DT);
-  KnownBits RHSKnown = computeKnownBits(RHS, DL, /*Depth=*/0, AC, CxtI, DT);
+  KnownBits LHSKnown = computeKnownBits(LHS, DL, /*Depth=*/0, AC, CxtI, DT,
+                                        nullptr, KBCache);
+  KnownBits RHSKnown = computeKnownBits(RHS, DL, /*Depth=*/0, AC, CxtI, DT,
+                                        nullptr, KBCache);
 
   if (checkRippleForSignedAdd(LHSKnown, RHSKnown))
     return OverflowResult::NeverOverflows;
@@ -3677,7 +3732,8 @@ static OverflowResult computeOverflowForSignedAdd(const Value *LHS,
   bool LHSOrRHSKnownNegative = 
       (LHSKnown.isNegative() || RHSKnown.isNegative());
   if (LHSOrRHSKnownNonNegative || LHSOrRHSKnownNegative) {
-    KnownBits AddKnown = computeKnownBits(Add, DL, /*Depth=*/0, AC, CxtI, DT);
+    KnownBits AddKnown = computeKnownBits(Add, DL, /*Depth=*/0, AC, CxtI, DT,
+                                          nullptr, KBCache);
     if ((AddKnown.isNonNegative() && LHSOrRHSKnownNonNegative) ||
         (AddKnown.isNegative() && LHSOrRHSKnownNegative)) {
       return OverflowResult::NeverOverflows;
@@ -3753,9 +3809,10 @@ OverflowResult llvm::computeOverflowForSignedAdd(const AddOperator *Add,
                                                  const DataLayout &DL,
                                                  AssumptionCache *AC,
                                                  const Instruction *CxtI,
-                                                 const DominatorTree *DT) {
+                                                 const DominatorTree *DT,
+                                                 KnownBitsCache *KBCache) {
   return ::computeOverflowForSignedAdd(Add->getOperand(0), Add->getOperand(1),
-                                       Add, DL, AC, CxtI, DT);
+                                       Add, DL, AC, CxtI, DT, KBCache);
 }
 
 OverflowResult llvm::computeOverflowForSignedAdd(const Value *LHS,
@@ -3763,8 +3820,10 @@ OverflowResult llvm::computeOverflowForSignedAdd(const Value *LHS,
                                                  const DataLayout &DL,
                                                  AssumptionCache *AC,
                                                  const Instruction *CxtI,
-                                                 const DominatorTree *DT) {
-  return ::computeOverflowForSignedAdd(LHS, RHS, nullptr, DL, AC, CxtI, DT);
+                                                 const DominatorTree *DT,
+                                                 KnownBitsCache *KBCache) {
+  return ::computeOverflowForSignedAdd(LHS, RHS, nullptr, DL, AC, CxtI, DT,
+                                       KBCache);
 }
 
 bool llvm::isGuaranteedToTransferExecutionToSuccessor(const Instruction *I) {
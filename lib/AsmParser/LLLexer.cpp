@@ -15,6 +15,7 @@
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Instruction.h"
@@ -23,6 +24,7 @@
 #include <cassert>
 #include <cctype>
 #include <cstdio>
+#include <cstring>
 
 using namespace llvm;
 
@@ -138,10 +140,18 @@ static void UnEscapeLexed(std::string &Str) {
   Str.resize(BOut-Buffer);
 }
 
+/// isDigitChar/isAlphaChar/isAlnumChar - ASCII versions of isdigit, isalpha
+/// and isalnum for the loops that scan names and keywords, where the <cctype>
+/// functions cost a call and a locale lookup per character.
+static bool isDigitChar(char C) { return C >= '0' && C <= '9'; }
+static bool isAlphaChar(char C) {
+  return (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z');
+}
+static bool isAlnumChar(char C) { return isDigitChar(C) || isAlphaChar(C); }
+
 /// isLabelChar - Return true for [-a-zA-Z$._0-9].
 static bool isLabelChar(char C) {
-  return isalnum(static_cast<unsigned char>(C)) || C == '-' || C == '$' ||
-         C == '.' || C == '_';
+  return isAlnumChar(C) || C == '-' || C == '$' || C == '.' || C == '_';
 }
 
 /// isLabelTail - Return true if this pointer points to a valid end of a label.
@@ -163,6 +173,13 @@ LLLexer::LLLexer(StringRef StartBuf, SourceMgr &sm, SMDiagnostic &Err,
   CurPtr = CurBuf.begin();
 }
 
+/// findQuote - Return the first '"' at or after Ptr, or null if the buffer ends
+/// first.  memchr looks at a word or a vector of characters at a time, which
+/// adds up for long string constants.
+const char *LLLexer::findQuote(const char *Ptr) const {
+  return static_cast<const char *>(memchr(Ptr, '"', CurBuf.end() - Ptr));
+}
+
 int LLLexer::getNextChar() {
   char CurChar = *CurPtr++;
   switch (CurChar) {
@@ -187,7 +204,7 @@ lltok::Kind LLLexer::LexToken() {
     switch (CurChar) {
     default:
       // Handle letters: [a-zA-Z_]
-      if (isalpha(static_cast<unsigned char>(CurChar)) || CurChar == '_')
+      if (isAlphaChar(CurChar) || CurChar == '_')
         return LexIdentifier();
 
       return lltok::Error;
@@ -241,9 +258,13 @@ lltok::Kind LLLexer::LexToken() {
 }
 
 void LLLexer::SkipLineComment() {
+  // strcspn also stops at a nul, which is either the end of the buffer or
+  // part of the comment.
   while (true) {
-    if (CurPtr[0] == '\n' || CurPtr[0] == '\r' || getNextChar() == EOF)
+    CurPtr += strcspn(CurPtr, "\n\r");
+    if (CurPtr[0] != 0 || CurPtr == CurBuf.end())
       return;
+    ++CurPtr;
   }
 }
 
@@ -264,25 +285,21 @@ lltok::Kind LLLexer::LexDollar() {
 
   // Handle DollarStringConstant: $\"[^\"]*\"
   if (CurPtr[0] == '"') {
-    ++CurPtr;
-
-    while (true) {
-      int CurChar = getNextChar();
+    const char *End = findQuote(++CurPtr);
+    if (!End) {
+      CurPtr = CurBuf.end();
+      Error("end of file in COMDAT variable name");
+      return lltok::Error;
+    }
 
-      if (CurChar == EOF) {
-        Error("end of file in COMDAT variable name");
-        return lltok::Error;
-      }
-      if (CurChar == '"') {
-        StrVal.assign(TokStart + 2, CurPtr - 1);
-        UnEscapeLexed(StrVal);
-        if (StringRef(StrVal).find_first_of(0) != StringRef::npos) {
-          Error("Null bytes are not allowed in names");
-          return lltok::Error;
-        }
-        return lltok::ComdatVar;
-      }
+    CurPtr = End + 1;
+    StrVal.assign(TokStart + 2, End);
+    UnEscapeLexed(StrVal);
+    if (StringRef(StrVal).find_first_of(0) != StringRef::npos) {
+      Error("Null bytes are not allowed in names");
+      return lltok::Error;
     }
+    return lltok::ComdatVar;
   }
 
   // Handle ComdatVarName: $[-a-zA-Z$._][-a-zA-Z$._0-9]*
@@ -295,31 +312,27 @@ lltok::Kind LLLexer::LexDollar() {
 /// ReadString - Read a string until the closing quote.
 lltok::Kind LLLexer::ReadString(lltok::Kind kind) {
   const char *Start = CurPtr;
-  while (true) {
-    int CurChar = getNextChar();
-
-    if (CurChar == EOF) {
-      Error("end of file in string constant");
-      return lltok::Error;
-    }
-    if (CurChar == '"') {
-      StrVal.assign(Start, CurPtr-1);
-      UnEscapeLexed(StrVal);
-      return kind;
-    }
+  const char *End = findQuote(Start);
+  if (!End) {
+    CurPtr = CurBuf.end();
+    Error("end of file in string constant");
+    return lltok::Error;
   }
+
+  CurPtr = End + 1;
+  StrVal.assign(Start, End);
+  UnEscapeLexed(StrVal);
+  return kind;
 }
 
 /// ReadVarName - Read the rest of a token containing a variable name.
 bool LLLexer::ReadVarName() {
   const char *NameStart = CurPtr;
-  if (isalpha(static_cast<unsigned char>(CurPtr[0])) ||
+  if (isAlphaChar(CurPtr[0]) ||
       CurPtr[0] == '-' || CurPtr[0] == '$' ||
       CurPtr[0] == '.' || CurPtr[0] == '_') {
     ++CurPtr;
-    while (isalnum(static_cast<unsigned char>(CurPtr[0])) ||
-           CurPtr[0] == '-' || CurPtr[0] == '$' ||
-           CurPtr[0] == '.' || CurPtr[0] == '_')
+    while (isLabelChar(CurPtr[0]))
       ++CurPtr;
 
     StrVal.assign(NameStart, CurPtr);
@@ -331,25 +344,21 @@ bool LLLexer::ReadVarName() {
 lltok::Kind LLLexer::LexVar(lltok::Kind Var, lltok::Kind VarID) {
   // Handle StringConstant: \"[^\"]*\"
   if (CurPtr[0] == '"') {
-    ++CurPtr;
-
-    while (true) {
-      int CurChar = getNextChar();
+    const char *End = findQuote(++CurPtr);
+    if (!End) {
+      CurPtr = CurBuf.end();
+      Error("end of file in global variable name");
+      return lltok::Error;
+    }
 
-      if (CurChar == EOF) {
-        Error("end of file in global variable name");
-        return lltok::Error;
-      }
-      if (CurChar == '"') {
-        StrVal.assign(TokStart+2, CurPtr-1);
-        UnEscapeLexed(StrVal);
-        if (StringRef(StrVal).find_first_of(0) != StringRef::npos) {
-          Error("Null bytes are not allowed in names");
-          return lltok::Error;
-        }
-        return Var;
-      }
+    CurPtr = End + 1;
+    StrVal.assign(TokStart + 2, End);
+    UnEscapeLexed(StrVal);
+    if (StringRef(StrVal).find_first_of(0) != StringRef::npos) {
+      Error("Null bytes are not allowed in names");
+      return lltok::Error;
     }
+    return Var;
   }
 
   // Handle VarName: [-a-zA-Z$._][-a-zA-Z$._0-9]*
@@ -404,13 +413,11 @@ lltok::Kind LLLexer::LexQuote() {
 ///    !
 lltok::Kind LLLexer::LexExclaim() {
   // Lex a metadata name as a MetadataVar.
-  if (isalpha(static_cast<unsigned char>(CurPtr[0])) ||
+  if (isAlphaChar(CurPtr[0]) ||
       CurPtr[0] == '-' || CurPtr[0] == '$' ||
       CurPtr[0] == '.' || CurPtr[0] == '_' || CurPtr[0] == '\\') {
     ++CurPtr;
-    while (isalnum(static_cast<unsigned char>(CurPtr[0])) ||
-           CurPtr[0] == '-' || CurPtr[0] == '$' ||
-           CurPtr[0] == '.' || CurPtr[0] == '_' || CurPtr[0] == '\\')
+    while (isLabelChar(CurPtr[0]) || CurPtr[0] == '\\')
       ++CurPtr;
 
     StrVal.assign(TokStart+1, CurPtr);   // Skip !
@@ -438,57 +445,24 @@ lltok::Kind LLLexer::LexHash() {
   return lltok::Error;
 }
 
-/// Lex a label, integer type, keyword, or hexadecimal integer constant.
-///    Label           [-a-zA-Z$._0-9]+:
-///    IntegerType     i[0-9]+
-///    Keyword         sdiv, float, ...
-///    HexIntConstant  [us]0x[0-9A-Fa-f]+
-lltok::Kind LLLexer::LexIdentifier() {
-  const char *StartChar = CurPtr;
-  const char *IntEnd = CurPtr[-1] == 'i' ? nullptr : StartChar;
-  const char *KeywordEnd = nullptr;
+namespace {
 
-  for (; isLabelChar(*CurPtr); ++CurPtr) {
-    // If we decide this is an integer, remember the end of the sequence.
-    if (!IntEnd && !isdigit(static_cast<unsigned char>(*CurPtr)))
-      IntEnd = CurPtr;
-    if (!KeywordEnd && !isalnum(static_cast<unsigned char>(*CurPtr)) &&
-        *CurPtr != '_')
-      KeywordEnd = CurPtr;
-  }
+/// What a keyword lexes as.
+struct KeywordInfo {
+  lltok::Kind Kind;
 
-  // If we stopped due to a colon, this really is a label.
-  if (*CurPtr == ':') {
-    StrVal.assign(StartChar-1, CurPtr++);
-    return lltok::LabelStr;
-  }
+  /// The opcode of an instruction keyword, the TypeID of a type keyword, and
+  /// zero for other keywords.
+  unsigned Value;
+};
 
-  // Otherwise, this wasn't a label.  If this was valid as an integer type,
-  // return it.
-  if (!IntEnd) IntEnd = CurPtr;
-  if (IntEnd != StartChar) {
-    CurPtr = IntEnd;
-    uint64_t NumBits = atoull(StartChar, CurPtr);
-    if (NumBits < IntegerType::MIN_INT_BITS ||
-        NumBits > IntegerType::MAX_INT_BITS) {
-      Error("bitwidth for integer type out of range!");
-      return lltok::Error;
-    }
-    TyVal = IntegerType::get(Context, NumBits);
-    return lltok::Type;
-  }
+} // end anonymous namespace
 
-  // Otherwise, this was a letter sequence.  See which keyword this is.
-  if (!KeywordEnd) KeywordEnd = CurPtr;
-  CurPtr = KeywordEnd;
-  --StartChar;
-  StringRef Keyword(StartChar, CurPtr - StartChar);
+/// Build the table of the keywords LexIdentifier looks up.
+static StringMap<KeywordInfo> buildKeywordTable() {
+  StringMap<KeywordInfo> Keywords;
 
-#define KEYWORD(STR)                                                           \
-  do {                                                                         \
-    if (Keyword == #STR)                                                       \
-      return lltok::kw_##STR;                                                  \
-  } while (false)
+#define KEYWORD(STR) Keywords.insert({#STR, {lltok::kw_##STR, 0}})
 
   KEYWORD(true);    KEYWORD(false);
   KEYWORD(declare); KEYWORD(define);
@@ -704,35 +678,25 @@ lltok::Kind LLLexer::LexIdentifier() {
 
   // Keywords for types.
 #define TYPEKEYWORD(STR, LLVMTY)                                               \
-  do {                                                                         \
-    if (Keyword == STR) {                                                      \
-      TyVal = LLVMTY;                                                          \
-      return lltok::Type;                                                      \
-    }                                                                          \
-  } while (false)
-
-  TYPEKEYWORD("void",      Type::getVoidTy(Context));
-  TYPEKEYWORD("half",      Type::getHalfTy(Context));
-  TYPEKEYWORD("float",     Type::getFloatTy(Context));
-  TYPEKEYWORD("double",    Type::getDoubleTy(Context));
-  TYPEKEYWORD("x86_fp80",  Type::getX86_FP80Ty(Context));
-  TYPEKEYWORD("fp128",     Type::getFP128Ty(Context));
-  TYPEKEYWORD("ppc_fp128", Type::getPPC_FP128Ty(Context));
-  TYPEKEYWORD("label",     Type::getLabelTy(Context));
-  TYPEKEYWORD("metadata",  Type::getMetadataTy(Context));
-  TYPEKEYWORD("x86_mmx",   Type::getX86_MMXTy(Context));
-  TYPEKEYWORD("token",     Type::getTokenTy(Context));
+  Keywords.insert({STR, {lltok::Type, Type::LLVMTY}})
+
+  TYPEKEYWORD("void",      VoidTyID);
+  TYPEKEYWORD("half",      HalfTyID);
+  TYPEKEYWORD("float",     FloatTyID);
+  TYPEKEYWORD("double",    DoubleTyID);
+  TYPEKEYWORD("x86_fp80",  X86_FP80TyID);
+  TYPEKEYWORD("fp128",     FP128TyID);
+  TYPEKEYWORD("ppc_fp128", PPC_FP128TyID);
+  TYPEKEYWORD("label",     LabelTyID);
+  TYPEKEYWORD("metadata",  MetadataTyID);
+  TYPEKEYWORD("x86_mmx",   X86_MMXTyID);
+  TYPEKEYWORD("token",     TokenTyID);
 
 #undef TYPEKEYWORD
 
   // Keywords for instructions.
 #define INSTKEYWORD(STR, Enum)                                                 \
-  do {                                                                         \
-    if (Keyword == #STR) {                                                     \
-      UIntVal = Instruction::Enum;                                             \
-      return lltok::kw_##STR;                                                  \
-    }                                                                          \
-  } while (false)
+  Keywords.insert({#STR, {lltok::kw_##STR, Instruction::Enum}})
 
   INSTKEYWORD(add,   Add);  INSTKEYWORD(fadd,   FAdd);
   INSTKEYWORD(sub,   Sub);  INSTKEYWORD(fsub,   FSub);
@@ -790,6 +754,66 @@ lltok::Kind LLLexer::LexIdentifier() {
 
 #undef INSTKEYWORD
 
+  return Keywords;
+}
+
+
+/// Lex a label, integer type, keyword, or hexadecimal integer constant.
+///    Label           [-a-zA-Z$._0-9]+:
+///    IntegerType     i[0-9]+
+///    Keyword         sdiv, float, ...
+///    HexIntConstant  [us]0x[0-9A-Fa-f]+
+lltok::Kind LLLexer::LexIdentifier() {
+  const char *StartChar = CurPtr;
+  const char *IntEnd = CurPtr[-1] == 'i' ? nullptr : StartChar;
+  const char *KeywordEnd = nullptr;
+
+  for (; isLabelChar(*CurPtr); ++CurPtr) {
+    // If we decide this is an integer, remember the end of the sequence.
+    if (!IntEnd && !isDigitChar(*CurPtr))
+      IntEnd = CurPtr;
+    if (!KeywordEnd && !isAlnumChar(*CurPtr) && *CurPtr != '_')
+      KeywordEnd = CurPtr;
+  }
+
+  // If we stopped due to a colon, this really is a label.
+  if (*CurPtr == ':') {
+    StrVal.assign(StartChar-1, CurPtr++);
+    return lltok::LabelStr;
+  }
+
+  // Otherwise, this wasn't a label.  If this was valid as an integer type,
+  // return it.
+  if (!IntEnd) IntEnd = CurPtr;
+  if (IntEnd != StartChar) {
+    CurPtr = IntEnd;
+    uint64_t NumBits = atoull(StartChar, CurPtr);
+    if (NumBits < IntegerType::MIN_INT_BITS ||
+        NumBits > IntegerType::MAX_INT_BITS) {
+      Error("bitwidth for integer type out of range!");
+      return lltok::Error;
+    }
+    TyVal = IntegerType::get(Context, NumBits);
+    return lltok::Type;
+  }
+
+  // Otherwise, this was a letter sequence.  See which keyword this is.
+  if (!KeywordEnd) KeywordEnd = CurPtr;
+  CurPtr = KeywordEnd;
+  --StartChar;
+  StringRef Keyword(StartChar, CurPtr - StartChar);
+
+  static const StringMap<KeywordInfo> Keywords = buildKeywordTable();
+  auto KI = Keywords.find(Keyword);
+  if (KI != Keywords.end()) {
+    const KeywordInfo &Info = KI->second;
+    if (Info.Kind == lltok::Type)
+      TyVal = Type::getPrimitiveType(Context, Type::TypeID(Info.Value));
+    else if (Info.Value)
+      UIntVal = Info.Value;
+    return Info.Kind;
+  }
+
 #define DWKEYWORD(TYPE, TOKEN)                                                 \
   do {                                                                         \
     if (Keyword.startswith("DW_" #TYPE "_")) {                                 \
@@ -70,6 +70,7 @@ namespace llvm {
     lltok::Kind LexToken();
 
     int getNextChar();
+    const char *findQuote(const char *Ptr) const;
     void SkipLineComment();
     lltok::Kind ReadString(lltok::Kind kind);
     bool ReadVarName();
@@ -71,6 +71,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -93,6 +94,13 @@ static cl::opt<bool> PrintSummaryGUIDs(
     cl::desc(
         "Print the global id for each value when reading the module summary"));
 
+static unsigned BitcodeReaderThreads;
+static cl::opt<unsigned, true> BitcodeReaderThreadsOpt(
+    "bitcode-reader-threads", cl::location(BitcodeReaderThreads),
+    cl::init(0), cl::Hidden,
+    cl::desc("Decode function blocks on this many threads ahead of the "
+             "reader when materializing a whole module"));
+
 namespace {
 
 enum {
@@ -430,6 +438,81 @@ BitcodeReaderBase::readNameFromStrtab(ArrayRef<uint64_t> Record) {
   return {StringRef(Strtab.data() + Record[0], Record[1]), Record.slice(2)};
 }
 
+/// Decodes the function blocks of a module on a thread pool, a few blocks
+/// ahead of the functions the reader materializes. The reader replays the
+/// recordings instead of decoding the blocks itself, so decoding overlaps with
+/// building the IR. Building the IR stays on one thread, because it adds uses
+/// to the constants and globals all functions share.
+class FunctionBlockPrefetcher {
+  struct Job {
+    BitstreamRecording Recording;
+    bool Failed = false;
+    std::shared_future<void> Done;
+  };
+
+  ArrayRef<uint8_t> Bytes;
+  BitstreamBlockInfo &BlockInfo;
+
+  /// The most blocks decoded or being decoded and not yet taken.
+  unsigned Window;
+
+  /// The functions and the positions of their blocks, in the order the reader
+  /// will materialize them, and the next one to decode.
+  std::vector<std::pair<Function *, uint64_t>> Blocks;
+  size_t NextBlock = 0;
+
+  DenseMap<Function *, std::unique_ptr<Job>> Jobs;
+
+  /// Destroyed first, so that no job is running when the others go away.
+  ThreadPool Pool;
+
+  void startJobs() {
+    while (Jobs.size() < Window && NextBlock != Blocks.size()) {
+      Function *F = Blocks[NextBlock].first;
+      uint64_t BitNo = Blocks[NextBlock].second;
+      ++NextBlock;
+      // The reader may have gotten to a function out of order.
+      if (!F->isMaterializable())
+        continue;
+
+      auto J = llvm::make_unique<Job>();
+      Job *JP = J.get();
+      JP->Done = Pool.async([this, JP, BitNo] {
+        BitstreamCursor Cursor(Bytes);
+        Cursor.setBlockInfo(&BlockInfo);
+        Cursor.JumpToBit(BitNo);
+        JP->Failed = Cursor.recordBlock(bitc::FUNCTION_BLOCK_ID, JP->Recording);
+      });
+      Jobs[F] = std::move(J);
+    }
+  }
+
+public:
+  FunctionBlockPrefetcher(ArrayRef<uint8_t> Bytes,
+                          BitstreamBlockInfo &BlockInfo, unsigned Threads,
+                          std::vector<std::pair<Function *, uint64_t>> Blocks)
+      : Bytes(Bytes), BlockInfo(BlockInfo), Window(4 * Threads),
+        Blocks(std::move(Blocks)), Pool(Threads) {
+    startJobs();
+  }
+
+  /// Wait for the block of \p F to be decoded and return its recording, or
+  /// null if it was not decoded ahead of time or could not be recorded. The
+  /// reader then decodes the block itself, reporting any errors in it.
+  std::unique_ptr<BitstreamRecording> take(Function *F) {
+    auto I = Jobs.find(F);
+    if (I == Jobs.end())
+      return nullptr;
+    std::unique_ptr<Job> J = std::move(I->second);
+    Jobs.erase(I);
+    J->Done.wait();
+    startJobs();
+    if (J->Failed)
+      return nullptr;
+    return llvm::make_unique<BitstreamRecording>(std::move(J->Recording));
+  }
+};
+
 class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   LLVMContext &Context;
   Module *TheModule = nullptr;
@@ -491,6 +574,10 @@ class BitcodeReader : public BitcodeReaderBase, public GVMaterializer {
   /// which Metadata blocks are deferred.
   std::vector<uint64_t> DeferredMetadataInfo;
 
+  /// Decodes function blocks ahead of materializeModule, if
+  /// -bitcode-reader-threads asks for it.
+  std::unique_ptr<FunctionBlockPrefetcher> Prefetcher;
+
   /// These are basic blocks forward-referenced by block addresses.  They are
   /// inserted lazily into functions when they're loaded.  The basic block ID is
   /// its index into the vector.
@@ -4650,7 +4737,15 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
   // Move the bit stream to the saved position of the deferred function body.
   Stream.JumpToBit(DFII->second);
 
-  if (Error Err = parseFunctionBody(F))
+  // Replay the body instead if it has been decoded already.
+  std::unique_ptr<BitstreamRecording> Recording;
+  if (Prefetcher && (Recording = Prefetcher->take(F)))
+    Stream.replay(*Recording);
+
+  Error Err = parseFunctionBody(F);
+  // A malformed body can be left before its end.
+  Stream.stopReplaying();
+  if (Err)
     return Err;
   F->setIsMaterializable(false);
 
@@ -4702,12 +4797,35 @@ Error BitcodeReader::materializeModule() {
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
+  // Decode the function bodies on other threads ahead of the loop below,
+  // provided we know where all of them are.
+  if (BitcodeReaderThreads > 1) {
+    std::vector<std::pair<Function *, uint64_t>> Blocks;
+    for (Function &F : *TheModule) {
+      if (!F.isMaterializable())
+        continue;
+      uint64_t BitNo = DeferredFunctionInfo.lookup(&F);
+      if (!BitNo) {
+        Blocks.clear();
+        break;
+      }
+      Blocks.push_back({&F, BitNo});
+    }
+    if (!Blocks.empty())
+      Prefetcher = llvm::make_unique<FunctionBlockPrefetcher>(
+          Stream.getBitcodeBytes(), BlockInfo, BitcodeReaderThreads,
+          std::move(Blocks));
+  }
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Function &F : *TheModule) {
-    if (Error Err = materialize(&F))
+    if (Error Err = materialize(&F)) {
+      Prefetcher.reset();
       return Err;
+    }
   }
+  Prefetcher.reset();
   // At this point, if there are any function bodies, parse the rest of
   // the bits in the module past the last function block we have recorded
   // through either lazy scanning or the VST.
@@ -5804,3 +5922,7 @@ llvm::getModuleSummaryIndexForFile(StringRef Path,
     return nullptr;
   return getModuleSummaryIndex(**FileOrErr);
 }
+
+void llvm::setBitcodeReaderThreads(unsigned Threads) {
+  BitcodeReaderThreads = Threads;
+}
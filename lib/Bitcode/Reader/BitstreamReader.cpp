@@ -21,6 +21,16 @@ using namespace llvm;
 /// EnterSubBlock - Having read the ENTER_SUBBLOCK abbrevid, enter
 /// the block, and return true if the block has an error.
 bool BitstreamCursor::EnterSubBlock(unsigned BlockID, unsigned *NumWordsP) {
+  if (Replay) {
+    const BitstreamRecording::Entry &Entry = getReplayEntry();
+    assert(Entry.Kind.Kind == BitstreamEntry::SubBlock &&
+           Entry.Kind.ID == BlockID && "Not at the start of the block");
+    (void)BlockID;
+    if (NumWordsP) *NumWordsP = Entry.Code;
+    ++ReplayDepth;
+    return false;
+  }
+
   // Save the current block's state on BlockScope.
   BlockScope.push_back(Block(CurCodeSize));
   BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
@@ -94,6 +104,12 @@ static void skipAbbreviatedField(BitstreamCursor &Cursor,
 
 /// skipRecord - Read the current record and discard it.
 unsigned BitstreamCursor::skipRecord(unsigned AbbrevID) {
+  if (Replay) {
+    assert(getReplayEntry().Kind.Kind == BitstreamEntry::Record &&
+           getReplayEntry().Kind.ID == AbbrevID && "Not at a record");
+    return getReplayEntry().Code;
+  }
+
   // Skip unabbreviated records by reading past their entries.
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     unsigned Code = ReadVBR(6);
@@ -179,6 +195,22 @@ unsigned BitstreamCursor::skipRecord(unsigned AbbrevID) {
 unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
                                      SmallVectorImpl<uint64_t> &Vals,
                                      StringRef *Blob) {
+  if (Replay) {
+    const BitstreamRecording::Entry &Entry = getReplayEntry();
+    assert(Entry.Kind.Kind == BitstreamEntry::Record &&
+           Entry.Kind.ID == AbbrevID && "Not at a record");
+    auto Ops = Replay->Ops.begin() + Entry.FirstOp;
+    Vals.append(Ops, Ops + Entry.NumOps);
+    if (Entry.Blob.data()) {
+      if (Blob)
+        *Blob = Entry.Blob;
+      else
+        for (char C : Entry.Blob)
+          Vals.push_back((unsigned char)C);
+    }
+    return Entry.Code;
+  }
+
   if (AbbrevID == bitc::UNABBREV_RECORD) {
     unsigned Code = ReadVBR(6);
     unsigned NumElts = ReadVBR(6);
@@ -320,6 +352,53 @@ void BitstreamCursor::ReadAbbrevRecord() {
   CurAbbrevs.push_back(std::move(Abbv));
 }
 
+bool BitstreamCursor::recordBlock(unsigned BlockID,
+                                  BitstreamRecording &Recording) {
+  assert(!Replay && "Recording while replaying");
+  Recording.clear();
+  std::vector<BitstreamRecording::Entry> &Entries = Recording.Entries;
+
+  // The indices of the entries that start the blocks we are in.
+  SmallVector<size_t, 8> OpenBlocks;
+  SmallVector<uint64_t, 64> Vals;
+  BitstreamEntry Entry = BitstreamEntry::getSubBlock(BlockID);
+  while (true) {
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return true;
+    case BitstreamEntry::SubBlock: {
+      // Block info blocks change how the rest of the stream is read.
+      if (Entry.ID == bitc::BLOCKINFO_BLOCK_ID)
+        return true;
+      unsigned NumWords;
+      if (EnterSubBlock(Entry.ID, &NumWords))
+        return true;
+      OpenBlocks.push_back(Entries.size());
+      Entries.push_back({Entry, NumWords, 0, 0, 0, StringRef()});
+      break;
+    }
+    case BitstreamEntry::EndBlock:
+      Entries.push_back({Entry, 0, 0, 0, 0, StringRef()});
+      Entries[OpenBlocks.pop_back_val()].SkipTo = Entries.size();
+      if (OpenBlocks.empty()) {
+        Recording.EndBitNo = GetCurrentBitNo();
+        return false;
+      }
+      break;
+    case BitstreamEntry::Record: {
+      Vals.clear();
+      StringRef Blob;
+      unsigned Code = readRecord(Entry.ID, Vals, &Blob);
+      Entries.push_back({Entry, Code, static_cast<unsigned>(Vals.size()),
+                         Recording.Ops.size(), 0, Blob});
+      Recording.Ops.insert(Recording.Ops.end(), Vals.begin(), Vals.end());
+      break;
+    }
+    }
+    Entry = advance();
+  }
+}
+
 Optional<BitstreamBlockInfo>
 BitstreamCursor::ReadBlockInfoBlock(bool ReadBlockInfoNames) {
   if (EnterSubBlock(bitc::BLOCKINFO_BLOCK_ID)) return None;
@@ -35,7 +35,9 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
 #include <cctype>
 #include <map>
 using namespace llvm;
@@ -46,6 +48,12 @@ cl::opt<unsigned>
     IndexThreshold("bitcode-mdindex-threshold", cl::Hidden, cl::init(25),
                    cl::desc("Number of metadatas above which we emit an index "
                             "to enable lazy-loading"));
+
+unsigned BitcodeWriterThreads;
+cl::opt<unsigned, true> BitcodeWriterThreadsOpt(
+    "bitcode-writer-threads", cl::location(BitcodeWriterThreads), cl::init(0),
+    cl::Hidden, cl::desc("Encode function blocks on this many threads"));
+
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
@@ -152,6 +160,14 @@ public:
               assignValueId(CallEdge.first.getGUID());
   }
 
+  /// Constructs a ModuleBitcodeWriterBase object that writes parts of the
+  /// module of \p Parent to \p Stream, with a copy of its value enumeration.
+  ModuleBitcodeWriterBase(const ModuleBitcodeWriterBase &Parent,
+                          BitstreamWriter &Stream)
+      : BitcodeWriterBase(Stream, Parent.StrtabBuilder), M(Parent.M),
+        VE(Parent.VE), Index(Parent.Index),
+        GlobalValueId(Parent.GlobalValueId) {}
+
 protected:
   void writePerModuleGlobalValueSummary();
 
@@ -216,6 +232,13 @@ public:
         Buffer(Buffer), GenerateHash(GenerateHash), ModHash(ModHash),
         BitcodeStartBit(Stream.GetCurrentBitNo()) {}
 
+  /// Constructs a ModuleBitcodeWriter object that writes function blocks of
+  /// the module of \p Parent to \p Stream, see writeFunctionsInParallel.
+  ModuleBitcodeWriter(const ModuleBitcodeWriter &Parent,
+                      SmallVectorImpl<char> &Buffer, BitstreamWriter &Stream)
+      : ModuleBitcodeWriterBase(Parent, Stream), Buffer(Buffer),
+        GenerateHash(false), ModHash(nullptr), BitcodeStartBit(0) {}
+
   /// Emit the current module to the bitstream.
   void write();
 
@@ -330,6 +353,9 @@ private:
   void
   writeFunction(const Function &F,
                 DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
+  void writeFunctionBody(const Function &F);
+  void writeFunctionsInParallel(
+      DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
   void writeBlockInfo();
   void writeModuleHash(size_t BlockStartPos);
 
@@ -2933,6 +2959,12 @@ void ModuleBitcodeWriter::writeFunction(
   FunctionToBitcodeIndex[&F] = Stream.GetCurrentBitNo();
 
   Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+  writeFunctionBody(F);
+  Stream.ExitBlock();
+}
+
+/// Emit the contents of a function block.
+void ModuleBitcodeWriter::writeFunctionBody(const Function &F) {
   VE.incorporateFunction(F);
 
   SmallVector<unsigned, 64> Vals;
@@ -2999,7 +3031,59 @@ void ModuleBitcodeWriter::writeFunction(
   if (VE.shouldPreserveUseListOrder())
     writeUseListBlock(&F);
   VE.purgeFunction();
-  Stream.ExitBlock();
+}
+
+/// Emit the function bodies like writeFunction does, but encode the blocks on
+/// BitcodeWriterThreads threads and splice them into the module stream in
+/// order afterwards.  A block does not depend on where it ends up in the
+/// stream, or on the blocks before it, so the output is the same.
+void ModuleBitcodeWriter::writeFunctionsInParallel(
+    DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex) {
+  std::vector<const Function *> Functions;
+  for (const Function &F : M)
+    if (!F.isDeclaration())
+      Functions.push_back(&F);
+
+  // Take the use-list orders of every function off the stack in the order
+  // writeUseListBlock would, so that each block can be given its own.
+  std::vector<UseListOrderStack> UseListOrders(Functions.size());
+  if (VE.shouldPreserveUseListOrder())
+    for (size_t I = 0, E = Functions.size(); I != E; ++I) {
+      UseListOrderStack &Orders = UseListOrders[I];
+      while (!VE.UseListOrders.empty() &&
+             VE.UseListOrders.back().F == Functions[I]) {
+        Orders.push_back(std::move(VE.UseListOrders.back()));
+        VE.UseListOrders.pop_back();
+      }
+      std::reverse(Orders.begin(), Orders.end());
+    }
+
+  // Each thread copies the value enumeration once and then encodes whichever
+  // function is next until there are none left.
+  std::vector<SmallVector<char, 0>> Bodies(Functions.size());
+  std::atomic<size_t> NextFunction(0);
+  auto WriteBodies = [&]() {
+    SmallVector<char, 0> Buffer;
+    BitstreamWriter BlockStream(Buffer);
+    BlockStream.CopyBlockInfo(Stream);
+    ModuleBitcodeWriter Writer(*this, Buffer, BlockStream);
+    for (size_t I; (I = NextFunction++) < Functions.size();) {
+      Writer.VE.UseListOrders = std::move(UseListOrders[I]);
+      BlockStream.EnterSubblockBody(bitc::FUNCTION_BLOCK_ID, 4);
+      Writer.writeFunctionBody(*Functions[I]);
+      BlockStream.ExitBlock();
+      Bodies[I].swap(Buffer);
+    }
+  };
+  ThreadPool Pool(BitcodeWriterThreads);
+  for (unsigned I = 0; I != BitcodeWriterThreads; ++I)
+    Pool.async(WriteBodies);
+  Pool.wait();
+
+  for (size_t I = 0, E = Functions.size(); I != E; ++I) {
+    FunctionToBitcodeIndex[Functions[I]] = Stream.GetCurrentBitNo();
+    Stream.EmitSubblockBody(bitc::FUNCTION_BLOCK_ID, 4, Bodies[I]);
+  }
 }
 
 // Emit blockinfo, which defines the standard abbreviations etc.
@@ -3782,9 +3866,12 @@ void ModuleBitcodeWriter::write() {
 
   // Emit function bodies.
   DenseMap<const Function *, uint64_t> FunctionToBitcodeIndex;
-  for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
-    if (!F->isDeclaration())
-      writeFunction(*F, FunctionToBitcodeIndex);
+  if (BitcodeWriterThreads > 1)
+    writeFunctionsInParallel(FunctionToBitcodeIndex);
+  else
+    for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
+      if (!F->isDeclaration())
+        writeFunction(*F, FunctionToBitcodeIndex);
 
   // Need to write after the above call to WriteFunction which populates
   // the summary information in the index.
@@ -4189,3 +4276,7 @@ void llvm::WriteThinLinkBitcodeToFile(const Module *M, raw_ostream &Out,
 
   Out.write((char *)&Buffer.front(), Buffer.size());
 }
+
+void llvm::setBitcodeWriterThreads(unsigned Threads) {
+  BitcodeWriterThreads = Threads;
+}
@@ -410,6 +410,21 @@ ValueEnumerator::ValueEnumerator(const Module &M,
   organizeMetadata();
 }
 
+ValueEnumerator::ValueEnumerator(const ValueEnumerator &VE)
+    : TypeMap(VE.TypeMap), Types(VE.Types), ValueMap(VE.ValueMap),
+      Values(VE.Values), Comdats(VE.Comdats), MDs(VE.MDs),
+      FunctionMDs(VE.FunctionMDs), MetadataMap(VE.MetadataMap),
+      FunctionMDInfo(VE.FunctionMDInfo),
+      ShouldPreserveUseListOrder(VE.ShouldPreserveUseListOrder),
+      AttributeGroupMap(VE.AttributeGroupMap),
+      AttributeGroups(VE.AttributeGroups),
+      AttributeListMap(VE.AttributeListMap), AttributeLists(VE.AttributeLists),
+      GlobalBasicBlockIDs(VE.GlobalBasicBlockIDs),
+      InstructionMap(VE.InstructionMap), NumModuleMDs(VE.NumModuleMDs),
+      NumMDStrings(VE.NumMDStrings) {
+  assert(VE.BasicBlocks.empty() && "Copying with a function incorporated");
+}
+
 unsigned ValueEnumerator::getInstructionID(const Instruction *Inst) const {
   InstructionMapType::const_iterator I = InstructionMap.find(Inst);
   assert(I != InstructionMap.end() && "Instruction is not mapped!");
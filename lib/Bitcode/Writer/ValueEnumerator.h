@@ -138,11 +138,15 @@ private:
   unsigned FirstFuncConstantID;
   unsigned FirstInstID;
 
-  ValueEnumerator(const ValueEnumerator &) = delete;
   void operator=(const ValueEnumerator &) = delete;
 public:
   ValueEnumerator(const Module &M, bool ShouldPreserveUseListOrder);
 
+  /// Copy the module-level numbering of \p VE, which must not have a function
+  /// incorporated.  The use-list orders are left out: the writer hands each
+  /// copy the ones of the functions it writes.
+  ValueEnumerator(const ValueEnumerator &VE);
+
   void dump() const;
   void print(raw_ostream &OS, const ValueMapType &Map, const char *Name) const;
   void print(raw_ostream &OS, const MetadataMapType &Map,
@@ -547,14 +547,14 @@ Constant *ConstantInt::getFalse(Type *Ty) {
 ConstantInt *ConstantInt::get(LLVMContext &Context, const APInt &V) {
   // get an existing value or the insertion position
   LLVMContextImpl *pImpl = Context.pImpl;
-  std::unique_ptr<ConstantInt> &Slot = pImpl->IntConstants[V];
-  if (!Slot) {
-    // Get the corresponding integer type for the bit width of the value.
-    IntegerType *ITy = IntegerType::get(Context, V.getBitWidth());
-    Slot.reset(new ConstantInt(ITy, V));
-  }
-  assert(Slot->getType() == IntegerType::get(Context, V.getBitWidth()));
-  return Slot.get();
+  ConstantInt *C = pImpl->IntConstants.getOrCreate(
+      V, pImpl->ConcurrentUniquing, [&] {
+        // Get the corresponding integer type for the bit width of the value.
+        IntegerType *ITy = IntegerType::get(Context, V.getBitWidth());
+        return new ConstantInt(ITy, V);
+      });
+  assert(C->getType() == IntegerType::get(Context, V.getBitWidth()));
+  return C;
 }
 
 Constant *ConstantInt::get(Type *Ty, uint64_t V, bool isSigned) {
@@ -685,9 +685,7 @@ Constant *ConstantFP::getZeroValueForNegation(Type *Ty) {
 ConstantFP* ConstantFP::get(LLVMContext &Context, const APFloat& V) {
   LLVMContextImpl* pImpl = Context.pImpl;
 
-  std::unique_ptr<ConstantFP> &Slot = pImpl->FPConstants[V];
-
-  if (!Slot) {
+  return pImpl->FPConstants.getOrCreate(V, pImpl->ConcurrentUniquing, [&] {
     Type *Ty;
     if (&V.getSemantics() == &APFloat::IEEEhalf())
       Ty = Type::getHalfTy(Context);
@@ -704,10 +702,8 @@ ConstantFP* ConstantFP::get(LLVMContext &Context, const APFloat& V) {
              "Unknown FP format");
       Ty = Type::getPPC_FP128Ty(Context);
     }
-    Slot.reset(new ConstantFP(Ty, V));
-  }
-
-  return Slot.get();
+    return new ConstantFP(Ty, V);
+  });
 }
 
 Constant *ConstantFP::getInfinity(Type *Ty, bool Negative) {
@@ -1238,8 +1234,9 @@ ConstantAggregateZero *ConstantAggregateZero::get(Type *Ty) {
   assert((Ty->isStructTy() || Ty->isArrayTy() || Ty->isVectorTy()) &&
          "Cannot create an aggregate zero of non-aggregate type!");
 
-  std::unique_ptr<ConstantAggregateZero> &Entry =
-      Ty->getContext().pImpl->CAZConstants[Ty];
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  auto Guard = pImpl->lockConstants();
+  std::unique_ptr<ConstantAggregateZero> &Entry = pImpl->CAZConstants[Ty];
   if (!Entry)
     Entry.reset(new ConstantAggregateZero(Ty));
 
@@ -1248,6 +1245,7 @@ ConstantAggregateZero *ConstantAggregateZero::get(Type *Ty) {
 
 /// Remove the constant from the constant table.
 void ConstantAggregateZero::destroyConstantImpl() {
+  auto Guard = getContext().pImpl->lockConstants();
   getContext().pImpl->CAZConstants.erase(getType());
 }
 
@@ -1304,8 +1302,9 @@ const APInt &Constant::getUniqueInteger() const {
 //
 
 ConstantPointerNull *ConstantPointerNull::get(PointerType *Ty) {
-  std::unique_ptr<ConstantPointerNull> &Entry =
-      Ty->getContext().pImpl->CPNConstants[Ty];
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  auto Guard = pImpl->lockConstants();
+  std::unique_ptr<ConstantPointerNull> &Entry = pImpl->CPNConstants[Ty];
   if (!Entry)
     Entry.reset(new ConstantPointerNull(Ty));
 
@@ -1314,11 +1313,14 @@ ConstantPointerNull *ConstantPointerNull::get(PointerType *Ty) {
 
 /// Remove the constant from the constant table.
 void ConstantPointerNull::destroyConstantImpl() {
+  auto Guard = getContext().pImpl->lockConstants();
   getContext().pImpl->CPNConstants.erase(getType());
 }
 
 UndefValue *UndefValue::get(Type *Ty) {
-  std::unique_ptr<UndefValue> &Entry = Ty->getContext().pImpl->UVConstants[Ty];
+  LLVMContextImpl *pImpl = Ty->getContext().pImpl;
+  auto Guard = pImpl->lockConstants();
+  std::unique_ptr<UndefValue> &Entry = pImpl->UVConstants[Ty];
   if (!Entry)
     Entry.reset(new UndefValue(Ty));
 
@@ -1328,6 +1330,7 @@ UndefValue *UndefValue::get(Type *Ty) {
 /// Remove the constant from the constant table.
 void UndefValue::destroyConstantImpl() {
   // Free the constant and any dangling references to it.
+  auto Guard = getContext().pImpl->lockConstants();
   getContext().pImpl->UVConstants.erase(getType());
 }
 
@@ -1337,10 +1340,13 @@ BlockAddress *BlockAddress::get(BasicBlock *BB) {
 }
 
 BlockAddress *BlockAddress::get(Function *F, BasicBlock *BB) {
+  auto Guard = F->getContext().pImpl->lockConstants();
   BlockAddress *&BA =
     F->getContext().pImpl->BlockAddresses[std::make_pair(F, BB)];
-  if (!BA)
+  if (!BA) {
+    auto UseListsGuard = F->getContext().pImpl->lockUseLists();
     BA = new BlockAddress(F, BB);
+  }
 
   assert(BA->getFunction() == F && "Basic block moved between functions");
   return BA;
@@ -1360,6 +1366,7 @@ BlockAddress *BlockAddress::lookup(const BasicBlock *BB) {
 
   const Function *F = BB->getParent();
   assert(F && "Block must have a parent");
+  auto Guard = F->getContext().pImpl->lockConstants();
   BlockAddress *BA =
       F->getContext().pImpl->BlockAddresses.lookup(std::make_pair(F, BB));
   assert(BA && "Refcount and block address map disagree!");
@@ -1368,8 +1375,11 @@ BlockAddress *BlockAddress::lookup(const BasicBlock *BB) {
 
 /// Remove the constant from the constant table.
 void BlockAddress::destroyConstantImpl() {
-  getFunction()->getType()->getContext().pImpl
-    ->BlockAddresses.erase(std::make_pair(getFunction(), getBasicBlock()));
+  {
+    auto Guard = getContext().pImpl->lockConstants();
+    getContext().pImpl->BlockAddresses.erase(
+        std::make_pair(getFunction(), getBasicBlock()));
+  }
   getBasicBlock()->AdjustBlockAddressRefCount(-1);
 }
 
@@ -2329,6 +2339,7 @@ Constant *ConstantDataSequential::getImpl(StringRef Elements, Type *Ty) {
     return ConstantAggregateZero::get(Ty);
 
   // Do a lookup to see if we have already formed one of these.
+  auto Guard = Ty->getContext().pImpl->lockConstants();
   auto &Slot =
       *Ty->getContext()
            .pImpl->CDSConstants.insert(std::make_pair(Elements, nullptr))
@@ -2355,6 +2366,7 @@ Constant *ConstantDataSequential::getImpl(StringRef Elements, Type *Ty) {
 
 void ConstantDataSequential::destroyConstantImpl() {
   // Remove the constant from the StringMap.
+  auto Guard = getContext().pImpl->lockConstants();
   StringMap<ConstantDataSequential*> &CDSConstants = 
     getType()->getContext().pImpl->CDSConstants;
 
@@ -27,6 +27,7 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instruction.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/OperandTraits.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Debug.h"
@@ -35,12 +36,36 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <utility>
 
 #define DEBUG_TYPE "ir"
 
 namespace llvm {
 
+/// Holds a lock on a uniquing table of an LLVMContext.  The lock is only taken
+/// while the context is in concurrent uniquing mode, so single threaded users
+/// of the context do not pay for it.
+template <class MutexT> class UniquingLockGuard {
+  MutexT *Lock;
+
+public:
+  UniquingLockGuard(MutexT &M, bool Concurrent)
+      : Lock(Concurrent ? &M : nullptr) {
+    if (Lock)
+      Lock->lock();
+  }
+  UniquingLockGuard(UniquingLockGuard &&Other) : Lock(Other.Lock) {
+    Other.Lock = nullptr;
+  }
+  UniquingLockGuard(const UniquingLockGuard &) = delete;
+  UniquingLockGuard &operator=(const UniquingLockGuard &) = delete;
+  ~UniquingLockGuard() {
+    if (Lock)
+      Lock->unlock();
+  }
+};
+
 /// UnaryConstantExpr - This class is private to Constants.cpp, and is used
 /// behind the scenes to implement unary constant exprs.
 class UnaryConstantExpr : public ConstantExpr {
@@ -621,6 +646,11 @@ public:
 private:
   MapTy Map;
 
+  /// Guards Map while the context is in concurrent uniquing mode.
+  std::mutex Lock;
+
+  using LockGuard = UniquingLockGuard<std::mutex>;
+
 public:
   typename MapTy::iterator begin() { return Map.begin(); }
   typename MapTy::iterator end() { return Map.end(); }
@@ -632,7 +662,13 @@ public:
 
 private:
   ConstantClass *create(TypeClass *Ty, ValType V, LookupKeyHashed &HashKey) {
-    ConstantClass *Result = V.create(Ty);
+    ConstantClass *Result;
+    {
+      // The operands may be shared with constants that other tables are
+      // creating at the same time.
+      auto Guard = Ty->getContext().pImpl->lockUseLists();
+      Result = V.create(Ty);
+    }
 
     assert(Result->getType() == Ty && "Type specified is not correct!");
     Map.insert_as(Result, HashKey);
@@ -649,6 +685,7 @@ public:
 
     ConstantClass *Result = nullptr;
 
+    LockGuard Guard(Lock, Ty->getContext().hasConcurrentUniquing());
     auto I = Map.find_as(Lookup);
     if (I == Map.end())
       Result = create(Ty, V, Lookup);
@@ -661,12 +698,19 @@ public:
 
   /// Remove this constant from the map
   void remove(ConstantClass *CP) {
+    LockGuard Guard(Lock, CP->getContext().hasConcurrentUniquing());
+    removeLocked(CP);
+  }
+
+private:
+  void removeLocked(ConstantClass *CP) {
     typename MapTy::iterator I = Map.find(CP);
     assert(I != Map.end() && "Constant not found in constant table!");
     assert(*I == CP && "Didn't find correct element?");
     Map.erase(I);
   }
 
+public:
   ConstantClass *replaceOperandsInPlace(ArrayRef<Constant *> Operands,
                                         ConstantClass *CP, Value *From,
                                         Constant *To, unsigned NumUpdated = 0,
@@ -675,13 +719,14 @@ public:
     /// Hash once, and reuse it for the lookup and the insertion if needed.
     LookupKeyHashed Lookup(MapInfo::getHashValue(Key), Key);
 
+    LockGuard Guard(Lock, CP->getContext().hasConcurrentUniquing());
     auto I = Map.find_as(Lookup);
     if (I != Map.end())
       return *I;
 
     // Update to the new value.  Optimize for the case when we have a single
     // operand that we're changing, but handle bulk updates efficiently.
-    remove(CP);
+    removeLocked(CP);
     if (NumUpdated == 1) {
       assert(OperandNo < CP->getNumOperands() && "Invalid index");
       assert(CP->getOperand(OperandNo) != To && "I didn't contain From!");
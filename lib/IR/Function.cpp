@@ -33,6 +33,7 @@
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instruction.h"
+#include "llvm/IR/InstructionArena.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Intrinsics.h"
@@ -244,6 +245,16 @@ Function::~Function() {
 
   // Remove the function from the on-the-side GC table.
   clearGC();
+
+  // The arena lives on until the instructions allocated from it are deleted.
+  if (Arena)
+    Arena->destroy();
+}
+
+InstructionArena *Function::getInstructionArena() {
+  if (!Arena)
+    Arena = InstructionArena::create();
+  return Arena;
 }
 
 void Function::BuildLazyArguments() const {
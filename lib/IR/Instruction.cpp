@@ -15,6 +15,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/InstructionArena.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
@@ -49,6 +50,24 @@ Instruction::~Instruction() {
     clearMetadataHashEntries();
 }
 
+void *Instruction::operator new(size_t Size) {
+  if (InstructionArena *Arena = InstructionArena::getCurrent())
+    return allocateInArena(Arena, Size);
+  return User::operator new(Size);
+}
+
+void *Instruction::operator new(size_t Size, unsigned Us) {
+  if (InstructionArena *Arena = InstructionArena::getCurrent())
+    return allocateInArena(Arena, Size, Us);
+  return User::operator new(Size, Us);
+}
+
+void *Instruction::operator new(size_t Size, unsigned Us, unsigned DescBytes) {
+  if (InstructionArena *Arena = InstructionArena::getCurrent())
+    return allocateInArena(Arena, Size, Us, DescBytes);
+  return User::operator new(Size, Us, DescBytes);
+}
+
 
 void Instruction::setParent(BasicBlock *P) {
   Parent = P;
@@ -0,0 +1,97 @@
+//===- InstructionArena.cpp - Per-function instruction memory -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the InstructionArena class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/InstructionArena.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
+#include <new>
+
+using namespace llvm;
+
+static bool EnableInstructionArenas;
+static cl::opt<bool, true> EnableInstructionArenasOpt(
+    "instruction-arenas", cl::location(EnableInstructionArenas),
+    cl::init(false), cl::Hidden,
+    cl::desc("Allocate the instructions created by function passes from "
+             "per-function arenas"));
+
+/// The arena of the function whose passes run on this thread.
+static LLVM_THREAD_LOCAL InstructionArena *CurrentArena = nullptr;
+
+void *InstructionArena::allocate(InstructionArena *Arena, size_t Size) {
+  size_t BlockSize = alignTo(sizeof(BlockHeader) + Size, Granule);
+  size_t SizeClass = BlockSize / Granule;
+  if (SizeClass >= NumSizeClasses)
+    Arena = nullptr;
+
+  void *Block;
+  if (!Arena) {
+    Block = ::operator new(BlockSize);
+  } else if (FreeBlock *Free = Arena->FreeLists[SizeClass]) {
+    Arena->FreeLists[SizeClass] = Free->Next;
+    Block = Free;
+  } else {
+    Block = Arena->Slabs.Allocate(BlockSize, Granule);
+  }
+  if (Arena)
+    Arena->RefCount.fetch_add(1, std::memory_order_relaxed);
+
+  auto *Header = new (Block) BlockHeader;
+  Header->Arena = Arena;
+  Header->SizeClass = SizeClass;
+  return Header + 1;
+}
+
+void InstructionArena::deallocate(void *Ptr) {
+  auto *Header = static_cast<BlockHeader *>(Ptr) - 1;
+  InstructionArena *Arena = Header->Arena;
+  if (!Arena) {
+    ::operator delete(Header);
+    return;
+  }
+
+  // Only the thread allocating from the arena may touch its free lists.
+  if (Arena == CurrentArena) {
+    size_t SizeClass = Header->SizeClass;
+    auto *Free = reinterpret_cast<FreeBlock *>(Header);
+    Free->Next = Arena->FreeLists[SizeClass];
+    Arena->FreeLists[SizeClass] = Free;
+  }
+  Arena->release();
+}
+
+void InstructionArena::release() {
+  if (RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    delete this;
+}
+
+InstructionArena *InstructionArena::getCurrent() { return CurrentArena; }
+
+bool InstructionArena::isEnabled() { return EnableInstructionArenas; }
+
+void InstructionArena::setEnabled(bool Enabled) {
+  EnableInstructionArenas = Enabled;
+}
+
+InstructionArenaScope::InstructionArenaScope(Function &F)
+    : Saved(CurrentArena), Active(EnableInstructionArenas) {
+  if (Active)
+    CurrentArena = F.getInstructionArena();
+}
+
+InstructionArenaScope::~InstructionArenaScope() {
+  if (Active)
+    CurrentArena = Saved;
+}
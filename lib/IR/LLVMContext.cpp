@@ -308,6 +308,21 @@ void LLVMContext::enableDebugTypeODRUniquing() {
 
 void LLVMContext::disableDebugTypeODRUniquing() { pImpl->DITypeMap.reset(); }
 
+bool LLVMContext::hasConcurrentUniquing() const {
+  return pImpl->ConcurrentUniquing;
+}
+
+void LLVMContext::setConcurrentUniquing(bool Concurrent) {
+  if (Concurrent) {
+    // Create the lazily initialized constants up front, so that threads only
+    // ever read them.
+    ConstantInt::getTrue(*this);
+    ConstantInt::getFalse(*this);
+    ConstantTokenNone::get(*this);
+  }
+  pImpl->ConcurrentUniquing = Concurrent;
+}
+
 void LLVMContext::setDiscardValueNames(bool Discard) {
   pImpl->DiscardValueNames = Discard;
 }
@@ -47,6 +47,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -1159,6 +1160,46 @@ public:
   void getAll(SmallVectorImpl<std::pair<unsigned, MDNode *>> &Result) const;
 };
 
+/// A uniquing table of constants that are looked up by value.  The table is
+/// split into shards by the hash of the key, and in concurrent uniquing mode
+/// every shard is locked on its own, so threads creating different constants
+/// rarely wait for each other.
+template <typename KeyT, typename ConstantT, typename KeyInfoT>
+class ShardedConstantMap {
+  static const unsigned NumShards = 16;
+
+  struct Shard {
+    std::mutex Lock;
+    DenseMap<KeyT, std::unique_ptr<ConstantT>, KeyInfoT> Map;
+  };
+  Shard Shards[NumShards];
+
+  /// Pick the shard from the high bits of the hash, so that the keys of one
+  /// shard still spread over the buckets of its map.
+  Shard &getShard(const KeyT &Key) {
+    uint32_t Hash = KeyInfoT::getHashValue(Key) * 0x9E3779B9u;
+    return Shards[Hash >> 28];
+  }
+
+public:
+  /// Return the constant for \p Key, calling \p Create to make it if there
+  /// is none yet.  \p Create runs with the shard locked.
+  template <typename CreateFn>
+  ConstantT *getOrCreate(const KeyT &Key, bool Concurrent, CreateFn Create) {
+    Shard &S = getShard(Key);
+    UniquingLockGuard<std::mutex> Guard(S.Lock, Concurrent);
+    std::unique_ptr<ConstantT> &Slot = S.Map[Key];
+    if (!Slot)
+      Slot.reset(Create());
+    return Slot.get();
+  }
+
+  void clear() {
+    for (Shard &S : Shards)
+      S.Map.clear();
+  }
+};
+
 class LLVMContextImpl {
 public:
   /// OwnedModules - The set of modules instantiated in this context, and which
@@ -1178,12 +1219,62 @@ public:
   LLVMContext::YieldCallbackTy YieldCallback = nullptr;
   void *YieldOpaqueHandle = nullptr;
 
+  /// Set while several threads may create constants, types and metadata at
+  /// once.  \see LLVMContext::setConcurrentUniquing
+  bool ConcurrentUniquing = false;
+
+  /// Guards the type tables and TypeAllocator.  A thread holding one of the
+  /// constant locks may take it, so no thread holding it may take a constant
+  /// lock.  Struct types set their body and name with it held, so the lock is
+  /// recursive.
+  std::recursive_mutex TypesLock;
+
+  /// Guards the constant tables that are not sharded and have no lock of
+  /// their own.
+  std::mutex ConstantsLock;
+
+  /// Guards MDStringCache, ValuesAsMetadata, the uniqued metadata node sets
+  /// and DistinctMDNodes.  Creating a node can create the nodes and values of
+  /// its operands, so the lock is recursive.
+  std::recursive_mutex MetadataLock;
+
+  /// Guards AttrsSet, AttrsLists and AttrsSetNodes.
+  std::mutex AttributesLock;
+
+  /// Guards the use lists of constants and globals while a new constant adds
+  /// its operands' uses.  It is taken last, with a constant table locked.
+  std::mutex UseListsLock;
+
+  /// Guards ValueHandles and the handle lists hanging off it, so function
+  /// passes running on different threads may watch shared values such as
+  /// globals.  Removing a handle can add another, so the lock is recursive.
+  std::recursive_mutex ValueHandlesLock;
+
+  UniquingLockGuard<std::recursive_mutex> lockTypes() {
+    return {TypesLock, ConcurrentUniquing};
+  }
+  UniquingLockGuard<std::mutex> lockConstants() {
+    return {ConstantsLock, ConcurrentUniquing};
+  }
+  UniquingLockGuard<std::recursive_mutex> lockMetadata() {
+    return {MetadataLock, ConcurrentUniquing};
+  }
+  UniquingLockGuard<std::mutex> lockAttributes() {
+    return {AttributesLock, ConcurrentUniquing};
+  }
+  UniquingLockGuard<std::mutex> lockUseLists() {
+    return {UseListsLock, ConcurrentUniquing};
+  }
+  UniquingLockGuard<std::recursive_mutex> lockValueHandles() {
+    return {ValueHandlesLock, ConcurrentUniquing};
+  }
+
   using IntMapTy =
-      DenseMap<APInt, std::unique_ptr<ConstantInt>, DenseMapAPIntKeyInfo>;
+      ShardedConstantMap<APInt, ConstantInt, DenseMapAPIntKeyInfo>;
   IntMapTy IntConstants;
 
   using FPMapTy =
-      DenseMap<APFloat, std::unique_ptr<ConstantFP>, DenseMapAPFloatKeyInfo>;
+      ShardedConstantMap<APFloat, ConstantFP, DenseMapAPFloatKeyInfo>;
   FPMapTy FPConstants;
 
   FoldingSet<AttributeImpl> AttrsSet;
@@ -13,21 +13,27 @@
 
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/IRPrintingPasses.h"
+#include "llvm/IR/InstructionArena.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManagers.h"
 #include "llvm/IR/LegacyPassNameParser.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/PassMemoryInfo.h"
+#include "llvm/Support/AllocationTracker.h"
 #include "llvm/Support/Chrono.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <deque>
 #include <map>
 #include <unordered_set>
 using namespace llvm;
@@ -486,9 +492,85 @@ public:
   }
 };
 
+//===----------------------------------------------------------------------===//
+/// PassMemoryInfo Class - This class is used to attribute heap allocations to
+/// the passes and analyses that make them. This only happens when
+/// -track-pass-memory is enabled on the command line. Both pass managers
+/// report into the same table, keyed by pass instance for the legacy one and
+/// by name for the new one.
+///
+
+static ManagedStatic<sys::SmartMutex<true> > PassMemoryInfoMutex;
+
+class PassMemoryInfo {
+  struct Record {
+    std::string Name;
+    AllocationCounts Counts;
+  };
+  std::deque<Record> Records;
+  DenseMap<Pass *, Record *> LegacyPasses;
+  StringMap<Record *> NamedPasses;
+
+  Record &createRecord(StringRef Name) {
+    Records.emplace_back();
+    Records.back().Name = Name;
+    return Records.back();
+  }
+
+public:
+  PassMemoryInfo() {
+    // The locks used while printing the report must outlive it.
+    (void)*PassMemoryInfoMutex;
+    AllocationTracker::setEnabled(true);
+  }
+
+  ~PassMemoryInfo() {
+    print();
+    AllocationTracker::setEnabled(false);
+  }
+
+  // createTheMemoryInfo - This method constructs TheMemoryInfo if
+  // -track-pass-memory is enabled. It may be called multiple times, from any
+  // thread.
+  static void createTheMemoryInfo();
+
+  // print - Prints out the allocations of each pass and then forgets them.
+  void print();
+
+  AllocationCounts *getPassMemoryRecord(Pass *P) {
+    if (P->getAsPMDataManager())
+      return nullptr;
+
+    sys::SmartScopedLock<true> Lock(*PassMemoryInfoMutex);
+    Record *&R = LegacyPasses[P];
+    if (!R)
+      R = &createRecord(P->getPassName());
+    return &R->Counts;
+  }
+
+  AllocationCounts *getPassMemoryRecord(StringRef PassName) {
+    // Pass managers, adaptors and proxies only run other passes, whose rows
+    // already show what they allocate.
+    StringRef Prefix = PassName.substr(0, PassName.find('<'));
+    if (Prefix.size() != PassName.size() &&
+        (Prefix.endswith("PassManager") || Prefix.endswith("PassAdaptor") ||
+         Prefix.endswith("AnalysisManagerProxy")))
+      return nullptr;
+
+    sys::SmartScopedLock<true> Lock(*PassMemoryInfoMutex);
+    Record *&R = NamedPasses[PassName];
+    if (!R)
+      R = &createRecord(PassName);
+    return &R->Counts;
+  }
+};
+
 } // End of anon namespace
 
 static TimingInfo *TheTimeInfo;
+// Passes of the new pass manager may run on several threads, so this is only
+// read through isConstructed() and constructed by ManagedStatic's lock.
+static ManagedStatic<PassMemoryInfo> TheMemoryInfo;
 
 //===----------------------------------------------------------------------===//
 // PMTopLevelManager implementation
@@ -1293,6 +1375,7 @@ bool BBPassManager::runOnFunction(Function &F) {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, BB);
         TimeRegion PassTimer(getPassTimer(BP));
+        AllocationRegion PassMemory(getPassMemoryRecord(BP));
 
         LocalChanged |= BP->runOnBasicBlock(BB);
       }
@@ -1457,6 +1540,7 @@ void FunctionPassManagerImpl::releaseMemoryOnTheFly() {
 bool FunctionPassManagerImpl::run(Function &F) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  PassMemoryInfo::createTheMemoryInfo();
 
   initializeAllAnalysisInfo();
   for (unsigned Index = 0; Index < getNumContainedManagers(); ++Index) {
@@ -1498,6 +1582,7 @@ bool FPPassManager::runOnFunction(Function &F) {
   // Collect inherited analysis from Module level pass manager.
   populateInheritedAnalysis(TPM->activeStack);
 
+  InstructionArenaScope Arena(F);
   for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
     FunctionPass *FP = getContainedPass(Index);
     bool LocalChanged = false;
@@ -1510,6 +1595,7 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      AllocationRegion PassMemory(getPassMemoryRecord(FP));
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1587,6 +1673,7 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      AllocationRegion PassMemory(getPassMemoryRecord(MP));
 
       LocalChanged |= MP->runOnModule(M);
     }
@@ -1682,6 +1769,7 @@ Pass* MPPassManager::getOnTheFlyPass(Pass *MP, AnalysisID PI, Function &F){
 bool PassManagerImpl::run(Module &M) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  PassMemoryInfo::createTheMemoryInfo();
 
   dumpArguments();
   dumpPasses();
@@ -1758,6 +1846,98 @@ Timer *llvm::getPassTimer(Pass *P) {
 void llvm::reportAndResetTimings() {
   if (TheTimeInfo)
     TheTimeInfo->print();
+  if (TheMemoryInfo.isConstructed())
+    TheMemoryInfo->print();
+}
+
+//===----------------------------------------------------------------------===//
+// PassMemoryInfo implementation
+
+static cl::opt<bool> TrackPassMemory(
+    "track-pass-memory",
+    cl::desc("Count the heap allocations of each pass, printing them next to "
+             "the -time-passes report on exit"));
+
+// createTheMemoryInfo - This method constructs TheMemoryInfo if
+// -track-pass-memory is enabled. It may be called multiple times, from any
+// thread.
+void PassMemoryInfo::createTheMemoryInfo() {
+  // Constructed the first time this is called, iff -track-pass-memory is
+  // enabled, so it is destroyed, and prints its report, before static globals.
+  if (TrackPassMemory)
+    (void)*TheMemoryInfo;
+}
+
+void PassMemoryInfo::print() {
+  std::vector<Record> ToPrint;
+  {
+    sys::SmartScopedLock<true> Lock(*PassMemoryInfoMutex);
+    if (Records.empty())
+      return;
+    for (Record &R : Records)
+      if (R.Counts.Allocations)
+        ToPrint.push_back(R);
+    Records.clear();
+    LegacyPasses.clear();
+    NamedPasses.clear();
+  }
+
+  // Heaviest passes first.
+  std::stable_sort(ToPrint.begin(), ToPrint.end(),
+                   [](const Record &LHS, const Record &RHS) {
+                     return LHS.Counts.Bytes > RHS.Counts.Bytes;
+                   });
+
+  // Regions nest, for example an analysis computed on demand by a pass, so
+  // only what was allocated outside of any other region adds up.
+  AllocationCounts Total;
+  for (const Record &R : ToPrint) {
+    Total.Allocations += R.Counts.OutermostAllocations;
+    Total.Bytes += R.Counts.OutermostBytes;
+    Total.PeakBytes = std::max(Total.PeakBytes, R.Counts.PeakBytes);
+  }
+
+  std::unique_ptr<raw_ostream> OutStream = CreateInfoOutputFile();
+  raw_ostream &OS = *OutStream;
+  StringRef Description = "... Pass memory usage report ...";
+  OS << "===" << std::string(73, '-') << "===\n";
+  OS.indent((80 - Description.size()) / 2) << Description << '\n';
+  OS << "===" << std::string(73, '-') << "===\n";
+  // Without the hook, only allocations reported to the tracker directly are
+  // counted.
+  if (ToPrint.empty() && !AllocationTracker::isAvailable()) {
+    OS << "  Heap allocations can't be tracked in this build.\n\n";
+    return;
+  }
+  OS << format("  Total: %" PRIu64 " allocations, %" PRIu64 " bytes\n\n",
+               Total.Allocations, Total.Bytes);
+
+  OS << "  --Allocations--  -----Bytes-----  ---Peak Live---  --- Name ---\n";
+  auto PrintRow = [&](const AllocationCounts &C, StringRef Name) {
+    OS << format("  %15" PRIu64 "  %15" PRIu64 "  %15" PRIu64 "  ",
+                 C.Allocations, C.Bytes, C.PeakBytes)
+       << Name << '\n';
+  };
+  for (const Record &R : ToPrint)
+    PrintRow(R.Counts, R.Name);
+  PrintRow(Total, "Total");
+  OS << '\n';
+  OS.flush();
+}
+
+/// If PassMemoryInfo is enabled then return the record of the pass. Turning
+/// -track-pass-memory off again stops the counting.
+AllocationCounts *llvm::getPassMemoryRecord(Pass *P) {
+  if (TrackPassMemory && TheMemoryInfo.isConstructed())
+    return TheMemoryInfo->getPassMemoryRecord(P);
+  return nullptr;
+}
+
+AllocationCounts *llvm::getPassMemoryRecord(StringRef PassName) {
+  PassMemoryInfo::createTheMemoryInfo();
+  if (TrackPassMemory && TheMemoryInfo.isConstructed())
+    return TheMemoryInfo->getPassMemoryRecord(PassName);
+  return nullptr;
 }
 
 //===----------------------------------------------------------------------===//
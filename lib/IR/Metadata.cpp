@@ -104,6 +104,7 @@ static Metadata *canonicalizeMetadataForValue(LLVMContext &Context,
 }
 
 MetadataAsValue *MetadataAsValue::get(LLVMContext &Context, Metadata *MD) {
+  auto Guard = Context.pImpl->lockMetadata();
   MD = canonicalizeMetadataForValue(Context, MD);
   auto *&Entry = Context.pImpl->MetadataAsValues[MD];
   if (!Entry)
@@ -196,6 +197,8 @@ bool MetadataTracking::isReplaceable(const Metadata &MD) {
 }
 
 void ReplaceableMetadataImpl::addRef(void *Ref, OwnerTy Owner) {
+  // Nodes over the same operands may be built on several threads at once.
+  auto Guard = Context.pImpl->lockMetadata();
   bool WasInserted =
       UseMap.insert(std::make_pair(Ref, std::make_pair(Owner, NextIndex)))
           .second;
@@ -207,6 +210,7 @@ void ReplaceableMetadataImpl::addRef(void *Ref, OwnerTy Owner) {
 }
 
 void ReplaceableMetadataImpl::dropRef(void *Ref) {
+  auto Guard = Context.pImpl->lockMetadata();
   bool WasErased = UseMap.erase(Ref);
   (void)WasErased;
   assert(WasErased && "Expected to drop a reference");
@@ -214,6 +218,7 @@ void ReplaceableMetadataImpl::dropRef(void *Ref) {
 
 void ReplaceableMetadataImpl::moveRef(void *Ref, void *New,
                                       const Metadata &MD) {
+  auto Guard = Context.pImpl->lockMetadata();
   auto I = UseMap.find(Ref);
   assert(I != UseMap.end() && "Expected to move a reference");
   auto OwnerAndIndex = I->second;
@@ -342,6 +347,7 @@ ValueAsMetadata *ValueAsMetadata::get(Value *V) {
   assert(V && "Unexpected null Value");
 
   auto &Context = V->getContext();
+  auto Guard = Context.pImpl->lockMetadata();
   auto *&Entry = Context.pImpl->ValuesAsMetadata[V];
   if (!Entry) {
     assert((isa<Constant>(V) || isa<Argument>(V) || isa<Instruction>(V)) &&
@@ -444,6 +450,7 @@ void ValueAsMetadata::handleRAUW(Value *From, Value *To) {
 //
 
 MDString *MDString::get(LLVMContext &Context, StringRef Str) {
+  auto Guard = Context.pImpl->lockMetadata();
   auto &Store = Context.pImpl->MDStringCache;
   auto I = Store.try_emplace(Str);
   auto &MapEntry = I.first->getValue();
@@ -775,6 +782,7 @@ MDNode *MDNode::uniquify() {
   assert(!hasSelfReference(this) && "Cannot uniquify a self-referencing node");
 
   // Try to insert into uniquing store.
+  auto Guard = getContext().pImpl->lockMetadata();
   switch (getMetadataID()) {
   default:
     llvm_unreachable("Invalid or non-uniquable subclass of MDNode");
@@ -791,6 +799,7 @@ MDNode *MDNode::uniquify() {
 }
 
 void MDNode::eraseFromStore() {
+  auto Guard = getContext().pImpl->lockMetadata();
   switch (getMetadataID()) {
   default:
     llvm_unreachable("Invalid or non-uniquable subclass of MDNode");
@@ -805,6 +814,7 @@ void MDNode::eraseFromStore() {
 MDTuple *MDTuple::getImpl(LLVMContext &Context, ArrayRef<Metadata *> MDs,
                           StorageType Storage, bool ShouldCreate) {
   unsigned Hash = 0;
+  auto Guard = Context.pImpl->lockMetadata();
   if (Storage == Uniqued) {
     MDTupleInfo::KeyTy Key(MDs);
     if (auto *N = getUniqued(Context.pImpl->MDTuples, Key))
@@ -845,6 +855,7 @@ void MDNode::storeDistinctInContext() {
 #include "llvm/IR/Metadata.def"
   }
 
+  auto Guard = getContext().pImpl->lockMetadata();
   getContext().pImpl->DistinctMDNodes.push_back(this);
 }
 
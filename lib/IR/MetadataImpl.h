@@ -14,6 +14,7 @@
 #ifndef LLVM_IR_METADATAIMPL_H
 #define LLVM_IR_METADATAIMPL_H
 
+#include "LLVMContextImpl.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/IR/Metadata.h"
 
@@ -42,9 +43,18 @@ template <class T> T *MDNode::storeImpl(T *N, StorageType Storage) {
 template <class T, class StoreT>
 T *MDNode::storeImpl(T *N, StorageType Storage, StoreT &Store) {
   switch (Storage) {
-  case Uniqued:
-    Store.insert(N);
+  case Uniqued: {
+    // Another thread may have stored an equal node since the lookup; keep
+    // the first one.
+    auto Guard = N->getContext().pImpl->lockMetadata();
+    auto Inserted = Store.insert(N);
+    if (!Inserted.second) {
+      N->dropAllReferences();
+      N->deleteAsSubclass();
+      return *Inserted.first;
+    }
     break;
+  }
   case Distinct:
     N->storeDistinctInContext();
     break;
@@ -9,8 +9,13 @@
 
 #include "llvm/IR/PassManager.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/LLVMContext.h"
 
+#if LLVM_ENABLE_THREADS
+#include <thread>
+#endif
+
 using namespace llvm;
 
 // Explicit template instantiations and specialization defininitions for core
@@ -94,3 +99,17 @@ bool FunctionAnalysisManagerModuleProxy::Result::invalidate(
 AnalysisSetKey CFGAnalyses::SetKey;
 
 AnalysisSetKey PreservedAnalyses::AllAnalysesKey;
+
+void llvm::detail::runOnThreads(unsigned NumThreads,
+                                function_ref<void()> Body) {
+#if LLVM_ENABLE_THREADS
+  std::vector<std::thread> Threads;
+  for (unsigned I = 1; I < NumThreads; ++I)
+    Threads.emplace_back([Body] { Body(); });
+  Body();
+  for (std::thread &T : Threads)
+    T.join();
+#else
+  Body();
+#endif
+}
@@ -253,6 +253,7 @@ IntegerType *IntegerType::get(LLVMContext &C, unsigned NumBits) {
     break;
   }
   
+  auto Guard = C.pImpl->lockTypes();
   IntegerType *&Entry = C.pImpl->IntegerTypes[NumBits];
 
   if (!Entry)
@@ -298,6 +299,7 @@ FunctionType *FunctionType::get(Type *ReturnType,
                                 ArrayRef<Type*> Params, bool isVarArg) {
   LLVMContextImpl *pImpl = ReturnType->getContext().pImpl;
   FunctionTypeKeyInfo::KeyTy Key(ReturnType, Params, isVarArg);
+  auto Guard = pImpl->lockTypes();
   auto I = pImpl->FunctionTypes.find_as(Key);
   FunctionType *FT;
 
@@ -337,6 +339,7 @@ StructType *StructType::get(LLVMContext &Context, ArrayRef<Type*> ETypes,
                             bool isPacked) {
   LLVMContextImpl *pImpl = Context.pImpl;
   AnonStructTypeKeyInfo::KeyTy Key(ETypes, isPacked);
+  auto Guard = pImpl->lockTypes();
   auto I = pImpl->AnonStructTypes.find_as(Key);
   StructType *ST;
 
@@ -367,12 +370,14 @@ void StructType::setBody(ArrayRef<Type*> Elements, bool isPacked) {
     return;
   }
 
+  auto Guard = getContext().pImpl->lockTypes();
   ContainedTys = Elements.copy(getContext().pImpl->TypeAllocator).data();
 }
 
 void StructType::setName(StringRef Name) {
   if (Name == getName()) return;
 
+  auto Guard = getContext().pImpl->lockTypes();
   StringMap<StructType *> &SymbolTable = getContext().pImpl->NamedStructTypes;
 
   using EntryTy = StringMap<StructType *>::MapEntryTy;
@@ -422,6 +427,7 @@ void StructType::setName(StringRef Name) {
 // StructType Helper functions.
 
 StructType *StructType::create(LLVMContext &Context, StringRef Name) {
+  auto Guard = Context.pImpl->lockTypes();
   StructType *ST = new (Context.pImpl->TypeAllocator) StructType(Context);
   if (!Name.empty())
     ST->setName(Name);
@@ -507,6 +513,7 @@ bool StructType::isLayoutIdentical(StructType *Other) const {
 }
 
 StructType *Module::getTypeByName(StringRef Name) const {
+  auto Guard = getContext().pImpl->lockTypes();
   return getContext().pImpl->NamedStructTypes.lookup(Name);
 }
 
@@ -569,6 +576,7 @@ ArrayType *ArrayType::get(Type *ElementType, uint64_t NumElements) {
   assert(isValidElementType(ElementType) && "Invalid type for array element!");
 
   LLVMContextImpl *pImpl = ElementType->getContext().pImpl;
+  auto Guard = pImpl->lockTypes();
   ArrayType *&Entry = 
     pImpl->ArrayTypes[std::make_pair(ElementType, NumElements)];
 
@@ -597,6 +605,7 @@ VectorType *VectorType::get(Type *ElementType, unsigned NumElements) {
                                             "pointer type.");
 
   LLVMContextImpl *pImpl = ElementType->getContext().pImpl;
+  auto Guard = pImpl->lockTypes();
   VectorType *&Entry = ElementType->getContext().pImpl
     ->VectorTypes[std::make_pair(ElementType, NumElements)];
 
@@ -619,6 +628,7 @@ PointerType *PointerType::get(Type *EltTy, unsigned AddressSpace) {
   assert(isValidElementType(EltTy) && "Invalid type for pointer element!");
   
   LLVMContextImpl *CImpl = EltTy->getContext().pImpl;
+  auto Guard = CImpl->lockTypes();
   
   // Since AddressSpace #0 is the common case, we special case it.
   PointerType *&Entry = AddressSpace == 0 ? CImpl->PointerTypes[EltTy]
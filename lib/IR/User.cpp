@@ -10,6 +10,7 @@
 #include "llvm/IR/User.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/InstructionArena.h"
 #include "llvm/IR/Operator.h"
 
 namespace llvm {
@@ -34,6 +35,14 @@ void User::replaceUsesOfWith(Value *From, Value *To) {
     }
 }
 
+/// Free the memory of a User, or of its hung off uses.
+static void freeUserStorage(bool HasArenaStorage, void *Storage) {
+  if (HasArenaStorage)
+    InstructionArena::deallocate(Storage);
+  else
+    ::operator delete(Storage);
+}
+
 //===----------------------------------------------------------------------===//
 //                         User allocHungoffUses Implementation
 //===----------------------------------------------------------------------===//
@@ -51,7 +60,12 @@ void User::allocHungoffUses(unsigned N, bool IsPhi) {
   size_t size = N * sizeof(Use) + sizeof(Use::UserRef);
   if (IsPhi)
     size += N * sizeof(BasicBlock *);
-  Use *Begin = static_cast<Use*>(::operator new(size));
+  // The uses of a User allocated from an arena come from the arena of the
+  // function being worked on, which need not be the one of the User.
+  Use *Begin = static_cast<Use *>(
+      HasArenaStorage
+          ? InstructionArena::allocate(InstructionArena::getCurrent(), size)
+          : ::operator new(size));
   Use *End = Begin + N;
   (void) new(End) Use::UserRef(const_cast<User*>(this), 1);
   setOperandList(Use::initTags(Begin, End));
@@ -81,7 +95,8 @@ void User::growHungoffUses(unsigned NewNumUses, bool IsPhi) {
         reinterpret_cast<char *>(NewOps + NewNumUses) + sizeof(Use::UserRef);
     std::copy(OldPtr, OldPtr + (OldNumUses * sizeof(BasicBlock *)), NewPtr);
   }
-  Use::zap(OldOps, OldOps + OldNumUses, true);
+  Use::zap(OldOps, OldOps + OldNumUses);
+  freeUserStorage(HasArenaStorage, OldOps);
 }
 
 
@@ -112,7 +127,8 @@ MutableArrayRef<uint8_t> User::getDescriptor() {
 //===----------------------------------------------------------------------===//
 
 void *User::allocateFixedOperandUser(size_t Size, unsigned Us,
-                                     unsigned DescBytes) {
+                                     unsigned DescBytes,
+                                     InstructionArena *Arena) {
   assert(Us < (1u << NumUserOperandsBits) && "Too many operands");
 
   static_assert(sizeof(DescriptorInfo) % sizeof(void *) == 0, "Required below");
@@ -122,14 +138,16 @@ void *User::allocateFixedOperandUser(size_t Size, unsigned Us,
   assert(DescBytesToAllocate % sizeof(void *) == 0 &&
          "We need this to satisfy alignment constraints for Uses");
 
+  size_t Bytes = Size + sizeof(Use) * Us + DescBytesToAllocate;
   uint8_t *Storage = static_cast<uint8_t *>(
-      ::operator new(Size + sizeof(Use) * Us + DescBytesToAllocate));
+      Arena ? InstructionArena::allocate(Arena, Bytes) : ::operator new(Bytes));
   Use *Start = reinterpret_cast<Use *>(Storage + DescBytesToAllocate);
   Use *End = Start + Us;
   User *Obj = reinterpret_cast<User*>(End);
   Obj->NumUserOperands = Us;
   Obj->HasHungOffUses = false;
   Obj->HasDescriptor = DescBytes != 0;
+  Obj->HasArenaStorage = Arena != nullptr;
   Use::initTags(Start, End);
 
   if (DescBytes != 0) {
@@ -140,26 +158,42 @@ void *User::allocateFixedOperandUser(size_t Size, unsigned Us,
   return Obj;
 }
 
-void *User::operator new(size_t Size, unsigned Us) {
-  return allocateFixedOperandUser(Size, Us, 0);
-}
-
-void *User::operator new(size_t Size, unsigned Us, unsigned DescBytes) {
-  return allocateFixedOperandUser(Size, Us, DescBytes);
-}
-
-void *User::operator new(size_t Size) {
+void *User::allocateHungOffOperandUser(size_t Size, InstructionArena *Arena) {
   // Allocate space for a single Use*
-  void *Storage = ::operator new(Size + sizeof(Use *));
+  size_t Bytes = Size + sizeof(Use *);
+  void *Storage =
+      Arena ? InstructionArena::allocate(Arena, Bytes) : ::operator new(Bytes);
   Use **HungOffOperandList = static_cast<Use **>(Storage);
   User *Obj = reinterpret_cast<User *>(HungOffOperandList + 1);
   Obj->NumUserOperands = 0;
   Obj->HasHungOffUses = true;
   Obj->HasDescriptor = false;
+  Obj->HasArenaStorage = Arena != nullptr;
   *HungOffOperandList = nullptr;
   return Obj;
 }
 
+void *User::operator new(size_t Size, unsigned Us) {
+  return allocateFixedOperandUser(Size, Us, 0, nullptr);
+}
+
+void *User::operator new(size_t Size, unsigned Us, unsigned DescBytes) {
+  return allocateFixedOperandUser(Size, Us, DescBytes, nullptr);
+}
+
+void *User::operator new(size_t Size) {
+  return allocateHungOffOperandUser(Size, nullptr);
+}
+
+void *User::allocateInArena(InstructionArena *Arena, size_t Size) {
+  return allocateHungOffOperandUser(Size, Arena);
+}
+
+void *User::allocateInArena(InstructionArena *Arena, size_t Size, unsigned Us,
+                            unsigned DescBytes) {
+  return allocateFixedOperandUser(Size, Us, DescBytes, Arena);
+}
+
 //===----------------------------------------------------------------------===//
 //                         User operator delete Implementation
 //===----------------------------------------------------------------------===//
@@ -173,21 +207,23 @@ void User::operator delete(void *Usr) {
 
     Use **HungOffOperandList = static_cast<Use **>(Usr) - 1;
     // drop the hung off uses.
-    Use::zap(*HungOffOperandList, *HungOffOperandList + Obj->NumUserOperands,
-             /* Delete */ true);
-    ::operator delete(HungOffOperandList);
+    if (Use *Uses = *HungOffOperandList) {
+      Use::zap(Uses, Uses + Obj->NumUserOperands, /* Delete */ false);
+      freeUserStorage(Obj->HasArenaStorage, Uses);
+    }
+    freeUserStorage(Obj->HasArenaStorage, HungOffOperandList);
   } else if (Obj->HasDescriptor) {
     Use *UseBegin = static_cast<Use *>(Usr) - Obj->NumUserOperands;
     Use::zap(UseBegin, UseBegin + Obj->NumUserOperands, /* Delete */ false);
 
     auto *DI = reinterpret_cast<DescriptorInfo *>(UseBegin) - 1;
     uint8_t *Storage = reinterpret_cast<uint8_t *>(DI) - DI->SizeInBytes;
-    ::operator delete(Storage);
+    freeUserStorage(Obj->HasArenaStorage, Storage);
   } else {
     Use *Storage = static_cast<Use *>(Usr) - Obj->NumUserOperands;
     Use::zap(Storage, Storage + Obj->NumUserOperands,
              /* Delete */ false);
-    ::operator delete(Storage);
+    freeUserStorage(Obj->HasArenaStorage, Storage);
   }
 }
 
@@ -731,6 +731,7 @@ bool Value::isSwiftError() const {
 
 void ValueHandleBase::AddToExistingUseList(ValueHandleBase **List) {
   assert(List && "Handle list is null?");
+  auto Guard = getValPtr()->getContext().pImpl->lockValueHandles();
 
   // Splice ourselves into the list.
   Next = *List;
@@ -756,6 +757,7 @@ void ValueHandleBase::AddToUseList() {
   assert(getValPtr() && "Null pointer doesn't have a use list!");
 
   LLVMContextImpl *pImpl = getValPtr()->getContext().pImpl;
+  auto Guard = pImpl->lockValueHandles();
 
   if (getValPtr()->HasValueHandle) {
     // If this value already has a ValueHandle, then it must be in the
@@ -798,6 +800,8 @@ void ValueHandleBase::AddToUseList() {
 void ValueHandleBase::RemoveFromUseList() {
   assert(getValPtr() && getValPtr()->HasValueHandle &&
          "Pointer doesn't have a use list!");
+  LLVMContextImpl *pImpl = getValPtr()->getContext().pImpl;
+  auto Guard = pImpl->lockValueHandles();
 
   // Unlink this from its use list.
   ValueHandleBase **PrevPtr = getPrevPtr();
@@ -813,7 +817,6 @@ void ValueHandleBase::RemoveFromUseList() {
   // If the Next pointer was null, then it is possible that this was the last
   // ValueHandle watching VP.  If so, delete its entry from the ValueHandles
   // map.
-  LLVMContextImpl *pImpl = getValPtr()->getContext().pImpl;
   DenseMap<Value*, ValueHandleBase*> &Handles = pImpl->ValueHandles;
   if (Handles.isPointerIntoBucketsArray(PrevPtr)) {
     Handles.erase(getValPtr());
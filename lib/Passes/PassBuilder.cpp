@@ -23,12 +23,14 @@
 #include "llvm/Analysis/BasicAliasAnalysis.h"
 #include "llvm/Analysis/BlockFrequencyInfo.h"
 #include "llvm/Analysis/BlockFrequencyInfoImpl.h"
+#include "llvm/Analysis/BlockReachability.h"
 #include "llvm/Analysis/BranchProbabilityInfo.h"
 #include "llvm/Analysis/CFGPrinter.h"
 #include "llvm/Analysis/CFLAndersAliasAnalysis.h"
 #include "llvm/Analysis/CFLSteensAliasAnalysis.h"
 #include "llvm/Analysis/CGSCCPassManager.h"
 #include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/ControlDependenceGraph.h"
 #include "llvm/Analysis/DemandedBits.h"
 #include "llvm/Analysis/DependenceAnalysis.h"
 #include "llvm/Analysis/DominanceFrontier.h"
@@ -38,6 +40,7 @@
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/Analysis/LoopAccessAnalysis.h"
 #include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/LoopNestingForest.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
 #include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/ModuleSummaryAnalysis.h"
@@ -48,6 +51,7 @@
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/Analysis/ScalarEvolutionAliasAnalysis.h"
 #include "llvm/Analysis/ScopedNoAliasAA.h"
+#include "llvm/Analysis/SourceLineIndex.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Analysis/TypeBasedAliasAnalysis.h"
@@ -59,6 +63,7 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Regex.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/GCOVProfiler.h"
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
@@ -132,6 +137,7 @@
 #include "llvm/Transforms/Scalar/TailRecursionElimination.h"
 #include "llvm/Transforms/Utils/AddDiscriminators.h"
 #include "llvm/Transforms/Utils/BreakCriticalEdges.h"
+#include "llvm/Transforms/Utils/Hello.h"
 #include "llvm/Transforms/Utils/LCSSA.h"
 #include "llvm/Transforms/Utils/LibCallsShrinkWrap.h"
 #include "llvm/Transforms/Utils/LoopSimplify.h"
@@ -172,6 +178,13 @@ static cl::opt<bool> EnableGVNSink(
     "enable-npm-gvn-sink", cl::init(false), cl::Hidden,
     cl::desc("Enable the GVN hoisting pass for the new PM (default = off)"));
 
+static cl::opt<unsigned> FunctionPassThreads(
+    "npm-function-pass-threads", cl::init(1), cl::Hidden,
+    cl::desc("Run the function(...) pipelines of a textual pipeline on this "
+             "many functions at once. Experimental: only correct for "
+             "analysis pipelines, which do not create constants or globals "
+             "or add or remove uses of them (default = 1)"));
+
 static Regex DefaultAliasRegex(
     "^(default|thinlto-pre-link|thinlto|lto-pre-link|lto)<(O[0123sz])>$");
 
@@ -1222,6 +1235,30 @@ static bool isLoopPassName(StringRef Name, CallbacksT &Callbacks) {
   return callbacksAcceptPassName<LoopPassManager>(Name, Callbacks);
 }
 
+/// \brief Find the first pass of a function pipeline that may change the IR.
+///
+/// Only analysis requests, printers, verifiers and no-op passes are known not
+/// to, and the nested function pipelines made of them. Loop pipelines are
+/// refused as a whole, since the loop pass adaptor puts loops into simplified
+/// and LCSSA form on its own. Returns null if there is none.
+static const PassBuilder::PipelineElement *
+findTransformPass(ArrayRef<PassBuilder::PipelineElement> Pipeline) {
+  for (const auto &E : Pipeline) {
+    StringRef Name = E.Name;
+    if (Name == "function" || parseRepeatPassName(Name)) {
+      if (auto *Inner = findTransformPass(E.InnerPipeline))
+        return Inner;
+      continue;
+    }
+    if (Name.startswith("require<") || Name.startswith("invalidate<") ||
+        Name.startswith("print") || Name.startswith("verify") ||
+        Name == "no-op-function")
+      continue;
+    return &E;
+  }
+  return nullptr;
+}
+
 Optional<std::vector<PassBuilder::PipelineElement>>
 PassBuilder::parsePipelineText(StringRef Text) {
   std::vector<PipelineElement> ResultPipeline;
@@ -1308,7 +1345,45 @@ bool PassBuilder::parseModulePass(ModulePassManager &MPM,
       if (!parseFunctionPassPipeline(FPM, InnerPipeline, VerifyEachPass,
                                      DebugLogging))
         return false;
-      MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
+      if (FunctionPassThreads <= 1) {
+        MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
+        return true;
+      }
+      // The threads share the use lists of constants and globals, so only
+      // pipelines that leave the IR alone may run in parallel.
+      if (auto *Transform = findTransformPass(InnerPipeline)) {
+        errs() << "-npm-function-pass-threads: '" << Transform->Name
+               << "' may change the IR; only analysis pipelines can run on "
+                  "several threads\n";
+        return false;
+      }
+      // Every thread parses its own copy of the pipeline and gets its own
+      // analysis managers, set up the same way as the ones of the caller.
+      // The threads may outlive this builder, so they use a copy of it. The
+      // pass names still point into the pipeline text.
+      PassBuilder PB(*this);
+      auto ThreadSetup = [PB, InnerPipeline, VerifyEachPass, DebugLogging](
+          ModuleAnalysisManager &MAM,
+          function_ref<void(FunctionPassManager &, FunctionAnalysisManager &)>
+              Run) mutable {
+        LoopAnalysisManager LAM(DebugLogging);
+        FunctionAnalysisManager FAM(DebugLogging);
+        PB.registerFunctionAnalyses(FAM);
+        PB.registerLoopAnalyses(LAM);
+        FAM.registerPass([&] { return LoopAnalysisManagerFunctionProxy(LAM); });
+        FAM.registerPass(
+            [&] { return ModuleAnalysisManagerFunctionProxy(MAM); });
+        LAM.registerPass([&] { return FunctionAnalysisManagerLoopProxy(FAM); });
+
+        FunctionPassManager ThreadFPM(DebugLogging);
+        bool Parsed = PB.parseFunctionPassPipeline(
+            ThreadFPM, InnerPipeline, VerifyEachPass, DebugLogging);
+        assert(Parsed && "The pipeline parsed before!");
+        (void)Parsed;
+        Run(ThreadFPM, FAM);
+      };
+      MPM.addPass(ModuleToFunctionPassAdaptor<FunctionPassManager>(
+          std::move(FPM), FunctionPassThreads, std::move(ThreadSetup)));
       return true;
     }
     if (auto Count = parseRepeatPassName(Name)) {
@@ -0,0 +1,73 @@
+//===- AllocationHook.cpp - Counting operator new and delete --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file replaces the global operator new and operator delete with versions
+// that report each block to the AllocationTracker. It is only built with
+// LLVM_ENABLE_ALLOCATION_HOOK, since replacing them affects every program that
+// links LLVMSupport.
+//
+// Nothing else lives in this file, so that a program which brings its own
+// operator new never pulls it out of the archive. The replacements are left
+// out of sanitizer builds, whose runtimes provide their own to catch
+// mismatched new and delete.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/AllocationTracker.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/ErrorHandling.h"
+#include <cstdlib>
+#include <new>
+
+#if !LLVM_ADDRESS_SANITIZER_BUILD && !LLVM_MEMORY_SANITIZER_BUILD &&           \
+    !LLVM_THREAD_SANITIZER_BUILD && !defined(_WIN32)
+
+using namespace llvm;
+
+static void *allocate(size_t Size, bool Nothrow) {
+  if (Size == 0)
+    Size = 1;
+  void *Ptr;
+  while (!(Ptr = std::malloc(Size))) {
+    std::new_handler Handler = std::get_new_handler();
+    if (!Handler) {
+      if (Nothrow)
+        return nullptr;
+      report_bad_alloc_error("Allocation failed");
+    }
+    Handler();
+  }
+  AllocationTracker::noteAllocation(Ptr);
+  return Ptr;
+}
+
+static void deallocate(void *Ptr) {
+  AllocationTracker::noteDeallocation(Ptr);
+  std::free(Ptr);
+}
+
+void *operator new(size_t Size) { return allocate(Size, false); }
+void *operator new[](size_t Size) { return allocate(Size, false); }
+void *operator new(size_t Size, const std::nothrow_t &) noexcept {
+  return allocate(Size, true);
+}
+void *operator new[](size_t Size, const std::nothrow_t &) noexcept {
+  return allocate(Size, true);
+}
+
+void operator delete(void *Ptr) noexcept { deallocate(Ptr); }
+void operator delete[](void *Ptr) noexcept { deallocate(Ptr); }
+void operator delete(void *Ptr, const std::nothrow_t &) noexcept {
+  deallocate(Ptr);
+}
+void operator delete[](void *Ptr, const std::nothrow_t &) noexcept {
+  deallocate(Ptr);
+}
+
+#endif
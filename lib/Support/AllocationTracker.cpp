@@ -0,0 +1,139 @@
+//===- AllocationTracker.cpp - Heap allocation counts ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the per-thread heap counters fed by the operator new
+// hook in AllocationHook.cpp, and the AllocationRegion class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/AllocationTracker.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
+#include <atomic>
+#include <cstdlib>
+
+#if defined(HAVE_MALLOC_USABLE_SIZE)
+#include <malloc.h>
+#elif defined(HAVE_MALLOC_MALLOC_H)
+#include <malloc/malloc.h>
+#endif
+
+using namespace llvm;
+
+namespace {
+/// The heap activity of one thread since it started.
+struct ThreadCounts {
+  uint64_t Allocations;
+  uint64_t Bytes;
+  int64_t Live; ///< May go negative if blocks move between threads.
+  int64_t Peak; ///< High-water mark of Live since the innermost region began.
+  unsigned ActiveRegions;
+};
+} // end anonymous namespace
+
+static std::atomic<bool> TrackingEnabled(false);
+static LLVM_THREAD_LOCAL ThreadCounts Counts;
+
+/// Serializes setEnabled and the availability probe, and the merging of
+/// region results into shared records.
+static ManagedStatic<sys::SmartMutex<true>> TrackerLock;
+
+/// Return the size malloc actually set aside for a block, or zero if the host
+/// can't tell.
+static size_t getBlockSize(void *Ptr) {
+#if defined(HAVE_MALLOC_USABLE_SIZE)
+  return malloc_usable_size(Ptr);
+#elif defined(HAVE_MALLOC_MALLOC_H)
+  return malloc_size(Ptr);
+#else
+  (void)Ptr;
+  return 0;
+#endif
+}
+
+void AllocationTracker::setEnabled(bool Enabled) {
+  sys::SmartScopedLock<true> Lock(*TrackerLock);
+  TrackingEnabled.store(Enabled, std::memory_order_relaxed);
+}
+
+bool AllocationTracker::isEnabled() {
+  return TrackingEnabled.load(std::memory_order_relaxed);
+}
+
+bool AllocationTracker::isAvailable() {
+#if !defined(HAVE_MALLOC_USABLE_SIZE) && !defined(HAVE_MALLOC_MALLOC_H)
+  return false;
+#else
+  static const bool Available = [] {
+    // Another operator new may have won over ours, so see whether an
+    // allocation actually gets reported.
+    sys::SmartScopedLock<true> Lock(*TrackerLock);
+    bool WasEnabled = TrackingEnabled.exchange(true);
+    uint64_t Before = Counts.Allocations;
+    ::operator delete(::operator new(1));
+    bool Reported = Counts.Allocations != Before;
+    TrackingEnabled.store(WasEnabled);
+    return Reported;
+  }();
+  return Available;
+#endif
+}
+
+void AllocationTracker::noteAllocation(void *Ptr) {
+  if (LLVM_LIKELY(!TrackingEnabled.load(std::memory_order_relaxed)))
+    return;
+  int64_t Size = getBlockSize(Ptr);
+  ThreadCounts &C = Counts;
+  ++C.Allocations;
+  C.Bytes += Size;
+  C.Live += Size;
+  if (C.Live > C.Peak)
+    C.Peak = C.Live;
+}
+
+void AllocationTracker::noteDeallocation(void *Ptr) {
+  if (LLVM_LIKELY(!TrackingEnabled.load(std::memory_order_relaxed)) || !Ptr)
+    return;
+  Counts.Live -= getBlockSize(Ptr);
+}
+
+AllocationRegion::AllocationRegion(AllocationCounts *Counts) : Counts(Counts) {
+  if (!Counts)
+    return;
+  ThreadCounts &C = ::Counts;
+  StartAllocations = C.Allocations;
+  StartBytes = C.Bytes;
+  StartLive = C.Live;
+  SavedPeak = C.Peak;
+  C.Peak = C.Live;
+  Outermost = C.ActiveRegions++ == 0;
+}
+
+AllocationRegion::~AllocationRegion() {
+  if (!Counts)
+    return;
+  ThreadCounts &C = ::Counts;
+  AllocationCounts Result;
+  Result.Allocations = C.Allocations - StartAllocations;
+  Result.Bytes = C.Bytes - StartBytes;
+  Result.PeakBytes = C.Peak - StartLive;
+  if (Outermost) {
+    Result.OutermostAllocations = Result.Allocations;
+    Result.OutermostBytes = Result.Bytes;
+  }
+  --C.ActiveRegions;
+  // The enclosing region saw this peak too.
+  if (SavedPeak > C.Peak)
+    C.Peak = SavedPeak;
+
+  sys::SmartScopedLock<true> Lock(*TrackerLock);
+  *Counts += Result;
+}
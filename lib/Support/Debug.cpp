@@ -25,6 +25,7 @@
 
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/circular_raw_ostream.h"
@@ -76,6 +77,18 @@ void setCurrentDebugTypes(const char **Types, unsigned Count) {
 }
 } // namespace llvm
 
+/// The stream dbgs() returns on this thread instead of the shared one, if any.
+static LLVM_THREAD_LOCAL raw_ostream *RedirectedDebugStream = nullptr;
+
+DebugStreamRedirect::DebugStreamRedirect(raw_ostream &OS)
+    : Saved(RedirectedDebugStream) {
+  RedirectedDebugStream = &OS;
+}
+
+DebugStreamRedirect::~DebugStreamRedirect() {
+  RedirectedDebugStream = Saved;
+}
+
 // All Debug.h functionality is a no-op in NDEBUG mode.
 #ifndef NDEBUG
 
@@ -117,19 +130,19 @@ static cl::opt<DebugOnlyOpt, true, cl::parser<std::string> >
 DebugOnly("debug-only", cl::desc("Enable a specific type of debug output (comma separated list of types)"),
           cl::Hidden, cl::ZeroOrMore, cl::value_desc("debug string"),
           cl::location(DebugOnlyOptLoc), cl::ValueRequired);
+
 // Signal handlers - dump debug output on termination.
 static void debug_user_sig_handler(void *Cookie) {
-  // This is a bit sneaky.  Since this is under #ifndef NDEBUG, we
-  // know that debug mode is enabled and dbgs() really is a
-  // circular_raw_ostream.  If NDEBUG is defined, then dbgs() ==
-  // errs() but this will never be invoked.
-  llvm::circular_raw_ostream &dbgout =
-      static_cast<circular_raw_ostream &>(llvm::dbgs());
-  dbgout.flushBufferWithBanner();
+  // The cookie is the circular-buffered debug stream; dbgs() may be
+  // redirected on the thread that handles the signal.
+  static_cast<circular_raw_ostream *>(Cookie)->flushBufferWithBanner();
 }
 
 /// dbgs - Return a circular-buffered debug stream.
 raw_ostream &llvm::dbgs() {
+  if (raw_ostream *OS = RedirectedDebugStream)
+    return *OS;
+
   // Do one-time initialization in a thread-safe way.
   static struct dbgstream {
     circular_raw_ostream strm;
@@ -140,7 +153,7 @@ raw_ostream &llvm::dbgs() {
       if (EnableDebugBuffering && DebugFlag && DebugBufferSize != 0)
         // TODO: Add a handler for SIGUSER1-type signals so the user can
         // force a debug dump.
-        sys::AddSignalHandler(&debug_user_sig_handler, nullptr);
+        sys::AddSignalHandler(&debug_user_sig_handler, &strm);
       // Otherwise we've already set the debug stream buffer size to
       // zero, disabling buffering so it will output directly to errs().
     }
@@ -154,6 +167,8 @@ raw_ostream &llvm::dbgs() {
 namespace llvm {
   /// dbgs - Return errs().
   raw_ostream &dbgs() {
+    if (raw_ostream *OS = RedirectedDebugStream)
+      return *OS;
     return errs();
   }
 }
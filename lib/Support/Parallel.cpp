@@ -10,9 +10,13 @@
 #include "llvm/Support/Parallel.h"
 #include "llvm/Config/llvm-config.h"
 
+#include "llvm/Support/Compiler.h"
+
+#include <algorithm>
 #include <atomic>
-#include <stack>
+#include <memory>
 #include <thread>
+#include <vector>
 
 using namespace llvm;
 
@@ -24,6 +28,11 @@ public:
   virtual ~Executor() = default;
   virtual void add(std::function<void()> func) = 0;
 
+#if LLVM_ENABLE_THREADS
+  /// \brief Wait until \p L reaches zero.
+  virtual void sync(const parallel::detail::Latch &L) { L.sync(); }
+#endif
+
   static Executor *getDefaultExecutor();
 };
 
@@ -66,20 +75,144 @@ Executor *Executor::getDefaultExecutor() {
 }
 
 #else
+/// \brief A Chase-Lev work-stealing deque of tasks.
+///
+/// The owning worker pushes and pops at the bottom without taking a lock;
+/// other workers steal from the top with a single compare-and-swap. The
+/// memory orderings follow Le et al., "Correct and Efficient Work-Stealing
+/// for Weak Memory Models" (PPoPP 2013). Arrays replaced on growth are kept
+/// until the deque dies, since a thief may still be reading them.
+template <typename T> class WorkStealingDeque {
+  class Array {
+    size_t Mask;
+    std::unique_ptr<std::atomic<T *>[]> Slots;
+
+  public:
+    explicit Array(size_t Size)
+        : Mask(Size - 1), Slots(new std::atomic<T *>[Size]) {}
+
+    size_t size() const { return Mask + 1; }
+    T *get(int64_t I) const {
+      return Slots[I & Mask].load(std::memory_order_relaxed);
+    }
+    void put(int64_t I, T *X) {
+      Slots[I & Mask].store(X, std::memory_order_relaxed);
+    }
+  };
+
+  std::atomic<int64_t> Top{0};
+  std::atomic<int64_t> Bottom{0};
+  std::atomic<Array *> Buffer;
+  /// The current array and all the arrays it replaced. Only the owner
+  /// modifies this.
+  std::vector<std::unique_ptr<Array>> Arrays;
+
+public:
+  WorkStealingDeque() {
+    Arrays.emplace_back(new Array(64));
+    Buffer.store(Arrays.back().get(), std::memory_order_relaxed);
+  }
+
+  /// \brief Push \p X at the bottom. Only called by the owner.
+  void push(T *X) {
+    int64_t B = Bottom.load(std::memory_order_relaxed);
+    int64_t Tp = Top.load(std::memory_order_acquire);
+    Array *A = Buffer.load(std::memory_order_relaxed);
+    if (B - Tp > static_cast<int64_t>(A->size()) - 1) {
+      Array *Grown = new Array(A->size() * 2);
+      for (int64_t I = Tp; I != B; ++I)
+        Grown->put(I, A->get(I));
+      Arrays.emplace_back(Grown);
+      Buffer.store(Grown, std::memory_order_release);
+      A = Grown;
+    }
+    A->put(B, X);
+    Bottom.store(B + 1, std::memory_order_release);
+  }
+
+  /// \brief Pop the most recently pushed task, or return null. Only called
+  /// by the owner.
+  T *pop() {
+    int64_t B = Bottom.load(std::memory_order_relaxed) - 1;
+    Array *A = Buffer.load(std::memory_order_relaxed);
+    Bottom.store(B, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t Tp = Top.load(std::memory_order_relaxed);
+    if (Tp > B) {
+      Bottom.store(B + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T *X = A->get(B);
+    if (Tp == B) {
+      // Last task: race the thieves for it.
+      if (!Top.compare_exchange_strong(Tp, Tp + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+        X = nullptr;
+      Bottom.store(B + 1, std::memory_order_relaxed);
+    }
+    return X;
+  }
+
+  /// \brief Steal the oldest task, or return null if there is none or
+  /// another thread took it first.
+  T *steal() {
+    int64_t Tp = Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t B = Bottom.load(std::memory_order_acquire);
+    if (Tp >= B)
+      return nullptr;
+    T *X = Buffer.load(std::memory_order_acquire)->get(Tp);
+    if (!Top.compare_exchange_strong(Tp, Tp + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed))
+      return nullptr;
+    return X;
+  }
+
+  bool empty() const {
+    return Top.load(std::memory_order_acquire) >=
+           Bottom.load(std::memory_order_acquire);
+  }
+};
+
 /// \brief An implementation of an Executor that runs closures on a thread pool
-///   in filo order.
+///   with one work-stealing deque per thread.
+///
+/// Tasks spawned by a worker go to the bottom of its own deque and are run
+/// most recent first, which keeps nested parallel algorithms depth-first and
+/// cache friendly; idle workers steal the oldest, and thus largest, tasks of
+/// the others. Tasks added from other threads are pushed onto a lock-free
+/// list that idle workers take as a whole. The mutex and condition variable
+/// are only used to park workers that found nothing to do.
 class ThreadPoolExecutor : public Executor {
+  struct Task {
+    std::function<void()> F;
+    Task *Next;
+  };
+
+  struct Worker {
+    WorkStealingDeque<Task> Deque;
+    unsigned Index;
+  };
+
+  /// The worker running on this thread, or null on other threads.
+  static LLVM_THREAD_LOCAL Worker *CurrentWorker;
+
 public:
   explicit ThreadPoolExecutor(
       unsigned ThreadCount = std::thread::hardware_concurrency())
-      : Done(ThreadCount) {
+      : Done(std::max(ThreadCount, 1U)) {
+    ThreadCount = std::max(ThreadCount, 1U);
+    for (unsigned I = 0; I != ThreadCount; ++I) {
+      Workers.emplace_back(new Worker);
+      Workers.back()->Index = I;
+    }
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     std::thread([&, ThreadCount] {
-      for (size_t i = 1; i < ThreadCount; ++i) {
-        std::thread([=] { work(); }).detach();
+      for (unsigned I = 1; I < ThreadCount; ++I) {
+        std::thread([=] { work(*Workers[I]); }).detach();
       }
-      work();
+      work(*Workers[0]);
     }).detach();
   }
 
@@ -92,34 +225,110 @@ public:
   }
 
   void add(std::function<void()> F) override {
-    std::unique_lock<std::mutex> Lock(Mutex);
-    WorkStack.push(F);
-    Lock.unlock();
-    Cond.notify_one();
+    Task *T = new Task{std::move(F), nullptr};
+    if (Worker *W = CurrentWorker) {
+      W->Deque.push(T);
+    } else {
+      T->Next = Submitted.load(std::memory_order_relaxed);
+      while (!Submitted.compare_exchange_weak(T->Next, T,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed))
+        ;
+    }
+    wakeOne();
+  }
+
+  void sync(const parallel::detail::Latch &L) override {
+    Worker *W = CurrentWorker;
+    if (!W) {
+      L.sync();
+      return;
+    }
+    // Blocking a worker could leave the tasks of the group with nobody to
+    // run them, so keep running tasks until the group is done.
+    while (!L.isDone())
+      if (!runTask(*W))
+        std::this_thread::yield();
   }
 
 private:
-  void work() {
-    while (true) {
+  void work(Worker &W) {
+    CurrentWorker = &W;
+    while (!Stop) {
+      if (runTask(W))
+        continue;
       std::unique_lock<std::mutex> Lock(Mutex);
-      Cond.wait(Lock, [&] { return Stop || !WorkStack.empty(); });
-      if (Stop)
-        break;
-      auto Task = WorkStack.top();
-      WorkStack.pop();
-      Lock.unlock();
-      Task();
+      Sleeping.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      // Recheck under the lock: add() publishes the task before it looks at
+      // Sleeping, so either it sees this worker asleep or we see the task.
+      if (!Stop && !hasWork())
+        Cond.wait(Lock);
+      Sleeping.fetch_sub(1, std::memory_order_relaxed);
     }
     Done.dec();
   }
 
+  /// \brief Run one task from the deque of \p W, the submitted list, or
+  /// another worker's deque. Return false if none was found.
+  bool runTask(Worker &W) {
+    Task *T = W.Deque.pop();
+    if (!T)
+      T = takeSubmitted(W);
+    for (size_t I = 1, E = Workers.size(); !T && I != E; ++I)
+      T = Workers[(W.Index + I) % E]->Deque.steal();
+    if (!T)
+      return false;
+    T->F();
+    delete T;
+    return true;
+  }
+
+  /// \brief Move the submitted tasks to the deque of \p W, where other
+  /// workers can steal them, and return one of them.
+  Task *takeSubmitted(Worker &W) {
+    Task *List = Submitted.exchange(nullptr, std::memory_order_acquire);
+    if (!List)
+      return nullptr;
+    for (Task *T = List->Next, *Next; T; T = Next) {
+      Next = T->Next;
+      W.Deque.push(T);
+    }
+    if (List->Next)
+      wakeOne();
+    return List;
+  }
+
+  bool hasWork() const {
+    if (Submitted.load(std::memory_order_acquire))
+      return true;
+    for (const std::unique_ptr<Worker> &W : Workers)
+      if (!W->Deque.empty())
+        return true;
+    return false;
+  }
+
+  void wakeOne() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (Sleeping.load(std::memory_order_relaxed) == 0)
+      return;
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Lock.unlock();
+    Cond.notify_one();
+  }
+
   std::atomic<bool> Stop{false};
-  std::stack<std::function<void()>> WorkStack;
+  std::vector<std::unique_ptr<Worker>> Workers;
+  /// Tasks added by threads that are not workers, most recent first.
+  std::atomic<Task *> Submitted{nullptr};
+  std::atomic<unsigned> Sleeping{0};
   std::mutex Mutex;
   std::condition_variable Cond;
   parallel::detail::Latch Done;
 };
 
+LLVM_THREAD_LOCAL ThreadPoolExecutor::Worker *ThreadPoolExecutor::CurrentWorker;
+
 Executor *Executor::getDefaultExecutor() {
   static ThreadPoolExecutor exec;
   return &exec;
@@ -135,4 +344,8 @@ void parallel::detail::TaskGroup::spawn(std::function<void()> F) {
     L.dec();
   });
 }
+
+void parallel::detail::TaskGroup::sync() const {
+  Executor::getDefaultExecutor()->sync(L);
+}
 #endif
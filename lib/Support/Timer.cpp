@@ -44,6 +44,13 @@ namespace {
                                       "tracking (this may be slow)"),
              cl::Hidden);
 
+  static cl::opt<bool>
+  TrackPerfCounters("track-perf-counters",
+                    cl::desc("Enable -time-passes counting of cycles, "
+                             "instructions, cache misses and branch misses, "
+                             "where hardware counters are available"),
+                    cl::Hidden);
+
   static cl::opt<std::string, true>
   InfoOutputFilename("info-output-file", cl::value_desc("filename"),
                      cl::desc("File to append -stats and -timer output to"),
@@ -109,20 +116,39 @@ static inline size_t getMemUsage() {
   return sys::Process::GetMallocUsage();
 }
 
+static inline sys::Process::PerfCounts getPerfCounts() {
+  sys::Process::PerfCounts Counts;
+  if (TrackPerfCounters)
+    sys::Process::GetPerfCounts(Counts);
+  return Counts;
+}
+
 TimeRecord TimeRecord::getCurrentTime(bool Start) {
   using Seconds = std::chrono::duration<double, std::ratio<1>>;
   TimeRecord Result;
   sys::TimePoint<> now;
   std::chrono::nanoseconds user, sys;
+  sys::Process::PerfCounts Counts;
 
+  // Read the counters closest to the timed region, so that they count as
+  // little of the other measurements as possible.
   if (Start) {
     Result.MemUsed = getMemUsage();
     sys::Process::GetTimeUsage(now, user, sys);
+    Counts = getPerfCounts();
   } else {
+    Counts = getPerfCounts();
     sys::Process::GetTimeUsage(now, user, sys);
     Result.MemUsed = getMemUsage();
   }
 
+  Result.Cycles = Counts.Cycles;
+  Result.Instructions = Counts.Instructions;
+  Result.CacheMisses = Counts.CacheMisses;
+  Result.BranchMisses = Counts.BranchMisses;
+  Result.PerfTimeEnabled = Counts.TimeEnabled;
+  Result.PerfTimeRunning = Counts.TimeRunning;
+
   Result.WallTime = Seconds(now.time_since_epoch()).count();
   Result.UserTime = Seconds(user).count();
   Result.SystemTime = Seconds(sys).count();
@@ -167,6 +193,13 @@ void TimeRecord::print(const TimeRecord &Total, raw_ostream &OS) const {
 
   if (Total.getMemUsed())
     OS << format("%9" PRId64 "  ", (int64_t)getMemUsed());
+
+  // The counters are all zero if they were not tracked or not available.
+  if (Total.getCycles())
+    OS << format("%14" PRIu64 "  %14" PRIu64 "  %14" PRIu64 "  %14" PRIu64
+                 "  ",
+                 getCycles(), getInstructions(), getCacheMisses(),
+                 getBranchMisses());
 }
 
 
@@ -315,6 +348,8 @@ void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
   OS << "   ---Wall Time---";
   if (Total.getMemUsed())
     OS << "  ---Mem---";
+  if (Total.getCycles())
+    OS << "  ----Cycles----  -Instructions-  -Cache Misses-  -Branch Misses";
   OS << "  --- Name ---\n";
 
   // Loop through all of the timing data, printing it out.
@@ -367,6 +402,13 @@ void TimerGroup::printJSONValue(raw_ostream &OS, const PrintRecord &R,
   OS << "\t\"time." << Name << '.' << R.Name << suffix << "\": " << Value;
 }
 
+void TimerGroup::printJSONValue(raw_ostream &OS, const PrintRecord &R,
+                                const char *suffix, uint64_t Value) {
+  assert(!yaml::needsQuotes(Name) && "TimerGroup name needs no quotes");
+  assert(!yaml::needsQuotes(R.Name) && "Timer name needs no quotes");
+  OS << "\t\"time." << Name << '.' << R.Name << suffix << "\": " << Value;
+}
+
 const char *TimerGroup::printJSONValues(raw_ostream &OS, const char *delim) {
   prepareToPrintList();
   for (const PrintRecord &R : TimersToPrint) {
@@ -379,6 +421,16 @@ const char *TimerGroup::printJSONValues(raw_ostream &OS, const char *delim) {
     printJSONValue(OS, R, ".user", T.getUserTime());
     OS << delim;
     printJSONValue(OS, R, ".sys", T.getSystemTime());
+    if (T.getCycles()) {
+      OS << delim;
+      printJSONValue(OS, R, ".cycles", T.getCycles());
+      OS << delim;
+      printJSONValue(OS, R, ".instructions", T.getInstructions());
+      OS << delim;
+      printJSONValue(OS, R, ".cache-misses", T.getCacheMisses());
+      OS << delim;
+      printJSONValue(OS, R, ".branch-misses", T.getBranchMisses());
+    }
   }
   TimersToPrint.clear();
   return delim;
@@ -431,7 +431,8 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
                 bool InsertLifetime,
                 function_ref<InlineCost(CallSite CS)> GetInlineCost,
                 function_ref<AAResults &(Function &)> AARGetter,
-                ImportedFunctionsInliningStatistics &ImportedFunctionsStats) {
+                ImportedFunctionsInliningStatistics &ImportedFunctionsStats,
+                InlineCostCache &CostCache) {
   SmallPtrSet<Function *, 8> SCCFunctions;
   DEBUG(dbgs() << "Inliner visiting SCC:");
   for (CallGraphNode *Node : SCC) {
@@ -575,6 +576,7 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
           continue;
         }
         ++NumInlined;
+        CostCache.invalidate(*Caller);
 
         if (OIC->isAlways())
           ORE.emit(OptimizationRemark(DEBUG_TYPE, "AlwaysInline", DLoc, Block)
@@ -651,9 +653,22 @@ bool LegacyInlinerBase::inlineCalls(CallGraphSCC &SCC) {
   auto GetAssumptionCache = [&](Function &F) -> AssumptionCache & {
     return ACT->getAssumptionCache(F);
   };
-  return inlineCallsImpl(SCC, CG, GetAssumptionCache, PSI, TLI, InsertLifetime,
-                         [this](CallSite CS) { return getInlineCost(CS); },
-                         LegacyAARGetter(*this), ImportedFunctionsStats);
+
+  // The functions of the SCC change as calls are inlined into them, and again
+  // in the passes that run on the SCC after this one. Don't let their costs as
+  // callees be computed from a body that has since changed.
+  auto InvalidateSCC = [&] {
+    for (CallGraphNode *Node : SCC)
+      if (Function *F = Node->getFunction())
+        CostCache.invalidate(*F);
+  };
+  InvalidateSCC();
+  bool Changed = inlineCallsImpl(
+      SCC, CG, GetAssumptionCache, PSI, TLI, InsertLifetime,
+      [this](CallSite CS) { return getInlineCost(CS); },
+      LegacyAARGetter(*this), ImportedFunctionsStats, CostCache);
+  InvalidateSCC();
+  return Changed;
 }
 
 /// Remove now-dead linkonce functions at the end of
@@ -662,6 +677,7 @@ bool LegacyInlinerBase::doFinalization(CallGraph &CG) {
   if (InlinerFunctionImportStats != InlinerFunctionImportStatsOpts::No)
     ImportedFunctionsStats.dump(InlinerFunctionImportStats ==
                                 InlinerFunctionImportStatsOpts::Verbose);
+  CostCache.clear();
   return removeDeadFunctions(CG);
 }
 
@@ -758,6 +774,14 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
   Module &M = *InitialC.begin()->getFunction().getParent();
   ProfileSummaryInfo *PSI = MAM.getCachedResult<ProfileSummaryAnalysis>(M);
 
+  // As in the legacy inliner, forget what the cost analysis learned about the
+  // functions of the SCC, both now and once done inlining into them.
+  SmallVector<Function *, 4> SCCFunctions;
+  for (auto &N : InitialC) {
+    SCCFunctions.push_back(&N.getFunction());
+    CostCache.invalidate(N.getFunction());
+  }
+
   // We use a single common worklist for calls across the entire SCC. We
   // process these in-order and append new calls introduced during inlining to
   // the end.
@@ -861,7 +885,7 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
       Function &Callee = *CS.getCalledFunction();
       auto &CalleeTTI = FAM.getResult<TargetIRAnalysis>(Callee);
       return getInlineCost(CS, Params, CalleeTTI, GetAssumptionCache, {GetBFI},
-                           PSI, &ORE);
+                           PSI, &ORE, &CostCache);
     };
 
     // Now process as many calls as we have within this caller in the sequnece.
@@ -917,6 +941,7 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
       }
       DidInline = true;
       InlinedCallees.insert(&Callee);
+      CostCache.invalidate(F);
 
       if (OIC->isAlways())
         ORE.emit(OptimizationRemark(DEBUG_TYPE, "AlwaysInline", DLoc, Block)
@@ -1024,6 +1049,13 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
     InlinedCallees.clear();
   }
 
+  // Inlining may have merged other functions into the SCC, which the passes
+  // that follow will change too.
+  for (Function *SCCF : SCCFunctions)
+    CostCache.invalidate(*SCCF);
+  for (auto &N : *C)
+    CostCache.invalidate(N.getFunction());
+
   // Now that we've finished inlining all of the calls across this SCC, delete
   // all of the trivially dead functions, updating the call graph and the CGSCC
   // pass manager in the process.
@@ -59,6 +59,10 @@ bool InstCombiner::SimplifyDemandedInstructionBits(Instruction &Inst) {
   Value *V = SimplifyDemandedUseBits(&Inst, DemandedMask, Known,
                                      0, &Inst);
   if (!V) return false;
+  // Instructions may have been changed in place, and what was known about
+  // them and their users may no longer hold.
+  if (KBCache)
+    KBCache->clear();
   if (V == &Inst) return true;
   replaceInstUsesWith(Inst, V);
   return true;
@@ -76,6 +80,9 @@ bool InstCombiner::SimplifyDemandedBits(Instruction *I, unsigned OpNo,
                                           Depth, I);
   if (!NewVal) return false;
   U = NewVal;
+  // See SimplifyDemandedInstructionBits.
+  if (KBCache)
+    KBCache->clear();
   return true;
 }
 
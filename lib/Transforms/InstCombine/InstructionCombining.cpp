@@ -91,6 +91,11 @@ static cl::opt<unsigned>
 MaxArraySize("instcombine-maxarray-size", cl::init(1024),
              cl::desc("Maximum array size considered when doing a combine"));
 
+static cl::opt<bool>
+CacheKnownBits("instcombine-cache-known-bits", cl::init(true), cl::Hidden,
+               cl::desc("Memoize known bits queries while visiting an "
+                        "instruction"));
+
 Value *InstCombiner::EmitGEPOffset(User *GEP) {
   return llvm::EmitGEPOffset(&Builder, DL, GEP);
 }
@@ -2873,6 +2878,11 @@ bool InstCombiner::run() {
     Instruction *I = Worklist.RemoveOne();
     if (I == nullptr) continue;  // skip null values.
 
+    // Earlier visits may have changed instructions in place, which the cache
+    // can't tell.
+    if (KBCache)
+      KBCache->clear();
+
     // Check to see if we can DCE the instruction.
     if (isInstructionTriviallyDead(I, &TLI)) {
       DEBUG(dbgs() << "IC: DCE: " << *I << '\n');
@@ -2950,6 +2960,9 @@ bool InstCombiner::run() {
           if (TryToSinkInstruction(I, UserParent)) {
             DEBUG(dbgs() << "IC: Sink: " << *I << '\n');
             MadeIRChange = true;
+            // I is the context of the queries made so far, and has moved.
+            if (KBCache)
+              KBCache->clear();
             // We'll add uses of the sunk instruction below, but since sinking
             // can expose opportunities for it's *operands* add them to the
             // worklist
@@ -3190,6 +3203,8 @@ static bool combineInstructionsOverFunction(
   // by instcombiner.
   bool MadeIRChange = LowerDbgDeclare(F);
 
+  KnownBitsCache KBCache;
+
   // Iterate while there is work to do.
   int Iteration = 0;
   for (;;) {
@@ -3200,7 +3215,8 @@ static bool combineInstructionsOverFunction(
     MadeIRChange |= prepareICWorklistFromFunction(F, DL, &TLI, Worklist);
 
     InstCombiner IC(Worklist, Builder, F.optForMinSize(), ExpensiveCombines, AA,
-                    AC, TLI, DT, ORE, DL, LI);
+                    AC, TLI, DT, ORE, DL, LI,
+                    CacheKnownBits ? &KBCache : nullptr);
     IC.MaxArraySizeForCombine = MaxArraySize;
 
     if (!IC.run())
@@ -36,6 +36,7 @@
 #include "llvm/Analysis/OptimizationDiagnosticInfo.h"
 #include "llvm/Analysis/PHITransAddr.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/GlobalVariable.h"
@@ -71,6 +72,10 @@ STATISTIC(NumPRELoad,   "Number of loads PRE'd");
 static cl::opt<bool> EnablePRE("enable-pre",
                                cl::init(true), cl::Hidden);
 static cl::opt<bool> EnableLoadPRE("enable-load-pre", cl::init(true));
+static cl::opt<bool> EnableMemorySSA(
+    "enable-gvn-memoryssa", cl::init(false), cl::Hidden,
+    cl::desc("Find the dependencies of loads with MemorySSA instead of "
+             "memdep"));
 
 // Maximum allowed recursion depth.
 static cl::opt<uint32_t>
@@ -364,6 +369,16 @@ uint32_t GVN::ValueTable::lookupOrAddCall(CallInst *C) {
     return e;
   } else if (AA->onlyReadsMemory(C)) {
     Expression exp = createExpr(C);
+    if (MSSA) {
+      // Calls that read the same state of memory compute the same value, so
+      // make the clobbering access of the call part of the expression.
+      if (MemoryUseOrDef *MA = MSSA->getMemoryAccess(C))
+        exp.varargs.push_back(
+            lookupOrAdd(MSSA->getWalker()->getClobberingMemoryAccess(MA)));
+      uint32_t e = assignExpNewValueNum(exp).first;
+      valueNumbering[C] = e;
+      return e;
+    }
     auto ValNum = assignExpNewValueNum(exp);
     if (ValNum.second) {
       valueNumbering[C] = ValNum.first;
@@ -605,10 +620,12 @@ PreservedAnalyses GVN::run(Function &F, FunctionAnalysisManager &AM) {
   auto &DT = AM.getResult<DominatorTreeAnalysis>(F);
   auto &TLI = AM.getResult<TargetLibraryAnalysis>(F);
   auto &AA = AM.getResult<AAManager>(F);
-  auto &MemDep = AM.getResult<MemoryDependenceAnalysis>(F);
+  auto *MemDep =
+      EnableMemorySSA ? nullptr : &AM.getResult<MemoryDependenceAnalysis>(F);
   auto *LI = AM.getCachedResult<LoopAnalysis>(F);
   auto &ORE = AM.getResult<OptimizationRemarkEmitterAnalysis>(F);
-  bool Changed = runImpl(F, AC, DT, TLI, AA, &MemDep, LI, &ORE);
+  bool Changed =
+      runImpl(F, AC, DT, TLI, AA, MemDep, EnableMemorySSA, LI, &ORE);
   if (!Changed)
     return PreservedAnalyses::all();
   PreservedAnalyses PA;
@@ -773,7 +790,10 @@ Value *AvailableValue::MaterializeAdjustedValue(LoadInst *LI,
       // tracks.  It is potentially possible to remove the load from the table,
       // but then there all of the operations based on it would need to be
       // rehashed.  Just leave the dead load around.
-      gvn.getMemDep().removeInstruction(Load);
+      // The MemorySSA mode only forwards from loads that cover the loaded
+      // value, which are never widened, and has no memdep to update.
+      if (!gvn.getMemorySSA())
+        gvn.getMemDep().removeInstruction(Load);
       DEBUG(dbgs() << "GVN COERCED NONLOCAL LOAD:\nOffset: " << Offset << "  "
                    << *getCoercedLoadValue() << '\n'
                    << *Res << '\n'
@@ -1146,6 +1166,8 @@ bool GVN::PerformLoadPRE(LoadInst *LI, AvailValInBlkVect &ValuesPerBlock,
     while (!NewInsts.empty()) {
       Instruction *I = NewInsts.pop_back_val();
       if (MD) MD->removeInstruction(I);
+      if (MSSA)
+        removeFromMemorySSA(I);
       I->eraseFromParent();
     }
     // HINT: Don't revert the edge-splitting as following transformation may
@@ -1186,6 +1208,11 @@ bool GVN::PerformLoadPRE(LoadInst *LI, AvailValInBlkVect &ValuesPerBlock,
                                  LI->getOrdering(), LI->getSyncScopeID(),
                                  UnavailablePred->getTerminator());
     NewLoad->setDebugLoc(LI->getDebugLoc());
+    if (MSSAU) {
+      auto *MU = cast<MemoryUse>(MSSAU->createMemoryAccessInBB(
+          NewLoad, nullptr, UnavailablePred, MemorySSA::End));
+      MSSAU->insertUse(MU);
+    }
 
     // Transfer the old load's AA tags to the new load.
     AAMDNodes Tags;
@@ -1209,7 +1236,8 @@ bool GVN::PerformLoadPRE(LoadInst *LI, AvailValInBlkVect &ValuesPerBlock,
     // Add the newly created load.
     ValuesPerBlock.push_back(AvailableValueInBlock::get(UnavailablePred,
                                                         NewLoad));
-    MD->invalidateCachedPointerInfo(LoadPtr);
+    if (MD)
+      MD->invalidateCachedPointerInfo(LoadPtr);
     DEBUG(dbgs() << "GVN INSERTED " << *NewLoad << '\n');
   }
 
@@ -1220,7 +1248,7 @@ bool GVN::PerformLoadPRE(LoadInst *LI, AvailValInBlkVect &ValuesPerBlock,
     V->takeName(LI);
   if (Instruction *I = dyn_cast<Instruction>(V))
     I->setDebugLoc(LI->getDebugLoc());
-  if (V->getType()->isPtrOrPtrVectorTy())
+  if (MD && V->getType()->isPtrOrPtrVectorTy())
     MD->invalidateCachedPointerInfo(V);
   markInstructionForDeletion(LI);
   ORE->emit(OptimizationRemark(DEBUG_TYPE, "LoadPRE", LI)
@@ -1238,6 +1266,182 @@ static void reportLoadElim(LoadInst *LI, Value *AvailableValue,
             << NV("InfavorOfValue", AvailableValue));
 }
 
+/// Return true if the address \p V, read by a load below \p BB, has the same
+/// value whichever edge into \p BB was taken, once the PHI nodes of \p BB are
+/// translated.  An address computed below \p BB from a value of \p BB can
+/// change from one trip around a loop through \p BB to the next, so it can't
+/// be carried into the predecessors of \p BB.
+static bool isAddressInvariantAt(Value *V, const BasicBlock *BB,
+                                 const DominatorTree &DT, bool IsRoot = true) {
+  auto *I = dyn_cast<Instruction>(V);
+  if (!I)
+    return true;
+  // PHITransAddr translates the address itself when it is defined in BB.
+  if (I->getParent() == BB)
+    return IsRoot;
+  if (DT.dominates(I->getParent(), BB))
+    return true;
+  if (!isa<GetElementPtrInst>(I) && !isa<CastInst>(I))
+    return false;
+  return all_of(I->operands(), [&](Value *Op) {
+    return isAddressInvariantAt(Op, BB, DT, /*IsRoot=*/false);
+  });
+}
+
+MemoryAccess *GVN::getClobberingAccess(MemoryAccess *Start,
+                                       const MemoryLocation &Loc) {
+  if (isa<MemoryPhi>(Start) || MSSA->isLiveOnEntryDef(Start))
+    return Start;
+
+  auto Key = std::make_pair(Start, Loc);
+  auto It = ClobberCache.find(Key);
+  if (It != ClobberCache.end())
+    return It->second;
+  MemoryAccess *Clobber =
+      MSSA->getWalker()->getClobberingMemoryAccess(Start, Loc);
+  ClobberCache[Key] = Clobber;
+  return Clobber;
+}
+
+/// Find a load of \p Address below \p Clobber that dominates \p LI, or the
+/// end of \p BB if \p BB isn't null.  Nothing that writes the location comes
+/// between the two, so they load the same value.
+LoadInst *GVN::findDominatingLoad(LoadInst *LI, Value *Address,
+                                  MemoryAccess *Clobber,
+                                  const BasicBlock *BB) {
+  MemoryUseOrDef *LIAccess = BB ? nullptr : MSSA->getMemoryAccess(LI);
+  for (User *U : Address->users()) {
+    auto *Load = dyn_cast<LoadInst>(U);
+    if (!Load || Load == LI || !Load->isUnordered())
+      continue;
+    MemoryUseOrDef *MA = MSSA->getMemoryAccess(Load);
+    if (!MA || !MSSA->dominates(Clobber, MA))
+      continue;
+    if (BB ? DT->dominates(Load->getParent(), BB)
+           : MSSA->dominates(MA, LIAccess))
+      return Load;
+  }
+  return nullptr;
+}
+
+MemDepResult GVN::getMemorySSADependency(LoadInst *LI, MemoryAccess *Clobber,
+                                         const MemoryLocation &Loc,
+                                         const BasicBlock *BB) {
+  Value *Address = const_cast<Value *>(Loc.Ptr);
+  // MemorySSA doesn't order loads, so look for an earlier load of the same
+  // address by hand.
+  if (LoadInst *Load = findDominatingLoad(LI, Address, Clobber, BB))
+    return MemDepResult::getDef(Load);
+
+  if (isa<MemoryPhi>(Clobber))
+    return MemDepResult::getNonLocal();
+
+  const DataLayout &DL = LI->getModule()->getDataLayout();
+  if (MSSA->isLiveOnEntryDef(Clobber)) {
+    // Nothing wrote the memory since it was allocated.
+    Value *Object = GetUnderlyingObject(Address, DL);
+    if (isa<AllocaInst>(Object) || isNoAliasFn(Object, TLI))
+      return MemDepResult::getDef(cast<Instruction>(Object));
+    return MemDepResult::getNonFuncLocal();
+  }
+
+  Instruction *DepInst = cast<MemoryDef>(Clobber)->getMemoryInst();
+  if (auto *SI = dyn_cast<StoreInst>(DepInst)) {
+    if (getAliasAnalysis()->alias(MemoryLocation::get(SI), Loc) == MustAlias)
+      return MemDepResult::getDef(SI);
+    return MemDepResult::getClobber(SI);
+  }
+  // Ordered loads are MemoryDefs only to keep them in order.
+  if (isa<LoadInst>(DepInst))
+    return MemDepResult::getUnknown();
+  // The walker only stops at a lifetime.start of exactly this location.
+  if (isLifetimeStart(DepInst) || (isNoAliasFn(DepInst, TLI) &&
+                                   GetUnderlyingObject(Address, DL) == DepInst))
+    return MemDepResult::getDef(DepInst);
+  return MemDepResult::getClobber(DepInst);
+}
+
+bool GVN::getNonLocalMemorySSADependencies(LoadInst *LI, MemoryPhi *Phi,
+                                           LoadDepVect &Deps) {
+  if (!isAddressInvariantAt(LI->getPointerOperand(), Phi->getBlock(), *DT))
+    return false;
+
+  const DataLayout &DL = LI->getModule()->getDataLayout();
+  MemoryLocation Loc = MemoryLocation::get(LI);
+
+  // The MemoryPhis to go through, with the address of the load in their
+  // block.  Reaching a block a second time with another address is a
+  // conflict memdep gives up on too.
+  SmallVector<std::pair<MemoryPhi *, Value *>, 8> Worklist;
+  DenseMap<MemoryPhi *, Value *> VisitedPhis;
+  DenseMap<BasicBlock *, Value *> VisitedPreds;
+  Worklist.push_back(std::make_pair(Phi, LI->getPointerOperand()));
+  VisitedPhis[Phi] = LI->getPointerOperand();
+
+  while (!Worklist.empty()) {
+    Value *Address;
+    std::tie(Phi, Address) = Worklist.pop_back_val();
+    BasicBlock *PhiBB = Phi->getBlock();
+
+    for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+      BasicBlock *Pred = Phi->getIncomingBlock(I);
+      PHITransAddr Translated(Address, DL, AC);
+      Value *PredAddress = nullptr;
+      if (!Translated.PHITranslateValue(PhiBB, Pred, DT,
+                                        /*MustDominate=*/false))
+        PredAddress = Translated.getAddr();
+
+      auto VisitedPred = VisitedPreds.insert(std::make_pair(Pred, PredAddress));
+      if (!VisitedPred.second) {
+        if (VisitedPred.first->second != PredAddress)
+          return false;
+        continue;
+      }
+      if (!PredAddress) {
+        Deps.push_back(
+            NonLocalDepResult(Pred, MemDepResult::getUnknown(), nullptr));
+        continue;
+      }
+
+      MemoryLocation PredLoc = Loc.getWithNewPtr(PredAddress);
+      MemoryAccess *Clobber =
+          getClobberingAccess(Phi->getIncomingValue(I), PredLoc);
+      MemDepResult Dep = getMemorySSADependency(LI, Clobber, PredLoc, Pred);
+      if (!Dep.isNonLocal()) {
+        Deps.push_back(NonLocalDepResult(Pred, Dep, PredAddress));
+        continue;
+      }
+
+      // The paths to Pred meet at another MemoryPhi further up.
+      auto *PredPhi = cast<MemoryPhi>(Clobber);
+      if (!isAddressInvariantAt(PredAddress, PredPhi->getBlock(), *DT)) {
+        Deps.push_back(
+            NonLocalDepResult(Pred, MemDepResult::getUnknown(), PredAddress));
+        continue;
+      }
+      auto VisitedPhi =
+          VisitedPhis.insert(std::make_pair(PredPhi, PredAddress));
+      if (VisitedPhi.second)
+        Worklist.push_back(std::make_pair(PredPhi, PredAddress));
+      else if (VisitedPhi.first->second != PredAddress)
+        return false;
+    }
+  }
+  return true;
+}
+
+void GVN::removeFromMemorySSA(Instruction *I) {
+  // Removing a MemoryDef frees an access that the cache may hold as a key or
+  // a clobber, and a new pointer may take the place of I in its locations.
+  bool InvalidatesCache = I->getType()->isPtrOrPtrVectorTy();
+  if (MemoryUseOrDef *MA = MSSA->getMemoryAccess(I)) {
+    InvalidatesCache |= isa<MemoryDef>(MA);
+    MSSAU->removeMemoryAccess(MA);
+  }
+  if (InvalidatesCache)
+    ClobberCache.clear();
+}
+
 /// Attempt to eliminate a load whose dependencies are
 /// non-local by performing PHI construction.
 bool GVN::processNonLocalLoad(LoadInst *LI) {
@@ -1247,14 +1451,24 @@ bool GVN::processNonLocalLoad(LoadInst *LI) {
 
   // Step 1: Find the non-local dependencies of the load.
   LoadDepVect Deps;
-  MD->getNonLocalPointerDependency(LI, Deps);
+  if (MSSA) {
+    // MemorySSA hands out the dependencies without scanning blocks, so there
+    // is no need to give up on loads with many of them.
+    MemoryAccess *Clobber =
+        MSSA->getWalker()->getClobberingMemoryAccess(LI);
+    if (!getNonLocalMemorySSADependencies(LI, cast<MemoryPhi>(Clobber),
+                                          Deps))
+      return false;
+  } else {
+    MD->getNonLocalPointerDependency(LI, Deps);
 
-  // If we had to process more than one hundred blocks to find the
-  // dependencies, this load isn't worth worrying about.  Optimizing
-  // it will be too expensive.
+    // If we had to process more than one hundred blocks to find the
+    // dependencies, this load isn't worth worrying about.  Optimizing
+    // it will be too expensive.
+    if (Deps.size() > 100)
+      return false;
+  }
   unsigned NumDeps = Deps.size();
-  if (NumDeps > 100)
-    return false;
 
   // If we had a phi translation failure, we'll have a single entry which is a
   // clobber in the current block.  Reject this early.
@@ -1307,7 +1521,7 @@ bool GVN::processNonLocalLoad(LoadInst *LI) {
       // to propagate LI's DebugLoc because LI may not post-dominate I.
       if (LI->getDebugLoc() && LI->getParent() == I->getParent())
         I->setDebugLoc(LI->getDebugLoc());
-    if (V->getType()->isPtrOrPtrVectorTy())
+    if (MD && V->getType()->isPtrOrPtrVectorTy())
       MD->invalidateCachedPointerInfo(V);
     markInstructionForDeletion(LI);
     ++NumGVNLoad;
@@ -1332,7 +1546,8 @@ bool GVN::processAssumeIntrinsic(IntrinsicInst *IntrinsicI) {
       Type *Int8Ty = Type::getInt8Ty(V->getContext());
       // Insert a new store to null instruction before the load to indicate that
       // this code is not reachable.  FIXME: We could insert unreachable
-      // instruction directly because we can modify the CFG.
+      // instruction directly because we can modify the CFG.  MemorySSA isn't
+      // told about the store, as nothing after it is reached anyway.
       new StoreInst(UndefValue::get(Int8Ty),
                     Constant::getNullValue(Int8Ty->getPointerTo()),
                     IntrinsicI);
@@ -1419,7 +1634,7 @@ static void patchAndReplaceAllUsesWith(Instruction *I, Value *Repl) {
 /// Attempt to eliminate a load, first by eliminating it
 /// locally, and then attempting non-local elimination if that fails.
 bool GVN::processLoad(LoadInst *L) {
-  if (!MD)
+  if (!MD && !MSSA)
     return false;
 
   // This code hasn't been audited for ordered or volatile memory access
@@ -1432,7 +1647,16 @@ bool GVN::processLoad(LoadInst *L) {
   }
 
   // ... to a pointer that has been loaded from before...
-  MemDepResult Dep = MD->getDependency(L);
+  MemDepResult Dep;
+  if (MSSA) {
+    MemoryUseOrDef *MA = MSSA->getMemoryAccess(L);
+    if (!MA)
+      return false;
+    MemoryAccess *Clobber = MSSA->getWalker()->getClobberingMemoryAccess(MA);
+    Dep = getMemorySSADependency(L, Clobber, MemoryLocation::get(L), nullptr);
+  } else {
+    Dep = MD->getDependency(L);
+  }
 
   // If it is defined in another block, try harder.
   if (Dep.isNonLocal())
@@ -1945,8 +2169,8 @@ bool GVN::processInstruction(Instruction *I) {
 /// runOnFunction - This is the main transformation entry point for a function.
 bool GVN::runImpl(Function &F, AssumptionCache &RunAC, DominatorTree &RunDT,
                   const TargetLibraryInfo &RunTLI, AAResults &RunAA,
-                  MemoryDependenceResults *RunMD, LoopInfo *LI,
-                  OptimizationRemarkEmitter *RunORE) {
+                  MemoryDependenceResults *RunMD, bool UseMemorySSA,
+                  LoopInfo *LI, OptimizationRemarkEmitter *RunORE) {
   AC = &RunAC;
   DT = &RunDT;
   VN.setDomTree(DT);
@@ -1971,6 +2195,14 @@ bool GVN::runImpl(Function &F, AssumptionCache &RunAC, DominatorTree &RunDT,
     Changed |= removedBlock;
   }
 
+  // Build MemorySSA once the blocks are merged, as it doesn't know how to
+  // follow that.
+  if (UseMemorySSA) {
+    MSSA = make_unique<MemorySSA>(F, &RunAA, DT);
+    MSSAU = make_unique<MemorySSAUpdater>(MSSA.get());
+  }
+  VN.setMemorySSA(MSSA.get());
+
   unsigned Iteration = 0;
   while (ShouldContinue) {
     DEBUG(dbgs() << "GVN iteration: " << Iteration << "\n");
@@ -2000,6 +2232,10 @@ bool GVN::runImpl(Function &F, AssumptionCache &RunAC, DominatorTree &RunDT,
   // Do not cleanup DeadBlocks in cleanupGlobalSets() as it's called for each
   // iteration.
   DeadBlocks.clear();
+  ClobberCache.clear();
+  VN.setMemorySSA(nullptr);
+  MSSAU.reset();
+  MSSA.reset();
 
   return Changed;
 }
@@ -2039,6 +2275,8 @@ bool GVN::processBlock(BasicBlock *BB) {
          E = InstrsToErase.end(); I != E; ++I) {
       DEBUG(dbgs() << "GVN removed: " << **I << '\n');
       if (MD) MD->removeInstruction(*I);
+      if (MSSA)
+        removeFromMemorySSA(*I);
       DEBUG(verifyRemoved(*I));
       (*I)->eraseFromParent();
     }
@@ -2235,6 +2473,8 @@ bool GVN::performScalarPRE(Instruction *CurInst) {
   DEBUG(dbgs() << "GVN PRE removed: " << *CurInst << '\n');
   if (MD)
     MD->removeInstruction(CurInst);
+  if (MSSA)
+    removeFromMemorySSA(CurInst);
   DEBUG(verifyRemoved(CurInst));
   CurInst->eraseFromParent();
   ++NumGVNInstr;
@@ -2269,6 +2509,18 @@ bool GVN::performPRE(Function &F) {
   return Changed;
 }
 
+/// The block \p NewBB was inserted on the edge from \p Pred to \p Succ, so
+/// make the MemoryPhi of \p Succ take the edge from \p NewBB instead, as
+/// SplitCriticalEdge does for the PHI nodes.
+static void updateMemoryPhiForSplitEdge(MemorySSA &MSSA, BasicBlock *Pred,
+                                        BasicBlock *Succ, BasicBlock *NewBB) {
+  if (MemoryPhi *Phi = MSSA.getMemoryAccess(Succ)) {
+    int Idx = Phi->getBasicBlockIndex(Pred);
+    assert(Idx != -1 && "Split edge isn't an incoming edge of the MemoryPhi");
+    Phi->setIncomingBlock(Idx, NewBB);
+  }
+}
+
 /// Split the critical edge connecting the given two blocks, and return
 /// the block inserted to the critical edge.
 BasicBlock *GVN::splitCriticalEdges(BasicBlock *Pred, BasicBlock *Succ) {
@@ -2276,6 +2528,8 @@ BasicBlock *GVN::splitCriticalEdges(BasicBlock *Pred, BasicBlock *Succ) {
       SplitCriticalEdge(Pred, Succ, CriticalEdgeSplittingOptions(DT));
   if (MD)
     MD->invalidateCachedPredecessors();
+  if (MSSA && BB)
+    updateMemoryPhiForSplitEdge(*MSSA, Pred, Succ, BB);
   return BB;
 }
 
@@ -2286,8 +2540,12 @@ bool GVN::splitCriticalEdges() {
     return false;
   do {
     std::pair<TerminatorInst*, unsigned> Edge = toSplit.pop_back_val();
-    SplitCriticalEdge(Edge.first, Edge.second,
-                      CriticalEdgeSplittingOptions(DT));
+    BasicBlock *Pred = Edge.first->getParent();
+    BasicBlock *Succ = Edge.first->getSuccessor(Edge.second);
+    BasicBlock *BB = SplitCriticalEdge(Edge.first, Edge.second,
+                                       CriticalEdgeSplittingOptions(DT));
+    if (MSSA && BB)
+      updateMemoryPhiForSplitEdge(*MSSA, Pred, Succ, BB);
   } while (!toSplit.empty());
   if (MD) MD->invalidateCachedPredecessors();
   return true;
@@ -2477,9 +2735,10 @@ public:
         getAnalysis<DominatorTreeWrapperPass>().getDomTree(),
         getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(),
         getAnalysis<AAResultsWrapperPass>().getAAResults(),
-        NoLoads ? nullptr
-                : &getAnalysis<MemoryDependenceWrapperPass>().getMemDep(),
-        LIWP ? &LIWP->getLoopInfo() : nullptr,
+        NoLoads || EnableMemorySSA
+            ? nullptr
+            : &getAnalysis<MemoryDependenceWrapperPass>().getMemDep(),
+        !NoLoads && EnableMemorySSA, LIWP ? &LIWP->getLoopInfo() : nullptr,
         &getAnalysis<OptimizationRemarkEmitterWrapperPass>().getORE());
   }
 
@@ -2487,7 +2746,7 @@ public:
     AU.addRequired<AssumptionCacheTracker>();
     AU.addRequired<DominatorTreeWrapperPass>();
     AU.addRequired<TargetLibraryInfoWrapperPass>();
-    if (!NoLoads)
+    if (!NoLoads && !EnableMemorySSA)
       AU.addRequired<MemoryDependenceWrapperPass>();
     AU.addRequired<AAResultsWrapperPass>();
 
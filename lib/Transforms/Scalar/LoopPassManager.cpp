@@ -34,7 +34,11 @@ PassManager<Loop, LoopAnalysisManager, LoopStandardAnalysisResults &,
     if (DebugLogging)
       dbgs() << "Running pass: " << Pass->name() << " on " << L;
 
-    PreservedAnalyses PassPA = Pass->run(L, AM, AR, U);
+    PreservedAnalyses PassPA = PreservedAnalyses::none();
+    {
+      AllocationRegion PassMemory(getPassMemoryRecord(Pass->name()));
+      PassPA = Pass->run(L, AM, AR, U);
+    }
 
     // If the loop was deleted, abort the run and return to the outer walk.
     if (U.skipCurrentLoop()) {
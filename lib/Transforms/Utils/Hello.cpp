@@ -5,7 +5,13 @@
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/Module.h"
 
+#include "llvm/Analysis/BitVectorDataflow.h"
+#include "llvm/Analysis/BlockReachability.h"
+#include "llvm/Analysis/ControlDependenceGraph.h"
 #include "llvm/Analysis/LoopInfoImpl.h"
+#include "llvm/Analysis/LoopNestingForest.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/SourceLineIndex.h"
 
 #include "llvm/IR/Dominators.h"
 #include "llvm/Analysis/PostDominators.h"
@@ -17,7 +23,25 @@
 #include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/IR/DebugLoc.h>
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/raw_sha1_ostream.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/PassSupport.h"
+#include "llvm/Transforms/Utils/Hello.h"
+#include <algorithm>
+#include <ctime>
+#include <thread>
 
 //This file should be included after including the above headers only 
 
@@ -28,612 +52,1090 @@
 using namespace llvm;
 #include "HelloHelper.h"
 
+#define DEBUG_TYPE "hello"
+
+STATISTIC(NumCacheHits, "Number of function reports read from -hello-cache-dir");
+STATISTIC(NumCacheMisses, "Number of function reports written to -hello-cache-dir");
+
+static cl::opt<bool> HelloParallel(
+    "hello-parallel", cl::init(false), cl::Hidden,
+    cl::desc("Compute the per-function reports of the new pass manager hello pass in parallel"));
+
+static cl::opt<unsigned> HelloThreads(
+    "hello-threads", cl::init(0), cl::Hidden,
+    cl::desc("Number of threads used by -hello-parallel (0 = one per hardware thread)"));
+
+//Sections of the report file besides the module summary, which is always written
+enum HelloReportSection
+{
+    HRS_Functions,
+    HRS_MultiEntryCycles,
+    HRS_UnsoundUses,
+    HRS_ControlDependence,
+    HRS_Reachability,
+    HRS_LineNumbers
+};
+
+static cl::opt<std::string> HelloReportFile(
+    "hello-report-file", cl::Hidden, cl::value_desc("filename"),
+    cl::desc("Write a YAML report of the hello pass to this file instead of printing to errs()"));
+
+static cl::bits<HelloReportSection> HelloReportSections(
+    "hello-report-sections", cl::Hidden, cl::CommaSeparated,
+    cl::desc("Sections of -hello-report-file to write in addition to the summary"),
+    cl::values(
+        clEnumValN(HRS_Functions, "functions", "Counters of every defined function"),
+        clEnumValN(HRS_MultiEntryCycles, "multi-entry-cycles", "Entry blocks of every cycle with more than one"),
+        clEnumValN(HRS_UnsoundUses, "unsound-uses", "Loads of possibly uninitialized allocas"),
+        clEnumValN(HRS_ControlDependence, "control-dependence", "Controlling blocks of every block"),
+        clEnumValN(HRS_Reachability, "reachability", "Blocks reachable from every block"),
+        clEnumValN(HRS_LineNumbers, "line-numbers", "Source lines, one entry per run of instructions from the same line")));
+
+static cl::opt<std::string> HelloTimingFile(
+    "hello-timing-file", cl::Hidden, cl::value_desc("filename"),
+    cl::desc("Time every analysis of the hello pass per function and write the timings to this CSV file"));
+
+static cl::opt<std::string> HelloCacheDir(
+    "hello-cache-dir", cl::Hidden, cl::value_desc("directory"),
+    cl::desc("Cache the per-function results of the hello pass in this directory, keyed by the function's IR"));
+
+static cl::opt<std::string> HelloCachePolicy(
+    "hello-cache-policy", cl::Hidden, cl::value_desc("policy"),
+    cl::desc("Pruning policy of -hello-cache-dir, in the format of the ThinLTO cache policy"));
+
 
 namespace
 {
-    struct Hello : public ModulePass
+    //The analyses the hello reports are computed from. The line index covers the whole
+    //module and is built once, before any function is analyzed. BR and CDG are only
+    //computed, and only set, when the report options need them (see needsSection)
+    struct HelloFunctionAnalyses
     {
-        static char ID;
-        Hello() : ModulePass(ID)
+        DominatorTree &DT;
+        LoopInfo &LI;
+        BlockReachability *BR;
+        ControlDependenceGraph *CDG;
+        LoopNestingForest &LNF;
+        const SourceLineIndex &Lines;
+    };
+
+    //What analyzeFunction records besides the counters: either the text logs printed
+    //to errs(), or the HelloReportSection bits selected for the report file,
+    //and whether every phase is timed for the timing file.
+    //parallel is set by the caller when functions are analyzed on several threads
+    struct HelloReportOptions
+    {
+        bool textLogs;
+        unsigned int sections;
+        bool timing;
+        bool parallel;
+    };
+
+    bool hasSection(const HelloReportOptions &options, HelloReportSection section)
+    {
+        return options.sections & (1u << section);
+    }
+
+    //Whether the phase behind section runs at all. The module summary only needs the
+    //loop, cycle and unsound use counters; the text logs and the timing file cover
+    //every phase, the report file only the selected sections
+    bool needsSection(const HelloReportOptions &options, HelloReportSection section)
+    {
+        return options.textLogs || options.timing || hasSection(options, section);
+    }
+
+    HelloReportOptions getReportOptions()
+    {
+        bool timing = !HelloTimingFile.empty();
+        if (HelloReportFile.empty())
+            return { true, 0, timing, false };
+        return { false, HelloReportSections.getBits(), timing, false };
+    }
+
+    //line is 0 when the load has no debug location
+    struct HelloUnsoundUse
+    {
+        StringRef var;
+        unsigned int line;
+    };
+
+    struct HelloBlockList
+    {
+        StringRef block;
+        std::vector<StringRef> blocks;
+    };
+
+    //A run of consecutive instructions of one block from the same source line
+    struct HelloLineEntry
+    {
+        unsigned int line;
+        unsigned int instructions;
+    };
+
+    //One row of the timing file. count is what the phase found: loops, cycles,
+    //strongly connected components, located instructions, controlled blocks or unsound uses
+    struct HelloPhaseTiming
+    {
+        const char *phase;
+        TimeRecord time;
+        double cpuSeconds;
+        unsigned int count;
+    };
+
+    //CPU time of the calling thread. The user time of a TimeRecord is the whole
+    //process's, which also counts the other threads of -hello-parallel
+    double getThreadCPUSeconds()
+    {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+        timespec now;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0)
+            return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+        return TimeRecord::getCurrentTime(false).getProcessTime();
+    }
+
+    //Runs phase, which returns its count, and records its time when timing is on
+    template<typename PhaseT>
+    void timePhase(std::vector<HelloPhaseTiming> &timings, const HelloReportOptions &options,
+                   const char *name, PhaseT phase)
+    {
+        if (!options.timing)
         {
-            initializeHelloPass(*PassRegistry::getPassRegistry());
+            phase();
+            return;
         }
-
-        virtual void getAnalysisUsage(AnalysisUsage &AU) const override
+        TimeRecord start = TimeRecord::getCurrentTime(true);
+        double cpuStart = getThreadCPUSeconds();
+        unsigned int count = phase();
+        double cpuSeconds = getThreadCPUSeconds() - cpuStart;
+        TimeRecord time = TimeRecord::getCurrentTime(false);
+        time -= start;
+        timings.push_back({ name, time, cpuSeconds, count });
+    }
+
+    //Everything the hello pass reports about one function.
+    //Every function writes into its own buffers and only reads the IR, so functions can be
+    //analyzed independently (and in parallel); printHelloReport merges them in module order
+    struct HelloFunctionReport
+    {
+        StringRef name;
+        unsigned int blockCount = 0;
+        unsigned int loopCount = 0;
+        unsigned int outerLoopCountUsingLoopInfo = 0;
+        unsigned int totalLoopCountUsingLoopInfo = 0;
+        unsigned int loopExitingEdges = 0;
+        unsigned int multipleEntryLoops = 0;
+        unsigned int irreducibleCycles = 0;
+        unsigned int unsoundVarUses = 0;
+        std::string multipleEntryLoopsLog;
+        std::string reachabilityLog;
+        std::string lineNumbersLog;
+        std::string controlDependenceLog;
+        std::string unsoundVarUsesLog;
+        //only filled for the sections selected for the report file
+        std::vector<HelloBlockList> multiEntryCycles;
+        std::vector<HelloUnsoundUse> unsoundUses;
+        std::vector<HelloBlockList> controlDependences;
+        std::vector<HelloBlockList> reachability;
+        std::vector<HelloLineEntry> lineNumbers;
+        //only filled when timing, in the order the phases ran
+        std::vector<HelloPhaseTiming> timings;
+        //holds the strings the StringRefs above point to when the report was read from the cache
+        std::unique_ptr<MemoryBuffer> cacheEntry;
+
+        bool hasFindings() const
         {
-            AU.addRequired<DominatorTreeWrapperPass>();
-            AU.addRequired<PostDominatorTreeWrapperPass>();
-            AU.addRequired<LoopInfoWrapperPass>();
+            return !multiEntryCycles.empty() || !unsoundUses.empty() || !controlDependences.empty() ||
+                !reachability.empty() || !lineNumbers.empty();
         }
+    };
+
+    //Module totals plus the functions listed in the report file
+    struct HelloModuleReport
+    {
+        StringRef module;
+        unsigned int functionCount = 0;
+        unsigned int averageBBs = 0;
+        unsigned int averageCFGEdges = 0;
+        unsigned int loopCount = 0;
+        unsigned int outerLoopCount = 0;
+        unsigned int loopExitingEdges = 0;
+        unsigned int multipleEntryLoops = 0;
+        unsigned int irreducibleCycles = 0;
+        unsigned int unsoundVarUses = 0;
+        std::vector<HelloFunctionReport> functions;
+    };
+}
 
+LLVM_YAML_IS_SEQUENCE_VECTOR(HelloUnsoundUse)
+LLVM_YAML_IS_SEQUENCE_VECTOR(HelloBlockList)
+LLVM_YAML_IS_SEQUENCE_VECTOR(HelloLineEntry)
+LLVM_YAML_IS_SEQUENCE_VECTOR(HelloFunctionReport)
 
-        //I have not used LoopInfo here. Hence I am able to calculate the inner loops as well
-        //LoopInfo.begin() does not calculate inner loops. 
-        //LoopInfo.begin/end is just iterates over top level loops / outer loops
-        unsigned int findNumberOfLoopsInModule(const Module &M)
+namespace llvm
+{
+namespace yaml
+{
+    template <> struct MappingTraits<HelloUnsoundUse>
+    {
+        static void mapping(IO &io, HelloUnsoundUse &use)
         {
-            unsigned int loopCount = 0;
-            for (auto F = M.begin(); F != M.end(); F++)
-            {
-                //Placing this check here because my original .c file compiled from clang 
-                //was using a system call - printf
-                //and llvm passes do not run on functions which are not defined within the module? 
-                //hence analysis information of DominatorTree pass was unavailable when I try to access it here
-                //without this check it will crash for inputs which use printf
-                if (F->isDeclaration())
-                    continue;
-                DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>(*const_cast<Function*>(&*F)).getDomTree();
-                for (auto BB = F->begin(); BB != F->end(); BB++)
-                {
-                    for (auto BBSucc = succ_begin(&*BB); BBSucc != succ_end(&*BB); BBSucc++)
-                    {
-                        if (DT.dominates(*BBSucc, &*BB))
-                        { //found a loop
-                            loopCount++;
-                        }
-                    }
-                }
-            }
-            return loopCount;
+            io.mapRequired("Var", use.var);
+            io.mapOptional("Line", use.line, 0u);
         }
 
-        //LoopInfo.begin() does not calculate inner loops. 
-        //LoopInfo.begin/end is just iterates over top level loops / outer loops
-        //Hence, this returns only number of outer loops - verified this!
-        unsigned int findLoopCountUsingLoopInfo(const Module &M)
+        static const bool flow = true;
+    };
+
+    template <> struct MappingTraits<HelloBlockList>
+    {
+        static void mapping(IO &io, HelloBlockList &list)
         {
-            unsigned int loopCount = 0;
-            for (auto F = M.begin(); F != M.end(); F++)
-            {
-                //Placing this check here because my original .c file compiled from clang 
-                //was using a system call - printf
-                //and llvm passes do not run on functions which are not defined within the module? 
-                //hence analysis information of LoopInfoWrapperPass was unavailable when I try to access it here
-                //without this check it will crash for inputs which use printf
-                if (F->isDeclaration())
-                    continue;
-                LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>(*const_cast<Function*>(&*F)).getLoopInfo();
-                for (auto loop = LI.begin(); loop != LI.end(); loop++)
-                {
-                    loopCount++;
-                }
-            }
-            return loopCount;
+            io.mapRequired("Block", list.block);
+            io.mapRequired("Blocks", list.blocks);
         }
+    };
 
+    template <> struct MappingTraits<HelloLineEntry>
+    {
+        static void mapping(IO &io, HelloLineEntry &entry)
+        {
+            io.mapRequired("Line", entry.line);
+            io.mapRequired("Instructions", entry.instructions);
+        }
 
+        static const bool flow = true;
+    };
 
-        //For this function F, for every outer loop, call getAllDepthSubLoopCount
-        unsigned int findTotalLoopCountForFunctionUsingLoopInfo(const Function &F)
+    template <> struct MappingTraits<HelloFunctionReport>
+    {
+        static void mapping(IO &io, HelloFunctionReport &report)
         {
-            unsigned int loopCount = 0;
-            LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>(*const_cast<Function*>(&F)).getLoopInfo();
-            for (auto loop = LI.begin(); loop != LI.end(); loop++)
-            {
-                loopCount++;
-                loopCount += getAllDepthSubLoopCount(*loop);
-            }
-            return loopCount;
+            io.mapRequired("Name", report.name);
+            io.mapRequired("Loops", report.loopCount);
+            io.mapRequired("OuterLoops", report.outerLoopCountUsingLoopInfo);
+            io.mapRequired("ExitingEdges", report.loopExitingEdges);
+            io.mapRequired("MultipleEntryLoops", report.multipleEntryLoops);
+            io.mapRequired("IrreducibleCycles", report.irreducibleCycles);
+            io.mapRequired("UnsoundVarUses", report.unsoundVarUses);
+            io.mapOptional("MultiEntryCycles", report.multiEntryCycles);
+            io.mapOptional("UnsoundUses", report.unsoundUses);
+            io.mapOptional("ControlDependences", report.controlDependences);
+            io.mapOptional("Reachability", report.reachability);
+            io.mapOptional("LineNumbers", report.lineNumbers);
         }
+    };
 
-        unsigned int findTotalLoopCountUsingLoopInfo(const Module &M)
+    template <> struct MappingTraits<HelloModuleReport>
+    {
+        static void mapping(IO &io, HelloModuleReport &report)
         {
-            unsigned int loopCount = 0;
-            for (auto F = M.begin(); F != M.end(); F++)
-            {
-                //Placing this check here because my original .c file compiled from clang 
-                //was using a system call - printf
-                //and llvm passes do not run on functions which are not defined within the module? 
-                //hence analysis information of LoopInfoWrapperPass was unavailable when I try to access it here
-                //without this check it will crash for inputs which use printf
-                if (F->isDeclaration())
-                    continue;
-                loopCount += findTotalLoopCountForFunctionUsingLoopInfo(*F);
-            }
-            return loopCount;
+            io.mapRequired("Module", report.module);
+            io.mapRequired("Functions", report.functionCount);
+            io.mapRequired("AverageBBs", report.averageBBs);
+            io.mapRequired("AverageCFGEdges", report.averageCFGEdges);
+            io.mapRequired("Loops", report.loopCount);
+            io.mapRequired("OuterLoops", report.outerLoopCount);
+            io.mapRequired("ExitingEdges", report.loopExitingEdges);
+            io.mapRequired("MultipleEntryLoops", report.multipleEntryLoops);
+            io.mapRequired("IrreducibleCycles", report.irreducibleCycles);
+            io.mapRequired("UnsoundVarUses", report.unsoundVarUses);
+            io.mapOptional("FunctionReports", report.functions);
         }
+    };
+}
+}
+
+namespace
+{
 
-        //find total number of loop exiting edges/blocks in the module
-        //is number of exiting edges == number of exiting blocks??
-        //Can a block that is exiting have 2 exiting edges??
-        unsigned int findTotalLoopExitingEdges(const Module &M)
+    //I have not used LoopInfo here. Hence I am able to calculate the inner loops as well
+    //LoopInfo.begin() does not calculate inner loops. 
+    //LoopInfo.begin/end is just iterates over top level loops / outer loops
+    unsigned int findNumberOfLoops(const Function &F, const DominatorTree &DT)
+    {
+        unsigned int loopCount = 0;
+        for (auto BB = F.begin(); BB != F.end(); BB++)
         {
-            unsigned int numExitEdgesInModule = 0;
-            for (auto F = M.begin(); F != M.end(); F++)
+            for (auto BBSucc = succ_begin(&*BB); BBSucc != succ_end(&*BB); BBSucc++)
             {
-                if (F->isDeclaration())
-                    continue;
-                LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>(*const_cast<Function*>(&*F)).getLoopInfo();
-                for (auto Loop = LI.begin(); Loop != LI.end(); Loop++)
-                {
-                    //call function
-                    //subloops calls the same function recursive from within the function
-                    numExitEdgesInModule += getNumExitingEdgesFromLoop(*Loop);
+                if (DT.dominates(*BBSucc, &*BB))
+                { //found a loop
+                    loopCount++;
                 }
             }
-            return numExitEdgesInModule;
         }
+        return loopCount;
+    }
 
+    //LoopInfo.begin() does not calculate inner loops. 
+    //LoopInfo.begin/end is just iterates over top level loops / outer loops
+    //Hence, this returns only number of outer loops - verified this!
+    unsigned int findLoopCountUsingLoopInfo(const LoopInfo &LI)
+    {
+        unsigned int loopCount = 0;
+        for (auto loop = LI.begin(); loop != LI.end(); loop++)
+        {
+            loopCount++;
+        }
+        return loopCount;
+    }
 
-        unsigned int MrCompilerMultipleEntryLoops(Module &M)
+    //For every outer loop, call getAllDepthSubLoopCount
+    unsigned int findTotalLoopCountUsingLoopInfo(const LoopInfo &LI)
+    {
+        unsigned int loopCount = 0;
+        for (auto loop = LI.begin(); loop != LI.end(); loop++)
         {
-            unsigned int multipleEntryLoops = 0;
-            visited.clear();
-            for (Module::iterator F = M.begin(); F != M.end(); F++)// : M.getFunctionList())
-            {
-                for (Function::iterator BB1 = F->begin(); BB1 != F->end(); BB1++)
-                {
-                    Function::iterator BB2 = BB1;
-                    //errs() << BB1.getName() << "\n";
-                    for (;BB2 != F->end(); BB2++)
-                    {
-                        visited.clear();
-
-                        if (isreachable(&*BB1, &*BB2))
-                        {
-                            llvm::StringRef name1 = BB1->getName();
-                            llvm::StringRef name2 = BB2->getName();
-                            errs() << name2 << "is reachable from " << name1 << "\n";
-                            for (auto succ = succ_begin(&*BB2); succ != succ_end(&*BB2); succ++)
-                            {
-                                errs() << "		Success of " << name2 << " is " << succ->getName() << "\n";
-                                if (*succ == &*BB1)
-                                {
-                                    multipleEntryLoops++;
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            return multipleEntryLoops;
+            loopCount++;
+            loopCount += getAllDepthSubLoopCount(*loop);
+        }
+        return loopCount;
+    }
+
+    //find total number of loop exiting edges/blocks in the function
+    //is number of exiting edges == number of exiting blocks??
+    //Can a block that is exiting have 2 exiting edges??
+    unsigned int findLoopExitingEdges(const LoopInfo &LI)
+    {
+        unsigned int numExitEdges = 0;
+        for (auto Loop = LI.begin(); Loop != LI.end(); Loop++)
+        {
+            //call function
+            //subloops calls the same function recursive from within the function
+            numExitEdges += getNumExitingEdgesFromLoop(*Loop);
         }
+        return numExitEdges;
+    }
 
 
-        void printControlDependenceMap(std::map< BasicBlock*, std::set<BasicBlock*> > &controlDependenceMap)
+    //Cycles come from the LoopNestingForest of the function, which also finds the
+    //irreducible ones that LoopInfo misses, together with the blocks they are entered through
+    void printMultipleEntryCycles(const LoopNestingForest &LNF, raw_ostream &OS)
+    {
+        LNF.forEachCycle([&](const NestedCycle &C)
         {
-            for (auto it = controlDependenceMap.begin(); it != controlDependenceMap.end(); it++)
+            if (!C.isMultiEntry())
+                return;
+            OS << "Cycle at " << C.getHeader()->getName() << " is entered through ";
+            for (BasicBlock* entry : C.getEntries())
             {
-                errs() << "\n" << it->first->getName() << "is control dependent on ";
-                for (auto BBList : it->second)
-                {
-                    errs() << BBList->getName() << " , ";
-                }
+                OS << entry->getName() << " , ";
             }
-        }
+            OS << "\n";
+        });
+    }
 
-        void dumpControlDependence(Module &M)
+
+    //Control dependences come from the ControlDependenceGraph of the function,
+    //which is built once from the post-dominator tree instead of testing every block pair
+    void dumpControlDependence(const Function &F, const ControlDependenceGraph &CDG, raw_ostream &OS)
+    {
+        for (const BasicBlock &BB : F)
         {
-            std::map< BasicBlock*, std::set<BasicBlock*> > controlDependenceMap;
-            for (Module::iterator F = M.begin(); F != M.end(); F++)
+            ArrayRef<BasicBlock*> controllers = CDG.getControllingBlocks(&BB);
+            if (controllers.empty())
+                continue;
+            OS << "\n" << BB.getName() << "is control dependent on ";
+            for (BasicBlock* controller : controllers)
             {
-                for (Function::iterator BB1 = F->begin(); BB1 != F->end(); BB1++)
-                {
-                    for (Function::iterator BB2 = BB1; BB2 != F->end(); BB2++)
-                    {
-                        visited.clear();
-
-                        if (isreachable(&*BB1, &*BB2))
-                        {
-                            errs() << "BB1: " << BB1->getName() << " BB2: " << BB2->getName() << "\n";
-
-                            PostDominatorTree &PDT = getAnalysis<PostDominatorTreeWrapperPass>(*F).getPostDomTree();
-                            DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>(*F).getDomTree();
-                            //errs() << BB1->getName() << " has " << BB1->getTerminator()->getNumSuccessors() << "\n";
-                            if (PDT.dominates(&*BB2, &*BB1)) continue;
-                            //bool isControlDependent = false;
-                            /*for (auto succ = succ_begin(&*BB1); succ != succ_end(&*BB1); succ++)
-                            {
-                            if (*succ == &*BB2) continue;
-                            bool postDominatesSucc = PDT.dominates(&*BB2, *succ);
-                            if (isControlDependent == true)
-                            {
-                            if (postDominatesSucc)
-                            {
-                            assert("This should never happen. A block BB2 can not post dominate both succ of BB1?");
-                            }
-                            }
-                            if (postDominatesSucc)
-                            {
-                            controlDependenceMap[&*BB2].insert(&*BB1);
-                            isControlDependent = true;
-                            }
-                            }*/
-                            if (DT.dominates(&*BB1, &*BB2))
-                            {
-                                if (!PDT.dominates(&*BB2, &*BB1))
-                                {
-                                    controlDependenceMap[&*BB2].insert(&*BB1);
-                                }
-                            }
-
-                        }
-                    }
-                }
+                OS << controller->getName() << " , ";
             }
-            printControlDependenceMap(controlDependenceMap);
         }
+    }
 
 
-        void checkFastReachabilityUsingLLVM(Module &M)
+    //One entry per run of instructions from the same line instead of one per instruction;
+    //the runs come from the module's line index, so F is not walked again
+    void printLineNumbers(const Function &F, const SourceLineIndex &Lines, raw_ostream &OS)
+    {
+        for (const SourceLineIndex::LineRange &range : Lines.ranges(F))
         {
-
+            OS << "\n" << Lines.getFiles()[range.File] << " : " << range.Line << " : " << range.NumInstructions
+               << (range.NumInstructions == 1 ? " instruction in " : " instructions in ")
+               << range.First->getParent()->getName();
         }
+    }
 
-        void printLineNumbers(Module &M)
+
+    unsigned int getLineNumber(const Instruction &I)
+    {
+        return SourceLineIndex::getLine(I);
+    }
+
+    //To find out unsound vars, we establish which allocas are definitely stored to
+    //before every block. This is a forward must-problem: a var is initialized on entry
+    //to a block only if it is initialized at the end of every predecessor.
+    //Loops need no special casing: the back edge can only add vars that already hold
+    //on entry to the header, so it never removes the defs coming from the pre-header.
+    //The fixed point is reached per function by the BitVectorDataflow solver, with
+    //one bit per alloca of the function (see SoundVarProblem in HelloHelper.h).
+    //Collects the loads of vars that are not initialized yet, in program order,
+    //and the blocks every var is loaded in
+    void findUnsoundVarUses(Function &F, const SoundVarProblem &problem, const BitVectorDataflow &soundVars,
+                            std::vector<LoadInst*> &unsound, std::map<Value*, std::set<BasicBlock*> > &used)
+    {
+        //replay every block from its IN set so that a load is checked against
+        //the stores that precede it, not against the whole block
+        BitVector initialized;
+        for (BasicBlock &BB : F)
         {
-            for (Module::iterator F = M.begin(); F != M.end(); F++)
+            initialized = soundVars.getIn(&BB);
+            for (Instruction &I : BB)
             {
-                for (Function::iterator BB = F->begin(); BB != F->end(); BB++)
+                if (StoreInst *SI = dyn_cast<StoreInst>(&I))
+                {
+                    int var = problem.getVarNumber(SI->getPointerOperand());
+                    if (var >= 0)
+                        initialized.set(var);
+                }
+                else if (LoadInst *LI = dyn_cast<LoadInst>(&I))
                 {
-                    for (BasicBlock::iterator inst = BB->begin(); inst != BB->end(); inst++)
-                    {
-                        if (DILocation* debugLoc = inst->getDebugLoc())
-                        {
-                            unsigned int lineNo = debugLoc->getLine();
-                            inst->dump();
-                            errs() << " : " << lineNo;
-                        }
-                    }
+                    int var = problem.getVarNumber(LI->getPointerOperand());
+                    if (var < 0)
+                        continue;
+                    used[LI->getPointerOperand()].insert(&BB);
+                    if (!initialized.test(var))
+                        unsound.push_back(LI);
                 }
             }
-
         }
+    }
 
+    void printUnsoundVarUses(Function &F, const SoundVarProblem &problem, const BitVectorDataflow &soundVars,
+                             ArrayRef<LoadInst*> unsound, const std::map<Value*, std::set<BasicBlock*> > &used,
+                             raw_ostream &OS)
+    {
+        printINSet(F, problem, soundVars, OS);
+        printOUTSet(F, problem, soundVars, OS);
 
-        bool isALoopHeader(BasicBlock* BB)
+        for (LoadInst *LI : unsound)
         {
-
+            OS << "Unsound var " << LI->getPointerOperand()->getName() << "used in line ";
+            if (DILocation* debugLoc = LI->getDebugLoc())
+                OS << " : " << debugLoc->getLine();
         }
 
-        //need to be careful for loops here because header will have tail also as a predecessor 
-        //but still any variable def coming from preheader is valid 
-        //since the entry point of the loop will have to go through the pre-headers
-        //multi-entry loops don't exist in code? -- Assumption
-        std::set<Value*> intersectionOfPredOutSets(BasicBlock* BB, std::map< BasicBlock*, std::set<Value*> > soundVar_Out)
+        printVarUses(used, OS);
+    }
+
+
+    //Structured counterparts of the text logs above, for the report file
+
+    void collectMultipleEntryCycles(const LoopNestingForest &LNF, std::vector<HelloBlockList> &multiEntryCycles)
+    {
+        LNF.forEachCycle([&](const NestedCycle &C)
         {
-            bool possibleHeader = false;
-            if (!BB->getSinglePredecessor())
-            {
-                possibleHeader = true;
-            }
+            if (!C.isMultiEntry())
+                return;
+            multiEntryCycles.push_back({ C.getHeader()->getName(), {} });
+            for (BasicBlock* entry : C.getEntries())
+                multiEntryCycles.back().blocks.push_back(entry->getName());
+        });
+    }
+
+    void collectControlDependences(const Function &F, const ControlDependenceGraph &CDG,
+                                   std::vector<HelloBlockList> &controlDependences)
+    {
+        for (const BasicBlock &BB : F)
+        {
+            ArrayRef<BasicBlock*> controllers = CDG.getControllingBlocks(&BB);
+            if (controllers.empty())
+                continue;
+            controlDependences.push_back({ BB.getName(), {} });
+            for (BasicBlock* controller : controllers)
+                controlDependences.back().blocks.push_back(controller->getName());
+        }
+    }
 
-            std::map<Value*, unsigned int> varCount;
-            std::set<Value*> returnSet;
-            unsigned int numValidPreds = 0;
+    void collectReachability(const Function &F, const BlockReachability &BR,
+                             std::vector<HelloBlockList> &reachability)
+    {
+        for (const BasicBlock &BB1 : F)
+        {
+            HelloBlockList reachable = { BB1.getName(), {} };
+            for (const BasicBlock &BB2 : F)
+                if (BR.isReachable(&BB1, &BB2))
+                    reachable.blocks.push_back(BB2.getName());
+            if (!reachable.blocks.empty())
+                reachability.push_back(std::move(reachable));
+        }
+    }
 
+    void collectLineNumbers(const Function &F, const SourceLineIndex &Lines,
+                            std::vector<HelloLineEntry> &lineNumbers)
+    {
+        for (const SourceLineIndex::LineRange &range : Lines.ranges(F))
+            lineNumbers.push_back({ range.Line, range.NumInstructions });
+    }
 
 
-            for (auto predIt = pred_begin(BB); predIt != pred_end(BB); predIt++)
+    //Runs every per-function analysis of the hello pass on F.
+    //Only reads the IR and writes nothing but the returned report.
+    HelloFunctionReport analyzeFunction(Function &F, const HelloFunctionAnalyses &A,
+                                        const HelloReportOptions &options)
+    {
+        HelloFunctionReport report;
+        report.name = F.getName();
+        report.blockCount = F.size();
+        timePhase(report.timings, options, "loops", [&]
+        {
+            report.loopCount = findNumberOfLoops(F, A.DT);
+            report.outerLoopCountUsingLoopInfo = findLoopCountUsingLoopInfo(A.LI);
+            report.totalLoopCountUsingLoopInfo = findTotalLoopCountUsingLoopInfo(A.LI);
+            report.loopExitingEdges = findLoopExitingEdges(A.LI);
+            return report.loopCount;
+        });
+        timePhase(report.timings, options, "multi-entry-cycles", [&]
+        {
+            report.multipleEntryLoops = A.LNF.getNumMultiEntryCycles();
+            report.irreducibleCycles = A.LNF.getNumIrreducibleCycles();
+            if (options.textLogs)
+            {
+                raw_string_ostream OS(report.multipleEntryLoopsLog);
+                //finding multi entry loops using the loop nesting forest
+                printMultipleEntryCycles(A.LNF, OS);
+            }
+            if (hasSection(options, HRS_MultiEntryCycles))
+                collectMultipleEntryCycles(A.LNF, report.multiEntryCycles);
+            return report.multipleEntryLoops;
+        });
+        if (needsSection(options, HRS_Reachability))
+            timePhase(report.timings, options, "reachability", [&]
             {
-                BasicBlock* predBB = *predIt;
-                if (possibleHeader)
+                if (options.textLogs)
                 {
-                    //This is not good; everytime I need to find whether block A is reachable from Block B
-                    //I have to remember to clear the visited (global) vector
-                    //As I was forgetting to do this, it was a bug for 4-5 days which wasted my time
-                    //I will fix the reachable to be independent of global vector, perhaps make it an arg?
-                    visited.clear();
-                    if (isreachable(BB, predBB))
-                    {
-                        //predBB->BB was a backedge and BB is a header
-                        //defs inside the loop should not matter because first use inside header will be unsound
-                        //consider only the other predecessor(pre-header)
-                        continue;
-                    }
+                    raw_string_ostream OS(report.reachabilityLog);
+                    checkReachability(F, *A.BR, OS);
                 }
-
-                numValidPreds++;
-                for (auto var : soundVar_Out[predBB])
+                if (hasSection(options, HRS_Reachability))
+                    collectReachability(F, *A.BR, report.reachability);
+                return A.BR->getNumSCCs();
+            });
+        if (needsSection(options, HRS_LineNumbers))
+            timePhase(report.timings, options, "line-numbers", [&]
+            {
+                if (options.textLogs)
                 {
-                    varCount[var]++;
+                    raw_string_ostream OS(report.lineNumbersLog);
+                    printLineNumbers(F, A.Lines, OS);
                 }
-            }
-            for (auto it : varCount)
+                if (hasSection(options, HRS_LineNumbers))
+                    collectLineNumbers(F, A.Lines, report.lineNumbers);
+                unsigned int located = 0;
+                for (const SourceLineIndex::LineRange &range : A.Lines.ranges(F))
+                    located += range.NumInstructions;
+                return located;
+            });
+        if (needsSection(options, HRS_ControlDependence))
+            timePhase(report.timings, options, "control-dependence", [&]
             {
-                if (it.second == numValidPreds)
-                    returnSet.insert(it.first);
+                if (options.textLogs)
+                {
+                    raw_string_ostream OS(report.controlDependenceLog);
+                    //check control flow dependence between blocks
+                    dumpControlDependence(F, *A.CDG, OS);
+                }
+                if (hasSection(options, HRS_ControlDependence))
+                    collectControlDependences(F, *A.CDG, report.controlDependences);
+                unsigned int controlled = 0;
+                for (const BasicBlock &BB : F)
+                    controlled += !A.CDG->getControllingBlocks(&BB).empty();
+                return controlled;
+            });
+
+        //issue warning for uninitialized variables that get used. 
+        timePhase(report.timings, options, "unsound-uses", [&]
+        {
+            SoundVarProblem problem(F);
+            if (problem.getNumBits() == 0)
+                return 0u;
+            BitVectorDataflow soundVars;
+            soundVars.solve(F, problem);
+            std::vector<LoadInst*> unsound;
+            std::map < Value*, std::set<BasicBlock*> > used;
+            findUnsoundVarUses(F, problem, soundVars, unsound, used);
+            report.unsoundVarUses = unsound.size();
+            if (options.textLogs)
+            {
+                raw_string_ostream OS(report.unsoundVarUsesLog);
+                printUnsoundVarUses(F, problem, soundVars, unsound, used, OS);
             }
-            return returnSet;
+            if (hasSection(options, HRS_UnsoundUses))
+                for (LoadInst *LI : unsound)
+                    report.unsoundUses.push_back({ LI->getPointerOperand()->getName(), getLineNumber(*LI) });
+            return report.unsoundVarUses;
+        });
+        return report;
+    }
+
+    //Builds the analyses of F itself instead of asking a pass manager for them, which
+    //is safe on any thread and lets the timing file include their construction
+    HelloFunctionReport analyzeFunctionStandalone(Function &F, const SourceLineIndex &Lines,
+                                                  const HelloReportOptions &options)
+    {
+        std::vector<HelloPhaseTiming> timings;
+        DominatorTree DT;
+        PostDominatorTree PDT;
+        LoopInfo LI;
+        BlockReachability BR;
+        ControlDependenceGraph CDG;
+        LoopNestingForest LNF;
+        timePhase(timings, options, "domtree", [&] { DT.recalculate(F); return 0u; });
+        bool reachability = needsSection(options, HRS_Reachability);
+        bool controlDependence = needsSection(options, HRS_ControlDependence);
+        if (controlDependence)
+            timePhase(timings, options, "postdomtree", [&] { PDT.recalculate(F); return 0u; });
+        timePhase(timings, options, "loopinfo", [&]
+        {
+            LI.analyze(DT);
+            return (unsigned int)(LI.end() - LI.begin());
+        });
+        if (reachability)
+            timePhase(timings, options, "block-reachability", [&]
+            {
+                BR.recalculate(F);
+                return BR.getNumSCCs();
+            });
+        if (controlDependence)
+            timePhase(timings, options, "control-dependence-graph", [&] { CDG.recalculate(F, PDT); return 0u; });
+        timePhase(timings, options, "loop-nesting-forest", [&]
+        {
+            LNF.recalculate(F);
+            return LNF.getNumCycles();
+        });
+        HelloFunctionReport report = analyzeFunction(F, { DT, LI, reachability ? &BR : nullptr,
+                                                          controlDependence ? &CDG : nullptr, LNF, Lines },
+                                                     options);
+        report.timings.insert(report.timings.begin(), timings.begin(), timings.end());
+        return report;
+    }
+
+    //Prints the reports of the defined functions of M, given in module order
+    void printHelloReport(const Module &M, ArrayRef<HelloFunctionReport> reports, raw_ostream &OS)
+    {
+        //Verifiying Basic passes
+        unsigned int avgBBsInFuncs = findAverageNumBBsInFuncs(M);
+        unsigned int avgCFGEdgesInFuncs = findAverageCFGEdgesInFuncs(M);
+        unsigned int totalLoopCount = 0;
+        unsigned int outerLoopCountUsingLoopInfo = 0;
+        unsigned int totalLoopCountUsingLoopInfo = 0;
+        unsigned int totalLoopExitingEdges = 0;
+        unsigned int multipleEntryLoops = 0;
+        unsigned int irreducibleCycles = 0;
+        for (const HelloFunctionReport &report : reports)
+        {
+            totalLoopCount += report.loopCount;
+            outerLoopCountUsingLoopInfo += report.outerLoopCountUsingLoopInfo;
+            totalLoopCountUsingLoopInfo += report.totalLoopCountUsingLoopInfo;
+            totalLoopExitingEdges += report.loopExitingEdges;
+            multipleEntryLoops += report.multipleEntryLoops;
+            irreducibleCycles += report.irreducibleCycles;
+        }
+        //LoopInfo only sees natural loops, and a header with several latches has several
+        //dominating back edges, so the loop counts only agree on the outer loops
+        assert(totalLoopCount >= outerLoopCountUsingLoopInfo && "Num outer loops from LoopInfo cannot be greater than total Loops");
+        assert(totalLoopCountUsingLoopInfo >= outerLoopCountUsingLoopInfo && "LoopInfo's outer loops are part of its total");
+
+        for (const HelloFunctionReport &report : reports)
+            OS << report.multipleEntryLoopsLog;
+        //first test reachability prints
+        for (const HelloFunctionReport &report : reports)
+            OS << report.reachabilityLog;
+        for (const HelloFunctionReport &report : reports)
+            OS << report.lineNumbersLog;
+        for (const HelloFunctionReport &report : reports)
+            OS << report.controlDependenceLog;
+
+        OS << "\nAverage Num BBs" << avgBBsInFuncs;
+        OS << "\nAverage CFG edges" << avgCFGEdgesInFuncs;
+        //OS << "\nTotal number of loops " << totalLoopCount;
+        OS << "\n Total number of exiting edges " << totalLoopExitingEdges;
+        OS << "\n Total number of multiple entry cycles " << multipleEntryLoops;
+        OS << "\n Total number of irreducible cycles " << irreducibleCycles;
+        OS << "\n";
+        for (const HelloFunctionReport &report : reports)
+            OS << report.unsoundVarUsesLog;
+    }
+
+    //Writes the module totals and, for the selected sections, the functions with findings
+    //as one YAML document. Nothing is written per function that has nothing to report
+    //unless the functions section is selected, so the output grows with the findings
+    void writeHelloReport(const Module &M, std::vector<HelloFunctionReport> &reports,
+                          const HelloReportOptions &options, StringRef filename)
+    {
+        std::error_code EC;
+        raw_fd_ostream OS(filename, EC, sys::fs::F_Text);
+        if (EC)
+        {
+            M.getContext().emitError("could not open hello report file '" + filename + "': " + EC.message());
+            return;
         }
 
-        void addInSetToOutSet(std::set<Value*> soundVar_In_Of_BB, std::set<Value*> &soundVar_Out_Of_BB)
+        HelloModuleReport summary;
+        summary.module = M.getModuleIdentifier();
+        summary.functionCount = reports.size();
+        summary.averageBBs = findAverageNumBBsInFuncs(M);
+        summary.averageCFGEdges = findAverageCFGEdgesInFuncs(M);
+        for (HelloFunctionReport &report : reports)
         {
-            for (auto i : soundVar_In_Of_BB)
-            {
-                soundVar_Out_Of_BB.insert(i);
-            }
+            summary.loopCount += report.loopCount;
+            summary.outerLoopCount += report.outerLoopCountUsingLoopInfo;
+            summary.loopExitingEdges += report.loopExitingEdges;
+            summary.multipleEntryLoops += report.multipleEntryLoops;
+            summary.irreducibleCycles += report.irreducibleCycles;
+            summary.unsoundVarUses += report.unsoundVarUses;
+            if (hasSection(options, HRS_Functions) || report.hasFindings())
+                summary.functions.push_back(std::move(report));
         }
 
+        yaml::Output YOut(OS);
+        YOut << summary;
+    }
 
-        //To find out unsound vars, we establish reaching definitions first
-        //To get reaching definitions in cases of loops in the input program, 
-        //I need to identify the final OUT sets of every block
-        //To get the final OUT sets, I need to iteratively populate the OUT sets of blocks until 
-        //the OUT sets stop changing. Why?
-        //Because the back edge will add  its OUT sets into the header's IN set again 
-        //which will consequently change the header's successors (which may be both inside
-        // and outside of the loop)
-        //To know whether the OUT sets got fixed, we need to keep a prevOUT sets of all blocks and newOUT sets of all blocks
-        //And compare even if one of the block's OUT set has changed
-        void printUnsoundVarUses(Module &M)
+    //One row per function and phase; mem_bytes is the change in malloc'ed memory.
+    //malloc only counts for the whole process, so mem_bytes is left empty when the
+    //functions were analyzed in parallel
+    void writeHelloTimings(const Module &M, ArrayRef<HelloFunctionReport> reports,
+                           const HelloReportOptions &options, StringRef filename)
+    {
+        std::error_code EC;
+        raw_fd_ostream OS(filename, EC, sys::fs::F_Text);
+        if (EC)
         {
-            std::map<BasicBlock*, std::set<Value*> > soundVar_In;
-            std::map<BasicBlock*, std::set<Value*> > soundVar_Out;
-            std::map<BasicBlock*, std::set<Value*> > soundVar_Def; //needed?
-            std::map<BasicBlock*, std::set<Value*> > soundVar_Declared; //needed?
-            std::map < Value*, std::set<BasicBlock*> > used;
-            std::map<BasicBlock*, std::set<Value*> > prev_Out;
-            bool changed = true;
-            while (changed)
+            M.getContext().emitError("could not open hello timing file '" + filename + "': " + EC.message());
+            return;
+        }
+        OS << "function,blocks,phase,wall_seconds,cpu_seconds,mem_bytes,count\n";
+        for (const HelloFunctionReport &report : reports)
+            for (const HelloPhaseTiming &timing : report.timings)
             {
-                changed = false;
-                prev_Out = soundVar_Out;
-                soundVar_Out.clear();
-                //first parse to store the def and use information of every var and block
-                for (Module::iterator F = M.begin(); F != M.end(); F++)
-                {
-                    if (F->isDeclaration()) continue;
-
-                    for (Function::iterator BB = F->begin(); BB != F->end(); BB++)
-                    {
-                        soundVar_In[&*BB] = intersectionOfPredOutSets(&*BB, soundVar_Out);
-                        //soundVar_Out[&*BB] = soundVar_In[&*BB]; //this is wrong, need to add both
-                        addInSetToOutSet(soundVar_In[&*BB], soundVar_Out[&*BB]);
-                        for (BasicBlock::iterator inst = BB->begin(); inst != BB->end(); inst++)
-                        {
-                            if (LoadInst *LI = dyn_cast<LoadInst>(&*inst))
-                            {//variable used
-                                Value* var = LI->getPointerOperand();
-                                Value* newVar = LI;
-                                used[var].insert(&*BB);
-                                soundVar_Out[&*BB].insert(newVar);
-                            }
-                            else if (StoreInst *SI = dyn_cast<StoreInst>(&*inst))
-                            {
-                                soundVar_Out[&*BB].insert(SI->getPointerOperand());
-                                soundVar_Def[&*BB].insert(SI->getPointerOperand());
-                            }
-                            else if (AllocaInst *AI = dyn_cast<AllocaInst>(&*inst))
-                            {
-                                soundVar_Declared[&*BB].insert(AI); //AI inst pointer itself is the var's Value*
-                            }
-                        }
-
-                        if (soundVar_Out[&*BB] != prev_Out[&*BB])
-                            changed = true;
-                    }
-                }
-
-                //second step is to identify the reaching definitions and populate the INsets
-                //must use dominance information?
-                // In set of Block will be intersection of Out sets of predecessors
-                /*for (Module::iterator F = M.begin(); F != M.end(); F++)
-                {
-                for (Function::iterator BB = F->begin(); BB != F->end(); BB++)
-                {
-                soundVar_In[&*BB] = intersectionOfPredOutSets(&*BB, soundVar_Out);
-                }
-                }*/
-                printINSet(soundVar_In);
-                printOUTSet(soundVar_Out);
+                OS << report.name << ',' << report.blockCount << ',' << timing.phase << ','
+                   << format("%.9f", timing.time.getWallTime()) << ','
+                   << format("%.9f", timing.cpuSeconds) << ',';
+                if (!options.parallel)
+                    OS << (int64_t)timing.time.getMemUsed();
+                OS << ',' << timing.count << '\n';
             }
+    }
 
-            printVarUses(used);
-
-            printINSet(soundVar_In);
-            printOUTSet(soundVar_Out);
-
-
-            for (Module::iterator F = M.begin(); F != M.end(); F++)
+    //Prints the text report to errs(), or writes the report file when one is requested
+    void emitHelloReport(const Module &M, std::vector<HelloFunctionReport> &reports,
+                         const HelloReportOptions &options)
+    {
+        if (options.timing)
+            writeHelloTimings(M, reports, options, HelloTimingFile);
+        if (options.textLogs)
+            printHelloReport(M, reports, errs());
+        else
+            writeHelloReport(M, reports, options, HelloReportFile);
+    }
+
+    //The report of a function is a pure function of its IR, its debug locations and the
+    //report options, so it is cached under a hash of those. The entries are named so that
+    //pruneCache manages the directory like the ThinLTO cache (see -hello-cache-policy)
+    const char HelloCacheMagic[] = "hello-cache-2\n";
+
+    unsigned int HelloFunctionReport::*const HelloCachedCounters[] = {
+        &HelloFunctionReport::blockCount,
+        &HelloFunctionReport::loopCount,
+        &HelloFunctionReport::outerLoopCountUsingLoopInfo,
+        &HelloFunctionReport::totalLoopCountUsingLoopInfo,
+        &HelloFunctionReport::loopExitingEdges,
+        &HelloFunctionReport::multipleEntryLoops,
+        &HelloFunctionReport::irreducibleCycles,
+        &HelloFunctionReport::unsoundVarUses };
+
+    std::string HelloFunctionReport::*const HelloCachedLogs[] = {
+        &HelloFunctionReport::multipleEntryLoopsLog,
+        &HelloFunctionReport::reachabilityLog,
+        &HelloFunctionReport::lineNumbersLog,
+        &HelloFunctionReport::controlDependenceLog,
+        &HelloFunctionReport::unsoundVarUsesLog };
+
+    std::string getReportCacheEntryPath(const Function &F, const HelloReportOptions &options)
+    {
+        raw_sha1_ostream OS;
+        OS << HelloCacheMagic << options.textLogs << ',' << options.sections << '\n';
+        F.print(OS);
+        //F.print only refers to the debug locations by metadata number
+        for (const BasicBlock &BB : F)
+            for (const Instruction &I : BB)
+                if (DILocation* debugLoc = I.getDebugLoc())
+                    OS << debugLoc->getFilename() << ':' << debugLoc->getLine() << ':'
+                       << debugLoc->getColumn() << '\n';
+
+        SmallString<128> path(HelloCacheDir);
+        sys::path::append(path, "llvmcache-hello-" + toHex(OS.sha1()));
+        return path.str();
+    }
+
+    void writeReportCacheEntry(StringRef path, const HelloFunctionReport &report)
+    {
+        std::string data;
+        raw_string_ostream OS(data);
+        support::endian::Writer<support::little> W(OS);
+        auto writeString = [&](StringRef S)
+        {
+            W.write<uint32_t>(S.size());
+            OS << S;
+        };
+        auto writeBlockLists = [&](ArrayRef<HelloBlockList> lists)
+        {
+            W.write<uint32_t>(lists.size());
+            for (const HelloBlockList &list : lists)
             {
-                for (Function::iterator BB = F->begin(); BB != F->end(); BB++)
-                {
-                    for (BasicBlock::iterator inst = BB->begin(); inst != BB->end(); inst++)
-                    {
-                        if (LoadInst *LI = dyn_cast<LoadInst>(&*inst))
-                        {
-                            if (soundVar_Out[&*BB].find(LI->getPointerOperand()) == soundVar_Out[&*BB].end())
-                            {
-
-                                errs() << "Unsound var " << LI->getPointerOperand()->getName() << "used in line ";
-                                if (DILocation* debugLoc = LI->getDebugLoc())
-                                {
-                                    unsigned int lineNo = debugLoc->getLine();
-                                    //inst->dump();
-                                    errs() << " : " << lineNo;
-                                }
-                            }
-                        }
-                    }
-                }
+                writeString(list.block);
+                W.write<uint32_t>(list.blocks.size());
+                for (StringRef block : list.blocks)
+                    writeString(block);
             }
-
+        };
+
+        OS << HelloCacheMagic;
+        for (auto counter : HelloCachedCounters)
+            W.write<uint32_t>(report.*counter);
+        for (auto log : HelloCachedLogs)
+            writeString(report.*log);
+        writeBlockLists(report.multiEntryCycles);
+        W.write<uint32_t>(report.unsoundUses.size());
+        for (const HelloUnsoundUse &use : report.unsoundUses)
+        {
+            writeString(use.var);
+            W.write<uint32_t>(use.line);
+        }
+        writeBlockLists(report.controlDependences);
+        writeBlockLists(report.reachability);
+        W.write<uint32_t>(report.lineNumbers.size());
+        for (const HelloLineEntry &entry : report.lineNumbers)
+        {
+            W.write<uint32_t>(entry.line);
+            W.write<uint32_t>(entry.instructions);
         }
+        OS.flush();
 
+        //write to a temporary file first, so that no one reads a partial entry
+        int FD;
+        SmallString<128> tempPath;
+        if (sys::fs::createUniqueFile(path + ".%%%%%%.tmp", FD, tempPath))
+            return;
+        {
+            raw_fd_ostream tempOS(FD, /*shouldClose=*/true);
+            tempOS << data;
+        }
+        if (sys::fs::rename(tempPath, path))
+            sys::fs::remove(tempPath);
+    }
 
-        
-        ////This is an implementation of the constant propagation pass. 
-        ////It identifies new constant variables generated as a result of previous iteration and 
-        //// propagates them in the current iteration
-        ////It keeps doing that until we can not propagata any more constants
-                
-        ////    Tested with this input:
-        ////              int main() {
-        ////                  int c;
-        ////                  c = 5;
-
-        ////                  int a, b, sum;
-        ////                  a = c;
-        ////                  b = a;
-        ////                  sum = a + b;
-        ////                  return 0;
-        ////              }
-
-
-        ////    Obtained output IR:
-        ////        define i32 @main() #0 {
-        ////            % 1 = alloca i32, align 4
-        ////            % c = alloca i32, align 4
-        ////            % a = alloca i32, align 4
-        ////            % b = alloca i32, align 4
-        ////            % sum = alloca i32, align 4
-        ////            % 2 = load i32, i32 5, align 4
-        ////            % 3 = load i32, i32 5, align 4
-        ////            % 4 = add nsw i32 % 2, % 3
-        ////            store i32 % 4, i32* %sum, align 4
-        ////            ret i32 0
-        ////}
-        
-        void propagateConstIteratively(Module &M)
-        {
-            std::map<llvm::Instruction*, llvm::ConstantInt*> constants;
-            std::set<Instruction*> toBeDeleted;
-
-            bool changed = true;
-
-            while (changed)
+    //Returns false, leaving report alone, if there is no valid entry at path
+    bool readReportCacheEntry(StringRef path, HelloFunctionReport &report)
+    {
+        ErrorOr<std::unique_ptr<MemoryBuffer>> bufferOrErr = MemoryBuffer::getFile(path);
+        if (!bufferOrErr)
+            return false;
+        StringRef data = (*bufferOrErr)->getBuffer();
+        if (!data.startswith(HelloCacheMagic))
+            return false;
+        data = data.drop_front(sizeof(HelloCacheMagic) - 1);
+
+        bool failed = false;
+        auto readInt = [&]() -> uint32_t
+        {
+            if (data.size() < sizeof(uint32_t))
             {
-                for (auto &F : M)
-                {
-                    llvm::StringRef n = "main";
-                    if (F.getName() != n) continue;
-                    for (auto &B : F)
-                    {
-                        for (auto &I : B)
-                        {
-                            if (StoreInst *SI = dyn_cast<StoreInst>(&I))
-                            {
-                                if (llvm::ConstantInt *CI = dyn_cast<llvm::ConstantInt>(SI->getValueOperand()))
-                                {
-                                    constants.insert(std::make_pair(dyn_cast<Instruction>(SI->getPointerOperand()), CI));
-                                }
-                            }
-                            if (LoadInst *LI = dyn_cast<LoadInst>(&I))
-                            {
-                                if (llvm::ConstantInt *CI = dyn_cast<llvm::ConstantInt>(LI->getPointerOperand()))
-                                {
-                                    constants.insert(std::make_pair(dyn_cast<Instruction>(LI), CI));
-                                }
-                            }
-
-                        }
-                    }
-                }
+                failed = true;
+                return 0;
+            }
+            uint32_t value = support::endian::read32le(data.data());
+            data = data.drop_front(sizeof(uint32_t));
+            return value;
+        };
+        auto readString = [&]() -> StringRef
+        {
+            uint32_t size = readInt();
+            if (data.size() < size)
+            {
+                failed = true;
+                return StringRef();
+            }
+            StringRef value = data.take_front(size);
+            data = data.drop_front(size);
+            return value;
+        };
+        auto readBlockLists = [&](std::vector<HelloBlockList> &lists)
+        {
+            for (uint32_t i = 0, e = readInt(); i != e && !failed; i++)
+            {
+                lists.push_back({ readString(), {} });
+                for (uint32_t j = 0, f = readInt(); j != f && !failed; j++)
+                    lists.back().blocks.push_back(readString());
+            }
+        };
+
+        HelloFunctionReport cached;
+        for (auto counter : HelloCachedCounters)
+            cached.*counter = readInt();
+        for (auto log : HelloCachedLogs)
+            cached.*log = readString();
+        readBlockLists(cached.multiEntryCycles);
+        for (uint32_t i = 0, e = readInt(); i != e && !failed; i++)
+        {
+            StringRef var = readString();
+            cached.unsoundUses.push_back({ var, readInt() });
+        }
+        readBlockLists(cached.controlDependences);
+        readBlockLists(cached.reachability);
+        for (uint32_t i = 0, e = readInt(); i != e && !failed; i++)
+        {
+            unsigned int line = readInt();
+            cached.lineNumbers.push_back({ line, readInt() });
+        }
+        if (failed || !data.empty())
+            return false;
+
+        cached.cacheEntry = std::move(*bufferOrErr);
+        report = std::move(cached);
+        return true;
+    }
+
+    //Looks F up in the cache of -hello-cache-dir, and runs analyze and caches its
+    //result on a miss. Timing runs always analyze, since they measure the analyses
+    template<typename AnalyzeT>
+    HelloFunctionReport analyzeFunctionCached(Function &F, const HelloReportOptions &options, AnalyzeT analyze)
+    {
+        if (HelloCacheDir.empty() || options.timing)
+            return analyze();
+        std::string path = getReportCacheEntryPath(F, options);
+        HelloFunctionReport report;
+        if (readReportCacheEntry(path, report))
+        {
+            ++NumCacheHits;
+            report.name = F.getName();
+            return report;
+        }
+        ++NumCacheMisses;
+        report = analyze();
+        writeReportCacheEntry(path, report);
+        return report;
+    }
+
+    //Creates the cache directory before a run
+    void prepareReportCache(const Module &M)
+    {
+        if (HelloCacheDir.empty())
+            return;
+        if (std::error_code EC = sys::fs::create_directories(HelloCacheDir))
+            M.getContext().emitError("could not create hello cache directory '" + HelloCacheDir + "': " + EC.message());
+    }
+
+    //Prunes the cache directory after a run
+    void pruneReportCache(const Module &M)
+    {
+        if (HelloCacheDir.empty())
+            return;
+        Expected<CachePruningPolicy> policy = parseCachePruningPolicy(HelloCachePolicy);
+        if (!policy)
+        {
+            M.getContext().emitError("invalid -hello-cache-policy: " + toString(policy.takeError()));
+            return;
+        }
+        pruneCache(HelloCacheDir, *policy);
+    }
 
-                bool foundCont = false;
+    //Adding and removing named metadata
+    void testMetaData(Module &M)
+    {
+        AddTestingMetaData(M);
+        M.dump();
+        RemoveTestingMetaData(M);
+        M.dump();
+    }
 
-                for (auto &F : M)
-                {
-                    llvm::StringRef n = "main";
-                    if (F.getName() != n) continue;
-                    for (auto &B : F)
-                    {
-
-                        for (auto &I : B)
-                        {
-                            if (LoadInst *LI = dyn_cast<LoadInst>(&I))
-                            {
-                                llvm::Value* loadFrom = LI->getPointerOperand();
-                                if (llvm::ConstantInt *CI = dyn_cast<llvm::ConstantInt>(loadFrom))
-                                {
-                                    toBeDeleted.insert(LI);
-                                }
-                                if (constants.find(dyn_cast<Instruction>(loadFrom)) != constants.end())
-                                {//found the use of a constant
-                                    LI->setOperand(0, constants[static_cast<Instruction*>(loadFrom)]);
-
-                                    foundCont = true;
-                                }
-                            }
-                            if (StoreInst *SI = dyn_cast<StoreInst>(&I))
-                            {
-                                llvm::Value* storeWhat = SI->getValueOperand();
-                                if (llvm::ConstantInt *CI = dyn_cast<llvm::ConstantInt>(storeWhat))
-                                {
-                                    toBeDeleted.insert(SI);
-                                }
-                                else
-                                {
-                                    if (constants.find(dyn_cast<Instruction>(storeWhat)) != constants.end())
-                                    {
-                                        SI->setOperand(0, constants[static_cast<Instruction*>(storeWhat)]);
-
-                                        foundCont = true;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-               
-                for (auto itr : toBeDeleted)
-                {
-                    if(itr->use_empty())
-                        itr->eraseFromParent();
-                }
 
+    ////This is an implementation of the constant propagation pass.
+    ////It forwards constants stored into allocas to the loads that read them,
+    ////folds the instructions that become constant as a result and repeats
+    ////until we can not propagate any more constants.
+    ////MemorySSA tells which store a load sees, so only the users of values that
+    ////just became constant are revisited (see propagateConstantsThroughAllocas)
 
-                if (foundCont)
-                    changed = true;
-                else
-                    changed = false;
+    ////    Tested with this input:
+    ////              int main() {
+    ////                  int c;
+    ////                  c = 5;
 
-                constants.clear();
-                toBeDeleted.clear();
-            }
+    ////                  int a, b, sum;
+    ////                  a = c;
+    ////                  b = a;
+    ////                  sum = a + b;
+    ////                  return 0;
+    ////              }
 
 
+    ////    Obtained output IR:
+    ////        define i32 @main() #0 {
+    ////            ret i32 0
+    ////}
 
-        }
 
-        bool Hello::runOnModule(Module &M)
+    struct Hello : public ModulePass
+    {
+        static char ID;
+        Hello() : ModulePass(ID)
         {
-            errs() << "Hello: ";
-            //errs().write_escaped();
-            //Adding and removing named metadata
-            AddTestingMetaData(M);
-            M.dump();
-            RemoveTestingMetaData(M);
-            M.dump();
-
-            //Verifiying Basic passes
-            unsigned int avgBBsInFuncs = findAverageNumBBsInFuncs(M);
-            unsigned int avgCFGEdgesInFuncs = findAverageCFGEdgesInFuncs(M);
-            unsigned int totalLoopCount = findNumberOfLoopsInModule(M);
-            unsigned int outerLoopCountUsingLoopInfo = findLoopCountUsingLoopInfo(M);
-            unsigned int totalLoopCountUsingLoopInfo = findTotalLoopCountUsingLoopInfo(M);
-            unsigned int totalLoopExitingEdges = findTotalLoopExitingEdges(M);
-            //finding multi entry loops using reachability
-            unsigned int multipleEntryLoops = MrCompilerMultipleEntryLoops(M);
-            assert(totalLoopCount == totalLoopCountUsingLoopInfo && "Total loops from both methods should be same");
-            assert(totalLoopCount >= outerLoopCountUsingLoopInfo && "Num outer loops from LoopInfo cannot be greater than total Loops");
-            assert(multipleEntryLoops >= totalLoopCountUsingLoopInfo && "MrCompiler's loop count can not be less");
-
-            //first test reachability prints
-            checkReachability(M);//tested
-
-            checkFastReachabilityUsingLLVM(M);
+            initializeHelloPass(*PassRegistry::getPassRegistry());
+        }
 
-            //do const propagation pass here
+        //A module pass gets function analyses by running every function analysis it
+        //requires on the function again, for each getAnalysis call. So the reports are
+        //built from analyses computed by analyzeFunctionStandalone, and the only function
+        //analysis requested is the MemorySSA of the constant propagation
+        virtual void getAnalysisUsage(AnalysisUsage &AU) const override
+        {
+            AU.addRequired<MemorySSAWrapperPass>();
+            AU.addRequired<SourceLineIndexWrapperPass>();
+        }
 
-            //issue warning for uninitialized variables that get used. 
-            //find how to check line number of the use
-            printLineNumbers(M);
-            //check control flow dependence between blocks
-            dumpControlDependence(M);
+        bool runOnModule(Module &M) override
+        {
+            //the report file replaces every print, including the module dumps
+            HelloReportOptions options = getReportOptions();
+            if (options.textLogs)
+            {
+                errs() << "Hello: ";
+                //errs().write_escaped();
+                testMetaData(M);
+            }
 
-            errs() << "\nAverage Num BBs" << avgBBsInFuncs;
-            errs() << "\nAverage CFG edges" << avgCFGEdgesInFuncs;
-            //errs() << "\nTotal number of loops " << totalLoopCount;
-            errs() << "\n Total number of exiting edges " << totalLoopExitingEdges;
-            errs() << "\n";
-            printUnsoundVarUses(M);
+            prepareReportCache(M);
+            const SourceLineIndex &lines = getAnalysis<SourceLineIndexWrapperPass>().getSourceLineIndex();
+            std::vector<HelloFunctionReport> reports;
+            for (Function &F : M)
+            {
+                //Placing this check here because my original .c file compiled from clang 
+                //was using a system call - printf
+                //and llvm passes do not run on functions which are not defined within the module? 
+                //hence analysis information was unavailable when I try to access it here
+                //without this check it will crash for inputs which use printf
+                if (F.isDeclaration())
+                    continue;
+                reports.push_back(analyzeFunctionCached(F, options, [&]
+                {
+                    return analyzeFunctionStandalone(F, lines, options);
+                }));
+            }
+            emitHelloReport(M, reports, options);
+            pruneReportCache(M);
 
-            propagateConstIteratively(M);
+            for (Function &F : M)
+            {
+                if (F.isDeclaration())
+                    continue;
+                propagateConstantsThroughAllocas(F, getAnalysis<MemorySSAWrapperPass>(F).getMSSA());
+            }
 
-            errs() << "\n";
+            if (options.textLogs)
+                errs() << "\n";
             return true;
         }
     };
@@ -648,8 +1150,80 @@ char Hello::ID = 0;
 
 INITIALIZE_PASS_BEGIN(Hello, "hello",
     "Hello World Pass", false, false)
-    INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
-    INITIALIZE_PASS_DEPENDENCY(PostDominatorTreeWrapperPass)
-    INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+    INITIALIZE_PASS_DEPENDENCY(MemorySSAWrapperPass)
+    INITIALIZE_PASS_DEPENDENCY(SourceLineIndexWrapperPass)
     INITIALIZE_PASS_END(Hello, "hello",
         "My hello pass", false, false)
+
+
+HelloPass::HelloPass() : Parallel(HelloParallel), NumThreads(HelloThreads) {}
+
+PreservedAnalyses HelloPass::run(Module &M, ModuleAnalysisManager &AM)
+{
+    HelloReportOptions options = getReportOptions();
+    options.parallel = Parallel;
+    if (options.textLogs)
+    {
+        errs() << "Hello: ";
+        testMetaData(M);
+    }
+
+    std::vector<Function*> functions;
+    for (Function &F : M)
+        if (!F.isDeclaration())
+            functions.push_back(&F);
+    std::vector<HelloFunctionReport> reports(functions.size());
+    prepareReportCache(M);
+
+    //computed before the tasks start, and only read by them
+    const SourceLineIndex &lines = AM.getResult<SourceLineIndexAnalysis>(M);
+    auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    if (Parallel)
+    {
+        //The analysis manager is not thread safe, so every task computes its own analyses.
+        //Each task only writes its own slot of reports, which keeps the output deterministic
+        //hardware_concurrency returns 0 when it can not tell, and a pool without threads never runs a task
+        ThreadPool pool(std::max(1u, NumThreads ? NumThreads : std::thread::hardware_concurrency()));
+        for (unsigned int i = 0; i != functions.size(); i++)
+        {
+            pool.async([&functions, &reports, &lines, options, i]()
+            {
+                Function &F = *functions[i];
+                reports[i] = analyzeFunctionCached(F, options, [&] { return analyzeFunctionStandalone(F, lines, options); });
+            });
+        }
+        pool.wait();
+    }
+    else
+    {
+        for (unsigned int i = 0; i != functions.size(); i++)
+        {
+            Function &F = *functions[i];
+            reports[i] = analyzeFunctionCached(F, options, [&]
+            {
+                if (options.timing)
+                    return analyzeFunctionStandalone(F, lines, options);
+                HelloFunctionAnalyses analyses = {
+                    FAM.getResult<DominatorTreeAnalysis>(F),
+                    FAM.getResult<LoopAnalysis>(F),
+                    needsSection(options, HRS_Reachability) ? &FAM.getResult<BlockReachabilityAnalysis>(F)
+                                                            : nullptr,
+                    needsSection(options, HRS_ControlDependence) ? &FAM.getResult<ControlDependenceAnalysis>(F)
+                                                                 : nullptr,
+                    FAM.getResult<LoopNestingForestAnalysis>(F),
+                    lines };
+                return analyzeFunction(F, analyses, options);
+            });
+        }
+    }
+    emitHelloReport(M, reports, options);
+    pruneReportCache(M);
+
+    //constant propagation rewrites the IR and creates constants, so it stays serial
+    for (Function *F : functions)
+        propagateConstantsThroughAllocas(*F, FAM.getResult<MemorySSAAnalysis>(*F).getMSSA());
+
+    if (options.textLogs)
+        errs() << "\n";
+    return PreservedAnalyses::none();
+}
@@ -5,7 +5,12 @@
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/Module.h"
 
+#include "llvm/Analysis/BitVectorDataflow.h"
+#include "llvm/Analysis/BlockReachability.h"
+#include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/LoopInfoImpl.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/MemorySSAUpdater.h"
 
 #include "llvm/IR/Dominators.h"
 #include "llvm/Analysis/PostDominators.h"
@@ -92,92 +97,208 @@ unsigned int findAverageCFGEdgesInFuncs(const Module &M)
 
 
 //just dumping the BB and vars used
-void printVarUses(std::map<Value*, std::set<BasicBlock*> > used)
+void printVarUses(const std::map<Value*, std::set<BasicBlock*> > &used, raw_ostream &OS)
 {
-    for (auto it : used)
+    for (auto &it : used)
     {
-        errs() << "Variable" << it.first->getName() << "used in : ";
+        OS << "Variable" << it.first->getName() << "used in : ";
         for (auto bb : it.second)
         {
-            errs() << bb->getName() << " , ";
+            OS << bb->getName() << " , ";
         }
-        errs() << "\n";
+        OS << "\n";
     }
 }
 
 
 
-bool isreachable(const BasicBlock* from, const BasicBlock* to);
-std::set<BasicBlock*> visited;
-
-
-void checkReachability(const Function &F)
+//Each pair is an O(1) lookup in the precomputed BlockReachability index of F
+void checkReachability(const Function &F, const BlockReachability &BR, raw_ostream &OS)
 {
     for (auto &BB1 : F.getBasicBlockList())
     {
         for (auto &BB2 : F.getBasicBlockList())
         {
-            visited.clear();
-            if (isreachable(&BB1, &BB2))
+            if (BR.isReachable(&BB1, &BB2))
             {
-                errs() << BB2.getName() << "is reachable from " << BB1.getName() << "\n";
+                OS << BB2.getName() << "is reachable from " << BB1.getName() << "\n";
             }
         }
     }
 }
 
-bool isreachable(const BasicBlock* from, const BasicBlock* to)
-{
-    if (from == nullptr || to == nullptr)
-        return false;
-    if (from == to)
-        return true;
-    for (auto succ = succ_begin(from); succ != succ_end(from); succ++)
-    {
-        visited.insert(const_cast<BasicBlock*>(from));
-        if (visited.find(const_cast<BasicBlock*>(*succ)) != visited.end())
-            continue;
-        if (isreachable(*succ, to))
-            return true;
-    }
-    return false;
-}
 
-void checkReachability(const Module &M)
+
+
+
+//Dataflow problem behind the unsound var report: one bit per alloca of F,
+//set once the alloca has definitely been stored to
+class SoundVarProblem : public BitVectorDataflowProblem
 {
-    for (const Function &F : M.getFunctionList())
+    DenseMap<const Value*, unsigned> varNumbers;
+    std::vector<AllocaInst*> vars;
+
+public:
+    SoundVarProblem(Function &F)
+        : BitVectorDataflowProblem(Direction::Forward, Meet::Intersection)
     {
-        checkReachability(F);
+        for (BasicBlock &BB : F)
+            for (Instruction &I : BB)
+                if (AllocaInst *AI = dyn_cast<AllocaInst>(&I))
+                {
+                    varNumbers[AI] = vars.size();
+                    vars.push_back(AI); //AI inst pointer itself is the var's Value*
+                }
     }
-}
 
+    unsigned getNumBits() const override { return vars.size(); }
 
+    AllocaInst* getVar(unsigned number) const { return vars[number]; }
 
+    //returns -1 if V is not one of the tracked allocas
+    int getVarNumber(const Value* V) const
+    {
+        auto it = varNumbers.find(V);
+        return it == varNumbers.end() ? -1 : (int)it->second;
+    }
 
+    void computeLocalSets(const BasicBlock &BB, BitVector &Gen, BitVector &Kill) override
+    {
+        for (const Instruction &I : BB)
+            if (const StoreInst *SI = dyn_cast<StoreInst>(&I))
+            {
+                int var = getVarNumber(SI->getPointerOperand());
+                if (var >= 0)
+                    Gen.set(var);
+            }
+    }
+};
 
 //to print INSet or OUTSet
-template<typename T>
-void printSets(T soudvar_TSet)
+template<typename GetSetT>
+void printSets(const Function &F, const SoundVarProblem &problem, GetSetT getSet, raw_ostream &OS)
 {
-    for (auto it : soudvar_TSet)
+    for (const BasicBlock &BB : F)
     {
-        errs() << "\nBasic Block : " << it.first->getName();
-        for (auto var : it.second)
+        OS << "\nBasic Block : " << BB.getName();
+        for (unsigned var : getSet(&BB).set_bits())
         {
-            errs() << var->getName() << ", ";
+            OS << problem.getVar(var)->getName() << ", ";
         }
     }
-    errs() << "\n";
+    OS << "\n";
+}
+
+void printINSet(const Function &F, const SoundVarProblem &problem, const BitVectorDataflow &soundVars, raw_ostream &OS)
+{
+    OS << " \n Printing IN Sets: ";
+    printSets(F, problem, [&](const BasicBlock* BB) -> const BitVector& { return soundVars.getIn(BB); }, OS);
 }
 
-void printINSet(std::map<BasicBlock*, std::set<Value*> > soundVar_In)
+void printOUTSet(const Function &F, const SoundVarProblem &problem, const BitVectorDataflow &soundVars, raw_ostream &OS)
 {
-    errs() << " \n Printing IN Sets: ";
-    printSets(soundVar_In);
+    OS << " \n Printing OUT Sets: ";
+    printSets(F, problem, [&](const BasicBlock* BB) -> const BitVector& { return soundVars.getOut(BB); }, OS);
 }
 
-void printOUTSet(std::map<BasicBlock*, std::set<Value*> > soundVar_Out)
+
+//If LI reads an alloca whose value comes from a store of a constant, return that constant
+Constant* getForwardedConstant(LoadInst* LI, MemorySSAWalker* walker)
+{
+    if (!LI->isSimple() || !isa<AllocaInst>(LI->getPointerOperand()))
+        return nullptr;
+    MemoryDef* clobber = dyn_cast<MemoryDef>(walker->getClobberingMemoryAccess(LI));
+    if (!clobber)
+        return nullptr;
+    StoreInst* SI = dyn_cast_or_null<StoreInst>(clobber->getMemoryInst());
+    if (!SI || !SI->isSimple() || SI->getPointerOperand() != LI->getPointerOperand())
+        return nullptr;
+    Constant* C = dyn_cast<Constant>(SI->getValueOperand());
+    if (!C || C->getType() != LI->getType())
+        return nullptr;
+    return C;
+}
+
+//Worklist constant propagation through the allocas of F.
+//Every load is visited once; afterwards an instruction is only revisited when one of
+//its operands became constant, and a load only when the store it reads from did.
+//Allocas that end up being only stored to are deleted together with their stores.
+//Returns the number of instructions replaced by constants.
+unsigned int propagateConstantsThroughAllocas(Function &F, MemorySSA &MSSA)
 {
-    errs() << " \n Printing OUT Sets: ";
-    printSets(soundVar_Out);
+    const DataLayout &DL = F.getParent()->getDataLayout();
+    MemorySSAUpdater updater(&MSSA);
+    MemorySSAWalker* walker = MSSA.getWalker();
+    SmallVector<Instruction*, 32> worklist;
+    SmallPtrSet<Instruction*, 32> replaced;
+    SmallVector<Instruction*, 32> toBeDeleted;
+
+    for (BasicBlock &BB : F)
+        for (Instruction &I : BB)
+            if (isa<LoadInst>(&I))
+                worklist.push_back(&I);
+
+    while (!worklist.empty())
+    {
+        Instruction* I = worklist.pop_back_val();
+        if (replaced.count(I))
+            continue;
+        Constant* C = nullptr;
+        if (LoadInst* LI = dyn_cast<LoadInst>(I))
+            C = getForwardedConstant(LI, walker);
+        else if (!isa<StoreInst>(I))
+            C = ConstantFoldInstruction(I, DL);
+        if (!C)
+            continue;
+
+        for (User* U : I->users())
+        {
+            StoreInst* SI = dyn_cast<StoreInst>(U);
+            if (!SI)
+            {
+                worklist.push_back(cast<Instruction>(U));
+                continue;
+            }
+            if (SI->getValueOperand() != I)
+                continue;
+            //the store now writes a constant: revisit the loads that read from it
+            if (MemoryAccess* MA = MSSA.getMemoryAccess(SI))
+                for (User* MU : MA->users())
+                    if (MemoryUse* use = dyn_cast<MemoryUse>(MU))
+                        if (LoadInst* user = dyn_cast_or_null<LoadInst>(use->getMemoryInst()))
+                            worklist.push_back(user);
+        }
+        I->replaceAllUsesWith(C);
+        replaced.insert(I);
+        toBeDeleted.push_back(I);
+    }
+
+    //allocas that are never read any more only hold dead stores; the loads that were
+    //replaced above still use them until they are erased below. Volatile and atomic
+    //stores must stay, like in getForwardedConstant
+    for (BasicBlock &BB : F)
+        for (Instruction &I : BB)
+        {
+            AllocaInst* AI = dyn_cast<AllocaInst>(&I);
+            if (!AI || !all_of(AI->users(), [AI, &replaced](User* U) {
+                    if (replaced.count(cast<Instruction>(U)))
+                        return true;
+                    const StoreInst* SI = dyn_cast<StoreInst>(U);
+                    return SI && SI->isSimple() && SI->getPointerOperand() == AI &&
+                        SI->getValueOperand() != AI;
+                }))
+                continue;
+            for (User* U : AI->users())
+                if (!replaced.count(cast<Instruction>(U)))
+                    toBeDeleted.push_back(cast<Instruction>(U));
+            toBeDeleted.push_back(AI);
+        }
+
+    for (Instruction* I : toBeDeleted)
+    {
+        if (MemoryAccess* MA = MSSA.getMemoryAccess(I))
+            updater.removeMemoryAccess(MA);
+        I->eraseFromParent();
+    }
+    return replaced.size();
 }
@@ -20,6 +20,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/InstructionSimplify.h"
+#include "llvm/Analysis/KnownBitsCache.h"
 #include "llvm/Analysis/OptimizationDiagnosticInfo.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/IR/DataLayout.h"
@@ -40,6 +41,13 @@ static bool runImpl(Function &F, const SimplifyQuery &SQ,
   SmallPtrSet<const Instruction *, 8> S1, S2, *ToSimplify = &S1, *Next = &S2;
   bool Changed = false;
 
+  // Instructions are only ever replaced and deleted below, which leaves what
+  // is known about the others true, so the known bits of the whole function
+  // can be kept.
+  KnownBitsCache KBCache;
+  SimplifyQuery CachedSQ = SQ;
+  CachedSQ.KBCache = &KBCache;
+
   do {
     for (BasicBlock *BB : depth_first(&F.getEntryBlock())) {
       // Here be subtlety: the iterator must be incremented before the loop
@@ -54,7 +62,7 @@ static bool runImpl(Function &F, const SimplifyQuery &SQ,
 
         // Don't waste time simplifying unused instructions.
         if (!I->use_empty()) {
-          if (Value *V = SimplifyInstruction(I, SQ, ORE)) {
+          if (Value *V = SimplifyInstruction(I, CachedSQ, ORE)) {
             // Mark all uses for resimplification next time round the loop.
             for (User *U : I->users())
               Next->insert(cast<Instruction>(U));
@@ -0,0 +1,84 @@
+; Analysis pipelines may run on several functions at once. What the printers
+; write comes out in module order.
+; RUN: opt -disable-output -npm-function-pass-threads=3 \
+; RUN:     -passes='function(require<scalar-evolution>,verify<domtree>,print<scalar-evolution>,print<domtree>)' %s 2>&1 \
+; RUN:     | FileCheck %s
+; CHECK: Classifying expressions for: @f
+; CHECK: DominatorTree for function: f
+; CHECK: Classifying expressions for: @g
+; CHECK: DominatorTree for function: g
+; CHECK: Classifying expressions for: @h
+; CHECK: DominatorTree for function: h
+; CHECK: Classifying expressions for: @k
+; CHECK: DominatorTree for function: k
+; CHECK-NOT: DominatorTree for function:
+
+; Pipelines that may change the IR are refused.
+; RUN: not opt -disable-output -npm-function-pass-threads=2 \
+; RUN:     -passes='function(verify,instcombine)' %s 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=CHECK-TRANSFORM
+; RUN: not opt -disable-output -npm-function-pass-threads=2 \
+; RUN:     -passes='function(aa-eval)' %s 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=CHECK-AA-EVAL
+; RUN: not opt -disable-output -npm-function-pass-threads=2 \
+; RUN:     -passes='function(loop(no-op-loop))' %s 2>&1 \
+; RUN:     | FileCheck %s --check-prefix=CHECK-LOOP
+; CHECK-TRANSFORM: -npm-function-pass-threads: 'instcombine' may change the IR
+; CHECK-AA-EVAL: -npm-function-pass-threads: 'aa-eval' may change the IR
+; CHECK-LOOP: -npm-function-pass-threads: 'loop' may change the IR
+
+; The same pipeline is fine on one thread.
+; RUN: opt -disable-output -passes='function(verify,instcombine)' %s
+
+@G = global i32 0
+
+define i32 @f(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %i.next
+}
+
+define i32 @g(i32 %a) {
+  %b = add i32 %a, 0
+  ret i32 %b
+}
+
+declare void @ext()
+
+define i64 @h(i64 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %p = getelementptr i32, i32* @G, i64 %i
+  store i32 0, i32* %p
+  %i.next = add nuw i64 %i, 1
+  %done = icmp ult i64 %i.next, 100
+  br i1 %done, label %loop, label %exit
+
+exit:
+  ret i64 ptrtoint (i32* @G to i64)
+}
+
+define i32 @k(i1 %c) {
+entry:
+  br i1 %c, label %then, label %exit
+
+then:
+  call void @ext()
+  %v = load i32, i32* @G
+  br label %exit
+
+exit:
+  %r = phi i32 [ %v, %then ], [ 0, %entry ]
+  ret i32 %r
+}
@@ -0,0 +1,35 @@
+; RUN: rm -f %t %t.new
+; RUN: opt < %s -o /dev/null -domtree -track-pass-memory -info-output-file %t && FileCheck %s --check-prefix=LEGACY < %t
+; RUN: opt < %s -o /dev/null -passes='require<domtree>' -track-pass-memory -info-output-file %t.new && FileCheck %s --check-prefix=NEWPM < %t.new
+; REQUIRES: allocation-hook
+
+; LEGACY: ... Pass memory usage report ...
+; LEGACY-NEXT: ===
+; LEGACY-NEXT: Total: {{[1-9][0-9]*}} allocations, {{[1-9][0-9]*}} bytes
+; LEGACY: --Allocations--  -----Bytes-----  ---Peak Live---  --- Name ---
+; LEGACY: {{^ +[1-9][0-9]* +[1-9][0-9]* +[0-9]+  Dominator Tree Construction$}}
+; LEGACY: {{^ +[1-9][0-9]* +[1-9][0-9]* +[0-9]+  Total$}}
+
+; NEWPM: ... Pass memory usage report ...
+; NEWPM-NEXT: ===
+; NEWPM-NEXT: Total: {{[1-9][0-9]*}} allocations, {{[1-9][0-9]*}} bytes
+; NEWPM: --Allocations--  -----Bytes-----  ---Peak Live---  --- Name ---
+; NEWPM: {{^ +[1-9][0-9]* +[1-9][0-9]* +[0-9]+  .*DominatorTreeAnalysis$}}
+; NEWPM: {{^ +[1-9][0-9]* +[1-9][0-9]* +[0-9]+  Total$}}
+
+define i32 @f(i1 %c, i32 %x) {
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  %a = add i32 %x, 1
+  br label %join
+
+else:
+  %b = mul i32 %x, 3
+  br label %join
+
+join:
+  %r = phi i32 [ %a, %then ], [ %b, %else ]
+  ret i32 %r
+}
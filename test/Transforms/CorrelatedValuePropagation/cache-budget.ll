@@ -0,0 +1,45 @@
+; REQUIRES: asserts
+; RUN: opt < %s -correlated-propagation -lvi-max-cache-entries=1 -stats -S 2>&1 \
+; RUN:     | FileCheck %s --check-prefixes=CHECK,EVICT
+; RUN: opt < %s -correlated-propagation -lvi-max-cache-entries=0 -S \
+; RUN:     | FileCheck %s
+;
+; The ranges of %x are narrowed block by block. With a tiny cache, blocks are
+; evicted between queries and recomputed, and the results stay the same.
+
+declare void @use(i1)
+
+define void @chain(i32 %x) {
+; CHECK-LABEL: @chain(
+; CHECK: bb1:
+; CHECK-NEXT: call void @use(i1 true)
+; CHECK: bb2:
+; CHECK-NEXT: call void @use(i1 true)
+; CHECK: bb3:
+; CHECK-NEXT: call void @use(i1 false)
+entry:
+  %c0 = icmp ult i32 %x, 100
+  br i1 %c0, label %bb1, label %exit
+
+bb1:
+  %c1 = icmp ult i32 %x, 200
+  call void @use(i1 %c1)
+  %d1 = icmp ult i32 %x, 50
+  br i1 %d1, label %bb2, label %exit
+
+bb2:
+  %c2 = icmp ult i32 %x, 60
+  call void @use(i1 %c2)
+  %d2 = icmp ult i32 %x, 25
+  br i1 %d2, label %bb3, label %exit
+
+bb3:
+  %c3 = icmp ugt i32 %x, 30
+  call void @use(i1 %c3)
+  br label %exit
+
+exit:
+  ret void
+}
+
+; EVICT: lazy-value-info - Number of blocks evicted from the cache
@@ -0,0 +1,201 @@
+; RUN: opt < %s -basicaa -gvn -enable-gvn-memoryssa -S | FileCheck %s
+; RUN: opt < %s -aa-pipeline=basic-aa -passes=gvn -enable-gvn-memoryssa -S | FileCheck %s
+
+declare i32 @readonly(i32*) readonly
+declare void @clobber()
+
+define i32 @local(i32* %p, i32* noalias %q, i32 %v) {
+; CHECK-LABEL: @local(
+; CHECK-NOT: load
+; CHECK: ret i32 %v
+entry:
+  store i32 %v, i32* %p
+  store i32 0, i32* %q
+  %a = load i32, i32* %p
+  ret i32 %a
+}
+
+define i32 @dominating_load(i32* %p, i1 %c) {
+; CHECK-LABEL: @dominating_load(
+; CHECK: %a = load i32, i32* %p
+; CHECK-NOT: load
+; CHECK: add i32 %a, %a
+entry:
+  %a = load i32, i32* %p
+  br i1 %c, label %then, label %exit
+
+then:
+  br label %exit
+
+exit:
+  %b = load i32, i32* %p
+  %r = add i32 %a, %b
+  ret i32 %r
+}
+
+define i32 @fully_redundant(i32* %p, i1 %c) {
+; CHECK-LABEL: @fully_redundant(
+; CHECK-NOT: load
+; CHECK: exit:
+; CHECK-NEXT: %r = phi i32
+; CHECK-NEXT: ret i32 %r
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  store i32 1, i32* %p
+  br label %exit
+
+else:
+  store i32 2, i32* %p
+  br label %exit
+
+exit:
+  %r = load i32, i32* %p
+  ret i32 %r
+}
+
+define i32 @partially_redundant(i32* %p, i1 %c) {
+; CHECK-LABEL: @partially_redundant(
+; CHECK: else:
+; CHECK-NEXT: call void @clobber()
+; CHECK-NEXT: %r.pre = load i32, i32* %p
+; CHECK: exit:
+; CHECK-NEXT: %r = phi i32
+; CHECK-NOT: load
+; CHECK: ret i32 %r
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  store i32 1, i32* %p
+  br label %exit
+
+else:
+  call void @clobber()
+  br label %exit
+
+exit:
+  %r = load i32, i32* %p
+  ret i32 %r
+}
+
+; The address is translated through the phi.
+define i32 @phi_translate(i32* %p, i32* %q, i1 %c) {
+; CHECK-LABEL: @phi_translate(
+; CHECK-NOT: load
+; CHECK: exit:
+; CHECK: %r = phi i32
+; CHECK: ret i32 %r
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  store i32 1, i32* %p
+  br label %exit
+
+else:
+  store i32 2, i32* %q
+  br label %exit
+
+exit:
+  %a = phi i32* [ %p, %then ], [ %q, %else ]
+  %r = load i32, i32* %a
+  ret i32 %r
+}
+
+define i32 @switch(i32* %p, i32 %x) {
+; CHECK-LABEL: @switch(
+; CHECK-NOT: load
+; CHECK: exit:
+; CHECK-NEXT: %r = phi i32
+; CHECK-NEXT: ret i32 %r
+entry:
+  switch i32 %x, label %default [
+    i32 0, label %bb0
+    i32 1, label %bb1
+    i32 2, label %bb2
+  ]
+
+bb0:
+  store i32 0, i32* %p
+  br label %exit
+
+bb1:
+  store i32 1, i32* %p
+  br label %exit
+
+bb2:
+  store i32 2, i32* %p
+  br label %exit
+
+default:
+  store i32 3, i32* %p
+  br label %exit
+
+exit:
+  %r = load i32, i32* %p
+  ret i32 %r
+}
+
+; The address changes on every iteration, so the store on the backedge
+; doesn't give the value loaded on the next one.
+define i32 @loop_variant_address(i32* %base, i32 %n) {
+; CHECK-LABEL: @loop_variant_address(
+; CHECK: body:
+; CHECK-NEXT: %addr = getelementptr i32, i32* %base, i32 %i
+; CHECK-NEXT: %v = load i32, i32* %addr
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %body ]
+  %done = icmp eq i32 %i, %n
+  br i1 %done, label %exit, label %body
+
+body:
+  %addr = getelementptr i32, i32* %base, i32 %i
+  %v = load i32, i32* %addr
+  %s.next = add i32 %s, %v
+  store i32 %s.next, i32* %addr
+  %i.next = add i32 %i, 1
+  br label %header
+
+exit:
+  ret i32 %s
+}
+
+define i32 @alloca() {
+; CHECK-LABEL: @alloca(
+; CHECK: ret i32 undef
+entry:
+  %a = alloca i32
+  %r = load i32, i32* %a
+  ret i32 %r
+}
+
+define i32 @readonly_calls(i32* %p, i32* noalias %q) {
+; CHECK-LABEL: @readonly_calls(
+; CHECK: %a = call i32 @readonly(i32* %p)
+; CHECK-NOT: call i32 @readonly
+; CHECK: %r = add i32 %a, %a
+entry:
+  %a = call i32 @readonly(i32* %p)
+  store i32 0, i32* %q
+  %b = call i32 @readonly(i32* %p)
+  %r = add i32 %a, %b
+  ret i32 %r
+}
+
+define i32 @readonly_calls_clobbered(i32* %p) {
+; CHECK-LABEL: @readonly_calls_clobbered(
+; CHECK: %a = call i32 @readonly(i32* %p)
+; CHECK: %b = call i32 @readonly(i32* %p)
+entry:
+  %a = call i32 @readonly(i32* %p)
+  store i32 0, i32* %p
+  %b = call i32 @readonly(i32* %p)
+  %r = add i32 %a, %b
+  ret i32 %r
+}
@@ -0,0 +1,48 @@
+; REQUIRES: asserts
+; RUN: opt -S -inline -stats < %s 2>&1 | FileCheck %s
+; RUN: opt -S -passes='cgscc(inline)' -stats < %s 2>&1 | FileCheck %s
+;
+; The walk of @callee for @caller1 is reused for @caller2, which binds its
+; argument the same way. @caller3 passes a pointer that isn't an alloca and
+; gets a walk of its own.
+
+define internal i32 @callee(i32* %p) {
+entry:
+  %v = load i32, i32* %p
+  %a = add i32 %v, 1
+  store i32 %a, i32* %p
+  ret i32 %a
+}
+
+define i32 @caller1() {
+; CHECK-LABEL: define i32 @caller1(
+; CHECK-NOT: call
+; CHECK: ret i32
+entry:
+  %x = alloca i32
+  store i32 0, i32* %x
+  %r = call i32 @callee(i32* %x)
+  ret i32 %r
+}
+
+define i32 @caller2() {
+; CHECK-LABEL: define i32 @caller2(
+; CHECK-NOT: call
+; CHECK: ret i32
+entry:
+  %x = alloca i32
+  store i32 1, i32* %x
+  %r = call i32 @callee(i32* %x)
+  ret i32 %r
+}
+
+define i32 @caller3(i32* %q) {
+; CHECK-LABEL: define i32 @caller3(
+; CHECK-NOT: call
+; CHECK: ret i32
+entry:
+  %r = call i32 @callee(i32* %q)
+  ret i32 %r
+}
+
+; CHECK: 1 inline-cost - Number of call sites analyzed from a cached walk of the callee
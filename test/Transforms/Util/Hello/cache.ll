@@ -0,0 +1,43 @@
+; REQUIRES: asserts
+; The first run analyzes every function and fills the cache.
+; RUN: rm -rf %t.cache
+; RUN: opt -disable-output -passes=hello -hello-cache-dir=%t.cache \
+; RUN:     -hello-report-file=%t.first.yaml -hello-report-sections=functions \
+; RUN:     -stats %s 2>&1 | FileCheck %s --check-prefix=FIRST
+; FIRST-NOT: read from -hello-cache-dir
+; FIRST: 2 hello - Number of function reports written to -hello-cache-dir
+; FIRST-NOT: read from -hello-cache-dir
+
+; The second run is served from the cache, with the same report.
+; RUN: opt -disable-output -passes=hello -hello-cache-dir=%t.cache \
+; RUN:     -hello-report-file=%t.second.yaml -hello-report-sections=functions \
+; RUN:     -stats %s 2>&1 | FileCheck %s --check-prefix=SECOND
+; RUN: diff %t.first.yaml %t.second.yaml
+; SECOND-NOT: written to -hello-cache-dir
+; SECOND: 2 hello - Number of function reports read from -hello-cache-dir
+; SECOND-NOT: written to -hello-cache-dir
+
+; A function that changed misses, the other one still hits.
+; RUN: sed -e 's/add i32 %a, 1/add i32 %a, 2/' %s \
+; RUN:     | opt -disable-output -passes=hello -hello-cache-dir=%t.cache \
+; RUN:       -hello-report-file=%t.third.yaml -hello-report-sections=functions \
+; RUN:       -stats 2>&1 | FileCheck %s --check-prefix=CHANGED
+; CHANGED-DAG: 1 hello - Number of function reports read from -hello-cache-dir
+; CHANGED-DAG: 1 hello - Number of function reports written to -hello-cache-dir
+
+define i32 @changes(i32 %a) {
+  %b = add i32 %a, 1
+  ret i32 %b
+}
+
+define i32 @stays(i32 %a, i1 %c) {
+entry:
+  br i1 %c, label %then, label %exit
+
+then:
+  br label %exit
+
+exit:
+  %r = phi i32 [ %a, %entry ], [ 0, %then ]
+  ret i32 %r
+}
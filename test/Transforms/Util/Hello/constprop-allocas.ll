@@ -0,0 +1,59 @@
+; The report goes to a file so that only the transformed module is printed.
+; RUN: opt -S -hello -hello-report-file=%t.yaml %s | FileCheck %s
+; RUN: opt -S -passes=hello -hello-report-file=%t.yaml %s | FileCheck %s
+
+; Constants stored to allocas are forwarded to the loads, and the allocas that
+; are only stored to afterwards are deleted with their stores.
+; CHECK-LABEL: define i32 @main()
+; CHECK-NOT: alloca
+; CHECK-NOT: store
+; CHECK-NOT: load
+; CHECK: ret i32 10
+define i32 @main() {
+entry:
+  %c = alloca i32
+  %a = alloca i32
+  %b = alloca i32
+  store i32 5, i32* %c
+  %0 = load i32, i32* %c
+  store i32 %0, i32* %a
+  %1 = load i32, i32* %a
+  store i32 %1, i32* %b
+  %2 = load i32, i32* %b
+  %sum = add i32 %1, %2
+  ret i32 %sum
+}
+
+; An alloca that is still read keeps its stores.
+; CHECK-LABEL: define i32 @unknown(i32 %n)
+; CHECK: %x = alloca i32
+; CHECK: store i32 %n, i32* %x
+; CHECK: load i32, i32* %x
+define i32 @unknown(i32 %n) {
+entry:
+  %x = alloca i32
+  store i32 %n, i32* %x
+  %v = load i32, i32* %x
+  ret i32 %v
+}
+
+; Volatile and atomic stores are not deleted, so neither are their allocas.
+; CHECK-LABEL: define i32 @volatile_store()
+; CHECK: %v = alloca i32
+; CHECK: %a = alloca i32
+; CHECK: store volatile i32 7, i32* %v
+; CHECK: store atomic i32 3, i32* %a unordered
+; CHECK: ret i32 10
+define i32 @volatile_store() {
+entry:
+  %v = alloca i32
+  %a = alloca i32
+  store i32 7, i32* %v
+  %0 = load i32, i32* %v
+  store volatile i32 %0, i32* %v
+  store i32 3, i32* %a
+  %1 = load i32, i32* %a
+  store atomic i32 %1, i32* %a unordered, align 4
+  %sum = add i32 %0, %1
+  ret i32 %sum
+}
@@ -0,0 +1,65 @@
+; The parallel mode writes the same report as the serial one, whatever the
+; number of threads.
+; RUN: opt -disable-output -passes=hello -hello-report-file=%t.serial.yaml \
+; RUN:     -hello-report-sections=functions,control-dependence,reachability %s
+; RUN: opt -disable-output -passes=hello -hello-parallel -hello-threads=2 \
+; RUN:     -hello-report-file=%t.parallel.yaml \
+; RUN:     -hello-report-sections=functions,control-dependence,reachability %s
+; RUN: diff %t.serial.yaml %t.parallel.yaml
+; RUN: opt -disable-output -passes=hello -hello-parallel \
+; RUN:     -hello-report-file=%t.default.yaml \
+; RUN:     -hello-report-sections=functions,control-dependence,reachability %s
+; RUN: diff %t.serial.yaml %t.default.yaml
+
+; The timing file has a row per function and phase. Memory is only counted for
+; the whole process, so it is left out in parallel mode.
+; RUN: opt -disable-output -passes=hello -hello-report-file=%t.yaml \
+; RUN:     -hello-timing-file=%t.serial.csv %s
+; RUN: FileCheck %s --check-prefix=SERIAL < %t.serial.csv
+; RUN: opt -disable-output -passes=hello -hello-parallel -hello-threads=2 \
+; RUN:     -hello-report-file=%t.yaml -hello-timing-file=%t.parallel.csv %s
+; RUN: FileCheck %s --check-prefix=PARALLEL < %t.parallel.csv
+; RUN: opt -disable-output -hello -hello-report-file=%t.yaml \
+; RUN:     -hello-timing-file=%t.legacy.csv %s
+; RUN: FileCheck %s --check-prefix=SERIAL < %t.legacy.csv
+
+; SERIAL: function,blocks,phase,wall_seconds,cpu_seconds,mem_bytes,count
+; SERIAL: loop,3,domtree,{{[0-9.]+}},{{[0-9.]+}},{{-?[0-9]+}},0
+; SERIAL: loop,3,loops,{{[0-9.]+}},{{[0-9.]+}},{{-?[0-9]+}},1
+; SERIAL: diamond,4,loops,{{[0-9.]+}},{{[0-9.]+}},{{-?[0-9]+}},0
+; SERIAL: diamond,4,control-dependence,{{[0-9.]+}},{{[0-9.]+}},{{-?[0-9]+}},2
+
+; PARALLEL: function,blocks,phase,wall_seconds,cpu_seconds,mem_bytes,count
+; PARALLEL: loop,3,loops,{{[0-9.]+}},{{[0-9.]+}},,1
+; PARALLEL: diamond,4,control-dependence,{{[0-9.]+}},{{[0-9.]+}},,2
+
+define i32 @loop(i32 %n) {
+entry:
+  br label %body
+
+body:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %body
+
+exit:
+  ret i32 %i.next
+}
+
+define i32 @diamond(i1 %c) {
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  br label %join
+
+else:
+  br label %join
+
+join:
+  %r = phi i32 [ 1, %then ], [ 2, %else ]
+  ret i32 %r
+}
+
+declare void @external()
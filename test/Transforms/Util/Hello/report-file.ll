@@ -0,0 +1,100 @@
+; Without sections the report file only has the module summary.
+; RUN: opt -disable-output -passes=hello -hello-report-file=%t.yaml %s
+; RUN: FileCheck %s --check-prefix=SUMMARY < %t.yaml
+; RUN: opt -disable-output -hello -hello-report-file=%t.legacy.yaml %s
+; RUN: diff %t.yaml %t.legacy.yaml
+
+; SUMMARY:      ---
+; SUMMARY-NEXT: Module: {{.*}}report-file.ll
+; SUMMARY-NEXT: Functions: 3
+; SUMMARY-NEXT: AverageBBs: 3
+; SUMMARY-NEXT: AverageCFGEdges: 3
+; SUMMARY-NEXT: Loops: 0
+; SUMMARY-NEXT: OuterLoops: 0
+; SUMMARY-NEXT: ExitingEdges: 0
+; SUMMARY-NEXT: MultipleEntryLoops: 1
+; SUMMARY-NEXT: IrreducibleCycles: 1
+; SUMMARY-NEXT: UnsoundVarUses: 1
+; SUMMARY-NEXT: ...
+
+; Only the functions with findings in the selected sections are listed, with
+; only those sections.
+; RUN: opt -disable-output -passes=hello -hello-report-file=%t.findings.yaml \
+; RUN:     -hello-report-sections=unsound-uses,multi-entry-cycles %s
+; RUN: FileCheck %s --check-prefix=FINDINGS < %t.findings.yaml
+
+; FINDINGS:      FunctionReports:
+; FINDINGS-NEXT:   - Name: uninitialized
+; FINDINGS:          UnsoundVarUses: 1
+; FINDINGS-NEXT:     UnsoundUses:
+; FINDINGS-NEXT:       - { Var: x }
+; FINDINGS-NEXT:   - Name: irreducible
+; FINDINGS:          IrreducibleCycles: 1
+; FINDINGS:          MultiEntryCycles:
+; FINDINGS-NEXT:       - Block: left
+; FINDINGS-NEXT:         Blocks:
+; FINDINGS-NEXT:           - left
+; FINDINGS-NEXT:           - right
+; FINDINGS-NEXT: ...
+; FINDINGS-NOT: diamond
+; FINDINGS-NOT: ControlDependences
+; FINDINGS-NOT: Reachability
+
+; The functions section lists every function, with its counters only.
+; RUN: opt -disable-output -passes=hello -hello-report-file=%t.functions.yaml \
+; RUN:     -hello-report-sections=functions %s
+; RUN: FileCheck %s --check-prefix=FUNCTIONS < %t.functions.yaml
+
+; FUNCTIONS:      FunctionReports:
+; FUNCTIONS-NEXT:   - Name: uninitialized
+; FUNCTIONS-NEXT:     Loops: 0
+; FUNCTIONS-NEXT:     OuterLoops: 0
+; FUNCTIONS-NEXT:     ExitingEdges: 0
+; FUNCTIONS-NEXT:     MultipleEntryLoops: 0
+; FUNCTIONS-NEXT:     IrreducibleCycles: 0
+; FUNCTIONS-NEXT:     UnsoundVarUses: 1
+; FUNCTIONS-NEXT:   - Name: irreducible
+; FUNCTIONS:        - Name: diamond
+; FUNCTIONS-NOT:  UnsoundUses
+; FUNCTIONS-NOT:  MultiEntryCycles
+; FUNCTIONS:      ...
+
+define i32 @uninitialized(i1 %c) {
+entry:
+  %x = alloca i32
+  br i1 %c, label %init, label %use
+
+init:
+  store i32 1, i32* %x
+  br label %use
+
+use:
+  %v = load i32, i32* %x
+  ret i32 %v
+}
+
+define void @irreducible(i1 %c, i1 %d) {
+entry:
+  br i1 %c, label %left, label %right
+
+left:
+  br i1 %d, label %right, label %exit
+
+right:
+  br label %left
+
+exit:
+  ret void
+}
+
+define i32 @diamond(i1 %c) {
+entry:
+  br i1 %c, label %then, label %join
+
+then:
+  br label %join
+
+join:
+  %r = phi i32 [ 1, %entry ], [ 2, %then ]
+  ret i32 %r
+}
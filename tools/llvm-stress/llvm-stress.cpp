@@ -65,6 +65,23 @@ static cl::opt<std::string>
 OutputFilename("o", cl::desc("Override output filename"),
                cl::value_desc("filename"));
 
+static cl::opt<unsigned> CFGBlocksCL("cfg-blocks",
+  cl::desc("Generate a CFG of about this many blocks with loads and stores "
+           "of allocas instead of random instructions (0 = off)"),
+  cl::init(0));
+
+static cl::opt<unsigned> CFGLoopDepthCL("cfg-loop-depth",
+  cl::desc("The maximum loop nesting depth of -cfg-blocks CFGs"),
+  cl::init(2));
+
+static cl::opt<unsigned> CFGIrreducibleCL("cfg-irreducible",
+  cl::desc("The number of loops of -cfg-blocks CFGs that get a second entry"),
+  cl::init(0));
+
+static cl::opt<unsigned> CFGAllocasCL("cfg-allocas",
+  cl::desc("The number of allocas loaded and stored by -cfg-blocks CFGs"),
+  cl::init(8));
+
 static LLVMContext Context;
 
 namespace cl {
@@ -726,6 +743,116 @@ static void IntroduceControlFlow(Function *F, Random &R) {
   }
 }
 
+namespace {
+
+/// Generates a structured CFG of straight-line blocks, if-then-else diamonds
+/// and natural loops nested up to -cfg-loop-depth deep, and then turns
+/// -cfg-irreducible of the loops into multiple-entry cycles. Every block
+/// loads and stores a few of the allocas, so that dataflow over the allocas
+/// has something to do; branch conditions compare an argument against a
+/// constant so that no SSA value crosses a block boundary and any edge can be
+/// added without breaking dominance.
+class CFGGenerator {
+  struct LoopRecord {
+    BasicBlock *Preheader;
+    BasicBlock *Header;
+    BasicBlock *Body;
+  };
+
+  Function *F;
+  Random &R;
+  Value *CondArg;
+  std::vector<AllocaInst *> Allocas;
+  std::vector<LoopRecord> Loops;
+
+  BasicBlock *newBlock(StringRef Name) {
+    BasicBlock *BB = BasicBlock::Create(F->getContext(), Name, F);
+    for (unsigned I = 0; I != 2 && !Allocas.empty(); ++I) {
+      AllocaInst *Ptr = Allocas[R.Rand() % Allocas.size()];
+      if (R.Rand() % 2) {
+        new LoadInst(Ptr, "L", BB);
+        continue;
+      }
+      Type *Ty = Ptr->getAllocatedType();
+      new StoreInst(ConstantInt::get(Ty, R.Rand()), Ptr, BB);
+    }
+    return BB;
+  }
+
+  Value *newCondition(BasicBlock *BB) {
+    return new ICmpInst(*BB, ICmpInst::ICMP_SLT, CondArg,
+                        ConstantInt::get(CondArg->getType(), R.Rand() % 100),
+                        "Cmp");
+  }
+
+  /// Append about \p Budget blocks after \p Cur, which is left pointing at
+  /// the last block of the sequence.
+  void genSequence(BasicBlock *&Cur, unsigned Budget, unsigned Depth) {
+    while (Budget) {
+      unsigned Kind = R.Rand() % 3;
+      if (Kind == 0 && Depth < CFGLoopDepthCL && Budget >= 3) {
+        BasicBlock *Header = newBlock("Header");
+        BasicBlock *Body = newBlock("Body");
+        BasicBlock *Exit = newBlock("Exit");
+        BranchInst::Create(Header, Cur);
+        BranchInst::Create(Body, Exit, newCondition(Header), Header);
+        Loops.push_back({Cur, Header, Body});
+        unsigned BodyBudget = R.Rand() % (Budget - 2);
+        BasicBlock *Latch = Body;
+        genSequence(Latch, BodyBudget, Depth + 1);
+        BranchInst::Create(Header, Latch);
+        Cur = Exit;
+        Budget -= BodyBudget + 3;
+      } else if (Kind == 1 && Budget >= 3) {
+        BasicBlock *Then = newBlock("Then");
+        BasicBlock *Else = newBlock("Else");
+        BasicBlock *Join = newBlock("Join");
+        BranchInst::Create(Then, Else, newCondition(Cur), Cur);
+        BranchInst::Create(Join, Then);
+        BranchInst::Create(Join, Else);
+        Cur = Join;
+        Budget -= 3;
+      } else {
+        BasicBlock *Next = newBlock("Next");
+        BranchInst::Create(Next, Cur);
+        Cur = Next;
+        Budget -= 1;
+      }
+    }
+  }
+
+public:
+  CFGGenerator(Function *F, Random &R) : F(F), R(R), CondArg(nullptr) {
+    for (Argument &Arg : F->args())
+      if (Arg.getType()->isIntegerTy(32))
+        CondArg = &Arg;
+  }
+
+  void generate() {
+    BasicBlock *Entry = BasicBlock::Create(F->getContext(), "BB", F);
+    Type *I32 = Type::getInt32Ty(F->getContext());
+    for (unsigned I = 0; I != CFGAllocasCL; ++I)
+      Allocas.push_back(new AllocaInst(I32, 0, "A", Entry));
+
+    BasicBlock *Cur = Entry;
+    genSequence(Cur, CFGBlocksCL, 0);
+    ReturnInst::Create(F->getContext(), Cur);
+
+    // Give some loops a second entry that bypasses the header, which makes
+    // them irreducible.
+    std::shuffle(Loops.begin(), Loops.end(), R);
+    for (unsigned I = 0, E = std::min<size_t>(CFGIrreducibleCL, Loops.size());
+         I != E; ++I) {
+      LoopRecord &L = Loops[I];
+      L.Preheader->getTerminator()->eraseFromParent();
+      BranchInst::Create(L.Header, L.Body, newCondition(L.Preheader),
+                         L.Preheader);
+    }
+  }
+};
+
+} // end anonymous namespace
+
 } // end namespace llvm
 
 int main(int argc, char **argv) {
@@ -741,10 +868,15 @@ int main(int argc, char **argv) {
 
   // Pick an initial seed value
   Random R(SeedCL);
-  // Generate lots of random instructions inside a single basic block.
-  FillFunction(F, R);
-  // Break the basic block into many loops.
-  IntroduceControlFlow(F, R);
+  if (CFGBlocksCL) {
+    // Generate a CFG of the requested shape.
+    CFGGenerator(F, R).generate();
+  } else {
+    // Generate lots of random instructions inside a single basic block.
+    FillFunction(F, R);
+    // Break the basic block into many loops.
+    IntroduceControlFlow(F, R);
+  }
 
   // Figure out what stream we are supposed to write to...
   std::unique_ptr<tool_output_file> Out;
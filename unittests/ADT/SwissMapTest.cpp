@@ -0,0 +1,119 @@
+//===- llvm/unittest/ADT/SwissMapTest.cpp - SwissMap unit tests -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The DenseMap interface of SwissMap is covered by the typed tests in
+// DenseMapTest.cpp. These tests cover what is particular to SwissMap.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SwissMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "gtest/gtest.h"
+#include <map>
+#include <memory>
+#include <string>
+
+using namespace llvm;
+
+namespace {
+
+// Keys that DenseMap reserves for itself are ordinary keys here.
+TEST(SwissMapTest, EmptyAndTombstoneKeys) {
+  SwissMap<unsigned, unsigned> Map;
+  unsigned Empty = DenseMapInfo<unsigned>::getEmptyKey();
+  unsigned Tombstone = DenseMapInfo<unsigned>::getTombstoneKey();
+  Map[Empty] = 1;
+  Map[Tombstone] = 2;
+  EXPECT_EQ(2u, Map.size());
+  EXPECT_EQ(1u, Map.lookup(Empty));
+  EXPECT_EQ(2u, Map.lookup(Tombstone));
+  EXPECT_TRUE(Map.erase(Empty));
+  EXPECT_EQ(0u, Map.count(Empty));
+  EXPECT_EQ(1u, Map.count(Tombstone));
+}
+
+// Mix insertions and erasures so that the table fills with erased buckets and
+// has to be rehashed both in place and into a bigger table.
+TEST(SwissMapTest, Churn) {
+  SwissMap<unsigned, unsigned> Map;
+  std::map<unsigned, unsigned> Reference;
+  uint32_t Seed = 1;
+  auto Next = [&Seed] {
+    Seed = Seed * 1103515245 + 12345;
+    return (Seed >> 8) % 3000;
+  };
+
+  for (unsigned I = 0; I != 100000; ++I) {
+    unsigned Key = Next();
+    if (I % 3 == 2) {
+      EXPECT_EQ(Reference.erase(Key), Map.erase(Key) ? 1u : 0u);
+      continue;
+    }
+    bool Inserted = Reference.insert(std::make_pair(Key, I)).second;
+    EXPECT_EQ(Inserted, Map.insert(std::make_pair(Key, I)).second);
+  }
+
+  EXPECT_EQ(Reference.size(), Map.size());
+  for (const auto &KV : Reference)
+    EXPECT_EQ(KV.second, Map.lookup(KV.first));
+  unsigned Visited = 0;
+  for (const auto &KV : Map) {
+    EXPECT_EQ(Reference[KV.first], KV.second);
+    ++Visited;
+  }
+  EXPECT_EQ(Reference.size(), Visited);
+}
+
+// Erasing keeps the other iterators valid, as it does for DenseMap.
+TEST(SwissMapTest, EraseWhileIterating) {
+  SwissMap<unsigned, unsigned> Map;
+  for (unsigned I = 0; I != 1000; ++I)
+    Map[I] = I;
+  for (auto I = Map.begin(), E = Map.end(); I != E;) {
+    auto Cur = I++;
+    if (Cur->first % 2)
+      Map.erase(Cur);
+  }
+  EXPECT_EQ(500u, Map.size());
+  for (unsigned I = 0; I != 1000; ++I)
+    EXPECT_EQ(I % 2 ? 0u : 1u, Map.count(I));
+}
+
+TEST(SwissMapTest, ReserveKeepsBuckets) {
+  SwissMap<unsigned, unsigned> Map;
+  Map.reserve(1000);
+  const void *Buckets = Map.getPointerIntoBucketsArray();
+  for (unsigned I = 0; I != 1000; ++I)
+    Map[I] = I;
+  EXPECT_EQ(Buckets, Map.getPointerIntoBucketsArray());
+}
+
+TEST(SwissMapTest, MoveOnlyValues) {
+  SwissMap<unsigned, std::unique_ptr<unsigned>> Map;
+  for (unsigned I = 0; I != 100; ++I)
+    Map.try_emplace(I, new unsigned(I));
+  SwissMap<unsigned, std::unique_ptr<unsigned>> Moved(std::move(Map));
+  EXPECT_TRUE(Map.empty());
+  EXPECT_EQ(100u, Moved.size());
+  for (unsigned I = 0; I != 100; ++I)
+    EXPECT_EQ(I, *Moved[I]);
+}
+
+TEST(SwissMapTest, FindAsStringRef) {
+  SwissMap<StringRef, std::string> Map;
+  Map["a"] = "alpha";
+  Map["b"] = "beta";
+  std::string Key = "b";
+  auto I = Map.find_as(StringRef(Key));
+  ASSERT_TRUE(I != Map.end());
+  EXPECT_EQ("beta", I->second);
+  EXPECT_TRUE(Map.find("c") == Map.end());
+}
+
+} // end anonymous namespace
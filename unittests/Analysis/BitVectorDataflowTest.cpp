@@ -0,0 +1,141 @@
+//===- BitVectorDataflowTest.cpp - BitVectorDataflow unit tests -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/BitVectorDataflow.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+// entry -> header <-> body, header -> exit, with an unreachable block feeding
+// the exit.
+const char *LoopFunction = "define void @f(i1 %c) {\n"
+                           "entry:\n"
+                           "  br label %header\n"
+                           "header:\n"
+                           "  br i1 %c, label %body, label %exit\n"
+                           "body:\n"
+                           "  br label %header\n"
+                           "exit:\n"
+                           "  ret void\n"
+                           "dead:\n"
+                           "  br label %exit\n"
+                           "}\n";
+
+/// A problem whose gen and kill sets are given per block name, as strings of
+/// '0' and '1'.
+class TableProblem : public BitVectorDataflowProblem {
+  StringMap<std::pair<const char *, const char *>> Table;
+
+public:
+  TableProblem(Direction Dir, Meet MeetOp)
+      : BitVectorDataflowProblem(Dir, MeetOp) {}
+
+  void setLocalSets(StringRef Block, const char *Gen, const char *Kill) {
+    Table[Block] = std::make_pair(Gen, Kill);
+  }
+
+  unsigned getNumBits() const override { return 3; }
+
+  void computeLocalSets(const BasicBlock &BB, BitVector &Gen,
+                        BitVector &Kill) override {
+    auto I = Table.find(BB.getName());
+    if (I == Table.end())
+      return;
+    for (unsigned Bit = 0; Bit != 3; ++Bit) {
+      if (I->second.first[Bit] == '1')
+        Gen.set(Bit);
+      if (I->second.second[Bit] == '1')
+        Kill.set(Bit);
+    }
+  }
+};
+
+class BitVectorDataflowTest : public testing::Test {
+protected:
+  LLVMContext C;
+  std::unique_ptr<Module> M;
+
+  Function *parse(const char *Assembly) {
+    SMDiagnostic Err;
+    M = parseAssemblyString(Assembly, Err, C);
+    if (!M)
+      Err.print("BitVectorDataflowTest", errs());
+    return M ? M->getFunction("f") : nullptr;
+  }
+
+  static BasicBlock *getBlock(Function &F, StringRef Name) {
+    for (BasicBlock &BB : F)
+      if (BB.getName() == Name)
+        return &BB;
+    llvm_unreachable("Expected to find basic block!");
+  }
+
+  static std::string str(const BitVector &BV) {
+    std::string S;
+    for (unsigned I = 0, E = BV.size(); I != E; ++I)
+      S += BV.test(I) ? '1' : '0';
+    return S;
+  }
+};
+
+TEST_F(BitVectorDataflowTest, ForwardIntersection) {
+  Function *F = parse(LoopFunction);
+  ASSERT_TRUE(F);
+  TableProblem P(BitVectorDataflowProblem::Direction::Forward,
+                 BitVectorDataflowProblem::Meet::Intersection);
+  P.setLocalSets("entry", "100", "000");
+  P.setLocalSets("body", "010", "000");
+  P.setLocalSets("dead", "001", "000");
+
+  BitVectorDataflow DF;
+  DF.solve(*F, P);
+  EXPECT_EQ("000", str(DF.getIn(getBlock(*F, "entry"))));
+  EXPECT_EQ("100", str(DF.getOut(getBlock(*F, "entry"))));
+  // The back edge only adds facts that already hold on entry to the header.
+  EXPECT_EQ("100", str(DF.getIn(getBlock(*F, "header"))));
+  EXPECT_EQ("110", str(DF.getOut(getBlock(*F, "body"))));
+  // The unreachable predecessor of exit is solved too and restricts it.
+  EXPECT_EQ("001", str(DF.getOut(getBlock(*F, "dead"))));
+  EXPECT_EQ("000", str(DF.getIn(getBlock(*F, "exit"))));
+}
+
+TEST_F(BitVectorDataflowTest, BackwardUnion) {
+  Function *F = parse(LoopFunction);
+  ASSERT_TRUE(F);
+  // Liveness: gen is "used before defined", kill is "defined".
+  TableProblem P(BitVectorDataflowProblem::Direction::Backward,
+                 BitVectorDataflowProblem::Meet::Union);
+  P.setLocalSets("entry", "000", "110");
+  P.setLocalSets("body", "100", "010");
+  P.setLocalSets("exit", "001", "000");
+
+  BitVectorDataflow DF;
+  DF.solve(*F, P);
+  EXPECT_EQ("000", str(DF.getOut(getBlock(*F, "exit"))));
+  EXPECT_EQ("001", str(DF.getIn(getBlock(*F, "exit"))));
+  EXPECT_EQ("101", str(DF.getIn(getBlock(*F, "header"))));
+  EXPECT_EQ("101", str(DF.getOut(getBlock(*F, "body"))));
+  EXPECT_EQ("101", str(DF.getIn(getBlock(*F, "body"))));
+  EXPECT_EQ("001", str(DF.getIn(getBlock(*F, "entry"))));
+  EXPECT_EQ("001", str(DF.getIn(getBlock(*F, "dead"))));
+  // Every block is visited once, and only the loop is revisited.
+  EXPECT_GE(DF.getNumBlockVisits(), 5u);
+  EXPECT_LE(DF.getNumBlockVisits(), 8u);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,127 @@
+//===- BlockReachabilityTest.cpp - BlockReachability unit tests -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/BlockReachability.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class BlockReachabilityTest : public testing::Test {
+protected:
+  LLVMContext C;
+  std::unique_ptr<Module> M;
+
+  Function *parse(const char *Assembly) {
+    SMDiagnostic Err;
+    M = parseAssemblyString(Assembly, Err, C);
+    if (!M)
+      Err.print("BlockReachabilityTest", errs());
+    return M ? M->getFunction("f") : nullptr;
+  }
+
+  static BasicBlock *getBlock(Function &F, StringRef Name) {
+    for (BasicBlock &BB : F)
+      if (BB.getName() == Name)
+        return &BB;
+    llvm_unreachable("Expected to find basic block!");
+  }
+};
+
+TEST_F(BlockReachabilityTest, LoopsAndUnreachableBlocks) {
+  Function *F = parse("define void @f(i1 %c) {\n"
+                      "entry:\n"
+                      "  br label %header\n"
+                      "header:\n"
+                      "  br i1 %c, label %body, label %exit\n"
+                      "body:\n"
+                      "  br label %header\n"
+                      "exit:\n"
+                      "  ret void\n"
+                      "dead:\n"
+                      "  br label %dead.self\n"
+                      "dead.self:\n"
+                      "  br i1 %c, label %dead.self, label %exit\n"
+                      "}\n");
+  ASSERT_TRUE(F);
+  BlockReachability BR(*F);
+
+  BasicBlock *Entry = getBlock(*F, "entry");
+  BasicBlock *Header = getBlock(*F, "header");
+  BasicBlock *Body = getBlock(*F, "body");
+  BasicBlock *Exit = getBlock(*F, "exit");
+  BasicBlock *Dead = getBlock(*F, "dead");
+  BasicBlock *DeadSelf = getBlock(*F, "dead.self");
+
+  EXPECT_TRUE(BR.isReachable(Entry, Entry));
+  EXPECT_TRUE(BR.isReachable(Entry, Exit));
+  EXPECT_TRUE(BR.isReachable(Body, Header));
+  EXPECT_TRUE(BR.isReachable(Body, Exit));
+  EXPECT_FALSE(BR.isReachable(Header, Entry));
+  EXPECT_FALSE(BR.isReachable(Exit, Header));
+  EXPECT_FALSE(BR.isReachable(Entry, Dead));
+  EXPECT_FALSE(BR.isReachable(Entry, DeadSelf));
+  EXPECT_TRUE(BR.isReachable(Dead, Exit));
+  EXPECT_FALSE(BR.isReachable(Dead, Header));
+
+  EXPECT_EQ(BR.getSCCNumber(Header), BR.getSCCNumber(Body));
+  EXPECT_NE(BR.getSCCNumber(Entry), BR.getSCCNumber(Header));
+  EXPECT_EQ(5u, BR.getNumSCCs());
+
+  EXPECT_FALSE(BR.isInCycle(Entry));
+  EXPECT_TRUE(BR.isInCycle(Header));
+  EXPECT_TRUE(BR.isInCycle(Body));
+  EXPECT_FALSE(BR.isInCycle(Dead));
+  EXPECT_TRUE(BR.isInCycle(DeadSelf));
+}
+
+// A long chain of blocks closed into one big cycle must be handled without
+// recursing once per block.
+TEST_F(BlockReachabilityTest, DeepChain) {
+  const unsigned NumBlocks = 50000;
+  M = make_unique<Module>("deep", C);
+  FunctionType *FTy =
+      FunctionType::get(Type::getVoidTy(C), {Type::getInt1Ty(C)}, false);
+  Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage, "f",
+                                 M.get());
+  Value *Cond = &*F->arg_begin();
+
+  SmallVector<BasicBlock *, 8> Blocks;
+  for (unsigned I = 0; I != NumBlocks; ++I)
+    Blocks.push_back(BasicBlock::Create(C, "", F));
+  BasicBlock *Exit = BasicBlock::Create(C, "exit", F);
+  IRBuilder<> B(C);
+  for (unsigned I = 0; I + 1 != NumBlocks; ++I) {
+    B.SetInsertPoint(Blocks[I]);
+    B.CreateBr(Blocks[I + 1]);
+  }
+  B.SetInsertPoint(Blocks.back());
+  B.CreateCondBr(Cond, Blocks[1], Exit);
+  B.SetInsertPoint(Exit);
+  B.CreateRetVoid();
+
+  BlockReachability BR(*F);
+  EXPECT_EQ(3u, BR.getNumSCCs());
+  EXPECT_TRUE(BR.isReachable(Blocks[0], Exit));
+  EXPECT_TRUE(BR.isReachable(Blocks.back(), Blocks[1]));
+  EXPECT_FALSE(BR.isReachable(Blocks[1], Blocks[0]));
+  EXPECT_FALSE(BR.isReachable(Exit, Blocks.back()));
+  EXPECT_FALSE(BR.isInCycle(Blocks[0]));
+  EXPECT_TRUE(BR.isInCycle(Blocks[NumBlocks / 2]));
+}
+
+} // end anonymous namespace
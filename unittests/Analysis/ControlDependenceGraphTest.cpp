@@ -0,0 +1,119 @@
+//===- ControlDependenceGraphTest.cpp - ControlDependenceGraph unit tests -===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/ControlDependenceGraph.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+const char *DiamondAndLoop = "define void @f(i1 %c, i1 %d) {\n"
+                             "entry:\n"
+                             "  br i1 %c, label %then, label %else\n"
+                             "then:\n"
+                             "  br label %join\n"
+                             "else:\n"
+                             "  br label %join\n"
+                             "join:\n"
+                             "  br label %loop\n"
+                             "loop:\n"
+                             "  br i1 %d, label %loop.body, label %exit\n"
+                             "loop.body:\n"
+                             "  br label %loop\n"
+                             "exit:\n"
+                             "  ret void\n"
+                             "}\n";
+
+class ControlDependenceGraphTest : public testing::Test {
+protected:
+  LLVMContext C;
+  std::unique_ptr<Module> M;
+
+  Function *parse(const char *Assembly) {
+    SMDiagnostic Err;
+    M = parseAssemblyString(Assembly, Err, C);
+    if (!M)
+      Err.print("ControlDependenceGraphTest", errs());
+    return M ? M->getFunction("f") : nullptr;
+  }
+
+  static BasicBlock *getBlock(Function &F, StringRef Name) {
+    for (BasicBlock &BB : F)
+      if (BB.getName() == Name)
+        return &BB;
+    llvm_unreachable("Expected to find basic block!");
+  }
+};
+
+TEST_F(ControlDependenceGraphTest, DiamondAndLoop) {
+  Function *F = parse(DiamondAndLoop);
+  ASSERT_TRUE(F);
+  PostDominatorTree PDT;
+  PDT.recalculate(*F);
+  ControlDependenceGraph CDG(*F, PDT);
+
+  BasicBlock *Entry = getBlock(*F, "entry");
+  BasicBlock *Then = getBlock(*F, "then");
+  BasicBlock *Else = getBlock(*F, "else");
+  BasicBlock *Join = getBlock(*F, "join");
+  BasicBlock *Loop = getBlock(*F, "loop");
+  BasicBlock *Body = getBlock(*F, "loop.body");
+  BasicBlock *Exit = getBlock(*F, "exit");
+
+  EXPECT_TRUE(CDG.getControllingBlocks(Entry).empty());
+  EXPECT_TRUE(CDG.getControllingBlocks(Join).empty());
+  EXPECT_TRUE(CDG.getControllingBlocks(Exit).empty());
+  EXPECT_TRUE(CDG.isControlDependent(Then, Entry));
+  EXPECT_TRUE(CDG.isControlDependent(Else, Entry));
+  EXPECT_FALSE(CDG.isControlDependent(Join, Entry));
+
+  // The loop header decides whether it runs again, so it is control dependent
+  // on itself.
+  EXPECT_EQ(1u, CDG.getControllingBlocks(Loop).size());
+  EXPECT_TRUE(CDG.isControlDependent(Loop, Loop));
+  EXPECT_TRUE(CDG.isControlDependent(Body, Loop));
+
+  ArrayRef<BasicBlock *> EntryDeps = CDG.getDependentBlocks(Entry);
+  ASSERT_EQ(2u, EntryDeps.size());
+  EXPECT_EQ(Then, EntryDeps[0]);
+  EXPECT_EQ(Else, EntryDeps[1]);
+  ArrayRef<BasicBlock *> LoopDeps = CDG.getDependentBlocks(Loop);
+  ASSERT_EQ(2u, LoopDeps.size());
+  EXPECT_EQ(Loop, LoopDeps[0]);
+  EXPECT_EQ(Body, LoopDeps[1]);
+  EXPECT_TRUE(CDG.getDependentBlocks(Body).empty());
+}
+
+TEST_F(ControlDependenceGraphTest, InvalidatedWithCFG) {
+  Function *F = parse(DiamondAndLoop);
+  ASSERT_TRUE(F);
+  FunctionAnalysisManager FAM;
+  FAM.registerPass([] { return PostDominatorTreeAnalysis(); });
+  FAM.registerPass([] { return ControlDependenceAnalysis(); });
+
+  FAM.getResult<ControlDependenceAnalysis>(*F);
+  PreservedAnalyses PA;
+  PA.preserveSet<CFGAnalyses>();
+  FAM.invalidate(*F, PA);
+  EXPECT_NE(nullptr, FAM.getCachedResult<ControlDependenceAnalysis>(*F));
+
+  FAM.invalidate(*F, PreservedAnalyses::none());
+  EXPECT_EQ(nullptr, FAM.getCachedResult<ControlDependenceAnalysis>(*F));
+}
+
+} // end anonymous namespace
@@ -0,0 +1,196 @@
+//===- LoopNestingForestTest.cpp - LoopNestingForest unit tests -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/LoopNestingForest.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class LoopNestingForestTest : public testing::Test {
+protected:
+  LLVMContext C;
+  std::unique_ptr<Module> M;
+
+  Function *parse(const char *Assembly) {
+    SMDiagnostic Err;
+    M = parseAssemblyString(Assembly, Err, C);
+    if (!M)
+      Err.print("LoopNestingForestTest", errs());
+    return M ? M->getFunction("f") : nullptr;
+  }
+
+  static BasicBlock *getBlock(Function &F, StringRef Name) {
+    for (BasicBlock &BB : F)
+      if (BB.getName() == Name)
+        return &BB;
+    llvm_unreachable("Expected to find basic block!");
+  }
+};
+
+TEST_F(LoopNestingForestTest, NestedNaturalLoops) {
+  Function *F = parse("define void @f(i1 %c) {\n"
+                      "entry:\n"
+                      "  br label %outer\n"
+                      "outer:\n"
+                      "  br label %inner\n"
+                      "inner:\n"
+                      "  br i1 %c, label %inner.latch, label %outer.latch\n"
+                      "inner.latch:\n"
+                      "  br label %inner\n"
+                      "outer.latch:\n"
+                      "  br i1 %c, label %outer, label %self\n"
+                      "self:\n"
+                      "  br i1 %c, label %self, label %exit\n"
+                      "exit:\n"
+                      "  ret void\n"
+                      "dead:\n"
+                      "  br label %dead\n"
+                      "}\n");
+  ASSERT_TRUE(F);
+  LoopNestingForest LNF(*F);
+
+  BasicBlock *Outer = getBlock(*F, "outer");
+  BasicBlock *Inner = getBlock(*F, "inner");
+  BasicBlock *Self = getBlock(*F, "self");
+
+  EXPECT_EQ(3u, LNF.getNumCycles());
+  EXPECT_EQ(0u, LNF.getNumIrreducibleCycles());
+  EXPECT_EQ(0u, LNF.getNumMultiEntryCycles());
+  ASSERT_EQ(2u, LNF.getTopLevelCycles().size());
+
+  NestedCycle *OuterCycle = LNF.getTopLevelCycles()[0];
+  EXPECT_EQ(Outer, OuterCycle->getHeader());
+  EXPECT_EQ(4u, OuterCycle->getBlocks().size());
+  ASSERT_EQ(1u, OuterCycle->getEntries().size());
+  EXPECT_EQ(Outer, OuterCycle->getEntries()[0]);
+  ASSERT_EQ(1u, OuterCycle->getSubCycles().size());
+
+  NestedCycle *InnerCycle = OuterCycle->getSubCycles()[0];
+  EXPECT_EQ(Inner, InnerCycle->getHeader());
+  EXPECT_EQ(OuterCycle, InnerCycle->getParent());
+  EXPECT_EQ(2u, InnerCycle->getDepth());
+  EXPECT_EQ(2u, InnerCycle->getBlocks().size());
+  ASSERT_EQ(1u, InnerCycle->getEntries().size());
+  EXPECT_EQ(Inner, InnerCycle->getEntries()[0]);
+  EXPECT_EQ(InnerCycle, LNF.getCycleFor(getBlock(*F, "inner.latch")));
+  EXPECT_EQ(OuterCycle, LNF.getCycleFor(getBlock(*F, "outer.latch")));
+  EXPECT_TRUE(OuterCycle->contains(InnerCycle));
+  EXPECT_FALSE(InnerCycle->contains(OuterCycle));
+
+  NestedCycle *SelfCycle = LNF.getTopLevelCycles()[1];
+  EXPECT_EQ(Self, SelfCycle->getHeader());
+  EXPECT_EQ(1u, SelfCycle->getBlocks().size());
+
+  EXPECT_EQ(0u, LNF.getCycleDepth(getBlock(*F, "entry")));
+  EXPECT_EQ(0u, LNF.getCycleDepth(getBlock(*F, "exit")));
+  // Unreachable blocks belong to no cycle.
+  EXPECT_EQ(nullptr, LNF.getCycleFor(getBlock(*F, "dead")));
+}
+
+TEST_F(LoopNestingForestTest, MultiEntryCycle) {
+  Function *F = parse("define void @f(i1 %c) {\n"
+                      "entry:\n"
+                      "  br i1 %c, label %a, label %b\n"
+                      "a:\n"
+                      "  br i1 %c, label %b, label %exit\n"
+                      "b:\n"
+                      "  br i1 %c, label %a, label %exit\n"
+                      "exit:\n"
+                      "  ret void\n"
+                      "}\n");
+  ASSERT_TRUE(F);
+  LoopNestingForest LNF(*F);
+
+  BasicBlock *A = getBlock(*F, "a");
+  BasicBlock *B = getBlock(*F, "b");
+
+  EXPECT_EQ(1u, LNF.getNumCycles());
+  EXPECT_EQ(1u, LNF.getNumIrreducibleCycles());
+  EXPECT_EQ(1u, LNF.getNumMultiEntryCycles());
+
+  NestedCycle *Cycle = LNF.getCycleFor(A);
+  ASSERT_TRUE(Cycle);
+  EXPECT_EQ(Cycle, LNF.getCycleFor(B));
+  EXPECT_TRUE(Cycle->isIrreducible());
+  ASSERT_EQ(2u, Cycle->getEntries().size());
+  EXPECT_EQ(A, Cycle->getEntries()[0]);
+  EXPECT_EQ(B, Cycle->getEntries()[1]);
+}
+
+TEST_F(LoopNestingForestTest, IrreducibleCycleInNaturalLoop) {
+  Function *F = parse("define void @f(i1 %c) {\n"
+                      "entry:\n"
+                      "  br label %header\n"
+                      "header:\n"
+                      "  br i1 %c, label %a, label %b\n"
+                      "a:\n"
+                      "  br i1 %c, label %b, label %latch\n"
+                      "b:\n"
+                      "  br i1 %c, label %a, label %latch\n"
+                      "latch:\n"
+                      "  br i1 %c, label %header, label %exit\n"
+                      "exit:\n"
+                      "  ret void\n"
+                      "}\n");
+  ASSERT_TRUE(F);
+  LoopNestingForest LNF(*F);
+
+  BasicBlock *Header = getBlock(*F, "header");
+  BasicBlock *A = getBlock(*F, "a");
+  BasicBlock *B = getBlock(*F, "b");
+
+  EXPECT_EQ(2u, LNF.getNumCycles());
+  EXPECT_EQ(1u, LNF.getNumIrreducibleCycles());
+  EXPECT_EQ(1u, LNF.getNumMultiEntryCycles());
+  ASSERT_EQ(1u, LNF.getTopLevelCycles().size());
+
+  NestedCycle *Loop = LNF.getTopLevelCycles()[0];
+  EXPECT_EQ(Header, Loop->getHeader());
+  EXPECT_FALSE(Loop->isIrreducible());
+  EXPECT_EQ(4u, Loop->getBlocks().size());
+  ASSERT_EQ(1u, Loop->getEntries().size());
+  EXPECT_EQ(Header, Loop->getEntries()[0]);
+
+  NestedCycle *Inner = LNF.getCycleFor(A);
+  ASSERT_TRUE(Inner);
+  EXPECT_EQ(Loop, Inner->getParent());
+  EXPECT_EQ(Inner, LNF.getCycleFor(B));
+  EXPECT_TRUE(Inner->isIrreducible());
+  ASSERT_EQ(2u, Inner->getEntries().size());
+  EXPECT_EQ(A, Inner->getEntries()[0]);
+  EXPECT_EQ(B, Inner->getEntries()[1]);
+}
+
+TEST_F(LoopNestingForestTest, EntryBlockInCycle) {
+  Function *F = parse("define void @f(i1 %c) {\n"
+                      "entry:\n"
+                      "  br i1 %c, label %entry, label %exit\n"
+                      "exit:\n"
+                      "  ret void\n"
+                      "}\n");
+  ASSERT_TRUE(F);
+  LoopNestingForest LNF(*F);
+
+  BasicBlock *Entry = getBlock(*F, "entry");
+  NestedCycle *Cycle = LNF.getCycleFor(Entry);
+  ASSERT_TRUE(Cycle);
+  EXPECT_FALSE(Cycle->isIrreducible());
+  ASSERT_EQ(1u, Cycle->getEntries().size());
+  EXPECT_EQ(Entry, Cycle->getEntries()[0]);
+}
+
+} // end anonymous namespace
@@ -1095,5 +1095,118 @@ TEST_F(ScalarEvolutionsTest, SCEVExitLimitForgetValue) {
   EXPECT_EQ(cast<SCEVConstant>(NewEC)->getAPInt().getLimitedValue(), 1999u);
 }
 
+// Make sure that forgetting a loop or a value only drops the backedge-taken
+// counts that refer to what was forgotten.
+TEST_F(ScalarEvolutionsTest, SCEVForgetKeepsUnaffectedBackedgeTakenCounts) {
+  LLVMContext C;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(
+      "define void @f(i32 %n, i32 %k) { "
+      "entry: "
+      "  %m = mul i32 %n, %n "
+      "  br label %loop1 "
+      " "
+      "loop1: "
+      "  %i = phi i32 [ 0, %entry ], [ %i.inc, %loop1 ] "
+      "  %i.inc = add nuw i32 %i, 1 "
+      "  %c1 = icmp eq i32 %i.inc, 100 "
+      "  br i1 %c1, label %loop2, label %loop1 "
+      " "
+      "loop2: "
+      "  %j = phi i32 [ 0, %loop1 ], [ %j.inc, %loop2 ] "
+      "  %j.inc = add nuw i32 %j, 1 "
+      "  %c2 = icmp eq i32 %j.inc, %m "
+      "  br i1 %c2, label %exit, label %loop2 "
+      " "
+      "exit: "
+      "  ret void "
+      "} ",
+      Err, C);
+
+  assert(M && "Could not parse module?");
+  assert(!verifyModule(*M) && "Must have been well formed!");
+
+  runWithSE(*M, "f", [&](Function &F, LoopInfo &LI, ScalarEvolution &SE) {
+    auto *C1 = getInstructionByName(F, "c1");
+    auto *C2 = getInstructionByName(F, "c2");
+    Loop *L1 = LI.getLoopFor(C1->getParent());
+    Loop *L2 = LI.getLoopFor(C2->getParent());
+
+    const SCEV *BTC1 = SE.getBackedgeTakenCount(L1);
+    const SCEV *BTC2 = SE.getBackedgeTakenCount(L2);
+    ASSERT_TRUE(isa<SCEVConstant>(BTC1));
+    EXPECT_EQ(cast<SCEVConstant>(BTC1)->getAPInt().getLimitedValue(), 99u);
+    ASSERT_FALSE(isa<SCEVCouldNotCompute>(BTC2));
+
+    // Change both loops, but only tell SCEV about the first one. The count of
+    // the second loop is still the cached one afterwards.
+    Type *I32 = Type::getInt32Ty(C);
+    C1->setOperand(1, ConstantInt::get(I32, 200));
+    Value *K = &*std::next(F.arg_begin());
+    C2->setOperand(1, K);
+    SE.forgetLoop(L1);
+
+    BTC1 = SE.getBackedgeTakenCount(L1);
+    ASSERT_TRUE(isa<SCEVConstant>(BTC1));
+    EXPECT_EQ(cast<SCEVConstant>(BTC1)->getAPInt().getLimitedValue(), 199u);
+    EXPECT_EQ(SE.getBackedgeTakenCount(L2), BTC2);
+
+    // Forgetting a value that the count of the second loop refers to drops
+    // the count.
+    SE.forgetValue(getInstructionByName(F, "m"));
+    EXPECT_EQ(SE.getBackedgeTakenCount(L2),
+              SE.getMinusSCEV(SE.getSCEV(K), SE.getOne(I32)));
+  });
+}
+
+TEST_F(ScalarEvolutionsTest, SCEVForgetRechecksStaleBackedgeTakenCountUsers) {
+  LLVMContext C;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(
+      "define void @f(i32 %n, i32 %k) { "
+      "entry: "
+      "  %m = mul i32 %n, %n "
+      "  br label %loop "
+      " "
+      "loop: "
+      "  %i = phi i32 [ 0, %entry ], [ %i.inc, %loop ] "
+      "  %i.inc = add nuw i32 %i, 1 "
+      "  %c = icmp eq i32 %i.inc, %m "
+      "  br i1 %c, label %exit, label %loop "
+      " "
+      "exit: "
+      "  ret void "
+      "} ",
+      Err, C);
+
+  assert(M && "Could not parse module?");
+  assert(!verifyModule(*M) && "Must have been well formed!");
+
+  runWithSE(*M, "f", [&](Function &F, LoopInfo &LI, ScalarEvolution &SE) {
+    auto *Cmp = getInstructionByName(F, "c");
+    auto *Mul = getInstructionByName(F, "m");
+    Loop *L = LI.getLoopFor(Cmp->getParent());
+    Type *I32 = Type::getInt32Ty(C);
+    Value *K = &*std::next(F.arg_begin());
+
+    // The count refers to %m, which records the loop as a user of %m.
+    const SCEV *BTC = SE.getBackedgeTakenCount(L);
+    EXPECT_EQ(BTC, SE.getMinusSCEV(SE.getSCEV(Mul), SE.getOne(I32)));
+
+    // Drop the count and compute it again without %m. The loop and its exit
+    // stay recorded as users of %m.
+    Cmp->setOperand(1, K);
+    SE.forgetLoop(L);
+    BTC = SE.getBackedgeTakenCount(L);
+    EXPECT_EQ(BTC, SE.getMinusSCEV(SE.getSCEV(K), SE.getOne(I32)));
+
+    // Change the loop again without telling SCEV. Forgetting %m must not drop
+    // the new count or exit limit, which do not refer to %m.
+    Cmp->setOperand(1, ConstantInt::get(I32, 100));
+    SE.forgetValue(Mul);
+    EXPECT_EQ(SE.getBackedgeTakenCount(L), BTC);
+  });
+}
+
 }  // end anonymous namespace
 }  // end namespace llvm
@@ -0,0 +1,148 @@
+//===- SourceLineIndexTest.cpp - SourceLineIndex unit tests ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/SourceLineIndex.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class SourceLineIndexTest : public testing::Test {
+protected:
+  LLVMContext C;
+  std::unique_ptr<Module> M;
+
+  void parse(const char *Assembly) {
+    SMDiagnostic Err;
+    M = parseAssemblyString(Assembly, Err, C);
+    if (!M)
+      Err.print("SourceLineIndexTest", errs());
+  }
+};
+
+// Two functions of a.c and one instruction of b.c. Lines 2 and 3 of a.c are
+// split across blocks, and line 2 is interrupted by an unlocated instruction.
+const char *TwoFilesModule =
+    "define i32 @f(i32 %x) !dbg !4 {\n"
+    "entry:\n"
+    "  %a = add i32 %x, 1, !dbg !10\n"
+    "  %b = add i32 %a, 1, !dbg !10\n"
+    "  %c = add i32 %b, 1\n"
+    "  %d = add i32 %c, 1, !dbg !10\n"
+    "  br label %next, !dbg !11\n"
+    "next:\n"
+    "  %e = mul i32 %d, 2, !dbg !11\n"
+    "  %g = mul i32 %e, 2, !dbg !12\n"
+    "  ret i32 %g, !dbg !11\n"
+    "}\n"
+    "define i32 @h(i32 %x) !dbg !7 {\n"
+    "entry:\n"
+    "  %a = add i32 %x, 1, !dbg !13\n"
+    "  ret i32 %a, !dbg !13\n"
+    "}\n"
+    "define void @nodebug() {\n"
+    "  ret void\n"
+    "}\n"
+    "!llvm.dbg.cu = !{!0}\n"
+    "!llvm.module.flags = !{!3}\n"
+    "!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, "
+    "emissionKind: FullDebug)\n"
+    "!1 = !DIFile(filename: \"a.c\", directory: \"/\")\n"
+    "!2 = !DIFile(filename: \"b.c\", directory: \"/\")\n"
+    "!3 = !{i32 2, !\"Debug Info Version\", i32 3}\n"
+    "!4 = distinct !DISubprogram(name: \"f\", scope: !1, file: !1, line: 1, "
+    "unit: !0)\n"
+    "!5 = distinct !DISubprogram(name: \"g\", scope: !2, file: !2, line: 1, "
+    "unit: !0)\n"
+    "!7 = distinct !DISubprogram(name: \"h\", scope: !1, file: !1, line: 9, "
+    "unit: !0)\n"
+    "!10 = !DILocation(line: 2, scope: !4)\n"
+    "!11 = !DILocation(line: 3, scope: !4)\n"
+    "!12 = !DILocation(line: 5, scope: !5, inlinedAt: !11)\n"
+    "!13 = !DILocation(line: 10, scope: !7)\n";
+
+TEST_F(SourceLineIndexTest, RangesInModuleOrder) {
+  parse(TwoFilesModule);
+  ASSERT_TRUE(M);
+  SourceLineIndex Index(*M);
+
+  ASSERT_EQ(2u, Index.getFiles().size());
+  EXPECT_EQ("a.c", Index.getFiles()[0]);
+  EXPECT_EQ("b.c", Index.getFiles()[1]);
+  EXPECT_EQ(-1, Index.getFileNumber("c.c"));
+
+  Function *F = M->getFunction("f");
+  ArrayRef<SourceLineIndex::LineRange> Ranges = Index.ranges(*F);
+  ASSERT_EQ(6u, Ranges.size());
+  // %a and %b are folded, %c has no location and ends the range.
+  EXPECT_EQ(2u, Ranges[0].Line);
+  EXPECT_EQ(2u, Ranges[0].NumInstructions);
+  EXPECT_EQ("a", Ranges[0].First->getName());
+  EXPECT_EQ("b", Ranges[0].getLast()->getName());
+  EXPECT_EQ(2u, Ranges[1].Line);
+  EXPECT_EQ("d", Ranges[1].First->getName());
+  EXPECT_EQ(3u, Ranges[2].Line);
+  EXPECT_TRUE(isa<BranchInst>(Ranges[2].First));
+  // Ranges do not span blocks.
+  EXPECT_EQ(3u, Ranges[3].Line);
+  EXPECT_EQ("e", Ranges[3].First->getName());
+  // The inlined instruction is attributed to its own file.
+  EXPECT_EQ(1u, Ranges[4].File);
+  EXPECT_EQ(5u, Ranges[4].Line);
+  EXPECT_EQ(3u, Ranges[5].Line);
+
+  EXPECT_EQ(1u, Index.ranges(*M->getFunction("h")).size());
+  EXPECT_TRUE(Index.ranges(*M->getFunction("nodebug")).empty());
+  EXPECT_EQ(7u, Index.ranges().size());
+}
+
+TEST_F(SourceLineIndexTest, Lookup) {
+  parse(TwoFilesModule);
+  ASSERT_TRUE(M);
+  SourceLineIndex Index(*M);
+
+  ArrayRef<const SourceLineIndex::LineRange *> Line2 = Index.lookup("a.c", 2);
+  ASSERT_EQ(2u, Line2.size());
+  EXPECT_EQ("a", Line2[0]->First->getName());
+  EXPECT_EQ("d", Line2[1]->First->getName());
+
+  EXPECT_EQ(3u, Index.lookup("a.c", 3).size());
+  EXPECT_TRUE(Index.lookup("a.c", 5).empty());
+  EXPECT_EQ(1u, Index.lookup("b.c", 5).size());
+  EXPECT_TRUE(Index.lookup("c.c", 2).empty());
+
+  // Lines [3, 11) of a.c, sorted by line.
+  ArrayRef<const SourceLineIndex::LineRange *> Lines =
+      Index.lookup("a.c", 3, 11);
+  ASSERT_EQ(4u, Lines.size());
+  EXPECT_EQ(3u, Lines[2]->Line);
+  EXPECT_EQ(10u, Lines[3]->Line);
+  EXPECT_EQ(M->getFunction("h"), Lines[3]->First->getFunction());
+}
+
+TEST_F(SourceLineIndexTest, GetLine) {
+  parse(TwoFilesModule);
+  ASSERT_TRUE(M);
+
+  BasicBlock &Entry = M->getFunction("f")->getEntryBlock();
+  auto I = Entry.begin();
+  EXPECT_EQ(2u, SourceLineIndex::getLine(*I));
+  std::advance(I, 2);
+  EXPECT_EQ(0u, SourceLineIndex::getLine(*I));
+}
+
+} // end anonymous namespace
@@ -8,12 +8,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Analysis/KnownBitsCache.h"
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/KnownBits.h"
 #include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
 
@@ -258,3 +260,49 @@ TEST(ValueTracking, ComputeNumSignBits_PR32045) {
       cast<ReturnInst>(F->getEntryBlock().getTerminator())->getOperand(0);
   EXPECT_EQ(ComputeNumSignBits(RVal, M->getDataLayout()), 1u);
 }
+
+TEST(ValueTracking, KnownBitsCache) {
+  StringRef Assembly = "define i32 @f(i32 %a, i32 %b) { "
+                       "  %x = and i32 %a, 255 "
+                       "  %y = shl i32 %b, 8 "
+                       "  %z = or i32 %x, %y "
+                       "  %s = ashr i32 %z, 4 "
+                       "  ret i32 %z "
+                       "} ";
+
+  LLVMContext Context;
+  SMDiagnostic Error;
+  auto M = parseAssemblyString(Assembly, Error, Context);
+  assert(M && "Bad assembly?");
+
+  auto *F = M->getFunction("f");
+  assert(F && "Bad assembly?");
+  const DataLayout &DL = M->getDataLayout();
+
+  auto I = inst_begin(F);
+  Instruction *X = &*I++;
+  ++I;
+  Instruction *Z = &*I++;
+  Instruction *S = &*I++;
+
+  // The cache doesn't change the answers, and keeps the answers for the
+  // values the query looked through.
+  KnownBitsCache Cache;
+  KnownBits Uncached = computeKnownBits(Z, DL);
+  KnownBits Cached = computeKnownBits(Z, DL, 0, nullptr, nullptr, nullptr,
+                                      nullptr, &Cache);
+  EXPECT_EQ(Uncached.Zero, Cached.Zero);
+  EXPECT_EQ(Uncached.One, Cached.One);
+  const KnownBits *XKnown = Cache.lookupKnownBits(X, Z, 1);
+  ASSERT_NE(nullptr, XKnown);
+  EXPECT_EQ(0xffffff00u, XKnown->Zero.getZExtValue());
+
+  EXPECT_EQ(ComputeNumSignBits(S, DL),
+            ComputeNumSignBits(S, DL, 0, nullptr, nullptr, nullptr, &Cache));
+  EXPECT_NE(0u, Cache.lookupNumSignBits(S, S, 0));
+
+  // Deleting a value the cache has seen empties it.
+  EXPECT_FALSE(Cache.empty());
+  S->eraseFromParent();
+  EXPECT_TRUE(Cache.empty());
+}
@@ -46,6 +46,34 @@ TEST(AsmParserTest, NonNullTerminatedInput) {
 #endif
 #endif
 
+TEST(AsmParserTest, CommentsAndQuotedNames) {
+  LLVMContext Ctx;
+  const char Text[] = "; comment with a \0 in it\r\n"
+                      "@\"quoted \\22name\\22\" = global [3 x i8] c\"a\\00b\"\n"
+                      "define float @f(float %x) { ; trailing comment\n"
+                      "  %\"y z\" = fadd float %x, 1.0\n"
+                      "  ret float %\"y z\"\n"
+                      "}";
+  SMDiagnostic Error;
+  auto Mod = parseAssemblyString(StringRef(Text, sizeof(Text) - 1), Error, Ctx);
+
+  ASSERT_TRUE(Mod != nullptr);
+  EXPECT_TRUE(Error.getMessage().empty());
+  auto *GV = Mod->getNamedGlobal("quoted \"name\"");
+  ASSERT_TRUE(GV != nullptr);
+  EXPECT_EQ(StringRef("a\0b", 3),
+            cast<ConstantDataArray>(GV->getInitializer())->getAsString());
+  Function *F = Mod->getFunction("f");
+  ASSERT_TRUE(F != nullptr);
+  EXPECT_TRUE(F->getReturnType()->isFloatTy());
+  EXPECT_EQ("y z", F->getEntryBlock().front().getName());
+  EXPECT_EQ(Instruction::FAdd, F->getEntryBlock().front().getOpcode());
+
+  // Unterminated names and strings run into the end of the buffer.
+  EXPECT_FALSE(parseAssemblyString("@\"g = global i8 0", Error, Ctx));
+  EXPECT_FALSE(parseAssemblyString("@g = global [1 x i8] c\"a", Error, Ctx));
+}
+
 TEST(AsmParserTest, SlotMappingTest) {
   LLVMContext Ctx;
   StringRef Source = "@0 = global i32 0\n !0 = !{}\n !42 = !{i32 42}";
@@ -195,4 +195,103 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddrInFunctionAfter) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+// Tests that a module reads the same when its function blocks are decoded on
+// other threads.
+TEST(BitReaderTest, MaterializeWithReaderThreads) {
+  const char *Assembly =
+      "@table = constant i8* blockaddress(@func, %bb)\n"
+      "@g = global i32 7\n"
+      "define i32 @f(i32 %x) {\n"
+      "entry:\n"
+      "  br label %loop\n"
+      "loop:\n"
+      "  %i = phi i32 [ 0, %entry ], [ %next, %loop ]\n"
+      "  %next = add nsw i32 %i, %x\n"
+      "  %v = load i32, i32* @g, !tbaa !0\n"
+      "  %c = icmp slt i32 %next, %v\n"
+      "  br i1 %c, label %loop, label %exit\n"
+      "exit:\n"
+      "  %s = select i1 %c, i32 %i, i32 ptrtoint (i32* @g to i32)\n"
+      "  ret i32 %s\n"
+      "}\n"
+      "define void @func() {\n"
+      "  unreachable\n"
+      "bb:\n"
+      "  unreachable\n"
+      "}\n"
+      "define i8* @h() {\n"
+      "  %r = call i32 @f(i32 3)\n"
+      "  ret i8* getelementptr (i8, i8* bitcast (i32* @g to i8*), i64 2)\n"
+      "}\n"
+      "!0 = !{!1, !1, i64 0}\n"
+      "!1 = !{!\"int\", !2, i64 0}\n"
+      "!2 = !{!\"tbaa root\"}\n";
+
+  auto readModule = [&](LLVMContext &Context, SmallString<1024> &Mem,
+                        unsigned Threads) {
+    std::unique_ptr<Module> M =
+        getLazyModuleFromAssembly(Context, Mem, Assembly);
+    setBitcodeReaderThreads(Threads);
+    EXPECT_FALSE(M->materializeAll());
+    setBitcodeReaderThreads(0);
+    EXPECT_FALSE(verifyModule(*M, &dbgs()));
+    std::string Printed;
+    raw_string_ostream OS(Printed);
+    M->print(OS, nullptr);
+    return OS.str();
+  };
+
+  SmallString<1024> SerialMem, ParallelMem;
+  LLVMContext SerialContext, ParallelContext;
+  EXPECT_EQ(readModule(SerialContext, SerialMem, 0),
+            readModule(ParallelContext, ParallelMem, 4));
+}
+
+// Tests that encoding function blocks on several threads gives the same bytes.
+TEST(BitReaderTest, WriteWithWriterThreads) {
+  LLVMContext Context;
+  std::unique_ptr<Module> M = parseAssembly(
+      Context, "@table = constant i8* blockaddress(@func, %bb)\n"
+               "@g = global i32 7\n"
+               "define i32 @f(i32 %x) {\n"
+               "entry:\n"
+               "  %a = add i32 %x, 1\n"
+               "  %b = mul i32 %x, %a\n"
+               "  %c = icmp slt i32 %b, %x\n"
+               "  %v = load i32, i32* @g, !tbaa !0\n"
+               "  %s = select i1 %c, i32 %v, i32 ptrtoint (i32* @g to i32)\n"
+               "  ret i32 %s\n"
+               "  uselistorder i32 %x, { 2, 0, 1 }\n"
+               "}\n"
+               "define void @func() {\n"
+               "  unreachable\n"
+               "bb:\n"
+               "  unreachable\n"
+               "}\n"
+               "declare void @decl()\n"
+               "define i32 @h() {\n"
+               "  call void @decl()\n"
+               "  %r = call i32 @f(i32 3)\n"
+               "  %q = call i32 @f(i32 %r)\n"
+               "  ret i32 %q\n"
+               "}\n"
+               "!0 = !{!1, !1, i64 0}\n"
+               "!1 = !{!\"int\", !2, i64 0}\n"
+               "!2 = !{!\"tbaa root\"}\n");
+
+  auto writeModule = [&](unsigned Threads) {
+    SmallString<1024> Mem;
+    raw_svector_ostream OS(Mem);
+    setBitcodeWriterThreads(Threads);
+    WriteBitcodeToFile(M.get(), OS, /*ShouldPreserveUseListOrder=*/true,
+                       /*Index=*/nullptr, /*GenerateHash=*/true);
+    setBitcodeWriterThreads(0);
+    return Mem.str().str();
+  };
+
+  std::string Serial = writeModule(0);
+  EXPECT_EQ(Serial, writeModule(3));
+  EXPECT_EQ(Serial, writeModule(8));
+}
+
 } // end namespace
@@ -140,6 +140,119 @@ TEST(BitstreamReaderTest, readRecordWithBlobWhileStreaming) {
   }
 }
 
+TEST(BitstreamReaderTest, recordAndReplayBlock) {
+  const unsigned Magic = 0x12345678;
+  const unsigned BlockID = bitc::FIRST_APPLICATION_BLOCKID;
+  const unsigned RecordID = 1;
+  const uint64_t Ops[] = {2, 3, 4};
+  StringRef BlobIn = "blob";
+
+  // Write a block holding a record, two nested blocks and a record with a
+  // blob, then a record after the block.
+  SmallVector<char, 64> Buffer;
+  unsigned BlobAbbrevID;
+  {
+    BitstreamWriter Stream(Buffer);
+    Stream.Emit(Magic, 32);
+    Stream.EnterSubblock(BlockID, 3);
+    auto Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(RecordID));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    BlobAbbrevID = Stream.EmitAbbrev(std::move(Abbrev));
+    Stream.EmitRecord(RecordID, makeArrayRef(Ops));
+    Stream.EnterSubblock(BlockID + 1, 3);
+    Stream.EmitRecord(RecordID, makeArrayRef(Ops).slice(1));
+    Stream.ExitBlock();
+    Stream.EnterSubblock(BlockID + 2, 3);
+    Stream.EmitRecord(RecordID, makeArrayRef(Ops).slice(2));
+    Stream.ExitBlock();
+    unsigned Record[] = {RecordID};
+    Stream.EmitRecordWithBlob(BlobAbbrevID, makeArrayRef(Record), BlobIn);
+    Stream.ExitBlock();
+    Stream.EmitRecord(RecordID + 1, makeArrayRef(Ops));
+  }
+  ArrayRef<uint8_t> Bytes((const uint8_t *)Buffer.begin(), Buffer.size());
+
+  // Record the block.
+  BitstreamCursor Recorder(Bytes);
+  ASSERT_EQ(Magic, Recorder.Read(32));
+  BitstreamEntry Entry = Recorder.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  BitstreamRecording Recording;
+  ASSERT_FALSE(Recorder.recordBlock(BlockID, Recording));
+  uint64_t EndBitNo = Recorder.GetCurrentBitNo();
+
+  // Replay it on another cursor, skipping the second nested block.
+  BitstreamCursor Stream(Bytes);
+  ASSERT_EQ(Magic, Stream.Read(32));
+  Entry = Stream.advance();
+  Stream.replay(Recording);
+  EXPECT_TRUE(Stream.isReplaying());
+  EXPECT_EQ(EndBitNo, Stream.GetCurrentBitNo());
+  ASSERT_FALSE(Stream.EnterSubBlock(BlockID));
+
+  SmallVector<uint64_t, 4> Record;
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+  EXPECT_EQ(RecordID, Stream.readRecord(Entry.ID, Record));
+  EXPECT_EQ(makeArrayRef(Ops), makeArrayRef(Record));
+
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  ASSERT_EQ(BlockID + 1, Entry.ID);
+  ASSERT_FALSE(Stream.EnterSubBlock(BlockID + 1));
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+  Record.clear();
+  EXPECT_EQ(RecordID, Stream.readRecord(Entry.ID, Record));
+  EXPECT_EQ(makeArrayRef(Ops).slice(1), makeArrayRef(Record));
+  EXPECT_EQ(BitstreamEntry::EndBlock, Stream.advance().Kind);
+
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  ASSERT_EQ(BlockID + 2, Entry.ID);
+  ASSERT_FALSE(Stream.SkipBlock());
+
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+  ASSERT_EQ(BlobAbbrevID, Entry.ID);
+  StringRef BlobOut;
+  Record.clear();
+  EXPECT_EQ(RecordID, Stream.readRecord(Entry.ID, Record, &BlobOut));
+  EXPECT_TRUE(Record.empty());
+  EXPECT_EQ(BlobIn, BlobOut);
+
+  // The end of the block ends the replay, and the stream goes on after it.
+  EXPECT_EQ(BitstreamEntry::EndBlock, Stream.advance().Kind);
+  EXPECT_FALSE(Stream.isReplaying());
+  EXPECT_EQ(EndBitNo, Stream.GetCurrentBitNo());
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+  Record.clear();
+  EXPECT_EQ(RecordID + 1, Stream.readRecord(Entry.ID, Record));
+  EXPECT_EQ(makeArrayRef(Ops), makeArrayRef(Record));
+
+  // Replay it again, skipping records and nested blocks. Without a place to
+  // put the blob, its bytes become operands.
+  Stream.JumpToBit(32);
+  Entry = Stream.advance();
+  Stream.replay(Recording);
+  ASSERT_FALSE(Stream.EnterSubBlock(BlockID));
+  Entry = Stream.advanceSkippingSubblocks();
+  ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+  EXPECT_EQ(RecordID, Stream.skipRecord(Entry.ID));
+  Entry = Stream.advanceSkippingSubblocks();
+  ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+  ASSERT_EQ(BlobAbbrevID, Entry.ID);
+  Record.clear();
+  EXPECT_EQ(RecordID, Stream.readRecord(Entry.ID, Record));
+  ASSERT_EQ(BlobIn.size(), Record.size());
+  EXPECT_EQ(uint64_t('b'), Record.front());
+  EXPECT_EQ(BitstreamEntry::EndBlock, Stream.advance().Kind);
+  EXPECT_FALSE(Stream.isReplaying());
+  EXPECT_EQ(EndBitNo, Stream.GetCurrentBitNo());
+}
+
 TEST(BitstreamReaderTest, shortRead) {
   uint8_t Bytes[] = {8, 7, 6, 5, 4, 3, 2, 1};
   for (unsigned I = 1; I != 8; ++I) {
@@ -56,4 +56,48 @@ TEST(BitstreamWriterTest, emitBlob4ByteAligned) {
   EXPECT_EQ(StringRef("str0"), Buffer);
 }
 
+TEST(BitstreamWriterTest, emitSubblockBody) {
+  auto Abbv = std::make_shared<BitCodeAbbrev>();
+  Abbv->Add(BitCodeAbbrevOp(1));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+  auto writeBlock = [](BitstreamWriter &W) {
+    W.EmitRecord(1, ArrayRef<unsigned>{42}, bitc::FIRST_APPLICATION_ABBREV);
+    W.EnterSubblock(9, 3);
+    W.EmitRecord(2, ArrayRef<unsigned>{1, 2, 3});
+    W.ExitBlock();
+  };
+
+  SmallString<64> Expected;
+  {
+    BitstreamWriter W(Expected);
+    W.EnterBlockInfoBlock();
+    W.EmitBlockInfoAbbrev(8, Abbv);
+    W.ExitBlock();
+    W.Emit(5, 7);
+    W.EnterSubblock(8, 4);
+    writeBlock(W);
+    W.ExitBlock();
+  }
+
+  SmallString<64> Buffer;
+  {
+    BitstreamWriter W(Buffer);
+    W.EnterBlockInfoBlock();
+    W.EmitBlockInfoAbbrev(8, Abbv);
+    W.ExitBlock();
+    W.Emit(5, 7);
+
+    SmallString<64> Body;
+    {
+      BitstreamWriter BodyWriter(Body);
+      BodyWriter.CopyBlockInfo(W);
+      BodyWriter.EnterSubblockBody(8, 4);
+      writeBlock(BodyWriter);
+      BodyWriter.ExitBlock();
+    }
+    W.EmitSubblockBody(8, 4, Body);
+  }
+  EXPECT_EQ(StringRef(Expected), Buffer);
+}
+
 } // end namespace
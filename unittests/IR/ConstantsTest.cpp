@@ -10,13 +10,18 @@
 #include "llvm/IR/Constants.h"
 #include "llvm-c/Core.h"
 #include "llvm/AsmParser/Parser.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
+#include <thread>
 
 namespace llvm {
 namespace {
@@ -477,5 +482,121 @@ TEST(ConstantsTest, BitcastToGEP) {
             Instruction::BitCast);
 }
 
+#if LLVM_ENABLE_THREADS
+TEST(ConstantsTest, ConcurrentUniquing) {
+  LLVMContext Context;
+  Context.setConcurrentUniquing(true);
+
+  // Every thread creates the same objects, in a different order.
+  const unsigned NumThreads = 4, NumValues = 500, NumObjects = 8;
+  std::vector<std::vector<const void *>> Objects(
+      NumThreads, std::vector<const void *>(NumValues * NumObjects));
+  auto Create = [&](unsigned Thread) {
+    for (unsigned N = 0; N != NumValues; ++N) {
+      unsigned V = Thread % 2 ? NumValues - 1 - N : N;
+      const void **Slot = &Objects[Thread][V * NumObjects];
+      auto *IntTy = IntegerType::get(Context, V % 64 + 1);
+      auto *ArrayTy = ArrayType::get(IntTy, V % 7);
+      auto *StructTy = StructType::get(IntTy, ArrayTy);
+      auto *C = ConstantInt::get(Type::getInt64Ty(Context), V);
+      uint8_t Data[] = {uint8_t(V), uint8_t(V >> 8), 1};
+      Slot[0] = ArrayTy;
+      Slot[1] = PointerType::get(StructTy, V % 3);
+      Slot[2] = C;
+      Slot[3] = ConstantFP::get(Type::getDoubleTy(Context), V);
+      Slot[4] = ConstantAggregateZero::get(StructTy);
+      Slot[5] = ConstantDataArray::get(Context, Data);
+      Slot[6] = MDString::get(Context, std::to_string(V));
+      Slot[7] = MDTuple::get(Context, {ConstantAsMetadata::get(C),
+                                       MDString::get(Context, "x")});
+    }
+  };
+  std::vector<std::thread> Threads;
+  for (unsigned Thread = 1; Thread != NumThreads; ++Thread)
+    Threads.emplace_back(Create, Thread);
+  Create(0);
+  for (std::thread &T : Threads)
+    T.join();
+
+  for (unsigned Thread = 1; Thread != NumThreads; ++Thread)
+    EXPECT_EQ(Objects[0], Objects[Thread]);
+
+  // The tables stay usable once the threads are done.
+  Context.setConcurrentUniquing(false);
+  EXPECT_EQ(Objects[0][2 * NumObjects + 2],
+            ConstantInt::get(Type::getInt64Ty(Context), 2));
+  EXPECT_EQ(Objects[0][2 * NumObjects + 6], MDString::get(Context, "2"));
+}
+
+TEST(ConstantsTest, ConcurrentUniquingSharedOperands) {
+  LLVMContext Context;
+  Module M("m", Context);
+  auto *Int32Ty = Type::getInt32Ty(Context);
+  auto *ArrayTy = ArrayType::get(Int32Ty, 4);
+  auto *G = new GlobalVariable(M, ArrayTy, false, GlobalValue::ExternalLinkage,
+                               nullptr, "g");
+  auto *Shared = ConstantInt::get(Int32Ty, 1000);
+  TempMDTuple Temp = MDTuple::getTemporary(Context, None);
+  Context.setConcurrentUniquing(true);
+
+  // Every thread creates the same users of the shared global, integer and
+  // temporary node, in a different order, through different tables.
+  const unsigned NumThreads = 4, NumValues = 200, NumObjects = 6;
+  std::vector<std::vector<const void *>> Objects(
+      NumThreads, std::vector<const void *>(NumValues * NumObjects));
+  auto Create = [&](unsigned Thread) {
+    for (unsigned N = 0; N != NumValues; ++N) {
+      unsigned V = Thread % 2 ? NumValues - 1 - N : N;
+      const void **Slot = &Objects[Thread][V * NumObjects];
+      Constant *Indices[] = {ConstantInt::get(Int32Ty, 0),
+                             ConstantInt::get(Int32Ty, V % 4)};
+      auto *GEP = ConstantExpr::getInBoundsGetElementPtr(ArrayTy, G, Indices);
+      auto *Cast =
+          ConstantExpr::getPtrToInt(G, IntegerType::get(Context, V % 64 + 1));
+      Slot[0] = GEP;
+      Slot[1] = Cast;
+      Slot[2] = ConstantStruct::getAnon({GEP, ConstantInt::get(Int32Ty, V)});
+      Slot[3] = ConstantStruct::getAnon({Shared, Cast});
+      Slot[4] =
+          MDTuple::get(Context, {ConstantAsMetadata::get(GEP), Temp.get()});
+      Slot[5] = DIDerivedType::get(Context, dwarf::DW_TAG_pointer_type, nullptr,
+                                   nullptr, V, nullptr, Temp.get(), 64, 0, 0,
+                                   None, DINode::FlagZero,
+                                   ConstantAsMetadata::get(Cast));
+    }
+  };
+  std::vector<std::thread> Threads;
+  for (unsigned Thread = 1; Thread != NumThreads; ++Thread)
+    Threads.emplace_back(Create, Thread);
+  Create(0);
+  for (std::thread &T : Threads)
+    T.join();
+  Context.setConcurrentUniquing(false);
+
+  for (unsigned Thread = 1; Thread != NumThreads; ++Thread)
+    EXPECT_EQ(Objects[0], Objects[Thread]);
+
+  // No use was lost: the global has 4 GEPs and 64 casts, the GEPs have a
+  // struct each for every value, and the shared integer a struct per cast.
+  EXPECT_EQ(68u, G->getNumUses());
+  unsigned GEPUses = 0;
+  for (const User *U : G->users())
+    if (isa<GEPOperator>(U))
+      GEPUses += U->getNumUses();
+  EXPECT_EQ(NumValues, GEPUses);
+  EXPECT_EQ(64u, Shared->getNumUses());
+
+  // Every node tracks the temporary, so they all see it replaced.
+  MDTuple *Resolved = MDTuple::getDistinct(Context, None);
+  Temp->replaceAllUsesWith(Resolved);
+  for (unsigned V = 0; V != NumValues; ++V) {
+    const void *const *Slot = &Objects[0][V * NumObjects];
+    EXPECT_EQ(Resolved, static_cast<const MDTuple *>(Slot[4])->getOperand(1));
+    EXPECT_EQ(Resolved,
+              static_cast<const DIDerivedType *>(Slot[5])->getRawBaseType());
+  }
+}
+#endif
+
 }  // end anonymous namespace
 }  // end namespace llvm
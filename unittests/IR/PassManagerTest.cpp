@@ -11,9 +11,16 @@
 #include "llvm/AsmParser/Parser.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/AllocationTracker.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
+#include <atomic>
+#include <cstdlib>
 
 using namespace llvm;
 
@@ -516,6 +523,70 @@ TEST_F(PassManagerTest, Basic) {
   EXPECT_EQ(1, ModuleAnalysisRuns);
 }
 
+TEST_F(PassManagerTest, ParallelFunctionPasses) {
+  FunctionAnalysisManager FAM;
+  int FunctionAnalysisRuns = 0;
+  FAM.registerPass([&] { return TestFunctionAnalysis(FunctionAnalysisRuns); });
+
+  ModuleAnalysisManager MAM;
+  int ModuleAnalysisRuns = 0;
+  MAM.registerPass([&] { return TestModuleAnalysis(ModuleAnalysisRuns); });
+  MAM.registerPass([&] { return FunctionAnalysisManagerModuleProxy(FAM); });
+  FAM.registerPass([&] { return ModuleAnalysisManagerFunctionProxy(MAM); });
+
+  ModulePassManager MPM;
+
+  // Cache the analysis of every function in the shared manager.
+  MPM.addPass(createModuleToFunctionPassAdaptor(
+      RequireAnalysisPass<TestFunctionAnalysis, Function>()));
+
+  // Run in parallel with private managers, and invalidate 'f'.
+  std::atomic<int> ThreadSetups(0), FunctionPassRunCount(0),
+      AnalyzedInstrCount(0), ThreadAnalysisRuns(0);
+  auto ThreadSetup = [&](
+      ModuleAnalysisManager &MAM,
+      function_ref<void(FunctionPassManager &, FunctionAnalysisManager &)>
+          Run) {
+    int RunCount = 0, InstrCount = 0, FunctionCount = 0, AnalysisRuns = 0;
+    FunctionAnalysisManager ThreadFAM;
+    ThreadFAM.registerPass([&] { return TestFunctionAnalysis(AnalysisRuns); });
+    ThreadFAM.registerPass(
+        [&] { return ModuleAnalysisManagerFunctionProxy(MAM); });
+    FunctionPassManager FPM;
+    FPM.addPass(TestFunctionPass(RunCount, InstrCount, FunctionCount));
+    FPM.addPass(TestInvalidationFunctionPass("f"));
+    Run(FPM, ThreadFAM);
+
+    ++ThreadSetups;
+    FunctionPassRunCount += RunCount;
+    AnalyzedInstrCount += InstrCount;
+    ThreadAnalysisRuns += AnalysisRuns;
+  };
+  MPM.addPass(ModuleToFunctionPassAdaptor<FunctionPassManager>(
+      FunctionPassManager(), 2, ThreadSetup));
+
+  // Only the results of 'g' and 'h' are still cached in the shared manager.
+  int CachedRunCount = 0, CachedInstrCount = 0, CachedFunctionCount = 0;
+  {
+    FunctionPassManager FPM;
+    FPM.addPass(TestFunctionPass(CachedRunCount, CachedInstrCount,
+                                 CachedFunctionCount,
+                                 /*OnlyUseCachedResults=*/true));
+    MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
+  }
+
+  MPM.run(*M, MAM);
+
+  EXPECT_EQ(2, ThreadSetups);
+  EXPECT_EQ(3, FunctionPassRunCount);
+  EXPECT_EQ(5, AnalyzedInstrCount);
+  EXPECT_EQ(3, ThreadAnalysisRuns);
+  EXPECT_EQ(3, FunctionAnalysisRuns);
+  EXPECT_EQ(3, CachedRunCount);
+  EXPECT_EQ(2, CachedInstrCount);
+  EXPECT_FALSE(Context.hasConcurrentUniquing());
+}
+
 // A customized pass manager that passes extra arguments through the
 // infrastructure.
 typedef AnalysisManager<Function, int> CustomizedAnalysisManager;
@@ -672,6 +743,51 @@ struct LambdaPass : public PassInfoMixin<LambdaPass> {
   FuncT Func;
 };
 
+TEST_F(PassManagerTest, PassMemoryReport) {
+  SmallString<128> ReportPath;
+  ASSERT_FALSE(
+      sys::fs::createTemporaryFile("pass-memory", "txt", ReportPath));
+  std::string OutputFileArg = ("-info-output-file=" + ReportPath).str();
+  const char *Args[] = {"PassManagerTest", "-track-pass-memory",
+                        OutputFileArg.c_str()};
+  ASSERT_TRUE(cl::ParseCommandLineOptions(3, Args));
+
+  // Report the blocks to the tracker directly, so that the test does not
+  // depend on the operator new hook.
+  FunctionAnalysisManager FAM;
+  FunctionPassManager FPM;
+  FPM.addPass(LambdaPass([](Function &F, FunctionAnalysisManager &AM) {
+    void *Ptr = std::malloc(100);
+    AllocationTracker::noteAllocation(Ptr);
+    AllocationTracker::noteDeallocation(Ptr);
+    std::free(Ptr);
+    return PreservedAnalyses::all();
+  }));
+  for (Function &F : *M)
+    FPM.run(F, FAM);
+  reportAndResetTimings();
+
+  cl::ResetAllOptionOccurrences();
+  const char *ResetArgs[] = {"PassManagerTest", "-track-pass-memory=false",
+                             "-info-output-file=-"};
+  ASSERT_TRUE(cl::ParseCommandLineOptions(3, ResetArgs));
+
+  auto Report = MemoryBuffer::getFile(ReportPath);
+  sys::fs::remove(ReportPath);
+  ASSERT_TRUE(bool(Report));
+  StringRef Text = (*Report)->getBuffer();
+  EXPECT_TRUE(Text.contains("Pass memory usage report"));
+  EXPECT_TRUE(Text.contains("Total: 3 allocations"));
+
+  // The pass has a row of its own, which starts with its allocation count.
+  SmallVector<StringRef, 8> Lines;
+  Text.split(Lines, '\n');
+  auto Row =
+      find_if(Lines, [](StringRef L) { return L.contains("LambdaPass"); });
+  ASSERT_NE(Lines.end(), Row);
+  EXPECT_TRUE(Row->ltrim().startswith("3 "));
+}
+
 TEST_F(PassManagerTest, IndirectAnalysisInvalidation) {
   FunctionAnalysisManager FAM(/*DebugLogging*/ true);
   int FunctionAnalysisRuns = 0, ModuleAnalysisRuns = 0,
@@ -9,7 +9,9 @@
 
 #include "llvm/IR/User.h"
 #include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/InstructionArena.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -142,4 +144,67 @@ TEST(UserTest, PersonalityUser) {
   EXPECT_TRUE(TestF->user_empty());
 }
 
+TEST(UserTest, ArenaAllocation) {
+  LLVMContext C;
+  const char *ModuleString = "declare void @g()\n"
+                             "define i32 @f(i32 %x) {\n"
+                             "entry:\n"
+                             "  br label %exit\n"
+                             "exit:\n"
+                             "  %p = phi i32 [ %x, %entry ]\n"
+                             "  ret i32 %p\n"
+                             "}\n"
+                             "define void @h() {\n"
+                             "  ret void\n"
+                             "}\n";
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(ModuleString, Err, C);
+  Function *F = M->getFunction("f");
+  Function *G = M->getFunction("g");
+  Function *H = M->getFunction("h");
+  BasicBlock &Entry = F->getEntryBlock();
+  auto *Phi = cast<PHINode>(&F->back().front());
+  Argument *X = &*F->arg_begin();
+
+  InstructionArena::setEnabled(true);
+  {
+    InstructionArenaScope Scope(*F);
+
+    // Fixed operands, and operands with a descriptor.
+    auto *Add = BinaryOperator::CreateAdd(X, X, "add", Entry.getTerminator());
+    OperandBundleDef Bundle("deopt", std::vector<Value *>{X, Add});
+    auto *Call = CallInst::Create(G, None, Bundle, "", Entry.getTerminator());
+    EXPECT_EQ(Add, Call->getOperandBundleAt(0).Inputs[1]);
+
+    // Hung off operands of an arena instruction, and of a heap one.
+    PHINode *NewPhi = PHINode::Create(X->getType(), 1, "q", Phi);
+    for (unsigned I = 0; I != 40; ++I) {
+      NewPhi->addIncoming(I % 2 ? static_cast<Value *>(X) : Add, &Entry);
+      Phi->addIncoming(Add, &Entry);
+    }
+    EXPECT_EQ(Add, NewPhi->getIncomingValue(38));
+    EXPECT_EQ(X, NewPhi->getIncomingValue(39));
+    EXPECT_EQ(&Entry, Phi->getIncomingBlock(40));
+
+    // Freed blocks are reused by instructions of the same size.
+    Constant *One = ConstantInt::get(X->getType(), 1);
+    auto *Sub =
+        BinaryOperator::CreateSub(One, One, "sub", Entry.getTerminator());
+    void *SubStorage = Sub;
+    Sub->eraseFromParent();
+    auto *Mul =
+        BinaryOperator::CreateMul(One, One, "mul", Entry.getTerminator());
+    EXPECT_EQ(SubStorage, static_cast<void *>(Mul));
+
+    // Instructions can leave the function and outlive it.
+    Mul->moveBefore(H->getEntryBlock().getTerminator());
+  }
+  InstructionArena::setEnabled(false);
+
+  for (unsigned I = 1; I != 41; ++I)
+    Phi->removeIncomingValue(1u, false);
+  F->eraseFromParent();
+  EXPECT_EQ("mul", H->getEntryBlock().front().getName());
+}
+
 } // end anonymous namespace
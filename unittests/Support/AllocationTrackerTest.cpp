@@ -0,0 +1,121 @@
+//===- llvm/unittest/Support/AllocationTrackerTest.cpp - Heap counts ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/AllocationTracker.h"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <new>
+
+using namespace llvm;
+
+namespace {
+
+TEST(AllocationTrackerTest, NestedRegions) {
+  if (!AllocationTracker::isAvailable())
+    return;
+
+  bool WasEnabled = AllocationTracker::isEnabled();
+  AllocationTracker::setEnabled(true);
+
+  AllocationCounts Outer, Inner;
+  {
+    AllocationRegion OuterRegion(&Outer);
+    void *Kept = ::operator new(1000);
+    for (int I = 0; I != 2; ++I) {
+      AllocationRegion InnerRegion(&Inner);
+      ::operator delete(::operator new(4000));
+      ::operator delete(::operator new(100));
+    }
+    ::operator delete(Kept);
+  }
+  AllocationTracker::setEnabled(WasEnabled);
+
+  // Runs of the same region add up, but their peaks don't.
+  EXPECT_EQ(4u, Inner.Allocations);
+  EXPECT_LE(8200u, Inner.Bytes);
+  EXPECT_LE(4000u, Inner.PeakBytes);
+  EXPECT_GT(4100u, Inner.PeakBytes);
+
+  // The outer region sees the inner allocations on top of its own.
+  EXPECT_EQ(5u, Outer.Allocations);
+  EXPECT_LE(9200u, Outer.Bytes);
+  EXPECT_LE(5000u, Outer.PeakBytes);
+  EXPECT_GT(5200u, Outer.PeakBytes);
+
+  // Only the outer region's counts add up with those of other regions.
+  EXPECT_EQ(0u, Inner.OutermostAllocations);
+  EXPECT_EQ(0u, Inner.OutermostBytes);
+  EXPECT_EQ(Outer.Allocations, Outer.OutermostAllocations);
+  EXPECT_EQ(Outer.Bytes, Outer.OutermostBytes);
+}
+
+// Regions count whatever is reported to the tracker, so they can be tested
+// without the operator new hook by reporting malloc'ed blocks directly.
+TEST(AllocationTrackerTest, ReportedAllocations) {
+  bool WasEnabled = AllocationTracker::isEnabled();
+  AllocationTracker::setEnabled(true);
+
+  auto Allocate = [](size_t Size) {
+    void *Ptr = std::malloc(Size);
+    AllocationTracker::noteAllocation(Ptr);
+    return Ptr;
+  };
+  auto Free = [](void *Ptr) {
+    AllocationTracker::noteDeallocation(Ptr);
+    std::free(Ptr);
+  };
+
+  AllocationCounts Outer, Inner;
+  {
+    AllocationRegion OuterRegion(&Outer);
+    void *Kept = Allocate(1000);
+    for (int I = 0; I != 2; ++I) {
+      AllocationRegion InnerRegion(&Inner);
+      Free(Allocate(4000));
+      Free(Allocate(100));
+    }
+    Free(Kept);
+  }
+  AllocationTracker::setEnabled(WasEnabled);
+
+  EXPECT_EQ(4u, Inner.Allocations);
+  EXPECT_EQ(5u, Outer.Allocations);
+  EXPECT_EQ(0u, Inner.OutermostAllocations);
+  EXPECT_EQ(5u, Outer.OutermostAllocations);
+
+  // The sizes are only known if malloc can tell them.
+  if (!Outer.Bytes)
+    return;
+  EXPECT_LE(8200u, Inner.Bytes);
+  EXPECT_LE(4000u, Inner.PeakBytes);
+  EXPECT_GT(4100u, Inner.PeakBytes);
+  EXPECT_LE(9200u, Outer.Bytes);
+  EXPECT_LE(5000u, Outer.PeakBytes);
+  EXPECT_GT(5200u, Outer.PeakBytes);
+  EXPECT_EQ(0u, Inner.OutermostBytes);
+  EXPECT_EQ(Outer.Bytes, Outer.OutermostBytes);
+}
+
+TEST(AllocationTrackerTest, Disabled) {
+  bool WasEnabled = AllocationTracker::isEnabled();
+  AllocationTracker::setEnabled(false);
+
+  AllocationCounts Counts;
+  {
+    AllocationRegion Region(&Counts);
+    ::operator delete(::operator new(100));
+  }
+  AllocationTracker::setEnabled(WasEnabled);
+
+  EXPECT_EQ(0u, Counts.Allocations);
+  EXPECT_EQ(0u, Counts.Bytes);
+  EXPECT_EQ(0u, Counts.PeakBytes);
+}
+
+} // end anonymous namespace
@@ -15,7 +15,9 @@
 #include "llvm/Support/Parallel.h"
 #include "gtest/gtest.h"
 #include <array>
+#include <atomic>
 #include <random>
+#include <vector>
 
 uint32_t array[1024 * 1024];
 
@@ -50,4 +52,34 @@ TEST(Parallel, parallel_for) {
   ASSERT_EQ(range[2049], 1u);
 }
 
+TEST(Parallel, NestedTaskGroups) {
+  // Tasks that spawn and wait for groups of their own must not deadlock the
+  // pool, even when there are more outer tasks than threads.
+  std::atomic<unsigned> Count(0);
+  parallel::detail::TaskGroup Outer;
+  for (unsigned I = 0; I != 64; ++I)
+    Outer.spawn([&Count] {
+      parallel::detail::TaskGroup Inner;
+      for (unsigned J = 0; J != 64; ++J)
+        Inner.spawn([&Count] { ++Count; });
+      Inner.sync();
+      ++Count;
+    });
+  Outer.sync();
+  ASSERT_EQ(64u * 65u, Count.load());
+}
+
+TEST(Parallel, NestedParallelFor) {
+  std::vector<uint32_t> Sums(256);
+  for_each_n(parallel::par, size_t(0), Sums.size(), [&Sums](size_t I) {
+    std::vector<uint32_t> Row(4096, 1);
+    std::atomic<uint32_t> Sum(0);
+    for_each(parallel::par, Row.begin(), Row.end(),
+             [&Sum](uint32_t V) { Sum += V; });
+    Sums[I] = Sum;
+  });
+  for (uint32_t Sum : Sums)
+    ASSERT_EQ(4096u, Sum);
+}
+
 #endif
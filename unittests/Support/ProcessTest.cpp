@@ -26,6 +26,29 @@ TEST(ProcessTest, GetRandomNumberTest) {
   EXPECT_NE((r1 | r2), 0u);
 }
 
+TEST(ProcessTest, GetPerfCounts) {
+  Process::PerfCounts Before, After;
+  // The counters may well be unavailable, in which case nothing is touched.
+  if (!Process::GetPerfCounts(Before)) {
+    EXPECT_EQ(0u, Before.Instructions);
+    return;
+  }
+
+  volatile unsigned Sum = 0;
+  for (unsigned I = 0; I != 100000; ++I)
+    Sum += I;
+  ASSERT_TRUE(Process::GetPerfCounts(After));
+  // The raw counts never go down, but they only cover the loop if the
+  // counters were not multiplexed with other events while it ran.
+  EXPECT_GE(After.Cycles, Before.Cycles);
+  EXPECT_GE(After.Instructions, Before.Instructions);
+  EXPECT_GE(After.TimeEnabled, Before.TimeEnabled);
+  EXPECT_GE(After.TimeRunning, Before.TimeRunning);
+  if (After.TimeEnabled - Before.TimeEnabled ==
+      After.TimeRunning - Before.TimeRunning)
+    EXPECT_GT(After.Instructions, Before.Instructions + 100000);
+}
+
 #ifdef _MSC_VER
 #define setenv(name, var, ignore) _putenv_s(name, var)
 #endif
@@ -0,0 +1,133 @@
+//===- HashMapBench - Benchmark DenseMap against SwissMap -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program runs DenseMap and SwissMap through the access patterns of the
+// hot maps of the compiler, which map pointers to IR objects to small values,
+// at several sizes, and outputs the run time of each.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SwissMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<unsigned>
+    Sizes("sizes", cl::CommaSeparated,
+          cl::desc("Number of keys in each map (default 1000,100000,2000000)"));
+
+static cl::opt<unsigned>
+    Repeat("repeat", cl::init(5),
+           cl::desc("Number of times each operation is repeated"));
+
+namespace {
+/// Stands in for an IR object: the keys are the addresses of these, spread
+/// over the heap as the keys of the compiler's maps are.
+struct Object {
+  char Payload[48];
+};
+} // end anonymous namespace
+
+/// The group prints its report once the last of its timers goes away, so the
+/// timers are kept in \p Timers until every map has been measured.
+template <typename MapT>
+static void benchmark(TimerGroup &Group,
+                      std::vector<std::unique_ptr<Timer>> &Timers,
+                      StringRef Name, ArrayRef<const Object *> Keys,
+                      ArrayRef<const Object *> Missing,
+                      ArrayRef<const Object *> Shuffled) {
+  auto Run = [&](StringRef Op, function_ref<unsigned()> Body) {
+    Timers.emplace_back(
+        new Timer((Name + "." + Op).str(), (Name + ": " + Op).str(), Group));
+    unsigned Sink = 0;
+    Timers.back()->startTimer();
+    for (unsigned I = 0; I != Repeat; ++I)
+      Sink += Body();
+    Timers.back()->stopTimer();
+    volatile unsigned DontOptimizeOut = Sink;
+    (void)DontOptimizeOut;
+  };
+
+  MapT Map;
+  Run("insert", [&] {
+    MapT Fresh;
+    for (unsigned I = 0, E = Keys.size(); I != E; ++I)
+      Fresh.insert(std::make_pair(Keys[I], I));
+    unsigned Size = Fresh.size();
+    Map = std::move(Fresh);
+    return Size;
+  });
+  Run("find hit", [&] {
+    unsigned Sum = 0;
+    for (const Object *K : Shuffled)
+      Sum += Map.find(K)->second;
+    return Sum;
+  });
+  Run("find miss", [&] {
+    unsigned Found = 0;
+    for (const Object *K : Missing)
+      Found += Map.count(K);
+    return Found;
+  });
+  Run("erase+insert", [&] {
+    for (unsigned I = 0, E = Keys.size(); I < E; I += 2)
+      Map.erase(Keys[I]);
+    for (unsigned I = 0, E = Keys.size(); I < E; I += 2)
+      Map[Keys[I]] = I;
+    return Map.size();
+  });
+  Run("iterate", [&] {
+    unsigned Sum = 0;
+    for (const auto &KV : Map)
+      Sum += KV.second;
+    return Sum;
+  });
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "DenseMap and SwissMap benchmark\n");
+  std::vector<unsigned> KeyCounts(Sizes.begin(), Sizes.end());
+  if (KeyCounts.empty())
+    KeyCounts = {1000, 100000, 2000000};
+
+  std::mt19937 Rand(42);
+  for (unsigned N : KeyCounts) {
+    // Allocate the objects interleaved with ones that never go into the maps,
+    // so that hits and misses come from the same part of the heap.
+    std::vector<std::unique_ptr<Object>> Storage;
+    std::vector<const Object *> Keys, Missing;
+    for (unsigned I = 0; I != N; ++I) {
+      Storage.emplace_back(new Object());
+      Keys.push_back(Storage.back().get());
+      Storage.emplace_back(new Object());
+      Missing.push_back(Storage.back().get());
+    }
+    std::shuffle(Keys.begin(), Keys.end(), Rand);
+    std::vector<const Object *> Shuffled = Keys;
+    std::shuffle(Shuffled.begin(), Shuffled.end(), Rand);
+
+    std::string Title;
+    raw_string_ostream(Title) << "Hash map benchmark, " << N << " keys";
+    TimerGroup Group("hashmap", Title);
+    std::vector<std::unique_ptr<Timer>> Timers;
+    benchmark<DenseMap<const Object *, unsigned>>(Group, Timers, "DenseMap",
+                                                  Keys, Missing, Shuffled);
+    benchmark<SwissMap<const Object *, unsigned>>(Group, Timers, "SwissMap",
+                                                  Keys, Missing, Shuffled);
+  }
+  return 0;
+}
@@ -0,0 +1,101 @@
+#!/usr/bin/env python
+
+"""Benchmark the analyses of the hello pass on synthetic CFGs.
+
+For every combination of the requested block counts, loop depths, irreducible
+loop counts, alloca counts and seeds, llvm-stress generates a CFG of that shape
+and opt runs the hello pass on it with -hello-timing-file. The per-phase
+timings of every run are collected into one CSV file, together with the shape
+of the CFG and the peak RSS of the opt process.
+
+Example:
+  hello-benchmark.py --bin-dir build/bin --blocks 1000,10000 --loop-depth 1,4 \\
+      --irreducible 0,8 --output hello.csv
+"""
+
+from __future__ import print_function
+
+import argparse
+import csv
+import itertools
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+def int_list(value):
+  return [int(v) for v in value.split(',')]
+
+def run_opt(args):
+  """Run opt and return its peak RSS in kilobytes."""
+  proc = subprocess.Popen(args)
+  _, status, usage = os.wait4(proc.pid, 0)
+  if status != 0:
+    raise RuntimeError('%s failed with status %d' % (' '.join(args), status))
+  return usage.ru_maxrss
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bin-dir', required=True,
+                      help='Directory containing llvm-stress and opt')
+  parser.add_argument('--output', default='hello-benchmark.csv',
+                      help='CSV file to write the results to')
+  parser.add_argument('--blocks', type=int_list, default=[100, 1000, 5000],
+                      help='Comma separated block counts')
+  parser.add_argument('--loop-depth', type=int_list, default=[1, 3],
+                      help='Comma separated maximum loop nesting depths')
+  parser.add_argument('--irreducible', type=int_list, default=[0, 4],
+                      help='Comma separated irreducible loop counts')
+  parser.add_argument('--allocas', type=int_list, default=[8, 64],
+                      help='Comma separated alloca counts')
+  parser.add_argument('--seeds', type=int_list, default=[1],
+                      help='Comma separated llvm-stress seeds')
+  parser.add_argument('--parallel', action='store_true',
+                      help='Run the new pass manager pass with -hello-parallel')
+  args = parser.parse_args()
+
+  llvm_stress = os.path.join(args.bin_dir, 'llvm-stress')
+  opt = os.path.join(args.bin_dir, 'opt')
+  if args.parallel:
+    pass_args = ['-passes=hello', '-hello-parallel']
+  else:
+    pass_args = ['-hello']
+
+  columns = ['blocks', 'loop_depth', 'irreducible', 'allocas', 'seed',
+             'peak_rss_kb']
+  tmpdir = tempfile.mkdtemp(prefix='hello-benchmark')
+  try:
+    with open(args.output, 'w') as out:
+      writer = None
+      for blocks, depth, irreducible, allocas, seed in itertools.product(
+          args.blocks, args.loop_depth, args.irreducible, args.allocas,
+          args.seeds):
+        ll = os.path.join(tmpdir, 'cfg.ll')
+        timings = os.path.join(tmpdir, 'timings.csv')
+        subprocess.check_call([llvm_stress, '-seed=%d' % seed,
+                               '-cfg-blocks=%d' % blocks,
+                               '-cfg-loop-depth=%d' % depth,
+                               '-cfg-irreducible=%d' % irreducible,
+                               '-cfg-allocas=%d' % allocas, '-o', ll])
+        # Write the report to a file so that printing does not dominate.
+        peak_rss = run_opt([opt, '-disable-output'] + pass_args +
+                           ['-hello-report-file=' + os.devnull,
+                            '-hello-timing-file=' + timings, ll])
+        shape = [blocks, depth, irreducible, allocas, seed, peak_rss]
+        with open(timings) as f:
+          reader = csv.reader(f)
+          header = next(reader)
+          if writer is None:
+            writer = csv.writer(out)
+            writer.writerow(columns + header)
+          for row in reader:
+            writer.writerow(shape + row)
+        print('blocks=%d loop-depth=%d irreducible=%d allocas=%d seed=%d: '
+              'peak RSS %d KB' % tuple(shape), file=sys.stderr)
+  finally:
+    shutil.rmtree(tmpdir)
+
+if __name__ == '__main__':
+  main()